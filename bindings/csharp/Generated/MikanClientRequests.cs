@@ -4,6 +4,12 @@ using System.Collections.Generic;
 
 namespace MikanXR
 {
+	public class CloseEventRing : MikanRequest
+	{
+		public static new readonly long classId= -748662239369951499;
+
+	};
+
 	public class DisposeClientRequest : MikanRequest
 	{
 		public static new readonly long classId= -671320724823045972;
@@ -18,4 +24,40 @@ namespace MikanXR
 		public MikanClientInfo clientInfo;
 	};
 
+	public class MikanBatchRequest : MikanRequest
+	{
+		public static new readonly long classId= 570279143462697704;
+
+		public List<string> requests;
+	};
+
+	public class MikanBatchResponse : MikanResponse
+	{
+		public static new readonly long classId= -2062134668505567068;
+
+		public List<string> responses;
+	};
+
+	public class MikanEventRingResponse : MikanResponse
+	{
+		public static new readonly long classId= 3561415067008822006;
+
+		public string ring_name;
+		public int reader_index;
+		public long start_position;
+	};
+
+	public class OpenEventRing : MikanRequest
+	{
+		public static new readonly long classId= -3749702783911594269;
+
+	};
+
+	public class SubscribeToEvents : MikanRequest
+	{
+		public static new readonly long classId= -7702605654805311611;
+
+		public List<long> eventTypeIds;
+	};
+
 }
@@ -19,6 +19,8 @@ namespace MikanXR
 		public bool supportsRGBA32;
 		public bool supportsBGRA32;
 		public bool supportsDepth;
+		public bool supportsBinaryFormatV2;
+		public bool supportsVRDevicePoseBatch;
 	};
 
 }
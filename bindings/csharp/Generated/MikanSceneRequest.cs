@@ -0,0 +1,40 @@
+// This file is auto generated. DO NO EDIT.
+using System;
+using System.Collections.Generic;
+
+namespace MikanXR
+{
+	public class GetSceneDelta : MikanRequest
+	{
+		public static new readonly long classId= -3650008681685025589;
+
+		public long sinceVersion;
+	};
+
+	public class GetSceneSnapshot : MikanRequest
+	{
+		public static new readonly long classId= 6209456377901081595;
+
+	};
+
+	public class MikanSceneDeltaResponse : MikanResponse
+	{
+		public static new readonly long classId= -5145944994326188844;
+
+		public long scene_version;
+		public bool is_full_snapshot;
+		public MikanSceneObjects changed;
+		public List<int> removed_spatial_anchor_ids;
+		public List<int> removed_stencil_ids;
+		public List<int> removed_vr_device_ids;
+	};
+
+	public class MikanSceneSnapshotResponse : MikanResponse
+	{
+		public static new readonly long classId= -5887950144677501356;
+
+		public long scene_version;
+		public MikanSceneObjects scene;
+	};
+
+}
@@ -0,0 +1,26 @@
+// This file is auto generated. DO NO EDIT.
+using System;
+using System.Collections.Generic;
+
+namespace MikanXR
+{
+	public class MikanSceneObjects
+	{
+		public static readonly long classId= 6371473088378808989;
+
+		public List<MikanSpatialAnchorInfo> spatial_anchors;
+		public List<MikanStencilQuadInfo> quad_stencils;
+		public List<MikanStencilBoxInfo> box_stencils;
+		public List<MikanStencilModelInfo> model_stencils;
+		public List<MikanVRDeviceDescriptor> vr_devices;
+	};
+
+	public class MikanVRDeviceDescriptor
+	{
+		public static readonly long classId= 4198649792096481218;
+
+		public int device_id;
+		public MikanVRDeviceInfo vr_device_info;
+	};
+
+}
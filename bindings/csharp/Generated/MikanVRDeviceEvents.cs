@@ -10,6 +10,14 @@ namespace MikanXR
 
 	};
 
+	public class MikanVRDevicePoseBatchEvent : MikanEvent
+	{
+		public static new readonly long classId= 1040066521151243898;
+
+		public List<MikanVRDevicePose> poses;
+		public long frame;
+	};
+
 	public class MikanVRDevicePoseUpdateEvent : MikanEvent
 	{
 		public static new readonly long classId= 3423063131481365449;
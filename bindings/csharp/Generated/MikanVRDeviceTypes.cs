@@ -27,4 +27,12 @@ namespace MikanXR
 		public string device_path;
 	};
 
+	public class MikanVRDevicePose
+	{
+		public static readonly long classId= 5320511335369669506;
+
+		public MikanMatrix4f transform;
+		public int device_id;
+	};
+
 }
@@ -14,6 +14,8 @@ namespace MikanXR
 		private MikanCoreNative.NativeLogCallback _nativeLogCallback;
 		private IntPtr _mikanContext = IntPtr.Zero;
 		private Dictionary<long, Type> _eventTypeCache = null;
+		// Receives the utf8 events from the core api, grows to fit the biggest event seen
+		private StringBuilder _utf8EventBuffer = new StringBuilder(1024);
 
 		public MikanEventManager(MikanCoreNative.NativeLogCallback logCallback)
 		{
@@ -39,16 +41,23 @@ namespace MikanXR
 
 		public MikanAPIResult FetchNextEvent(out MikanEvent outEvent)
 		{
-			StringBuilder utf8Buffer = new StringBuilder(1024);
-			UIntPtr utf8BufferSize = (UIntPtr)utf8Buffer.Capacity;
-
 			outEvent= null;
 
 			var result = (MikanAPIResult)MikanCoreNative.Mikan_FetchNextEvent(
-				_mikanContext, utf8BufferSize, utf8Buffer, out UIntPtr utf8BytesWritten);
+				_mikanContext, (UIntPtr)_utf8EventBuffer.Capacity, _utf8EventBuffer, out UIntPtr utf8BytesWritten);
+			if (result == MikanAPIResult.BufferTooSmall)
+			{
+				// The event stays queued, so make room for it and fetch it again
+				MikanCoreNative.Mikan_FetchNextEvent(_mikanContext, UIntPtr.Zero, null, out UIntPtr utf8BytesNeeded);
+				_utf8EventBuffer = new StringBuilder((int)utf8BytesNeeded);
+
+				result = (MikanAPIResult)MikanCoreNative.Mikan_FetchNextEvent(
+					_mikanContext, (UIntPtr)_utf8EventBuffer.Capacity, _utf8EventBuffer, out utf8BytesWritten);
+			}
+
 			if (result == MikanAPIResult.Success)
 			{
-				string utf8BufferString = utf8Buffer.ToString();
+				string utf8BufferString = _utf8EventBuffer.ToString();
 				
 				outEvent = parseEventString(utf8BufferString);
 				if (outEvent == null)
@@ -21,7 +21,7 @@
 
 // Latest Mikan API Protocol Version used by the server
 // Increment this value when the server API changes
-#define MIKAN_SERVER_API_VERSION                0
+#define MIKAN_SERVER_API_VERSION                3
 
 // Oldest Mikan API Protocol Version allowed by the server
 // Increment this value when deprecating old client API versions
@@ -253,10 +253,15 @@ int64_t VideoFrameDistortionView::readNextVideoFrame()
 		int frameHeight= (int)m_videoSourceView->getFrameHeight();
 		ensureFrameBufferSize(frameWidth, frameHeight);
 
+		// The frame is swapped into the queue entry, the entry's old buffer gets reused by the video source
 		cv::Mat* bgrSourceBuffer = m_bgrSourceBuffers[m_bgrSourceBufferWriteIndex].bgrSourceBuffer;
-		m_lastVideoFrameReadIndex= m_videoSourceView->readVideoFrameSectionBuffer(VideoFrameSection::Primary, bgrSourceBuffer);
-		m_bgrSourceBuffers[m_bgrSourceBufferWriteIndex].frameIndex= m_lastVideoFrameReadIndex;
-		m_bgrSourceBufferWriteIndex = (m_bgrSourceBufferWriteIndex + 1) % m_bgrSourceBufferCount;
+		const int64_t frameIndex= m_videoSourceView->readVideoFrameSectionBuffer(VideoFrameSection::Primary, bgrSourceBuffer);
+		if (frameIndex != m_lastVideoFrameReadIndex)
+		{
+			m_lastVideoFrameReadIndex= frameIndex;
+			m_bgrSourceBuffers[m_bgrSourceBufferWriteIndex].frameIndex= m_lastVideoFrameReadIndex;
+			m_bgrSourceBufferWriteIndex = (m_bgrSourceBufferWriteIndex + 1) % m_bgrSourceBufferCount;
+		}
 	}
 
 	return m_lastVideoFrameReadIndex;
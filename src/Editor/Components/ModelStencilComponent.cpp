@@ -115,8 +115,11 @@ MikanStencilModelInfo ModelStencilDefinition::getModelInfo() const
 }
 
 // -- ModelStencilComponent -----
+static int g_nextRenderGeometryRevision= 0;
+
 ModelStencilComponent::ModelStencilComponent(MikanObjectWeakPtr owner)
 	: StencilComponent(owner)
+	, m_renderGeometryRevision(++g_nextRenderGeometryRevision)
 {
 	m_bWantsCustomRender= true;
 }
@@ -256,6 +259,8 @@ void ModelStencilComponent::setModelPath(const std::filesystem::path& path)
 
 void ModelStencilComponent::disposeMeshComponents()
 {
+	m_renderGeometryRevision= ++g_nextRenderGeometryRevision;
+
 	// Clean up any previously created mesh components
 	while (m_meshComponents.size() > 0)
 	{
@@ -68,6 +68,8 @@ public:
 	void disposeMeshComponents();
 	void rebuildMeshComponents();
 	void extractRenderGeometry(MikanStencilModelRenderGeometry& outRenderGeometry);
+	// Changes whenever the meshes are rebuilt, never reused by another model stencil
+	inline int getRenderGeometryRevision() const { return m_renderGeometryRevision; }
 
 	// Selection Events
 	void onInteractionRayOverlapEnter(const ColliderRaycastHitResult& hitResult);
@@ -105,4 +107,5 @@ protected:
 	bool m_bIsHovered= false;
 	bool m_bIsSelected= false;
 	bool m_bIsTransformGizmoBound= false;
+	int m_renderGeometryRevision;
 };
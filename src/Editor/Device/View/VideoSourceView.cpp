@@ -25,17 +25,22 @@
 
 #include <algorithm>
 #include <atomic>
-#include <mutex>
 
 #include <easy/profiler.h>
 
 //-- private methods -----
+// Lock-free triple buffer handing video frames from the capture thread to the main thread.
+// The writer fills its back buffer and publishes it by swapping it with the shared middle buffer,
+// the reader takes the middle buffer the same way. Neither side ever waits on the other,
+// and the reader hands the frame over to the caller with a cv::Mat swap instead of a copy.
 class OpenCVBufferState
 {
 public:
 	OpenCVBufferState(IVideoSourceInterface* device, VideoFrameSection _section)
 		: m_section(_section)
-		, m_bgrBuffer(nullptr)
+		, m_writeBufferIndex(0)
+		, m_sharedBufferState(1)
+		, m_readBufferIndex(2)
 		, m_lastVideoFrameWriteIndex(0)
 	{
 		const VideoModeConfig* mode = device->getVideoMode();
@@ -45,55 +50,53 @@ public:
 		m_srcBufferHeight = mode->bufferPixelHeight;
 		device->getVideoFrameDimensions(&m_frameWidth, &m_frameHeight, nullptr);
 
-		m_bgrBuffer = new cv::Mat(m_frameHeight, m_frameWidth, CV_8UC3);
+		for (int bufferIndex = 0; bufferIndex < k_bufferCount; ++bufferIndex)
+		{
+			m_bgrBuffers[bufferIndex].create(m_frameHeight, m_frameWidth, CV_8UC3);
+			m_bufferFrameIndices[bufferIndex] = 0;
+		}
 	}
 
 	virtual ~OpenCVBufferState()
 	{
-		if (m_bgrBuffer != nullptr)
-		{
-			delete m_bgrBuffer;
-		}
 	}
 
 	void writeVideoFrame(const unsigned char* video_buffer, bool bIsFlipped)
 	{
 		EASY_FUNCTION();
 
-		std::lock_guard<std::mutex> bufferLock(m_bufferMutex);
 		const cv::Mat videoBufferMat(m_srcBufferHeight, m_srcBufferWidth, CV_8UC3, const_cast<unsigned char*>(video_buffer));
+		cv::Mat& bgrBuffer = m_bgrBuffers[m_writeBufferIndex];
 
 		if (bIsFlipped)
 		{
-			cv::flip(videoBufferMat, *m_bgrBuffer, +1);
+			cv::flip(videoBufferMat, bgrBuffer, +1);
 		}
 		else
 		{
-			videoBufferMat.copyTo(*m_bgrBuffer);
+			videoBufferMat.copyTo(bgrBuffer);
 		}
 
-		// Atomically increment the frame index on the write thread
-		m_lastVideoFrameWriteIndex++;
+		publishWriteBuffer();
 	}
 
 	void writeStereoVideoFrameSection(const unsigned char* video_buffer, const cv::Rect& buffer_bounds, bool bIsFlipped)
 	{
 		EASY_FUNCTION();
 
-		std::lock_guard<std::mutex> bufferLock(m_bufferMutex);
 		const cv::Mat videoBufferMat(m_srcBufferHeight, m_srcBufferWidth, CV_8UC3, const_cast<unsigned char*>(video_buffer));
+		cv::Mat& bgrBuffer = m_bgrBuffers[m_writeBufferIndex];
 
 		if (bIsFlipped)
 		{
-			cv::flip(videoBufferMat(buffer_bounds), *m_bgrBuffer, +1);
+			cv::flip(videoBufferMat(buffer_bounds), bgrBuffer, +1);
 		}
 		else
 		{
-			videoBufferMat(buffer_bounds).copyTo(*m_bgrBuffer);
+			videoBufferMat(buffer_bounds).copyTo(bgrBuffer);
 		}
 
-		// Atomically increment the frame index on the write thread
-		m_lastVideoFrameWriteIndex++;
+		publishWriteBuffer();
 	}
 
 	int64_t getLastVideoFrameWriteIndex() const
@@ -101,22 +104,45 @@ public:
 		return m_lastVideoFrameWriteIndex.load();
 	}
 
+	// Swaps the newest frame into outBGRBuffer, whose old contents become a spare buffer for the writer.
+	// Returns the index of the frame now in outBGRBuffer, or lastReadFrameIndex if there was no new frame.
 	int64_t readVideoFrame(cv::Mat* outBGRBuffer, int64_t lastReadFrameIndex)
 	{
 		EASY_FUNCTION();
-		int64_t lastVideoFrameWriteIndex= getLastVideoFrameWriteIndex();
 
-		if (lastVideoFrameWriteIndex != lastReadFrameIndex)
+		if ((m_sharedBufferState.load(std::memory_order_acquire) & k_newFrameFlag) == 0)
 		{
-			std::lock_guard<std::mutex> bufferLock(m_bufferMutex);
-
-			m_bgrBuffer->copyTo(*outBGRBuffer);
+			return lastReadFrameIndex;
 		}
 
-		return lastVideoFrameWriteIndex;
+		const uint8_t sharedState = m_sharedBufferState.exchange(m_readBufferIndex, std::memory_order_acq_rel);
+		m_readBufferIndex = sharedState & k_bufferIndexMask;
+
+		cv::swap(m_bgrBuffers[m_readBufferIndex], *outBGRBuffer);
+
+		return m_bufferFrameIndices[m_readBufferIndex];
 	}
 
 private:
+	static const int k_bufferCount = 3;
+	static const uint8_t k_bufferIndexMask = 0x3;
+	// Set in the shared state when the shared buffer holds a frame the reader hasn't taken yet
+	static const uint8_t k_newFrameFlag = 0x4;
+
+	// Called on the capture thread once the write buffer holds the new frame
+	void publishWriteBuffer()
+	{
+		const int64_t frameIndex = m_lastVideoFrameWriteIndex.load() + 1;
+		m_bufferFrameIndices[m_writeBufferIndex] = frameIndex;
+
+		const uint8_t sharedState = 
+			m_sharedBufferState.exchange(m_writeBufferIndex | k_newFrameFlag, std::memory_order_acq_rel);
+		m_writeBufferIndex = sharedState & k_bufferIndexMask;
+
+		// Only bumped once the frame can be read, so a reader never sees the index before the frame
+		m_lastVideoFrameWriteIndex.store(frameIndex);
+	}
+
 	VideoFrameSection m_section;
 
 	int m_srcBufferWidth;
@@ -124,8 +150,14 @@ private:
 	int m_frameWidth;
 	int m_frameHeight;
 
-	std::mutex m_bufferMutex;
-	cv::Mat* m_bgrBuffer; // source video frame
+	cv::Mat m_bgrBuffers[k_bufferCount]; // source video frames
+	int64_t m_bufferFrameIndices[k_bufferCount];
+	// Only touched by the capture thread
+	uint8_t m_writeBufferIndex;
+	// Index of the buffer in the middle, plus k_newFrameFlag
+	std::atomic<uint8_t> m_sharedBufferState;
+	// Only touched by the reading thread
+	uint8_t m_readBufferIndex;
 	std::atomic_int64_t m_lastVideoFrameWriteIndex;
 };
 
@@ -79,6 +79,8 @@ public:
 	void setVideoProperty(const VideoPropertyType property_type, int desired_value, bool save_setting);
 
 	bool hasNewVideoFrameAvailable(VideoFrameSection section) const;
+	// Swaps the newest frame into outBuffer (no copy), outBuffer's old image buffer is reused for later frames.
+	// Returns the index of the last frame read, which is unchanged if there was no new frame.
 	int64_t readVideoFrameSectionBuffer(VideoFrameSection section, cv::Mat* outBuffer);
 
 	void getCameraIntrinsics(MikanVideoSourceIntrinsics& out_camera_intrinsics) const;
@@ -0,0 +1,306 @@
+#include "ClientRequestDispatch.h"
+#include "OutboundQueueConnection.h"
+#include "RequestWorkerPool.h"
+#include "BinaryDeserializer.h"
+#include "JsonDeserializer.h"
+#include "JsonSerializer.h"
+#include "JsonUtils.h"
+#include "MikanAPITypes.h"
+#include "Logger.h"
+#include "SerializableObjectPtr.h"
+
+namespace ClientRequestDispatch
+{
+	using RequestPtr = std::shared_ptr<MikanRequest>;
+
+	bool readBinaryRequestHeader(
+		const uint8_t* buffer,
+		size_t bufferSize,
+		int64_t& outRequestTypeId,
+		int& outRequestId)
+	{
+		try
+		{
+			MikanRequest requestHeader;
+			requestHeader.requestTypeId = 0;
+
+			const Serialization::BinaryFormat format = Serialization::getBinaryFormat(buffer, bufferSize);
+			if (!Serialization::deserializeFromBytes(
+					buffer, bufferSize, &requestHeader, MikanRequest::staticGetArchetype(), format) ||
+				requestHeader.requestTypeId == 0)
+			{
+				return false;
+			}
+
+			outRequestTypeId = requestHeader.requestTypeId;
+			outRequestId = requestHeader.requestId;
+			return true;
+		}
+		catch (std::exception& e)
+		{
+			MIKAN_LOG_WARNING("readBinaryRequestHeader") << "Failed to parse request header: " << e.what();
+			return false;
+		}
+	}
+
+	bool readRequestHeader(
+		const ClientRequestMessage& inRequest,
+		int64_t& outRequestTypeId,
+		int& outRequestId)
+	{
+		const std::string& inRequestString = inRequest.payload;
+
+		if (inRequest.bIsBinary)
+		{
+			// The MikanRequest fields come first, so the header can be read on its own
+			const uint8_t* binaryRequestData = reinterpret_cast<const uint8_t*>(inRequestString.data());
+			if (!readBinaryRequestHeader(binaryRequestData, inRequestString.size(), outRequestTypeId, outRequestId))
+			{
+				MIKAN_MT_LOG_WARNING("processRequests") <<
+					"Malformed binary request of " << inRequestString.size() << " bytes";
+				return false;
+			}
+		}
+		else
+		{
+			JsonSaxInt64ValueSearcher typeNameSearcher;
+			if (!typeNameSearcher.fetchKeyValuePair(inRequestString, "requestTypeId", outRequestTypeId))
+			{
+				MIKAN_MT_LOG_WARNING("processRequests") << 
+					"Request missing/invalid requestType field: " << inRequestString;
+				return false;
+			}
+
+			// Request ID is optional if the request doesn't expect a response
+			JsonSaxIntegerValueSearcher requestIdSearcher;
+			if (!requestIdSearcher.fetchKeyValuePair(inRequestString, "requestId", outRequestId))
+			{
+				outRequestId= INVALID_MIKAN_ID;
+			}
+		}
+
+		return true;
+	}
+
+	// Makes an instance of the request struct with the given type id (nullptr if it isn't a request type)
+	static RequestPtr allocateRequest(int64_t requestTypeId, rfk::Struct const*& outRequestStruct)
+	{
+		rfk::Struct const* requestStruct =
+			rfk::getDatabase().getStructById(Serialization::toRfkClassId(requestTypeId));
+		if (requestStruct == nullptr || !requestStruct->isSubclassOf(MikanRequest::staticGetArchetype()))
+		{
+			return RequestPtr();
+		}
+
+		outRequestStruct = requestStruct;
+		return requestStruct->makeSharedInstance<MikanRequest>();
+	}
+
+	// The type id comes from the json itself, the request is deserialized in the same pass
+	static bool parseJsonRequest(ClientRequestMessage& inOutRequest)
+	{
+		const std::string& inRequestString = inOutRequest.payload;
+		RequestPtr parsedRequest;
+		int64_t parsedRequestTypeId = 0;
+
+		try
+		{
+			if (!Serialization::deserializeTypedFromJsonString(
+					inRequestString.data(), inRequestString.size(), "requestTypeId",
+					[&parsedRequest, &parsedRequestTypeId](int64_t requestTypeId, rfk::Struct const*& outStructType) -> void* {
+						parsedRequest = allocateRequest(requestTypeId, outStructType);
+						parsedRequestTypeId = requestTypeId;
+						return parsedRequest.get();
+					}))
+			{
+				return false;
+			}
+		}
+		catch (std::exception& e)
+		{
+			MIKAN_LOG_WARNING("parseJsonRequest") << "Failed to parse request: " << e.what();
+			return false;
+		}
+
+		parsedRequest->requestTypeId = parsedRequestTypeId;
+		inOutRequest.parsedRequest = std::move(parsedRequest);
+		inOutRequest.parsedRequestTypeId = parsedRequestTypeId;
+		return true;
+	}
+
+	// The header has already been read, this deserializes the rest
+	static bool parseBinaryRequest(ClientRequestMessage& inOutRequest, int64_t requestTypeId)
+	{
+		const std::string& inRequestString = inOutRequest.payload;
+		const uint8_t* binaryRequestData = reinterpret_cast<const uint8_t*>(inRequestString.data());
+
+		rfk::Struct const* requestStruct = nullptr;
+		RequestPtr parsedRequest = allocateRequest(requestTypeId, requestStruct);
+		if (!parsedRequest)
+			return false;
+
+		try
+		{
+			const Serialization::BinaryFormat format =
+				Serialization::getBinaryFormat(binaryRequestData, inRequestString.size());
+			if (!Serialization::deserializeFromBytes(
+					binaryRequestData, inRequestString.size(), parsedRequest.get(), *requestStruct, format))
+			{
+				return false;
+			}
+		}
+		catch (std::exception& e)
+		{
+			MIKAN_LOG_WARNING("parseBinaryRequest") << "Failed to parse request: " << e.what();
+			return false;
+		}
+
+		parsedRequest->requestTypeId = requestTypeId;
+		inOutRequest.parsedRequest = std::move(parsedRequest);
+		inOutRequest.parsedRequestTypeId = requestTypeId;
+		return true;
+	}
+
+	bool parseRequest(
+		ClientRequestMessage& inOutRequest,
+		int64_t& outRequestTypeId,
+		int& outRequestId)
+	{
+		inOutRequest.parsedRequest.reset();
+		inOutRequest.parsedRequestTypeId = 0;
+
+		if (inOutRequest.bIsBinary)
+		{
+			if (!readRequestHeader(inOutRequest, outRequestTypeId, outRequestId))
+				return false;
+
+			parseBinaryRequest(inOutRequest, outRequestTypeId);
+			return true;
+		}
+
+		if (parseJsonRequest(inOutRequest))
+		{
+			outRequestTypeId = inOutRequest.parsedRequestTypeId;
+			outRequestId = inOutRequest.parsedRequest->requestId;
+			return true;
+		}
+
+		// Unknown or malformed requests still get a response (if they have a header)
+		return readRequestHeader(inOutRequest, outRequestTypeId, outRequestId);
+	}
+
+	void invokeRequestHandler(
+		const RequestHandler* handler,
+		const std::string& connectionId,
+		const ClientRequestMessage& inRequest,
+		int64_t requestTypeId,
+		int requestId,
+		ClientResponse& outResponse)
+	{
+		const std::string& inRequestString = inRequest.payload;
+
+		outResponse.utf8String.clear();
+		outResponse.binaryData.clear();
+
+		// NOTE: Connection ID here is a unique ID for the socket connection on the server
+		// and is not the same as the client ID that the client sends to identify itself
+		ClientRequest request;
+		request.connectionId = connectionId;
+		request.requestId = requestId;
+		request.parsedRequest = inRequest.parsedRequest.get();
+		if (inRequest.bIsBinary)
+		{
+			request.binaryRequestData = reinterpret_cast<const uint8_t*>(inRequestString.data());
+			request.binaryRequestSize = inRequestString.size();
+		}
+		else
+		{
+			request.utf8RequestData = inRequestString.data();
+			request.utf8RequestSize = inRequestString.size();
+		}
+
+		if (handler != nullptr)
+		{
+			(*handler)(request, outResponse);
+		}
+		else
+		{
+			const rfk::Struct& requestTypeStruct = MikanResponse::staticGetArchetype();
+
+			MikanResponse outResult;
+			outResult.responseTypeName = requestTypeStruct.getName();
+			outResult.responseTypeId = requestTypeStruct.getId();
+			outResult.requestId= requestId;
+			outResult.resultCode= MikanAPIResult::UnknownFunction;
+
+			Serialization::serializeToJsonString(outResult, outResponse.utf8String);
+		}
+	}
+
+	void queueResponse(
+		OutboundQueueConnection& connection,
+		int64_t requestTypeId,
+		int requestId,
+		const ClientResponse& response,
+		const OutboundQueueSettings& outboundQueueSettings)
+	{
+		// Send the response back to the client (responses are never dropped or coalesced)
+		if (!response.utf8String.empty())
+		{
+			connection.queueText(response.utf8String, 0, false, outboundQueueSettings);
+		}
+
+		if (!response.binaryData.empty())
+		{
+			connection.queueBinaryData(response.binaryData, false, outboundQueueSettings);
+		}
+
+		if (requestId != INVALID_MIKAN_ID &&
+			response.utf8String.empty() &&
+			response.binaryData.empty())
+		{
+			MIKAN_MT_LOG_WARNING("processRequests") <<
+				"Request handler for " << requestTypeId 
+				<< " returned empty response, but response expected!";
+		}
+	}
+
+	void dispatchRequest(
+		const RequestHandler* handler,
+		OutboundQueueConnection& connection,
+		const ClientRequestMessage& inRequest,
+		int64_t requestTypeId,
+		int requestId,
+		ClientResponse& responseBuffer,
+		const OutboundQueueSettings& outboundQueueSettings)
+	{
+		invokeRequestHandler(
+			handler, connection.getConnectionId(), inRequest, requestTypeId, requestId, responseBuffer);
+		queueResponse(connection, requestTypeId, requestId, responseBuffer, outboundQueueSettings);
+	}
+
+	void dispatchRequestToWorker(
+		const RequestHandler& handler,
+		RequestWorkerPool& workerPool,
+		std::weak_ptr<OutboundQueueConnection> connection,
+		const std::string& connectionId,
+		ClientRequestMessage&& inRequest,
+		int64_t requestTypeId,
+		int requestId,
+		const OutboundQueueSettings& outboundQueueSettings)
+	{
+		// The job owns the request (the ClientRequest handed to the handler points into it)
+		workerPool.submitJob(
+			[handler, connection, connectionId, request = std::move(inRequest), requestTypeId, requestId, 
+			 outboundQueueSettings]() {
+				ClientResponse response;
+				invokeRequestHandler(&handler, connectionId, request, requestTypeId, requestId, response);
+
+				std::shared_ptr<OutboundQueueConnection> liveConnection = connection.lock();
+				if (liveConnection)
+				{
+					queueResponse(*liveConnection, requestTypeId, requestId, response, outboundQueueSettings);
+				}
+			});
+	}
+};
\ No newline at end of file
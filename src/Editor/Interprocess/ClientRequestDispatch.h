@@ -0,0 +1,87 @@
+#pragma once
+
+#include "InterprocessMessageServerInterface.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class OutboundQueueConnection;
+class RequestWorkerPool;
+
+// A request as received from a client socket: either json text or binary encoded
+struct ClientRequestMessage
+{
+	std::string payload;
+	bool bIsBinary= false;
+
+	// The deserialized request, filled in by ClientRequestDispatch::parseRequest()
+	std::shared_ptr<struct MikanRequest> parsedRequest;
+	// The type parsedRequest was allocated as (requests are dispatched on this, not on the parsed field)
+	int64_t parsedRequestTypeId= 0;
+};
+
+namespace ClientRequestDispatch
+{
+	// Reads the MikanRequest header fields from a binary encoded request
+	bool readBinaryRequestHeader(
+		const uint8_t* buffer,
+		size_t bufferSize,
+		int64_t& outRequestTypeId,
+		int& outRequestId);
+
+	// Reads the request type and id from either a json or binary encoded request
+	bool readRequestHeader(
+		const ClientRequestMessage& inRequest,
+		int64_t& outRequestTypeId,
+		int& outRequestId);
+
+	// Deserializes the whole request into inOutRequest.parsedRequest (a single pass over the payload)
+	// and returns its type and id. If the body can't be deserialized only the header is read,
+	// leaving the handler to report the malformed request. Returns false if there is no valid header.
+	bool parseRequest(
+		ClientRequestMessage& inOutRequest,
+		int64_t& outRequestTypeId,
+		int& outRequestId);
+
+	// Runs the handler for the request, or writes an UnknownFunction response if there isn't one
+	void invokeRequestHandler(
+		const RequestHandler* handler,
+		const std::string& connectionId,
+		const ClientRequestMessage& inRequest,
+		int64_t requestTypeId,
+		int requestId,
+		ClientResponse& outResponse);
+
+	// Queues the response on the connection the request came from (never dropped or coalesced)
+	void queueResponse(
+		OutboundQueueConnection& connection,
+		int64_t requestTypeId,
+		int requestId,
+		const ClientResponse& response,
+		const OutboundQueueSettings& outboundQueueSettings);
+
+	// Runs the handler for the request and queues the response on the connection it came from.
+	// The response buffer is reused across requests to keep its capacity.
+	void dispatchRequest(
+		const RequestHandler* handler,
+		OutboundQueueConnection& connection,
+		const ClientRequestMessage& inRequest,
+		int64_t requestTypeId,
+		int requestId,
+		ClientResponse& responseBuffer,
+		const OutboundQueueSettings& outboundQueueSettings);
+
+	// Runs the (read-only) handler for the request on the worker pool.
+	// The worker queues the response on the connection as soon as the handler returns
+	// (dropped if the connection closed in the meantime).
+	void dispatchRequestToWorker(
+		const RequestHandler& handler,
+		RequestWorkerPool& workerPool,
+		std::weak_ptr<OutboundQueueConnection> connection,
+		const std::string& connectionId,
+		ClientRequestMessage&& inRequest,
+		int64_t requestTypeId,
+		int requestId,
+		const OutboundQueueSettings& outboundQueueSettings);
+};
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "CompositeInterprocessMessageServer.h"
+#include "Logger.h"
+
+#include <easy/profiler.h>
+
+CompositeInterprocessMessageServer::CompositeInterprocessMessageServer()
+{}
+
+CompositeInterprocessMessageServer::~CompositeInterprocessMessageServer()
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		delete entry.server;
+	}
+	m_servers.clear();
+}
+
+void CompositeInterprocessMessageServer::addServer(IInterprocessMessageServer* server, bool bIsRequired)
+{
+	m_servers.push_back({server, bIsRequired});
+}
+
+bool CompositeInterprocessMessageServer::initialize()
+{
+	for (auto it = m_servers.begin(); it != m_servers.end();)
+	{
+		if (it->server->initialize())
+		{
+			++it;
+		}
+		else if (it->bIsRequired)
+		{
+			return false;
+		}
+		else
+		{
+			MIKAN_LOG_WARNING("CompositeInterprocessMessageServer::initialize()")
+				<< "Optional message server failed to initialize, continuing without it";
+
+			it->server->dispose();
+			delete it->server;
+			it = m_servers.erase(it);
+		}
+	}
+
+	return !m_servers.empty();
+}
+
+void CompositeInterprocessMessageServer::dispose()
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->dispose();
+	}
+}
+
+void CompositeInterprocessMessageServer::setSocketEventHandler(
+	const std::string& eventType, 
+	SocketEventHandler handler)
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->setSocketEventHandler(eventType, handler);
+	}
+}
+
+void CompositeInterprocessMessageServer::setRequestHandler(
+	std::size_t requestTypeId, 
+	RequestHandler handler,
+	bool bIsReadOnly)
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->setRequestHandler(requestTypeId, handler, bIsReadOnly);
+	}
+}
+
+void CompositeInterprocessMessageServer::setRequestWorkerPool(RequestWorkerPool* workerPool)
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->setRequestWorkerPool(workerPool);
+	}
+}
+
+void CompositeInterprocessMessageServer::setStateSnapshotPublisher(StateSnapshotPublisher publisher)
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->setStateSnapshotPublisher(publisher);
+	}
+}
+
+bool CompositeInterprocessMessageServer::invokeRequestHandler(
+	std::size_t requestTypeId,
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	// Every server has the same handlers registered
+	return !m_servers.empty() && m_servers[0].server->invokeRequestHandler(requestTypeId, request, response);
+}
+
+void CompositeInterprocessMessageServer::setOutboundQueueSettings(const OutboundQueueSettings& settings)
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->setOutboundQueueSettings(settings);
+	}
+}
+
+bool CompositeInterprocessMessageServer::getOutboundQueueStats(
+	const std::string& connectionId, 
+	OutboundQueueStats& outStats)
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		if (entry.server->getOutboundQueueStats(connectionId, outStats))
+			return true;
+	}
+
+	return false;
+}
+
+void CompositeInterprocessMessageServer::sendMessageToClient(
+	const std::string& connectionId, 
+	const std::string& message,
+	uint64_t coalesceKey)
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->sendMessageToClient(connectionId, message, coalesceKey);
+	}
+}
+
+void CompositeInterprocessMessageServer::sendMessageToClients(
+	const std::vector<std::string>& connectionIds, 
+	const std::string& message,
+	uint64_t coalesceKey,
+	bool bIsDroppable)
+{
+	EASY_FUNCTION();
+
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->sendMessageToClients(connectionIds, message, coalesceKey, bIsDroppable);
+	}
+}
+
+void CompositeInterprocessMessageServer::sendMessageToAllClients(const std::string& message)
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->sendMessageToAllClients(message);
+	}
+}
+
+void CompositeInterprocessMessageServer::sendBinaryResponseToClient(
+	const std::string& connectionId, 
+	const std::vector<uint8_t>& binaryData)
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->sendBinaryResponseToClient(connectionId, binaryData);
+	}
+}
+
+void CompositeInterprocessMessageServer::processSocketEvents()
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->processSocketEvents();
+	}
+}
+
+void CompositeInterprocessMessageServer::processRequests()
+{
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->processRequests();
+	}
+}
+
+void CompositeInterprocessMessageServer::flushOutboundMessages()
+{
+	EASY_FUNCTION();
+
+	for (ServerEntry& entry : m_servers)
+	{
+		entry.server->flushOutboundMessages();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "InterprocessMessageServerInterface.h"
+
+#include <vector>
+
+// Runs several message servers (transports) side by side as one.
+// Handlers are registered with every transport and messages for a connection
+// go to whichever transport owns it (the others don't know the connection id).
+class CompositeInterprocessMessageServer : public IInterprocessMessageServer
+{
+public:
+	CompositeInterprocessMessageServer();
+	virtual ~CompositeInterprocessMessageServer();
+
+	// Takes ownership of the server.
+	// Optional servers that fail to initialize are dropped instead of failing initialize().
+	void addServer(IInterprocessMessageServer* server, bool bIsRequired);
+
+	bool initialize() override;
+	void dispose() override;
+	void setSocketEventHandler(const std::string& eventType, SocketEventHandler handler) override;
+	void setRequestHandler(std::size_t requestTypeId, RequestHandler handler, bool bIsReadOnly= false) override;
+	void setRequestWorkerPool(class RequestWorkerPool* workerPool) override;
+	void setStateSnapshotPublisher(StateSnapshotPublisher publisher) override;
+	bool invokeRequestHandler(
+		std::size_t requestTypeId, 
+		const ClientRequest& request, 
+		ClientResponse& response) override;
+
+	void setOutboundQueueSettings(const OutboundQueueSettings& settings) override;
+	bool getOutboundQueueStats(const std::string& connectionId, OutboundQueueStats& outStats) override;
+
+	void sendMessageToClient(
+		const std::string& connectionId, 
+		const std::string& message, 
+		uint64_t coalesceKey= 0) override;
+	void sendMessageToClients(
+		const std::vector<std::string>& connectionIds, 
+		const std::string& message, 
+		uint64_t coalesceKey= 0,
+		bool bIsDroppable= true) override;
+	void sendMessageToAllClients(const std::string& message) override;
+	void sendBinaryResponseToClient(const std::string& connectionId, const std::vector<uint8_t>& binaryData) override;
+	void processSocketEvents() override;
+	void processRequests() override;
+	void flushOutboundMessages() override;
+
+private:
+	struct ServerEntry
+	{
+		IInterprocessMessageServer* server;
+		bool bIsRequired;
+	};
+	std::vector<ServerEntry> m_servers;
+};
\ No newline at end of file
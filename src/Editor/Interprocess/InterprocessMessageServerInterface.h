@@ -1,7 +1,9 @@
 #pragma once
 
 #include <functional>
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 #define WEBSOCKET_SERVER_ADDRESS			"ws://127.0.0.1"
 #define WEBSOCKET_SERVER_PORT				"8080"
@@ -22,11 +24,23 @@ struct ClientSocketEvent
 
 using MikanRequestID = int;
 
+// Points into the request message, which outlives the handler call
 struct ClientRequest
 {
 	std::string connectionId;
 	MikanRequestID requestId;
-	std::string utf8RequestString;
+
+	// Set when the request was sent as json text
+	const char* utf8RequestData= nullptr;
+	size_t utf8RequestSize= 0;
+
+	// Set (instead of utf8RequestData) when the request was sent binary encoded
+	const uint8_t* binaryRequestData= nullptr;
+	size_t binaryRequestSize= 0;
+
+	// The request already deserialized by the dispatcher (unset if that failed),
+	// so readTypedRequest doesn't have to parse the request again
+	const struct MikanRequest* parsedRequest= nullptr;
 };
 
 struct ClientResponse
@@ -35,8 +49,66 @@ struct ClientResponse
 	std::vector<uint8_t> binaryData;
 };
 
+// What to do when a client's outbound queue is over its byte limit
+enum class OutboundDropPolicy
+{
+	DropOldest,	// Drop the oldest queued events to make room for the new one
+	DropNewest,	// Drop the event being sent
+	Disconnect	// Disconnect the client
+};
+
+struct OutboundQueueSettings
+{
+	// Messages are queued instead of sent once the socket has this many unsent bytes
+	size_t maxSocketBufferedBytes= 256 * 1024;
+	// Events are dropped (following dropPolicy) once the queue holds this many bytes.
+	// Responses are never dropped, except by OutboundDropPolicy::Disconnect.
+	size_t maxQueuedBytes= 4 * 1024 * 1024;
+	OutboundDropPolicy dropPolicy= OutboundDropPolicy::DropOldest;
+};
+
+struct OutboundQueueStats
+{
+	size_t queuedMessageCount= 0;
+	size_t queuedBytes= 0;
+	uint64_t droppedMessageCount= 0;
+	uint64_t coalescedMessageCount= 0;
+};
+
 using SocketEventHandler = std::function<void(const ClientSocketEvent& event)>;
-using RequestHandler = std::function<void(const ClientRequest& request, ClientResponse& response)>;
+// Brings the server state snapshot up to date with the requests handled so far (main thread only)
+using StateSnapshotPublisher = std::function<void()>;
+
+// Calls a request handler member function directly, without std::function / std::bind indirection.
+// Made with RequestHandler::bind<&Class::handlerMethod>(object).
+class RequestHandler
+{
+public:
+	using InvokeFunction = void (*)(void* target, const ClientRequest& request, ClientResponse& response);
+
+	RequestHandler() = default;
+
+	template <auto t_method, typename t_class>
+	static RequestHandler bind(t_class* target)
+	{
+		RequestHandler handler;
+		handler.m_target = target;
+		handler.m_invoke = [](void* object, const ClientRequest& request, ClientResponse& response) {
+			(static_cast<t_class*>(object)->*t_method)(request, response);
+		};
+
+		return handler;
+	}
+
+	inline void operator()(const ClientRequest& request, ClientResponse& response) const
+	{
+		m_invoke(m_target, request, response);
+	}
+
+private:
+	void* m_target= nullptr;
+	InvokeFunction m_invoke= nullptr;
+};
 
 class IInterprocessMessageServer
 {
@@ -46,10 +118,41 @@ public:
 	virtual bool initialize() = 0;
 	virtual void dispose() = 0;
 	virtual void setSocketEventHandler(const std::string& eventType, SocketEventHandler handler) = 0;
-	virtual void setRequestHandler(std::size_t requestTypeId, RequestHandler handler) = 0;
+	// Read-only handlers must only read the published server state snapshot (never live editor state),
+	// which lets them run on the request worker pool instead of the main thread
+	virtual void setRequestHandler(std::size_t requestTypeId, RequestHandler handler, bool bIsReadOnly= false) = 0;
+	// Without a worker pool every request is handled on the main thread
+	virtual void setRequestWorkerPool(class RequestWorkerPool* workerPool) = 0;
+	// Called before a read-only request is handled whenever other requests ran since the last call,
+	// so a client always reads the effects of its own earlier requests
+	virtual void setStateSnapshotPublisher(StateSnapshotPublisher publisher) = 0;
+	// Runs the handler registered for the request type on the calling thread, returns false if there isn't one.
+	// A read-only handler gets the state snapshot published first, so it sees the requests handled before it.
+	virtual bool invokeRequestHandler(
+		std::size_t requestTypeId, 
+		const ClientRequest& request, 
+		ClientResponse& response) = 0;
+
+	virtual void setOutboundQueueSettings(const OutboundQueueSettings& settings) = 0;
+	virtual bool getOutboundQueueStats(const std::string& connectionId, OutboundQueueStats& outStats) = 0;
 
-	virtual void sendMessageToClient(const std::string& connectionId, const std::string& message) = 0;
+	// A message with a non-zero coalesceKey replaces any message with the same key
+	// still waiting in a client's outbound queue (i.e. only the latest value is sent)
+	virtual void sendMessageToClient(
+		const std::string& connectionId, 
+		const std::string& message, 
+		uint64_t coalesceKey= 0) = 0;
+	// Sends one already serialized message to each of the given connections.
+	// A message that isn't droppable stays queued like a response when the client falls behind.
+	virtual void sendMessageToClients(
+		const std::vector<std::string>& connectionIds, 
+		const std::string& message, 
+		uint64_t coalesceKey= 0,
+		bool bIsDroppable= true) = 0;
 	virtual void sendMessageToAllClients(const std::string& message) = 0;
+	// Sends a binary response outside of the request that produced it (never dropped)
+	virtual void sendBinaryResponseToClient(const std::string& connectionId, const std::vector<uint8_t>& binaryData) = 0;
 	virtual void processSocketEvents() = 0;
 	virtual void processRequests() = 0;
+	virtual void flushOutboundMessages() = 0;
 };
\ No newline at end of file
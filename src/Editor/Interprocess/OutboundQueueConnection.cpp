@@ -0,0 +1,174 @@
+#include "OutboundQueueConnection.h"
+#include "Logger.h"
+
+void OutboundQueueConnection::queueText(
+	const std::string& textData,
+	uint64_t coalesceKey,
+	bool bIsDroppable,
+	const OutboundQueueSettings& settings)
+{
+	std::lock_guard<std::mutex> lock(m_outboundMutex);
+
+	if (canSendImmediately(settings))
+	{
+		sendText(textData);
+		return;
+	}
+
+	OutboundMessage message;
+	message.text = textData;
+	message.bIsDroppable = bIsDroppable;
+	message.coalesceKey = coalesceKey;
+	queueMessage(std::move(message), settings);
+}
+
+void OutboundQueueConnection::queueBinaryData(
+	const std::vector<uint8_t>& binaryData,
+	bool bIsDroppable,
+	const OutboundQueueSettings& settings)
+{
+	std::lock_guard<std::mutex> lock(m_outboundMutex);
+
+	if (canSendImmediately(settings))
+	{
+		sendBinaryData(binaryData);
+		return;
+	}
+
+	OutboundMessage message;
+	message.binaryData = binaryData;
+	message.bIsBinary = true;
+	message.bIsDroppable = bIsDroppable;
+	queueMessage(std::move(message), settings);
+}
+
+void OutboundQueueConnection::flushOutboundQueue(const OutboundQueueSettings& settings)
+{
+	std::lock_guard<std::mutex> lock(m_outboundMutex);
+
+	while (!m_outboundQueue.empty() && getSocketBufferedBytes() < settings.maxSocketBufferedBytes)
+	{
+		OutboundMessage& message = m_outboundQueue.front();
+
+		if (message.bIsBinary)
+		{
+			sendBinaryData(message.binaryData);
+		}
+		else
+		{
+			sendText(message.text);
+		}
+
+		m_outboundStats.queuedBytes -= message.getSize();
+		m_outboundQueue.pop_front();
+	}
+
+	if (m_outboundQueue.empty())
+	{
+		m_bIsDroppingMessages = false;
+	}
+}
+
+OutboundQueueStats OutboundQueueConnection::getOutboundStats() const
+{
+	std::lock_guard<std::mutex> lock(m_outboundMutex);
+
+	OutboundQueueStats stats = m_outboundStats;
+	stats.queuedMessageCount = m_outboundQueue.size();
+
+	return stats;
+}
+
+bool OutboundQueueConnection::canSendImmediately(const OutboundQueueSettings& settings) const
+{
+	return m_outboundQueue.empty() && getSocketBufferedBytes() < settings.maxSocketBufferedBytes;
+}
+
+void OutboundQueueConnection::queueMessage(OutboundMessage&& message, const OutboundQueueSettings& settings)
+{
+	const size_t messageSize = message.getSize();
+
+	// Latest-value messages replace the queued one with the same key, keeping its place in line
+	if (message.coalesceKey != 0)
+	{
+		for (OutboundMessage& queuedMessage : m_outboundQueue)
+		{
+			if (queuedMessage.coalesceKey == message.coalesceKey)
+			{
+				m_outboundStats.queuedBytes = m_outboundStats.queuedBytes - queuedMessage.getSize() + messageSize;
+				m_outboundStats.coalescedMessageCount++;
+				queuedMessage = std::move(message);
+				return;
+			}
+		}
+	}
+
+	if (m_outboundStats.queuedBytes + messageSize > settings.maxQueuedBytes)
+	{
+		switch (settings.dropPolicy)
+		{
+			case OutboundDropPolicy::DropOldest:
+				{
+					auto it = m_outboundQueue.begin();
+					while (it != m_outboundQueue.end() &&
+						   m_outboundStats.queuedBytes + messageSize > settings.maxQueuedBytes)
+					{
+						if (it->bIsDroppable)
+						{
+							m_outboundStats.queuedBytes -= it->getSize();
+							it = m_outboundQueue.erase(it);
+							onMessageDropped();
+						}
+						else
+						{
+							++it;
+						}
+					}
+
+					// Only responses are left in the queue
+					if (m_outboundStats.queuedBytes + messageSize > settings.maxQueuedBytes &&
+						message.bIsDroppable)
+					{
+						onMessageDropped();
+						return;
+					}
+				}
+				break;
+			case OutboundDropPolicy::DropNewest:
+				if (message.bIsDroppable)
+				{
+					onMessageDropped();
+					return;
+				}
+				break;
+			case OutboundDropPolicy::Disconnect:
+				{
+					MIKAN_MT_LOG_WARNING("OutboundQueueConnection::queueMessage")
+						<< "Disconnecting " << getConnectionId() << ", outbound queue is over " 
+						<< settings.maxQueuedBytes << " bytes";
+
+					m_outboundStats.droppedMessageCount += m_outboundQueue.size() + 1;
+					m_outboundStats.queuedBytes = 0;
+					m_outboundQueue.clear();
+					disconnect();
+				}
+				return;
+		}
+	}
+
+	m_outboundStats.queuedBytes += messageSize;
+	m_outboundQueue.push_back(std::move(message));
+}
+
+void OutboundQueueConnection::onMessageDropped()
+{
+	m_outboundStats.droppedMessageCount++;
+
+	// Warn once each time the client falls behind, rather than on every dropped message
+	if (!m_bIsDroppingMessages)
+	{
+		MIKAN_MT_LOG_WARNING("OutboundQueueConnection::onMessageDropped")
+			<< "Client " << getConnectionId() << " is not keeping up, dropping events";
+		m_bIsDroppingMessages = true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "InterprocessMessageServerInterface.h"
+
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// A message waiting for room in the client's socket send buffer
+struct OutboundMessage
+{
+	std::string text;
+	std::vector<uint8_t> binaryData;
+	bool bIsBinary= false;
+	bool bIsDroppable= true;
+	uint64_t coalesceKey= 0;
+
+	inline size_t getSize() const { return bIsBinary ? binaryData.size() : text.size(); }
+};
+
+// Per client outbound queue shared by the transports.
+// Outbound messages are queued from the main thread and (for responses) the request worker threads.
+// They go straight to the socket until it backs up, then wait in the outbound queue.
+class OutboundQueueConnection
+{
+public:
+	virtual ~OutboundQueueConnection() {}
+
+	virtual const std::string& getConnectionId() const = 0;
+	virtual bool sendText(const std::string& textData) = 0;
+	virtual bool sendBinaryData(const std::vector<uint8_t>& binaryData) = 0;
+	virtual bool disconnect() = 0;
+
+	void queueText(
+		const std::string& textData,
+		uint64_t coalesceKey,
+		bool bIsDroppable,
+		const OutboundQueueSettings& settings);
+	void queueBinaryData(
+		const std::vector<uint8_t>& binaryData,
+		bool bIsDroppable,
+		const OutboundQueueSettings& settings);
+
+	// Sends queued messages until the socket backs up again
+	void flushOutboundQueue(const OutboundQueueSettings& settings);
+
+	OutboundQueueStats getOutboundStats() const;
+
+protected:
+	// Bytes handed to the socket that it hasn't sent yet
+	virtual size_t getSocketBufferedBytes() const = 0;
+
+	bool canSendImmediately(const OutboundQueueSettings& settings) const;
+	void queueMessage(OutboundMessage&& message, const OutboundQueueSettings& settings);
+	void onMessageDropped();
+
+private:
+	// Guards the queue and keeps queued and immediate sends in order across threads
+	mutable std::mutex m_outboundMutex;
+	std::deque<OutboundMessage> m_outboundQueue;
+	OutboundQueueStats m_outboundStats;
+	bool m_bIsDroppingMessages= false;
+};
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "InterprocessMessageServerInterface.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Request handlers keyed by request type id, looked up once for every incoming request.
+// Open addressing with linear probing in a power of two sized array, kept at most half full,
+// so a lookup is usually a single probe into contiguous memory.
+// Filled in at startup, after that lookups are safe from any thread.
+class RequestHandlerTable
+{
+public:
+	struct Entry
+	{
+		// Zero marks an empty slot (never a valid request type id)
+		std::size_t requestTypeId= 0;
+		RequestHandler handler;
+		bool bIsReadOnly= false;
+	};
+
+	void setHandler(std::size_t requestTypeId, RequestHandler handler, bool bIsReadOnly)
+	{
+		if (requestTypeId == 0)
+			return;
+
+		if ((m_entryCount + 1) * 2 > m_entries.size())
+		{
+			rehash(m_entries.empty() ? k_minCapacity : m_entries.size() * 2);
+		}
+
+		Entry& entry = m_entries[findIndex(requestTypeId)];
+		if (entry.requestTypeId == 0)
+		{
+			entry.requestTypeId = requestTypeId;
+			++m_entryCount;
+		}
+
+		entry.handler = handler;
+		entry.bIsReadOnly = bIsReadOnly;
+	}
+
+	// Returns nullptr if there is no handler for the request type
+	const Entry* find(std::size_t requestTypeId) const
+	{
+		if (m_entries.empty() || requestTypeId == 0)
+			return nullptr;
+
+		const Entry& entry = m_entries[findIndex(requestTypeId)];
+
+		return entry.requestTypeId != 0 ? &entry : nullptr;
+	}
+
+private:
+	static const std::size_t k_minCapacity = 64;
+
+	// Returns the index of the type id's entry, or of the empty slot it would go in
+	std::size_t findIndex(std::size_t requestTypeId) const
+	{
+		const std::size_t mask = m_entries.size() - 1;
+
+		// Fibonacci hashing spreads the type ids over the top bits
+		std::size_t index = (std::size_t)(((uint64_t)requestTypeId * 0x9E3779B97F4A7C15ull) >> m_hashShift);
+		while (m_entries[index].requestTypeId != requestTypeId && m_entries[index].requestTypeId != 0)
+		{
+			index = (index + 1) & mask;
+		}
+
+		return index;
+	}
+
+	void rehash(std::size_t capacity)
+	{
+		std::vector<Entry> oldEntries;
+		oldEntries.swap(m_entries);
+
+		m_entries.resize(capacity);
+		m_hashShift = 64;
+		for (std::size_t size = capacity; size > 1; size >>= 1)
+		{
+			--m_hashShift;
+		}
+
+		for (const Entry& entry : oldEntries)
+		{
+			if (entry.requestTypeId != 0)
+			{
+				m_entries[findIndex(entry.requestTypeId)] = entry;
+			}
+		}
+	}
+
+	std::vector<Entry> m_entries;
+	std::size_t m_entryCount= 0;
+	unsigned int m_hashShift= 64;
+};
\ No newline at end of file
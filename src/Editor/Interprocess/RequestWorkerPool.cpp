@@ -0,0 +1,123 @@
+#include "RequestWorkerPool.h"
+#include "Logger.h"
+#include "WorkerThread.h"
+
+#include <easy/profiler.h>
+
+#include <chrono>
+#include <string>
+
+// How long an idle worker sleeps before checking its exit flag again
+#define REQUEST_WORKER_IDLE_TIMEOUT_MS		100
+
+class RequestWorkerThread : public WorkerThread
+{
+public:
+	RequestWorkerThread(RequestWorkerPool* ownerPool, int workerIndex)
+		: WorkerThread("RequestWorker" + std::to_string(workerIndex))
+		, m_ownerPool(ownerPool)
+	{}
+
+protected:
+	virtual void onThreadHaltBegin() override
+	{
+		m_ownerPool->wakeAllWorkers();
+	}
+
+	virtual bool doWork() override
+	{
+		m_ownerPool->runNextJob(REQUEST_WORKER_IDLE_TIMEOUT_MS);
+
+		return true;
+	}
+
+private:
+	RequestWorkerPool* m_ownerPool;
+};
+
+RequestWorkerPool::RequestWorkerPool()
+{
+}
+
+RequestWorkerPool::~RequestWorkerPool()
+{
+	shutdown();
+}
+
+bool RequestWorkerPool::startup(int workerCount)
+{
+	if (getIsRunning())
+	{
+		MIKAN_LOG_WARNING("RequestWorkerPool::startup") << "Worker pool already started";
+		return false;
+	}
+
+	for (int workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+	{
+		RequestWorkerThread* worker = new RequestWorkerThread(this, workerIndex);
+
+		worker->startThread();
+		m_workers.push_back(worker);
+	}
+
+	return getIsRunning();
+}
+
+void RequestWorkerPool::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_pendingJobsMutex);
+
+		m_pendingJobs.clear();
+	}
+
+	for (RequestWorkerThread* worker : m_workers)
+	{
+		worker->stopThread();
+		delete worker;
+	}
+	m_workers.clear();
+}
+
+void RequestWorkerPool::submitJob(Job&& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_pendingJobsMutex);
+
+		m_pendingJobs.push_back(std::move(job));
+	}
+
+	m_pendingJobsCondition.notify_one();
+}
+
+bool RequestWorkerPool::runNextJob(int timeoutMilliseconds)
+{
+	Job job;
+
+	{
+		std::unique_lock<std::mutex> lock(m_pendingJobsMutex);
+
+		if (m_pendingJobs.empty())
+		{
+			m_pendingJobsCondition.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds));
+		}
+
+		if (m_pendingJobs.empty())
+		{
+			return false;
+		}
+
+		job = std::move(m_pendingJobs.front());
+		m_pendingJobs.pop_front();
+	}
+
+	EASY_BLOCK("RequestWorkerPool::runJob");
+	job();
+
+	return true;
+}
+
+void RequestWorkerPool::wakeAllWorkers()
+{
+	m_pendingJobsCondition.notify_all();
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Runs jobs (read-only request handlers) on a fixed set of worker threads,
+// so they don't hold up the main (UI/render) thread.
+class RequestWorkerPool
+{
+public:
+	using Job = std::function<void()>;
+
+	RequestWorkerPool();
+	virtual ~RequestWorkerPool();
+
+	bool startup(int workerCount);
+	// Jobs not started yet are dropped, blocks until running jobs finish
+	void shutdown();
+
+	inline bool getIsRunning() const { return !m_workers.empty(); }
+	void submitJob(Job&& job);
+
+protected:
+	friend class RequestWorkerThread;
+
+	// Runs the next job, waiting up to the timeout for one. Returns false if there was none.
+	bool runNextJob(int timeoutMilliseconds);
+	void wakeAllWorkers();
+
+private:
+	std::vector<class RequestWorkerThread*> m_workers;
+
+	std::deque<Job> m_pendingJobs;
+	std::mutex m_pendingJobsMutex;
+	std::condition_variable m_pendingJobsCondition;
+};
\ No newline at end of file
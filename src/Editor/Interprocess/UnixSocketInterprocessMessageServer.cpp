@@ -0,0 +1,619 @@
+#include "UnixSocketInterprocessMessageServer.h"
+#include "ClientRequestDispatch.h"
+#include "OutboundQueueConnection.h"
+#include "RequestWorkerPool.h"
+#include "UnixSocketUtils.h"
+#include "Logger.h"
+#include "StringUtils.h"
+#include "ThreadUtils.h"
+#include "Version.h"
+
+#include "readerwriterqueue.h"
+
+#include <easy/profiler.h>
+
+#include <sstream>
+
+using namespace UnixSocketUtils;
+
+using LockFreeMessageQueue = moodycamel::ReaderWriterQueue<std::string>;
+using LockFreeRequestQueue = moodycamel::ReaderWriterQueue<ClientRequestMessage>;
+
+static const int k_socketPollTimeoutMilliseconds = 100;
+static const char* k_normalClosureArgs = "1000:Normal closure";
+
+static SocketHandle toSocketHandle(uint64_t opaqueSocket)
+{
+	return (SocketHandle)opaqueSocket;
+}
+
+static uint64_t fromSocketHandle(SocketHandle socketHandle)
+{
+	return (uint64_t)socketHandle;
+}
+
+//-- UnixSocketClientConnection -----
+class UnixSocketClientConnection : public OutboundQueueConnection
+{
+public:
+	UnixSocketClientConnection(const std::string& connectionId, SocketHandle socketHandle)
+		: m_connectionId(connectionId)
+		, m_socket(socketHandle)
+		, m_bStopRequested(false)
+		, m_bLocalCloseRequested(false)
+	{}
+
+	virtual ~UnixSocketClientConnection()
+	{
+		m_bStopRequested = true;
+		shutdownSocket(m_socket);
+
+		if (m_readerThread.joinable())
+		{
+			m_readerThread.join();
+		}
+
+		closeSocket(m_socket);
+	}
+
+	void startReaderThread()
+	{
+		// The connection owns the thread and joins it on destruction, so it can't outlive "this"
+		m_readerThread = std::thread(&UnixSocketClientConnection::readerThreadFunc, this);
+	}
+
+	const std::string& getConnectionId() const override { return m_connectionId; }
+
+	inline LockFreeMessageQueue& getSocketEventQueue() { return m_socketEventQueue; }
+	inline LockFreeRequestQueue& getRequestQueue() { return m_requestQueue; }
+
+	bool disconnect() override
+	{
+		// Set before the client can react to the close frame
+		m_bLocalCloseRequested = true;
+		sendFrame(eFrameType::close, k_normalClosureArgs, strlen(k_normalClosureArgs));
+
+		{
+			std::lock_guard<std::mutex> lock(m_sendMutex);
+
+			if (m_bIsClosed)
+				return false;
+
+			m_bIsClosed = true;
+		}
+
+		// The reader thread sees the connection close and posts the disconnect event
+		shutdownSocket(m_socket);
+
+		return true;
+	}
+
+	bool sendText(const std::string& textData) override
+	{
+		return sendFrame(eFrameType::text, textData.data(), textData.size());
+	}
+
+	bool sendBinaryData(const std::vector<uint8_t>& binaryData) override
+	{
+		return sendFrame(eFrameType::binary, binaryData.data(), binaryData.size());
+	}
+
+	// Writes out as much of the pending send buffer as the socket will take without blocking
+	void flushSendBuffer()
+	{
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+
+		flushSendBufferLocked();
+	}
+
+protected:
+	size_t getSocketBufferedBytes() const override
+	{
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+
+		return m_sendBuffer.size() - m_sendOffset;
+	}
+
+	bool sendFrame(eFrameType frameType, const void* payload, size_t payloadSize)
+	{
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+
+		if (m_bIsClosed || m_bSendFailed)
+			return false;
+
+		appendFrame(m_sendBuffer, frameType, payload, payloadSize);
+		flushSendBufferLocked();
+
+		return !m_bSendFailed;
+	}
+
+	void flushSendBufferLocked()
+	{
+		if (m_sendOffset >= m_sendBuffer.size() || m_bSendFailed)
+			return;
+
+		int64_t sent = sendSome(m_socket, m_sendBuffer.data() + m_sendOffset, m_sendBuffer.size() - m_sendOffset);
+		if (sent < 0)
+		{
+			// The reader thread notices the broken connection and posts the disconnect event
+			m_bSendFailed = true;
+			return;
+		}
+
+		m_sendOffset += (size_t)sent;
+		if (m_sendOffset == m_sendBuffer.size())
+		{
+			m_sendBuffer.clear();
+			m_sendOffset = 0;
+		}
+	}
+
+	void readerThreadFunc()
+	{
+		ThreadUtils::setCurrentThreadName("UnixSocketClientConnection");
+
+		FrameReader frameReader;
+		std::vector<uint8_t> readBuffer(64 * 1024);
+		std::string closeArgs = "1006:Connection lost";
+
+		while (!m_bStopRequested)
+		{
+			const int pollResult = pollSocket(m_socket, false, k_socketPollTimeoutMilliseconds);
+			if (pollResult < 0)
+				break;
+			if (pollResult == 0)
+				continue;
+
+			const int64_t received = recvSome(m_socket, readBuffer.data(), readBuffer.size());
+			if (received < 0)
+				break;
+
+			frameReader.append(readBuffer.data(), (size_t)received);
+
+			eFrameType frameType;
+			std::string payload;
+			bool bIsClosing = false;
+			while (!bIsClosing && frameReader.tryReadFrame(frameType, payload))
+			{
+				switch (frameType)
+				{
+					case eFrameType::handshake:
+						{
+							MIKAN_MT_LOG_TRACE("UnixSocketClientConnection::readerThreadFunc")
+								<< "New connection " << m_connectionId << ", protocol: " << payload;
+
+							// Reply with the latest version of the protocol
+							std::stringstream ss;
+							ss << WEBSOCKET_PROTOCOL_PREFIX << MIKAN_SERVER_API_VERSION;
+							const std::string serverProtocol = ss.str();
+							sendFrame(eFrameType::handshake, serverProtocol.data(), serverProtocol.size());
+
+							m_socketEventQueue.enqueue(std::string(WEBSOCKET_CONNECT_EVENT) + ":" + payload);
+						}
+						break;
+					case eFrameType::text:
+						m_requestQueue.enqueue({std::move(payload), false});
+						break;
+					case eFrameType::binary:
+						m_requestQueue.enqueue({std::move(payload), true});
+						break;
+					case eFrameType::close:
+						closeArgs = payload;
+						bIsClosing = true;
+						break;
+				}
+			}
+
+			if (bIsClosing)
+				break;
+
+			if (frameReader.getHasError())
+			{
+				MIKAN_MT_LOG_WARNING("UnixSocketClientConnection::readerThreadFunc")
+					<< "Corrupt frame from " << m_connectionId << ", closing connection";
+				m_socketEventQueue.enqueue(std::string(WEBSOCKET_ERROR_EVENT) + ":Corrupt frame");
+				closeArgs = "1002:Protocol error";
+				break;
+			}
+		}
+
+		if (m_bLocalCloseRequested)
+		{
+			closeArgs = k_normalClosureArgs;
+		}
+
+		MIKAN_MT_LOG_TRACE("UnixSocketClientConnection::readerThreadFunc")
+			<< "Close connection " << m_connectionId << ": " << closeArgs;
+		m_socketEventQueue.enqueue(std::string(WEBSOCKET_DISCONNECT_EVENT) + ":" + closeArgs);
+	}
+
+private:
+	std::string m_connectionId;
+	SocketHandle m_socket;
+	std::thread m_readerThread;
+	std::atomic_bool m_bStopRequested;
+	std::atomic_bool m_bLocalCloseRequested;
+	bool m_bIsClosed= false;
+
+	// Socket events and requests, posted by the reader thread for the main thread
+	LockFreeMessageQueue m_socketEventQueue;
+	LockFreeRequestQueue m_requestQueue;
+
+	// Frames the socket hasn't accepted yet (written to by the main and reader threads)
+	mutable std::mutex m_sendMutex;
+	std::vector<uint8_t> m_sendBuffer;
+	size_t m_sendOffset= 0;
+	bool m_bSendFailed= false;
+};
+
+//-- UnixSocketInterprocessMessageServer -----
+UnixSocketInterprocessMessageServer::UnixSocketInterprocessMessageServer(const std::string& socketPath)
+	: m_socketPath(socketPath.empty() ? getDefaultSocketPath() : socketPath)
+	, m_listenSocket(fromSocketHandle(k_invalidSocket))
+	, m_bStopRequested(false)
+{}
+
+UnixSocketInterprocessMessageServer::~UnixSocketInterprocessMessageServer()
+{
+	dispose();
+}
+
+bool UnixSocketInterprocessMessageServer::initialize()
+{
+	std::string error;
+	SocketHandle listenSocket = openListenSocket(m_socketPath, error);
+	if (listenSocket == k_invalidSocket)
+	{
+		MIKAN_LOG_WARNING("UnixSocketInterprocessMessageServer::initialize()") << error;
+		return false;
+	}
+
+	m_listenSocket = fromSocketHandle(listenSocket);
+	m_bStopRequested = false;
+	m_acceptThread = std::thread(&UnixSocketInterprocessMessageServer::acceptThreadFunc, this);
+
+	MIKAN_LOG_INFO("UnixSocketInterprocessMessageServer::initialize()") 
+		<< "Listening on " << m_socketPath;
+
+	return true;
+}
+
+void UnixSocketInterprocessMessageServer::dispose()
+{
+	if (m_acceptThread.joinable())
+	{
+		m_bStopRequested = true;
+		m_acceptThread.join();
+	}
+
+	if (toSocketHandle(m_listenSocket) != k_invalidSocket)
+	{
+		closeSocket(toSocketHandle(m_listenSocket));
+		m_listenSocket = fromSocketHandle(k_invalidSocket);
+
+		std::error_code error;
+		std::filesystem::remove(m_socketPath, error);
+	}
+
+	// Close down all connections
+	std::vector<UnixSocketClientConnectionPtr> connections;
+	getConnectionList(connections);
+
+	for (UnixSocketClientConnectionPtr connection : connections)
+	{
+		connection->disconnect();
+	}
+
+	// Dropping the last reference joins each connection's reader thread
+	{
+		std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+		m_connections.clear();
+	}
+}
+
+void UnixSocketInterprocessMessageServer::acceptThreadFunc()
+{
+	ThreadUtils::setCurrentThreadName("UnixSocketAcceptThread");
+
+	const SocketHandle listenSocket = toSocketHandle(m_listenSocket);
+
+	while (!m_bStopRequested)
+	{
+		if (pollSocket(listenSocket, false, k_socketPollTimeoutMilliseconds) <= 0)
+			continue;
+
+		SocketHandle clientSocket = ::accept(listenSocket, nullptr, nullptr);
+		if (clientSocket == k_invalidSocket)
+			continue;
+
+		if (!setNonBlocking(clientSocket))
+		{
+			MIKAN_MT_LOG_WARNING("UnixSocketInterprocessMessageServer::acceptThreadFunc")
+				<< "Failed to make client socket non-blocking, error " << getLastSocketError();
+			closeSocket(clientSocket);
+			continue;
+		}
+
+		const std::string connectionId = "uds-" + std::to_string(m_nextConnectionIndex++);
+		UnixSocketClientConnectionPtr connection =
+			std::make_shared<UnixSocketClientConnection>(connectionId, clientSocket);
+
+		// Add the connection before any of its events can be posted
+		{
+			std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+			m_connections[connectionId] = connection;
+		}
+
+		connection->startReaderThread();
+	}
+}
+
+void UnixSocketInterprocessMessageServer::setSocketEventHandler(
+	const std::string& eventType, 
+	SocketEventHandler handler)
+{
+	m_socketEventHandlers[eventType] = handler;
+}
+
+void UnixSocketInterprocessMessageServer::setRequestHandler(
+	std::size_t requestTypeId, 
+	RequestHandler handler,
+	bool bIsReadOnly)
+{
+	m_requestHandlers.setHandler(requestTypeId, handler, bIsReadOnly);
+}
+
+void UnixSocketInterprocessMessageServer::setRequestWorkerPool(RequestWorkerPool* workerPool)
+{
+	m_requestWorkerPool= workerPool;
+}
+
+void UnixSocketInterprocessMessageServer::setStateSnapshotPublisher(StateSnapshotPublisher publisher)
+{
+	m_stateSnapshotPublisher= publisher;
+}
+
+bool UnixSocketInterprocessMessageServer::invokeRequestHandler(
+	std::size_t requestTypeId,
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	const RequestHandlerTable::Entry* entry = m_requestHandlers.find(requestTypeId);
+	if (entry != nullptr)
+	{
+		// The read-only handler runs inline against the snapshot, which has to include
+		// whatever the requests handled just before it changed (only rebuilt if dirty)
+		if (entry->bIsReadOnly && m_stateSnapshotPublisher)
+		{
+			m_stateSnapshotPublisher();
+		}
+
+		entry->handler(request, response);
+		return true;
+	}
+
+	return false;
+}
+
+void UnixSocketInterprocessMessageServer::getConnectionList(std::vector<UnixSocketClientConnectionPtr>& outConnections)
+{
+	std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+	for (auto& connection_it : m_connections)
+	{
+		if (connection_it.second)
+		{
+			outConnections.push_back(connection_it.second);
+		}
+	}
+}
+
+UnixSocketClientConnectionPtr UnixSocketInterprocessMessageServer::findConnection(const std::string& connectionId)
+{
+	std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+	auto connection_it = m_connections.find(connectionId);
+	if (connection_it != m_connections.end())
+	{
+		return connection_it->second;
+	}
+
+	return nullptr;
+}
+
+void UnixSocketInterprocessMessageServer::removeConnection(const std::string& connectionId)
+{
+	std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+	m_connections.erase(connectionId);
+}
+
+void UnixSocketInterprocessMessageServer::setOutboundQueueSettings(const OutboundQueueSettings& settings)
+{
+	m_outboundQueueSettings = settings;
+}
+
+bool UnixSocketInterprocessMessageServer::getOutboundQueueStats(
+	const std::string& connectionId, 
+	OutboundQueueStats& outStats)
+{
+	UnixSocketClientConnectionPtr connection= findConnection(connectionId);
+
+	if (connection)
+	{
+		outStats = connection->getOutboundStats();
+		return true;
+	}
+
+	return false;
+}
+
+void UnixSocketInterprocessMessageServer::sendMessageToClient(
+	const std::string& connectionId, 
+	const std::string& message,
+	uint64_t coalesceKey)
+{
+	UnixSocketClientConnectionPtr connection= findConnection(connectionId);
+
+	if (connection)
+	{
+		connection->queueText(message, coalesceKey, true, m_outboundQueueSettings);
+	}
+}
+
+void UnixSocketInterprocessMessageServer::sendMessageToClients(
+	const std::vector<std::string>& connectionIds, 
+	const std::string& message,
+	uint64_t coalesceKey,
+	bool bIsDroppable)
+{
+	EASY_FUNCTION();
+
+	// Look up every connection under a single lock, then send outside of it
+	std::vector<UnixSocketClientConnectionPtr> connections;
+	connections.reserve(connectionIds.size());
+	{
+		std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+		for (const std::string& connectionId : connectionIds)
+		{
+			auto connection_it = m_connections.find(connectionId);
+			if (connection_it != m_connections.end() && connection_it->second)
+			{
+				connections.push_back(connection_it->second);
+			}
+		}
+	}
+
+	for (UnixSocketClientConnectionPtr& connection : connections)
+	{
+		connection->queueText(message, coalesceKey, bIsDroppable, m_outboundQueueSettings);
+	}
+}
+
+void UnixSocketInterprocessMessageServer::sendMessageToAllClients(const std::string& message)
+{
+	std::vector<UnixSocketClientConnectionPtr> connections;
+	getConnectionList(connections);
+
+	for (UnixSocketClientConnectionPtr connection : connections)
+	{
+		connection->queueText(message, 0, true, m_outboundQueueSettings);
+	}
+}
+
+void UnixSocketInterprocessMessageServer::sendBinaryResponseToClient(
+	const std::string& connectionId, 
+	const std::vector<uint8_t>& binaryData)
+{
+	UnixSocketClientConnectionPtr connection= findConnection(connectionId);
+
+	if (connection)
+	{
+		connection->queueBinaryData(binaryData, false, m_outboundQueueSettings);
+	}
+}
+
+void UnixSocketInterprocessMessageServer::processSocketEvents()
+{
+	std::vector<UnixSocketClientConnectionPtr> connections;
+	getConnectionList(connections);
+
+	for (UnixSocketClientConnectionPtr connection : connections)
+	{
+		std::string inEventString;
+		while (connection->getSocketEventQueue().try_dequeue(inEventString))
+		{
+			// Split on the argument separator, first argument is the event type
+			std::vector<std::string> eventArgs= StringUtils::splitString(inEventString, ':');
+			if (eventArgs.size() == 0)
+			{
+				continue;
+			}
+
+			std::string eventType= eventArgs[0];
+			eventArgs.erase(eventArgs.begin());
+
+			auto handler_it = m_socketEventHandlers.find(eventType);
+			if (handler_it != m_socketEventHandlers.end())
+			{
+				ClientSocketEvent socketEvent = {connection->getConnectionId(), eventType, eventArgs};
+				handler_it->second(socketEvent);
+			}
+
+			// Closed connections no longer need to be looked up
+			if (eventType == WEBSOCKET_DISCONNECT_EVENT)
+			{
+				removeConnection(connection->getConnectionId());
+				break;
+			}
+		}
+	}
+}
+
+void UnixSocketInterprocessMessageServer::processRequests()
+{
+	std::vector<UnixSocketClientConnectionPtr> connections;
+	getConnectionList(connections);
+
+	// Set once a request that may have changed server state ran, until the snapshot is published again
+	bool bHasUnpublishedRequests= false;
+
+	for (UnixSocketClientConnectionPtr connection : connections)
+	{
+		ClientRequestMessage inRequest;
+		while (connection->getRequestQueue().try_dequeue(inRequest))
+		{
+			int64_t requestTypeId;
+			int requestId;
+			if (!ClientRequestDispatch::parseRequest(inRequest, requestTypeId, requestId))
+			{
+				continue;
+			}
+
+			const RequestHandlerTable::Entry* entry = m_requestHandlers.find(requestTypeId);
+			const bool bIsReadOnly = entry != nullptr && entry->bIsReadOnly;
+
+			// Read-only handlers must see the effects of the requests handled before them
+			if (bIsReadOnly && bHasUnpublishedRequests)
+			{
+				if (m_stateSnapshotPublisher)
+				{
+					m_stateSnapshotPublisher();
+				}
+				bHasUnpublishedRequests= false;
+			}
+
+			if (m_requestWorkerPool != nullptr && bIsReadOnly)
+			{
+				ClientRequestDispatch::dispatchRequestToWorker(
+					entry->handler, *m_requestWorkerPool, connection, connection->getConnectionId(),
+					std::move(inRequest), requestTypeId, requestId, m_outboundQueueSettings);
+			}
+			else
+			{
+				ClientRequestDispatch::dispatchRequest(
+					entry != nullptr ? &entry->handler : nullptr, *connection, inRequest, requestTypeId, requestId, 
+					m_responseBuffer, m_outboundQueueSettings);
+				bHasUnpublishedRequests= bHasUnpublishedRequests || !bIsReadOnly;
+			}
+		}
+	}
+}
+
+void UnixSocketInterprocessMessageServer::flushOutboundMessages()
+{
+	EASY_FUNCTION();
+
+	std::vector<UnixSocketClientConnectionPtr> connections;
+	getConnectionList(connections);
+
+	for (UnixSocketClientConnectionPtr connection : connections)
+	{
+		// Frames the socket couldn't take last time go out first
+		connection->flushSendBuffer();
+		connection->flushOutboundQueue(m_outboundQueueSettings);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "ClientRequestDispatch.h"
+#include "InterprocessMessageServerInterface.h"
+#include "RequestHandlerTable.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using UnixSocketClientConnectionPtr = std::shared_ptr<class UnixSocketClientConnection>;
+
+// Serves local clients over a Unix domain socket, as length prefixed frames.
+// Skips the websocket handshake and framing overhead of the websocket server.
+class UnixSocketInterprocessMessageServer : public IInterprocessMessageServer
+{
+public:
+	UnixSocketInterprocessMessageServer(const std::string& socketPath= "");
+	virtual ~UnixSocketInterprocessMessageServer();
+
+	inline const std::string& getSocketPath() const { return m_socketPath; }
+
+	bool initialize() override;
+	void dispose() override;
+	void setSocketEventHandler(const std::string& eventType, SocketEventHandler handler) override;
+	void setRequestHandler(std::size_t requestTypeId, RequestHandler handler, bool bIsReadOnly= false) override;
+	void setRequestWorkerPool(class RequestWorkerPool* workerPool) override;
+	void setStateSnapshotPublisher(StateSnapshotPublisher publisher) override;
+	bool invokeRequestHandler(
+		std::size_t requestTypeId, 
+		const ClientRequest& request, 
+		ClientResponse& response) override;
+
+	void setOutboundQueueSettings(const OutboundQueueSettings& settings) override;
+	bool getOutboundQueueStats(const std::string& connectionId, OutboundQueueStats& outStats) override;
+
+	void sendMessageToClient(
+		const std::string& connectionId, 
+		const std::string& message, 
+		uint64_t coalesceKey= 0) override;
+	void sendMessageToClients(
+		const std::vector<std::string>& connectionIds, 
+		const std::string& message, 
+		uint64_t coalesceKey= 0,
+		bool bIsDroppable= true) override;
+	void sendMessageToAllClients(const std::string& message) override;
+	void sendBinaryResponseToClient(const std::string& connectionId, const std::vector<uint8_t>& binaryData) override;
+	void processSocketEvents() override;
+	void processRequests() override;
+	void flushOutboundMessages() override;
+
+protected:
+	void acceptThreadFunc();
+	void getConnectionList(std::vector<UnixSocketClientConnectionPtr>& outConnections);
+	UnixSocketClientConnectionPtr findConnection(const std::string& connectionId);
+	void removeConnection(const std::string& connectionId);
+
+private:
+	std::string m_socketPath;
+	// UnixSocketUtils::SocketHandle, stored opaque to keep the socket headers out of this one
+	uint64_t m_listenSocket;
+	std::thread m_acceptThread;
+	std::atomic_bool m_bStopRequested;
+	int m_nextConnectionIndex= 0;
+
+	// Keyed by connection id ("uds-<index>")
+	std::unordered_map<std::string, UnixSocketClientConnectionPtr> m_connections;
+	std::mutex m_connectionsMutex;
+	std::map<std::string, SocketEventHandler> m_socketEventHandlers;
+	RequestHandlerTable m_requestHandlers;
+
+	OutboundQueueSettings m_outboundQueueSettings;
+
+	// Response buffers recycled across requests and frames (keeps their capacity)
+	ClientResponse m_responseBuffer;
+
+	// Read-only requests run on the worker pool, which sends their responses as soon as they're done
+	class RequestWorkerPool* m_requestWorkerPool= nullptr;
+	StateSnapshotPublisher m_stateSnapshotPublisher;
+};
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "WebsocketInterprocessMessageServer.h"
+#include "ClientRequestDispatch.h"
+#include "OutboundQueueConnection.h"
+#include "RequestWorkerPool.h"
 #include "JsonUtils.h"
+#include "MikanAPITypes.h"
 #include "MikanClientRequests.h"
 #include "MikanClientEvents.h"
 #include "MikanScriptEvents.h"
@@ -24,24 +28,29 @@
 
 #include "readerwriterqueue.h"
 
+#include <easy/profiler.h>
+
 #include <chrono>
 
 using json = nlohmann::json;
 
 using LockFreeMessageQueue = moodycamel::ReaderWriterQueue<std::string>;
 using LockFreeMessageQueuePtr = std::shared_ptr<LockFreeMessageQueue>;
+
+using LockFreeRequestQueue = moodycamel::ReaderWriterQueue<ClientRequestMessage>;
+using LockFreeRequestQueuePtr = std::shared_ptr<LockFreeRequestQueue>;
 using WebSocketWeakPtr = std::weak_ptr<ix::WebSocket>;
 using WebSocketPtr = std::shared_ptr<ix::WebSocket>;
 
 //-- WebSocketClientConnection -----
-class WebSocketClientConnection : public ix::ConnectionState
+class WebSocketClientConnection : public ix::ConnectionState, public OutboundQueueConnection
 {
 public:
 	WebSocketClientConnection(WebsocketInterprocessMessageServer* ownerMessageServer)
 		: ix::ConnectionState()
 		, m_ownerMessageServer(ownerMessageServer)
 		, m_socketEventQueue(std::make_shared<LockFreeMessageQueue>())
-		, m_requestQueue(std::make_shared<LockFreeMessageQueue>())
+		, m_requestQueue(std::make_shared<LockFreeRequestQueue>())
 	{}
 
 	void bindWebSocket(WebSocketWeakPtr websocket)
@@ -49,7 +58,12 @@ public:
 		m_websocket = websocket;
 	}
 
-	bool disconnect()
+	const std::string& getConnectionId() const override
+	{
+		return getId();
+	}
+
+	bool disconnect() override
 	{
 		WebSocketPtr websocket = m_websocket.lock();
 		if (websocket)
@@ -62,7 +76,7 @@ public:
 	}
 
 	inline LockFreeMessageQueuePtr getSocketEventQueue() { return m_socketEventQueue; }
-	inline LockFreeMessageQueuePtr getRequestQueue() { return m_requestQueue; }
+	inline LockFreeRequestQueuePtr getRequestQueue() { return m_requestQueue; }
 
 	void handleClientMessage(
 		ConnectionStatePtr connectionState,
@@ -125,16 +139,8 @@ public:
 				break;
 			case ix::WebSocketMessageType::Message:
 				{
-					if (!msg->binary)
-					{
-						// Enqueue the request json string
-						m_requestQueue->enqueue(msg->str);
-					}
-					else
-					{
-						MIKAN_MT_LOG_ERROR("WebSocketClientConnection::handleClientMessage")
-							<< "Received unsupported binary message";
-					}
+					// Enqueue the request json string or binary encoded request
+					m_requestQueue->enqueue({msg->str, msg->binary});
 				} break;
 			case ix::WebSocketMessageType::Error:
 				{
@@ -176,7 +182,7 @@ public:
 		return sendText(eventJsonString);
 	}
 
-	bool sendText(const std::string& textData)
+	bool sendText(const std::string& textData) override
 	{
 		WebSocketPtr websocket = m_websocket.lock();
 
@@ -190,7 +196,7 @@ public:
 		return false;
 	}
 
-	bool sendBinaryData(const std::vector<uint8_t>& binaryData)
+	bool sendBinaryData(const std::vector<uint8_t>& binaryData) override
 	{
 		WebSocketPtr websocket = m_websocket.lock();
 
@@ -205,10 +211,18 @@ public:
 		return false;
 	}
 
+protected:
+	size_t getSocketBufferedBytes() const override
+	{
+		WebSocketPtr websocket = m_websocket.lock();
+
+		return websocket ? websocket->bufferedAmount() : 0;
+	}
+
 private:
 	WebsocketInterprocessMessageServer* m_ownerMessageServer= nullptr;
 	LockFreeMessageQueuePtr m_socketEventQueue;
-	LockFreeMessageQueuePtr m_requestQueue;
+	LockFreeRequestQueuePtr m_requestQueue;
 	WebSocketWeakPtr m_websocket;
 };
 
@@ -277,7 +291,7 @@ bool WebsocketInterprocessMessageServer::initialize()
 			{
 				std::lock_guard<std::mutex> lock(ownerMessageServer->m_connectionsMutex);
 
-				ownerMessageServer->m_connections.push_back(clientConnectionState);
+				ownerMessageServer->m_connections[clientConnectionState->getId()] = clientConnectionState;
 			}
 		};
 
@@ -310,7 +324,7 @@ void WebsocketInterprocessMessageServer::dispose()
 		getConnectionList(connections);
 
 		// Disconnect all clients
-		for (WebSocketClientConnectionPtr connection : m_connections)
+		for (WebSocketClientConnectionPtr connection : connections)
 		{
 			connection->disconnect();
 		}
@@ -339,20 +353,53 @@ void WebsocketInterprocessMessageServer::setSocketEventHandler(
 
 void WebsocketInterprocessMessageServer::setRequestHandler(
 	std::size_t requestTypeId, 
-	RequestHandler handler)
+	RequestHandler handler,
+	bool bIsReadOnly)
 {
-	m_requestHandlers[requestTypeId] = handler;
+	m_requestHandlers.setHandler(requestTypeId, handler, bIsReadOnly);
+}
+
+void WebsocketInterprocessMessageServer::setRequestWorkerPool(RequestWorkerPool* workerPool)
+{
+	m_requestWorkerPool= workerPool;
+}
+
+void WebsocketInterprocessMessageServer::setStateSnapshotPublisher(StateSnapshotPublisher publisher)
+{
+	m_stateSnapshotPublisher= publisher;
+}
+
+bool WebsocketInterprocessMessageServer::invokeRequestHandler(
+	std::size_t requestTypeId,
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	const RequestHandlerTable::Entry* entry = m_requestHandlers.find(requestTypeId);
+	if (entry != nullptr)
+	{
+		// The read-only handler runs inline against the snapshot, which has to include
+		// whatever the requests handled just before it changed (only rebuilt if dirty)
+		if (entry->bIsReadOnly && m_stateSnapshotPublisher)
+		{
+			m_stateSnapshotPublisher();
+		}
+
+		entry->handler(request, response);
+		return true;
+	}
+
+	return false;
 }
 
 void WebsocketInterprocessMessageServer::getConnectionList(std::vector<WebSocketClientConnectionPtr>& outConnections)
 {
 	std::lock_guard<std::mutex> lock(m_connectionsMutex);
 
-	for (WebSocketClientConnectionPtr connection : m_connections)
+	for (auto& connection_it : m_connections)
 	{
-		if (connection)
+		if (connection_it.second)
 		{
-			outConnections.push_back(connection);
+			outConnections.push_back(connection_it.second);
 		}
 	}
 }
@@ -361,24 +408,82 @@ WebSocketClientConnectionPtr WebsocketInterprocessMessageServer::findConnection(
 {
 	std::lock_guard<std::mutex> lock(m_connectionsMutex);
 
-	for (WebSocketClientConnectionPtr connection : m_connections)
+	auto connection_it = m_connections.find(connectionId);
+	if (connection_it != m_connections.end())
 	{
-		if (connection && connection->getId() == connectionId)
-		{
-			return connection;
-		}
+		return connection_it->second;
 	}
 
 	return nullptr;
 }
 
-void WebsocketInterprocessMessageServer::sendMessageToClient(const std::string& connectionId, const std::string& message)
+void WebsocketInterprocessMessageServer::removeConnection(const std::string& connectionId)
+{
+	std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+	m_connections.erase(connectionId);
+}
+
+void WebsocketInterprocessMessageServer::setOutboundQueueSettings(const OutboundQueueSettings& settings)
+{
+	m_outboundQueueSettings = settings;
+}
+
+bool WebsocketInterprocessMessageServer::getOutboundQueueStats(
+	const std::string& connectionId, 
+	OutboundQueueStats& outStats)
 {
 	WebSocketClientConnectionPtr connection= findConnection(connectionId);
 
 	if (connection)
 	{
-		connection->sendText(message);
+		outStats = connection->getOutboundStats();
+		return true;
+	}
+
+	return false;
+}
+
+void WebsocketInterprocessMessageServer::sendMessageToClient(
+	const std::string& connectionId, 
+	const std::string& message,
+	uint64_t coalesceKey)
+{
+	WebSocketClientConnectionPtr connection= findConnection(connectionId);
+
+	if (connection)
+	{
+		connection->queueText(message, coalesceKey, true, m_outboundQueueSettings);
+	}
+}
+
+void WebsocketInterprocessMessageServer::sendMessageToClients(
+	const std::vector<std::string>& connectionIds, 
+	const std::string& message,
+	uint64_t coalesceKey,
+	bool bIsDroppable)
+{
+	EASY_FUNCTION();
+
+	// Look up every connection under a single lock, then send outside of it
+	std::vector<WebSocketClientConnectionPtr> connections;
+	connections.reserve(connectionIds.size());
+	{
+		std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+		for (const std::string& connectionId : connectionIds)
+		{
+			auto connection_it = m_connections.find(connectionId);
+			if (connection_it != m_connections.end() && connection_it->second)
+			{
+				connections.push_back(connection_it->second);
+			}
+		}
+	}
+
+	for (WebSocketClientConnectionPtr& connection : connections)
+	{
+		connection->queueText(message, coalesceKey, bIsDroppable, m_outboundQueueSettings);
 	}
 }
 
@@ -389,7 +494,19 @@ void WebsocketInterprocessMessageServer::sendMessageToAllClients(const std::stri
 
 	for (WebSocketClientConnectionPtr connection : connections)
 	{
-		connection->sendText(message);
+		connection->queueText(message, 0, true, m_outboundQueueSettings);
+	}
+}
+
+void WebsocketInterprocessMessageServer::sendBinaryResponseToClient(
+	const std::string& connectionId, 
+	const std::vector<uint8_t>& binaryData)
+{
+	WebSocketClientConnectionPtr connection= findConnection(connectionId);
+
+	if (connection)
+	{
+		connection->queueBinaryData(binaryData, false, m_outboundQueueSettings);
 	}
 }
 
@@ -427,6 +544,12 @@ void WebsocketInterprocessMessageServer::processSocketEvents()
 				ClientSocketEvent socketEvent = {connectionId, eventType, eventArgs};
 				handler_it->second(socketEvent);
 			}
+
+			// Closed connections no longer need to be looked up
+			if (eventType == WEBSOCKET_DISCONNECT_EVENT)
+			{
+				removeConnection(connection->getId());
+			}
 		}
 	}
 }
@@ -436,74 +559,62 @@ void WebsocketInterprocessMessageServer::processRequests()
 	std::vector<WebSocketClientConnectionPtr> connections;
 	getConnectionList(connections);
 
+	// Set once a request that may have changed server state ran, until the snapshot is published again
+	bool bHasUnpublishedRequests= false;
+
 	// Process all connections	
 	for (WebSocketClientConnectionPtr connection : connections)
 	{
 		// Read all pending requests in the queue
-		std::string inRequestString;
-		while (connection->getRequestQueue()->try_dequeue(inRequestString))
+		ClientRequestMessage inRequest;
+		while (connection->getRequestQueue()->try_dequeue(inRequest))
 		{
 			int64_t requestTypeId;
-			JsonSaxInt64ValueSearcher typeNameSearcher;
-			if (!typeNameSearcher.fetchKeyValuePair(inRequestString, "requestTypeId", requestTypeId))
+			int requestId;
+			if (!ClientRequestDispatch::parseRequest(inRequest, requestTypeId, requestId))
 			{
-				MIKAN_LOG_WARNING("processRequests") << 
-					"Request missing/invalid requestType field: " << inRequestString;
 				continue;
 			}
 
-			// Request ID is optional if the request doesn't expect a response
-			int requestId;
-			JsonSaxIntegerValueSearcher requestIdSearcher;
-			if (!requestIdSearcher.fetchKeyValuePair(inRequestString, "requestId", requestId))
+			const RequestHandlerTable::Entry* entry = m_requestHandlers.find(requestTypeId);
+			const bool bIsReadOnly = entry != nullptr && entry->bIsReadOnly;
+
+			// Read-only handlers must see the effects of the requests handled before them
+			if (bIsReadOnly && bHasUnpublishedRequests)
 			{
-				requestId= INVALID_MIKAN_ID;
+				if (m_stateSnapshotPublisher)
+				{
+					m_stateSnapshotPublisher();
+				}
+				bHasUnpublishedRequests= false;
 			}
 
-			// Get the response from a registered function handler, if any
-			ClientResponse outResponse;
-			auto handler_it = m_requestHandlers.find(requestTypeId);
-			if (handler_it != m_requestHandlers.end())
+			if (m_requestWorkerPool != nullptr && bIsReadOnly)
 			{
-				// NOTE: Connection ID here is a unique ID for the websocket connection on the server
-				// and is not the same as the client ID that the client sends to identify itself
-				const std::string connectionId = connection->getId();
-				ClientRequest request= { connectionId, requestId, inRequestString };
-
-				handler_it->second(request, outResponse);
+				ClientRequestDispatch::dispatchRequestToWorker(
+					entry->handler, *m_requestWorkerPool, connection, connection->getConnectionId(),
+					std::move(inRequest), requestTypeId, requestId, m_outboundQueueSettings);
 			}
 			else
 			{
-				const rfk::Struct& requestTypeStruct = MikanResponse::staticGetArchetype();
-
-				MikanResponse outResult;
-				outResult.responseTypeName = requestTypeStruct.getName();
-				outResult.responseTypeId = requestTypeStruct.getId();
-				outResult.requestId= requestId;
-				outResult.resultCode= MikanAPIResult::UnknownFunction;
-
-				Serialization::serializeToJsonString(outResult, outResponse.utf8String);
+				ClientRequestDispatch::dispatchRequest(
+					entry != nullptr ? &entry->handler : nullptr, *connection, inRequest, requestTypeId, requestId, 
+					m_responseBuffer, m_outboundQueueSettings);
+				bHasUnpublishedRequests= bHasUnpublishedRequests || !bIsReadOnly;
 			}
+		}
+	}
+}
 
-			// Send the response back to the client
-			if (!outResponse.utf8String.empty())
-			{
-				connection->sendText(outResponse.utf8String);
-			}
+void WebsocketInterprocessMessageServer::flushOutboundMessages()
+{
+	EASY_FUNCTION();
 
-			if (!outResponse.binaryData.empty())
-			{
-				connection->sendBinaryData(outResponse.binaryData);
-			}
+	std::vector<WebSocketClientConnectionPtr> connections;
+	getConnectionList(connections);
 
-			if (requestId != INVALID_MIKAN_ID &&
-				outResponse.utf8String.empty() &&
-				outResponse.binaryData.empty())
-			{
-				MIKAN_LOG_WARNING("processRequests") <<
-					"Request handler for " << requestTypeId 
-					<< " returned empty response, but response expected!";
-			}
-		}
+	for (WebSocketClientConnectionPtr connection : connections)
+	{
+		connection->flushOutboundQueue(m_outboundQueueSettings);
 	}
 }
\ No newline at end of file
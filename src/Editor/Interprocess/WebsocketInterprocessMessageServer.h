@@ -1,11 +1,14 @@
 #pragma once
 
+#include "ClientRequestDispatch.h"
 #include "InterprocessMessageServerInterface.h"
+#include "RequestHandlerTable.h"
 
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace ix
 {
@@ -26,23 +29,53 @@ public:
 	bool initialize() override;
 	void dispose() override;
 	void setSocketEventHandler(const std::string& eventType, SocketEventHandler handler) override;
-	void setRequestHandler(std::size_t requestTypeId, RequestHandler handler) override;
+	void setRequestHandler(std::size_t requestTypeId, RequestHandler handler, bool bIsReadOnly= false) override;
+	void setRequestWorkerPool(class RequestWorkerPool* workerPool) override;
+	void setStateSnapshotPublisher(StateSnapshotPublisher publisher) override;
+	bool invokeRequestHandler(
+		std::size_t requestTypeId, 
+		const ClientRequest& request, 
+		ClientResponse& response) override;
 
-	void sendMessageToClient(const std::string& connectionId, const std::string& message) override;
+	void setOutboundQueueSettings(const OutboundQueueSettings& settings) override;
+	bool getOutboundQueueStats(const std::string& connectionId, OutboundQueueStats& outStats) override;
+
+	void sendMessageToClient(
+		const std::string& connectionId, 
+		const std::string& message, 
+		uint64_t coalesceKey= 0) override;
+	void sendMessageToClients(
+		const std::vector<std::string>& connectionIds, 
+		const std::string& message, 
+		uint64_t coalesceKey= 0,
+		bool bIsDroppable= true) override;
 	void sendMessageToAllClients(const std::string& message) override;
+	void sendBinaryResponseToClient(const std::string& connectionId, const std::vector<uint8_t>& binaryData) override;
 	void processSocketEvents() override;
 	void processRequests() override;
+	void flushOutboundMessages() override;
 
 protected:
 	void getConnectionList(std::vector<WebSocketClientConnectionPtr>& outConnections);
 	WebSocketClientConnectionPtr findConnection(const std::string& clientId);
+	void removeConnection(const std::string& connectionId);
 
 private:
 	WebSocketServerPtr m_server;
-	std::vector<WebSocketClientConnectionPtr> m_connections;
+	// Keyed by websocket connection id
+	std::unordered_map<std::string, WebSocketClientConnectionPtr> m_connections;
 	std::mutex m_connectionsMutex;
 	std::map<std::string, SocketEventHandler> m_socketEventHandlers;
-	std::map<std::size_t, RequestHandler> m_requestHandlers;
+	RequestHandlerTable m_requestHandlers;
+
+	OutboundQueueSettings m_outboundQueueSettings;
+
+	// Response buffers recycled across requests and frames (keeps their capacity)
+	ClientResponse m_responseBuffer;
+
+	// Read-only requests run on the worker pool, which sends their responses as soon as they're done
+	class RequestWorkerPool* m_requestWorkerPool= nullptr;
+	StateSnapshotPublisher m_stateSnapshotPublisher;
 };
 
 
@@ -0,0 +1,222 @@
+#include "EditorServerObjectSystems.h"
+#include "App.h"
+#include "AnchorComponent.h"
+#include "AnchorObjectSystem.h"
+#include "BoxStencilComponent.h"
+#include "MathTypeConversion.h"
+#include "ModelStencilComponent.h"
+#include "ProfileConfig.h"
+#include "QuadStencilComponent.h"
+#include "ServerStateSnapshot.h"
+#include "StencilObjectSystemConfig.h"
+#include "StencilObjectSystem.h"
+#include "VideoCapabilitiesConfig.h"
+#include "VideoSourceView.h"
+#include "VideoSourceManager.h"
+#include "VRDeviceManager.h"
+#include "VRDeviceView.h"
+
+#include <easy/profiler.h>
+
+static VideoSourceViewPtr getCurrentVideoSource()
+{
+	ProfileConfigConstPtr profileConfig = App::getInstance()->getProfileConfig();
+
+	return VideoSourceListIterator(profileConfig->videoSourcePath).getCurrent();
+}
+
+static VRDeviceViewPtr getCurrentCameraVRDevice()
+{
+	ProfileConfigConstPtr profileConfig = App::getInstance()->getProfileConfig();
+
+	return VRDeviceManager::getInstance()->getVRDeviceViewByPath(profileConfig->cameraVRDevicePath);
+}
+
+// State Snapshot
+static void extractVideoSourceState(ServerStateSnapshot& outSnapshot)
+{
+	VideoSourceViewPtr videoSourceView= getCurrentVideoSource();
+	if (!videoSourceView)
+		return;
+
+	videoSourceView->getCameraIntrinsics(outSnapshot.videoSourceIntrinsics.intrinsics);
+	outSnapshot.bHasVideoSourceIntrinsics= true;
+
+	const VideoModeConfig* modeConfig= videoSourceView->getVideoMode();
+	if (modeConfig != nullptr)
+	{
+		MikanVideoSourceModeResponse& info= outSnapshot.videoSourceMode;
+		info.device_path = videoSourceView->getUSBDevicePath();
+		info.frame_rate = modeConfig->frameRate;
+		info.resolution_x = modeConfig->bufferPixelWidth;
+		info.resolution_y = modeConfig->bufferPixelHeight;
+		info.video_mode_name = modeConfig->modeName;
+		switch (videoSourceView->getVideoSourceDriverType())
+		{
+			case IVideoSourceInterface::OpenCV:
+				info.video_source_api = MikanVideoSourceApi_INVALID;
+				break;
+			case IVideoSourceInterface::WindowsMediaFramework:
+				info.video_source_api = MikanVideoSourceApi_WINDOWS_MEDIA_FOUNDATION;
+				break;
+			case IVideoSourceInterface::INVALID:
+			default:
+				info.video_source_api = MikanVideoSourceApi_INVALID;
+				break;
+		}
+		info.video_source_type = videoSourceView->getIsStereoCamera() ? MikanVideoSourceType_STEREO : MikanVideoSourceType_MONO;
+		outSnapshot.bHasVideoSourceMode= true;
+	}
+
+	VRDeviceViewPtr vrDeviceView = getCurrentCameraVRDevice();
+	if (vrDeviceView)
+	{
+		MikanVideoSourceAttachmentInfoResponse& info= outSnapshot.videoSourceAttachment;
+
+		// Get the ID of the VR tracker device
+		info.attached_vr_device_id = vrDeviceView->getDeviceID();
+
+		// Get the camera offset
+		const glm::vec3 cameraOffsetPos = MikanVector3d_to_glm_dvec3(videoSourceView->getCameraOffsetPosition());
+		const glm::quat cameraOffsetQuat = MikanQuatd_to_glm_dquat(videoSourceView->getCameraOffsetOrientation());
+		const glm::mat4 cameraOffsetXform =
+			glm::translate(glm::mat4(1.0), cameraOffsetPos) *
+			glm::mat4_cast(cameraOffsetQuat);
+		info.vr_device_offset_xform = glm_mat4_to_MikanMatrix4f(cameraOffsetXform);
+		outSnapshot.bHasVideoSourceAttachment= true;
+	}
+}
+
+void EditorServerObjectSystems::extractStateSnapshot(
+	const ServerStateSnapshot* previousSnapshot,
+	ServerStateSnapshot& outSnapshot) const
+{
+	EASY_FUNCTION();
+
+	// Spatial Anchors
+	auto anchorSystemConfig = App::getInstance()->getProfileConfig()->anchorConfig;
+	for (AnchorDefinitionPtr spatialAnchor : anchorSystemConfig->spatialAnchorList)
+	{
+		outSnapshot.spatialAnchorIds.push_back(spatialAnchor->getAnchorId());
+	}
+	for (auto& anchor_it : AnchorObjectSystem::getSystem()->getAnchorMap())
+	{
+		AnchorComponentPtr anchorPtr= anchor_it.second.lock();
+		if (anchorPtr)
+		{
+			outSnapshot.spatialAnchors.push_back(MikanSpatialAnchorInfo());
+			anchorPtr->extractAnchorInfoForClientAPI(outSnapshot.spatialAnchors.back());
+		}
+	}
+
+	// Stencils
+	auto stencilSystemConfig = App::getInstance()->getProfileConfig()->stencilConfig;
+	for (QuadStencilDefinitionPtr quadConfig : stencilSystemConfig->quadStencilList)
+	{
+		outSnapshot.quadStencils.push_back(quadConfig->getQuadInfo());
+	}
+	for (BoxStencilDefinitionPtr boxConfig : stencilSystemConfig->boxStencilList)
+	{
+		outSnapshot.boxStencils.push_back(boxConfig->getBoxInfo());
+	}
+	for (ModelStencilDefinitionPtr modelConfig : stencilSystemConfig->modelStencilList)
+	{
+		outSnapshot.modelStencils.push_back(modelConfig->getModelInfo());
+	}
+
+	// Model geometry is only extracted again after the stencil rebuilt its meshes
+	for (auto& stencil_it : StencilObjectSystem::getSystem()->getModelStencilMap())
+	{
+		ModelStencilComponentPtr modelStencil= stencil_it.second.lock();
+		if (!modelStencil)
+			continue;
+
+		ServerStateSnapshot::ModelStencilGeometry entry;
+		entry.revision= modelStencil->getRenderGeometryRevision();
+
+		if (previousSnapshot)
+		{
+			auto previous_it= previousSnapshot->modelStencilGeometry.find(stencil_it.first);
+
+			if (previous_it != previousSnapshot->modelStencilGeometry.end() &&
+				previous_it->second.revision == entry.revision)
+			{
+				entry.geometry= previous_it->second.geometry;
+			}
+		}
+
+		if (!entry.geometry)
+		{
+			auto renderGeometry= std::make_shared<MikanStencilModelRenderGeometry>();
+			modelStencil->extractRenderGeometry(*renderGeometry);
+			entry.geometry= renderGeometry;
+		}
+
+		outSnapshot.modelStencilGeometry.insert({stencil_it.first, entry});
+	}
+
+	// Video Source
+	extractVideoSourceState(outSnapshot);
+}
+
+// VR Devices
+void EditorServerObjectSystems::getVRDeviceIdList(std::vector<MikanVRDeviceID>& outDeviceIds) const
+{
+	for (VRDeviceViewPtr deviceView : VRDeviceManager::getInstance()->getVRDeviceList())
+	{
+		outDeviceIds.push_back(deviceView->getDeviceID());
+	}
+}
+
+bool EditorServerObjectSystems::getVRDeviceInfo(MikanVRDeviceID deviceId, MikanVRDeviceInfo& outInfo) const
+{
+	VRDeviceViewPtr vrDeviceView = VRDeviceManager::getInstance()->getVRDeviceViewById(deviceId);
+	if (!vrDeviceView)
+		return false;
+
+	outInfo.device_path= vrDeviceView->getDevicePath();
+
+	switch (vrDeviceView->getVRTrackerDriverType())
+	{
+	case IVRDeviceInterface::eDriverType::SteamVR:
+		outInfo.vr_device_api= MikanVRDeviceApi_STEAM_VR;
+		break;
+	default:
+		outInfo.vr_device_api = MikanVRDeviceApi_INVALID;
+	}
+
+	switch (vrDeviceView->getVRDeviceType())
+	{
+	case eDeviceType::HMD:
+		outInfo.vr_device_type = MikanVRDeviceType_HMD;
+		break;
+	case eDeviceType::VRController:
+		outInfo.vr_device_type = MikanVRDeviceType_CONTROLLER;
+		break;
+	case eDeviceType::VRTracker:
+		outInfo.vr_device_type = MikanVRDeviceType_TRACKER;
+		break;
+	default:
+		outInfo.vr_device_type= MikanVRDeviceType_INVALID;
+	}
+
+	return true;
+}
+
+bool EditorServerObjectSystems::getVRDevicePose(MikanVRDeviceID deviceId, MikanMatrix4f& outTransform) const
+{
+	VRDeviceViewPtr vrDeviceView= VRDeviceManager::getInstance()->getVRDeviceViewById(deviceId);
+
+	if (vrDeviceView && vrDeviceView->getIsOpen() && vrDeviceView->getIsPoseValid())
+	{
+		// TODO: We should provide option to select which component we want the pose updates for
+		glm::mat4 xform;
+		if (vrDeviceView->getDefaultComponentPose(xform))
+		{
+			outTransform = glm_mat4_to_MikanMatrix4f(xform);
+			return true;
+		}
+	}
+
+	return false;
+}
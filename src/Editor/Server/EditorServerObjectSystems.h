@@ -0,0 +1,16 @@
+#pragma once
+
+#include "IServerObjectSystems.h"
+
+// The editor's anchor, stencil, video source and VR device systems, as seen by the server
+class EditorServerObjectSystems : public IServerObjectSystems
+{
+public:
+	virtual void extractStateSnapshot(
+		const ServerStateSnapshot* previousSnapshot,
+		ServerStateSnapshot& outSnapshot) const override;
+
+	virtual void getVRDeviceIdList(std::vector<MikanVRDeviceID>& outDeviceIds) const override;
+	virtual bool getVRDeviceInfo(MikanVRDeviceID deviceId, MikanVRDeviceInfo& outInfo) const override;
+	virtual bool getVRDevicePose(MikanVRDeviceID deviceId, MikanMatrix4f& outTransform) const override;
+};
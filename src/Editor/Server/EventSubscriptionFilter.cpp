@@ -0,0 +1,53 @@
+#include "EventSubscriptionFilter.h"
+
+//-- EventSubscriptionFilter -----
+bool EventSubscriptionFilter::getIsSubscribedToEvent(int64_t eventTypeId) const
+{
+	return m_eventTypeIds.empty() || m_eventTypeIds.find(eventTypeId) != m_eventTypeIds.end();
+}
+
+//-- EventSubscriberCounts -----
+void EventSubscriberCounts::addFilter(const EventSubscriptionFilter& filter)
+{
+	if (filter.getIsSubscribedToAllEvents())
+	{
+		m_allEventsSubscriberCount++;
+		return;
+	}
+
+	for (int64_t eventTypeId : filter.getSubscribedEvents())
+	{
+		m_eventSubscriberCounts[eventTypeId]++;
+	}
+}
+
+void EventSubscriberCounts::removeFilter(const EventSubscriptionFilter& filter)
+{
+	if (filter.getIsSubscribedToAllEvents())
+	{
+		m_allEventsSubscriberCount--;
+		return;
+	}
+
+	for (int64_t eventTypeId : filter.getSubscribedEvents())
+	{
+		auto it = m_eventSubscriberCounts.find(eventTypeId);
+		if (it != m_eventSubscriberCounts.end() && --it->second <= 0)
+		{
+			m_eventSubscriberCounts.erase(it);
+		}
+	}
+}
+
+void EventSubscriberCounts::clear()
+{
+	m_allEventsSubscriberCount= 0;
+	m_eventSubscriberCounts.clear();
+}
+
+bool EventSubscriberCounts::hasEventSubscribers(int64_t eventTypeId) const
+{
+	return 
+		m_allEventsSubscriberCount > 0 || 
+		m_eventSubscriberCounts.find(eventTypeId) != m_eventSubscriberCounts.end();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// The event types a client connection asked for (see SubscribeToEvents).
+// With no event filter set the client receives every event.
+class EventSubscriptionFilter
+{
+public:
+	inline bool getIsSubscribedToAllEvents() const { return m_eventTypeIds.empty(); }
+	inline const std::unordered_set<int64_t>& getSubscribedEvents() const { return m_eventTypeIds; }
+	bool getIsSubscribedToEvent(int64_t eventTypeId) const;
+
+	// An empty list subscribes to every event again
+	template <typename t_event_type_id_list>
+	void setSubscribedEvents(const t_event_type_id_list& eventTypeIds)
+	{
+		m_eventTypeIds.clear();
+		m_eventTypeIds.insert(eventTypeIds.begin(), eventTypeIds.end());
+	}
+
+private:
+	std::unordered_set<int64_t> m_eventTypeIds;
+};
+
+// How many connection filters let each event type through, kept up to date as filters
+// are added, changed and removed, so checking for subscribers doesn't walk every connection
+class EventSubscriberCounts
+{
+public:
+	void addFilter(const EventSubscriptionFilter& filter);
+	void removeFilter(const EventSubscriptionFilter& filter);
+	void clear();
+
+	bool hasEventSubscribers(int64_t eventTypeId) const;
+
+private:
+	int m_allEventsSubscriberCount= 0;
+	std::unordered_map<int64_t, int> m_eventSubscriberCounts;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "MikanMathTypes.h"
+#include "MikanTypeFwd.h"
+#include "MikanVRDeviceTypes.h"
+
+#include <vector>
+
+struct ServerStateSnapshot;
+
+// Everything the object request handlers and the VR device pose publisher read from the
+// editor's anchor, stencil, video source and VR device systems.
+// EditorServerObjectSystems forwards to the real systems, the server load test stubs them.
+class IServerObjectSystems
+{
+public:
+	virtual ~IServerObjectSystems() {}
+
+	// Fills in the anchors, stencils and video source of a new state snapshot.
+	// Model geometry that hasn't been rebuilt can be shared with previousSnapshot (may be null).
+	virtual void extractStateSnapshot(
+		const ServerStateSnapshot* previousSnapshot,
+		ServerStateSnapshot& outSnapshot) const= 0;
+
+	// VR Devices
+	virtual void getVRDeviceIdList(std::vector<MikanVRDeviceID>& outDeviceIds) const= 0;
+	virtual bool getVRDeviceInfo(MikanVRDeviceID deviceId, MikanVRDeviceInfo& outInfo) const= 0;
+	// False if the device isn't open or its pose isn't valid
+	virtual bool getVRDevicePose(MikanVRDeviceID deviceId, MikanMatrix4f& outTransform) const= 0;
+};
@@ -5,39 +5,44 @@
 #include "BinarySerializer.h"
 #include "BinaryUtility.h"
 #include "BoxStencilComponent.h"
+#include "ClientRequestDispatch.h"
 #include "CommonScriptContext.h"
+#include "CompositeInterprocessMessageServer.h"
+#include "EditorServerObjectSystems.h"
 #include "MathTypeConversion.h"
 #include "JsonDeserializer.h"
 #include "JsonSerializer.h"
+#include "JsonUtils.h"
 #include "Logger.h"
 #include "MikanAPITypes.h"
 #include "MikanCoreTypes.h"
 #include "MikanRenderTargetRequests.h"
 #include "MikanClientRequests.h"
+#include "MikanSceneRequests.h"
 #include "MikanScriptRequests.h"
-#include "MikanSpatialAnchorRequests.h"
-#include "MikanStencilRequests.h"
-#include "MikanVideoSourceRequests.h"
-#include "MikanVRDeviceRequests.h"
 #include "MikanScriptTypes.h"
 #include "MikanServer.h"
 #include "ModelStencilComponent.h"
 #include "ProfileConfig.h"
 #include "QuadStencilComponent.h"
 #include "RemoteControlManager.h"
+#include "RequestWorkerPool.h"
+#include "ServerObjectRequestHandlers.h"
 #include "ServerResponseHelpers.h"
+#include "SharedEventRing.h"
 #include "SharedTextureReader.h"
 #include "StencilObjectSystemConfig.h"
 #include "StencilObjectSystem.h"
 #include "StringUtils.h"
-#include "VideoCapabilitiesConfig.h"
-#include "VideoSourceView.h"
-#include "VideoSourceManager.h"
 #include "VRDeviceManager.h"
+#include "VRDevicePosePublisher.h"
 #include "VRDeviceView.h"
 #include "Version.h"
+#include "UnixSocketInterprocessMessageServer.h"
 #include "WebsocketInterprocessMessageServer.h"
 
+#include <map>
+#include <random>
 #include <set>
 #include <assert.h>
 
@@ -46,6 +51,13 @@
 
 #include <nlohmann/json.hpp>
 
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
 using json = nlohmann::json;
 
 #ifdef _MSC_VER
@@ -64,7 +76,6 @@ public:
 		: m_connectionId(connectionId)
 		, m_messageServer(messageServer)
 		, m_connectionInfo(new MikanClientConnectionInfo())
-		, m_subscribedVRDevices()
 	{	
 	}
 
@@ -78,6 +89,25 @@ public:
 		return m_connectionId;
 	}
 
+	int getClientProtocolVersion() const
+	{
+		return m_clientProtocolVersion;
+	}
+
+	void setClientProtocolVersion(int protocolVersion)
+	{
+		m_clientProtocolVersion= protocolVersion;
+	}
+
+	// Binary responses use the compact V2 format once the client info said it can read it
+	Serialization::BinaryFormat getBinaryFormat() const
+	{
+		return 
+			m_connectionInfo->getClientInfo().supportsBinaryFormatV2
+			? Serialization::BinaryFormat::V2 
+			: Serialization::BinaryFormat::V1;
+	}
+
 	const MikanClientConnectionInfo& getClientConnectionInfo() const 
 	{
 		return *m_connectionInfo;
@@ -126,20 +156,32 @@ public:
 		return m_connectionInfo->getRenderTargetReadAccessor()->getClientGraphicsAPI();
 	}
 
-	void subscribeToVRDevicePoseUpdatesHandler(MikanVRDeviceID deviceId)
+	inline const EventSubscriptionFilter& getEventSubscriptionFilter() const
 	{
-		m_subscribedVRDevices.insert(deviceId);
+		return m_eventSubscriptionFilter;
 	}
 
-	void unsubscribeFromVRDevicePoseUpdatesHandler(MikanVRDeviceID deviceId)
+	bool getIsSubscribedToEvent(int64_t eventTypeId) const
 	{
-		auto it = m_subscribedVRDevices.find(deviceId);
-		if (it != m_subscribedVRDevices.end())
-		{
-			m_subscribedVRDevices.erase(it);
-		}
+		return m_eventSubscriptionFilter.getIsSubscribedToEvent(eventTypeId);
 	}
-	
+
+	void setSubscribedEvents(const Serialization::List<int64_t>& eventTypeIds)
+	{
+		m_eventSubscriptionFilter.setSubscribedEvents(eventTypeIds);
+	}
+
+	// The client's bit in the shared memory event ring, -1 if it gets its events over the socket
+	int getEventRingReaderIndex() const
+	{
+		return m_eventRingReaderIndex;
+	}
+
+	void setEventRingReaderIndex(int readerIndex)
+	{
+		m_eventRingReaderIndex= readerIndex;
+	}
+
 	bool allocateRenderTargetTextures(const MikanRenderTargetDescriptor& desc)
 	{
 		EASY_FUNCTION();
@@ -181,27 +223,16 @@ public:
 		}
 	}
 
+	// Serializes into a buffer owned by the connection, so its capacity is reused by every event.
+	// The returned string is only valid until the next call.
 	template <typename t_mikan_type>
-	std::string mikanTypeToJsonString(const t_mikan_type& mikanType)
+	const std::string& mikanTypeToJsonString(const t_mikan_type& mikanType)
 	{
 		EASY_FUNCTION();
 
-		std::string jsonStr;
-		Serialization::serializeToJsonString(mikanType, jsonStr);
-
-		return jsonStr;
-	}
-
-	void publishMikanJsonEvent(const std::string& mikanJsonEvent)
-	{
-		m_messageServer->sendMessageToClient(getConnectionId(), mikanJsonEvent);
-	}
+		Serialization::serializeToJsonString(mikanType, m_jsonEventBuffer);
 
-	template <typename t_mikan_type>
-	void publishSimpleEvent()
-	{
-		t_mikan_type mikanEvent;
-		publishMikanJsonEvent(mikanTypeToJsonString(mikanEvent));
+		return m_jsonEventBuffer;
 	}
 
 	// Connection Events
@@ -215,105 +246,14 @@ public:
 		m_messageServer->sendMessageToClient(getConnectionId(), mikanTypeToJsonString(connectedEvent));
 	}
 
-	// Scripting Events
-	void publishScriptMessageEvent(const std::string& message)
-	{
-		MikanScriptMessagePostedEvent messageInfo;
-		messageInfo.message = message;
-
-		m_messageServer->sendMessageToClient(getConnectionId(), mikanTypeToJsonString(messageInfo));
-	}
-
-	// Video Source Events
-	void publishVideoSourceOpenedEvent()
-	{
-		publishSimpleEvent<MikanVideoSourceOpenedEvent>();
-	}
-
-	void publishVideoSourceClosedEvent()
-	{
-		publishSimpleEvent<MikanVideoSourceClosedEvent>();
-	}
-
-	void publishNewVideoFrameEvent(const MikanVideoSourceNewFrameEvent& newFrameEvent)
-	{
-		m_messageServer->sendMessageToClient(getConnectionId(), mikanTypeToJsonString(newFrameEvent));
-	}
-
-	void publishVideoSourceAttachmentChangedEvent()
-	{
-		publishSimpleEvent<MikanVideoSourceAttachmentChangedEvent>();
-	}
-
-	void publishVideoSourceIntrinsicsChangedEvent()
-	{
-		publishSimpleEvent<MikanVideoSourceIntrinsicsChangedEvent>();
-	}
-
-	void publishVideoSourceModeChangedEvent()
-	{
-		publishSimpleEvent<MikanVideoSourceModeChangedEvent>();
-	}
-
-	// VR Device Events
-	void publishVRDevicePoses(int64_t newVRFrameIndex)
-	{
-		VRDeviceManager* vrDeviceManager= VRDeviceManager::getInstance();
-
-		for (auto deviceId : m_subscribedVRDevices)
-		{
-			VRDeviceViewPtr vrDeviceView= vrDeviceManager->getVRDeviceViewById(deviceId);
-
-			if (vrDeviceView && vrDeviceView->getIsOpen() && vrDeviceView->getIsPoseValid())
-			{
-				// TODO: We should provide option to select which component we want the pose updates for
-				glm::mat4 xform;
-				if (vrDeviceView->getDefaultComponentPose(xform))
-				{
-					// Send a pose update to the client
-					MikanVRDevicePoseUpdateEvent poseUpdate;
-					poseUpdate.transform = glm_mat4_to_MikanMatrix4f(xform);
-					poseUpdate.device_id = deviceId;
-					poseUpdate.frame = newVRFrameIndex;
-
-					m_messageServer->sendMessageToClient(getConnectionId(), mikanTypeToJsonString(poseUpdate));
-				}
-			}
-		}
-	}
-
-	void publishVRDeviceListChangedEvent()
-	{
-		publishSimpleEvent<MikanVRDeviceListUpdateEvent>();
-	}
-
-	// Spatial Anchor Events
-	void publishAnchorNameUpdatedEvent(const MikanAnchorNameUpdateEvent& newNameEvent)
-	{
-		m_messageServer->sendMessageToClient(getConnectionId(), mikanTypeToJsonString(newNameEvent));
-	}
-
-	void publishAnchorPoseUpdatedEvent(const MikanAnchorPoseUpdateEvent& newPoseEvent)
-	{
-		m_messageServer->sendMessageToClient(getConnectionId(), mikanTypeToJsonString(newPoseEvent));
-	}
-
-	// Stencil Events
-	void publishStencilNameUpdatedEvent(const MikanStencilNameUpdateEvent& newNameEvent)
-	{
-		m_messageServer->sendMessageToClient(getConnectionId(), mikanTypeToJsonString(newNameEvent));
-	}
-
-	void publishStencilPoseUpdatedEvent(const MikanStencilPoseUpdateEvent& newPoseEvent)
-	{
-		m_messageServer->sendMessageToClient(getConnectionId(), mikanTypeToJsonString(newPoseEvent));
-	}
-
 private:
 	std::string m_connectionId;
+	int m_clientProtocolVersion= -1;
 	IInterprocessMessageServer* m_messageServer= nullptr;
 	MikanClientConnectionInfo* m_connectionInfo= nullptr;
-	std::set<MikanVRDeviceID> m_subscribedVRDevices;
+	EventSubscriptionFilter m_eventSubscriptionFilter;
+	int m_eventRingReaderIndex= -1;
+	std::string m_jsonEventBuffer;
 };
 
 // -- MikanClientConnectionInfo -----
@@ -421,30 +361,79 @@ void MikanClientConnectionInfo::freeRenderTargetTexturesHandler()
 // -- MikanServer -----
 MikanServer* MikanServer::m_instance= nullptr;
 
+// Shared memory event ring for clients on this machine, roughly 30k pose events deep.
+// Each server process gets its own ring, named after its process id.
+static const char* k_eventRingNamePrefix= "MikanXR_EventRing_";
+static const size_t k_eventRingCapacity= 4 * 1024 * 1024;
+
+// Threads running the read-only request handlers
+static const int k_requestWorkerCount= 2;
+
+// Scene removals remembered for GetSceneDelta, older deltas get a full snapshot
+static const size_t k_maxRemovedSceneObjects= 1024;
+
+// Clients connect over websockets, or over a unix domain socket when on the same machine
+static IInterprocessMessageServer* createMessageServer()
+{
+	CompositeInterprocessMessageServer* messageServer= new CompositeInterprocessMessageServer();
+	messageServer->addServer(new WebsocketInterprocessMessageServer(), true);
+	messageServer->addServer(new UnixSocketInterprocessMessageServer(), false);
+
+	return messageServer;
+}
+
 MikanServer::MikanServer()
-	: m_messageServer(new WebsocketInterprocessMessageServer())
+	: m_messageServer(createMessageServer())
+	, m_eventRing(new SharedEventRingWriter())
+	, m_eventRingName(k_eventRingNamePrefix + std::to_string(getpid()))
 	, m_remoteControlManager(new RemoteControlManager(this))
-{
+	, m_requestWorkerPool(new RequestWorkerPool())
+	, m_objectSystems(new EditorServerObjectSystems())
+	// A new run id each time the server starts, so clients can't mix up scene versions across runs
+	, m_sceneVersionTracker(k_maxRemovedSceneObjects, std::random_device()())
+{
+	m_objectRequestHandlers= new ServerObjectRequestHandlers(m_objectSystems);
+	m_vrDevicePosePublisher= new VRDevicePosePublisher(
+		m_objectSystems,
+		[this](const std::vector<std::string>& connectionIds, const std::string& mikanJsonEvent, uint64_t coalesceKey) {
+			sendEventToClients(connectionIds, mikanJsonEvent, coalesceKey);
+		});
+
 	m_instance= this;
 }
 
 MikanServer::~MikanServer()
 {
 	delete m_remoteControlManager;
+	delete m_vrDevicePosePublisher;
+	delete m_objectRequestHandlers;
+	delete m_objectSystems;
+	delete m_requestWorkerPool;
+	delete m_eventRing;
 	delete m_messageServer;
 	m_instance= nullptr;
 }
 
 // -- ClientMikanAPI System -----
+// Broadcast events are serialized once and the same payload is sent to every connection
 template <typename t_mikan_type>
-void publishSimpleEvent(std::map<std::string, MikanClientConnectionStatePtr>& clientConnections)
+void MikanServer::publishEventToAllClients(const t_mikan_type& mikanEvent, uint64_t coalesceKey)
 {
 	EASY_FUNCTION();
 
-	for (auto& connection_it : clientConnections)
-	{
-		connection_it.second->publishSimpleEvent<t_mikan_type>();
-	}
+	// Skip serializing events no client has subscribed to
+	if (!hasEventSubscribers(mikanEvent.eventTypeId))
+		return;
+
+	Serialization::serializeToJsonString(mikanEvent, m_broadcastJsonBuffer);
+	publishMikanJsonEvent(mikanEvent.eventTypeId, m_broadcastJsonBuffer, coalesceKey);
+}
+
+template <typename t_mikan_type>
+void MikanServer::publishSimpleEvent()
+{
+	t_mikan_type mikanEvent;
+	publishEventToAllClients(mikanEvent);
 }
 
 bool MikanServer::startup(MainWindow* mainWindow)
@@ -457,6 +446,12 @@ bool MikanServer::startup(MainWindow* mainWindow)
 		return false;
 	}
 
+	// Clients can still get their events over the socket without it
+	if (!m_eventRing->create(m_eventRingName, k_eventRingCapacity))
+	{
+		MIKAN_LOG_WARNING("MikanServer::startup()") << "Failed to create shared memory event ring: " << m_eventRingName;
+	}
+
 	// Bind the remote control request handlers
 	if (!m_remoteControlManager->startup(mainWindow))
 	{
@@ -478,90 +473,55 @@ bool MikanServer::startup(MainWindow* mainWindow)
 	// Client Init/Dispose Requests
 	m_messageServer->setRequestHandler(
 		InitClientRequest::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::initClientHandler, this, _1, _2));
+		RequestHandler::bind<&MikanServer::initClientHandler>(this));
 	m_messageServer->setRequestHandler(
 		DisposeClientRequest::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::disposeClientHandler, this, _1, _2));
+		RequestHandler::bind<&MikanServer::disposeClientHandler>(this));
+	m_messageServer->setRequestHandler(
+		SubscribeToEvents::staticGetArchetype().getId(), 
+		RequestHandler::bind<&MikanServer::subscribeToEventsHandler>(this));
+	m_messageServer->setRequestHandler(
+		OpenEventRing::staticGetArchetype().getId(), 
+		RequestHandler::bind<&MikanServer::openEventRingHandler>(this));
+	m_messageServer->setRequestHandler(
+		CloseEventRing::staticGetArchetype().getId(), 
+		RequestHandler::bind<&MikanServer::closeEventRingHandler>(this));
+	m_messageServer->setRequestHandler(
+		MikanBatchRequest::staticGetArchetype().getId(), 
+		RequestHandler::bind<&MikanServer::batchRequestHandler>(this));
 
 	// Render Target Requests
 	m_messageServer->setRequestHandler(
 		AllocateRenderTargetTextures::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::allocateRenderTargetTexturesHandler, this, _1, _2));
+		RequestHandler::bind<&MikanServer::allocateRenderTargetTexturesHandler>(this));
 	m_messageServer->setRequestHandler(
 		FreeRenderTargetTextures::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::freeRenderTargetTexturesHandler, this, _1, _2));
+		RequestHandler::bind<&MikanServer::freeRenderTargetTexturesHandler>(this));
 	m_messageServer->setRequestHandler(
 		PublishRenderTargetTextures::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::frameRenderedHandler, this, _1, _2));
+		RequestHandler::bind<&MikanServer::frameRenderedHandler>(this));
 
 	// Script Requests	
 	m_messageServer->setRequestHandler(
 		SendScriptMessage::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::invokeScriptMessageHandler, this, _1, _2));
+		RequestHandler::bind<&MikanServer::invokeScriptMessageHandler>(this));
 
-	// Spatial Anchor Requests
-	m_messageServer->setRequestHandler(
-		GetSpatialAnchorList::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getSpatialAnchorListHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		GetSpatialAnchorInfo::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getSpatialAnchorInfoHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		FindSpatialAnchorInfoByName::staticGetArchetype().getId(),
-		std::bind(&MikanServer::findSpatialAnchorInfoByNameHandler, this, _1, _2));
-
-	// Stencil Requests
-	m_messageServer->setRequestHandler(
-		GetQuadStencilList::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getQuadStencilListHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		GetQuadStencil::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getQuadStencilHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		GetBoxStencilList::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getBoxStencilListHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		GetBoxStencil::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getBoxStencilHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		GetModelStencilList::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getModelStencilListHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		GetModelStencil::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getModelStencilHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		GetModelStencilRenderGeometry::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getModelStencilRenderGeometryHandler, this, _1, _2));
+	// Anchor, Stencil, Video Source and VR Device Requests
+	m_objectRequestHandlers->bindRequestHandlers(m_messageServer);
+	m_vrDevicePosePublisher->bindRequestHandlers(m_messageServer);
 
-	// Video Source Requests
-	m_messageServer->setRequestHandler(
-		GetVideoSourceIntrinsics::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getVideoSourceIntrinsicsHandler, this, _1, _2));
+	// Scene Requests
 	m_messageServer->setRequestHandler(
-		GetVideoSourceMode::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getVideoSourceModeHandler, this, _1, _2));
+		GetSceneSnapshot::staticGetArchetype().getId(), 
+		RequestHandler::bind<&MikanServer::getSceneSnapshotHandler>(this));
 	m_messageServer->setRequestHandler(
-		GetVideoSourceAttachment::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getVideoSourceAttachmentHandler, this, _1, _2));
-
-	// VR Device Requests
-	m_messageServer->setRequestHandler(
-		GetVRDeviceList::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getVRDeviceListHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		GetVRDeviceInfo::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::getVRDeviceInfoHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		SubscribeToVRDevicePoseUpdates::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::subscribeToVRDevicePoseUpdatesHandler, this, _1, _2));
-	m_messageServer->setRequestHandler(
-		UnsubscribeFromVRDevicePoseUpdates::staticGetArchetype().getId(), 
-		std::bind(&MikanServer::unsubscribeFromVRDevicePoseUpdatesHandler, this, _1, _2));
+		GetSceneDelta::staticGetArchetype().getId(), 
+		RequestHandler::bind<&MikanServer::getSceneDeltaHandler>(this));
 
 	VRDeviceManager::getInstance()->OnDeviceListChanged 
 		+= MakeDelegate(this, &MikanServer::publishVRDeviceListChanged);
 	VRDeviceManager::getInstance()->OnDevicePosesChanged 
-		+= MakeDelegate(this, &MikanServer::publishVRDevicePoses);
+		+= MakeDelegate(m_vrDevicePosePublisher, &VRDevicePosePublisher::publishVRDevicePoses);
 
 	AnchorObjectSystem::getSystem()->getAnchorSystemConfig()->OnMarkedDirty+= 
 		MakeDelegate(this, &MikanServer::handleAnchorSystemConfigChange);
@@ -569,6 +529,23 @@ bool MikanServer::startup(MainWindow* mainWindow)
 	StencilObjectSystem::getSystem()->getStencilSystemConfig()->OnMarkedDirty+=
 		MakeDelegate(this, &MikanServer::handleStencilSystemConfigChange);
 
+	// Scene versions start out covering whatever is already loaded
+	syncSceneSpatialAnchorIds();
+	syncSceneStencilIds();
+	syncSceneVRDeviceIds();
+
+	// Without worker threads the read-only requests just run on the main thread
+	publishStateSnapshot();
+	m_messageServer->setStateSnapshotPublisher([this]() { publishStateSnapshotIfDirty(); });
+	if (m_requestWorkerPool->startup(k_requestWorkerCount))
+	{
+		m_messageServer->setRequestWorkerPool(m_requestWorkerPool);
+	}
+	else
+	{
+		MIKAN_LOG_WARNING("MikanServer::startup()") << "Failed to start request worker threads";
+	}
+
 	return true;
 }
 
@@ -581,23 +558,125 @@ void MikanServer::update()
 		EASY_BLOCK("processRemoteFunctionCalls");
 
 		m_messageServer->processSocketEvents();
+
+		// Read-only requests see the state as of the start of this frame
+		// (plus the effects of any requests handled ahead of them this frame)
+		publishStateSnapshotIfDirty();
+
 		m_messageServer->processRequests();
 	}
+
+	// Send whatever clients have room for of their queued responses and events
+	m_messageServer->flushOutboundMessages();
 }
 
 void MikanServer::shutdown()
 {
-	VRDeviceManager::getInstance()->OnDevicePosesChanged -= MakeDelegate(this, &MikanServer::publishVRDevicePoses);
+	VRDeviceManager::getInstance()->OnDevicePosesChanged -= 
+		MakeDelegate(m_vrDevicePosePublisher, &VRDevicePosePublisher::publishVRDevicePoses);
+
+	// Workers may still be reading the snapshot or queueing responses
+	m_messageServer->setRequestWorkerPool(nullptr);
+	m_messageServer->setStateSnapshotPublisher(nullptr);
+	m_requestWorkerPool->shutdown();
 
 	m_clientConnections.clear();
+	m_eventSubscriberCounts.clear();
+	m_vrDevicePosePublisher->clearConnections();
 	m_messageServer->dispose();
+
+	m_eventRing->dispose();
+	m_eventRingReaderMask= 0;
 }
 
-void MikanServer::publishMikanJsonEvent(const std::string& mikanJsonEvent)
+bool MikanServer::hasEventSubscribers(int64_t eventTypeId) const
 {
+	return m_eventSubscriberCounts.hasEventSubscribers(eventTypeId);
+}
+
+void MikanServer::publishMikanJsonEvent(
+	int64_t eventTypeId, 
+	const std::string& mikanJsonEvent, 
+	uint64_t coalesceKey)
+{
+	m_broadcastConnectionIds.clear();
 	for (auto& connection_it : m_clientConnections)
 	{
-		connection_it.second->publishMikanJsonEvent(mikanJsonEvent);
+		if (connection_it.second->getIsSubscribedToEvent(eventTypeId))
+		{
+			m_broadcastConnectionIds.push_back(connection_it.first);
+		}
+	}
+
+	if (!m_broadcastConnectionIds.empty())
+	{
+		sendEventToClients(m_broadcastConnectionIds, mikanJsonEvent, coalesceKey);
+	}
+}
+
+// Clients reading the event ring share a single copy of the event in shared memory,
+// everyone else goes out over the socket.
+// An event too big for the ring leaves a marker in the ring for its readers and goes out over their socket.
+// The client hands out the socket event when it reaches the marker, which keeps the events in order.
+void MikanServer::sendEventToClients(
+	const std::vector<std::string>& connectionIds,
+	const std::string& mikanJsonEvent,
+	uint64_t coalesceKey)
+{
+	EASY_FUNCTION();
+
+	const bool bFitsInEventRing= mikanJsonEvent.size() <= m_eventRing->getMaxEventSize();
+
+	uint64_t readerMask= 0;
+	m_socketConnectionIds.clear();
+	m_oversizedEventConnectionIds.clear();
+	for (const std::string& connectionId : connectionIds)
+	{
+		auto connection_it= m_clientConnections.find(connectionId);
+		const int readerIndex= 
+			connection_it != m_clientConnections.end() 
+			? connection_it->second->getEventRingReaderIndex() 
+			: -1;
+
+		if (m_eventRingReaderMask != 0 && readerIndex >= 0)
+		{
+			readerMask|= 1ull << readerIndex;
+
+			if (!bFitsInEventRing)
+			{
+				m_oversizedEventConnectionIds.push_back(connectionId);
+			}
+		}
+		else
+		{
+			m_socketConnectionIds.push_back(connectionId);
+		}
+	}
+
+	if (readerMask != 0)
+	{
+		if (bFitsInEventRing)
+		{
+			m_eventRing->writeEvent(readerMask, mikanJsonEvent.data(), mikanJsonEvent.size());
+		}
+		else
+		{
+			static const std::string k_socketEventMarker= SHARED_EVENT_RING_SOCKET_EVENT_MARKER;
+
+			// Written before the socket send, so the client always finds the marker first
+			m_eventRing->writeEvent(readerMask, k_socketEventMarker.data(), k_socketEventMarker.size());
+		}
+	}
+
+	if (!m_socketConnectionIds.empty())
+	{
+		m_messageServer->sendMessageToClients(m_socketConnectionIds, mikanJsonEvent, coalesceKey);
+	}
+
+	if (!m_oversizedEventConnectionIds.empty())
+	{
+		// Every marker waits on its own event, so these are never coalesced or dropped
+		m_messageServer->sendMessageToClients(m_oversizedEventConnectionIds, mikanJsonEvent, 0, false);
 	}
 }
 
@@ -625,73 +704,74 @@ void MikanServer::unbindScriptContect(CommonScriptContextPtr scriptContext)
 
 void MikanServer::publishScriptMessageEvent(const std::string& message)
 {
-	for (auto& connection_it : m_clientConnections)
-	{
-		connection_it.second->publishScriptMessageEvent(message);
-	}
+	MikanScriptMessagePostedEvent messageInfo;
+	messageInfo.message = message;
+
+	publishEventToAllClients(messageInfo);
 }
 
 // Video Source Events
 void MikanServer::publishVideoSourceOpenedEvent()
 {
-	publishSimpleEvent<MikanVideoSourceOpenedEvent>(m_clientConnections);
+	markStateSnapshotDirty();
+	publishSimpleEvent<MikanVideoSourceOpenedEvent>();
 }
 
 void MikanServer::publishVideoSourceClosedEvent()
 {
-	publishSimpleEvent<MikanVideoSourceClosedEvent>(m_clientConnections);
+	markStateSnapshotDirty();
+	publishSimpleEvent<MikanVideoSourceClosedEvent>();
 }
 
 void MikanServer::publishVideoSourceNewFrameEvent(const MikanVideoSourceNewFrameEvent& newFrameEvent)
 {
-	EASY_FUNCTION();
-
-	for (auto& connection_it : m_clientConnections)
-	{
-		connection_it.second->publishNewVideoFrameEvent(newFrameEvent);
-	}
+	publishEventToAllClients(newFrameEvent, makeEventCoalesceKey(newFrameEvent.eventTypeId));
 }
 
 void MikanServer::publishVideoSourceAttachmentChangedEvent()
 {
-	publishSimpleEvent<MikanVideoSourceAttachmentChangedEvent>(m_clientConnections);
+	markStateSnapshotDirty();
+	publishSimpleEvent<MikanVideoSourceAttachmentChangedEvent>();
 }
 
 void MikanServer::publishVideoSourceIntrinsicsChangedEvent()
 {
-	publishSimpleEvent<MikanVideoSourceIntrinsicsChangedEvent>(m_clientConnections);
+	markStateSnapshotDirty();
+	publishSimpleEvent<MikanVideoSourceIntrinsicsChangedEvent>();
 }
 
 void MikanServer::publishVideoSourceModeChangedEvent()
 {
-	publishSimpleEvent<MikanVideoSourceModeChangedEvent>(m_clientConnections);
+	markStateSnapshotDirty();
+	publishSimpleEvent<MikanVideoSourceModeChangedEvent>();
 }
 
 // Spatial Anchor Events
 void MikanServer::publishAnchorNameUpdatedEvent(const MikanAnchorNameUpdateEvent& newNameEvent)
 {
-	EASY_FUNCTION();
-
-	for (auto& connection_it : m_clientConnections)
-	{
-		connection_it.second->publishAnchorNameUpdatedEvent(newNameEvent);
-	}
+	publishEventToAllClients(newNameEvent);
 }
 
 void MikanServer::publishAnchorPoseUpdatedEvent(const MikanAnchorPoseUpdateEvent& newPoseEvent)
 {
-	EASY_FUNCTION();
-
-	for (auto& connection_it : m_clientConnections)
-	{
-		connection_it.second->publishAnchorPoseUpdatedEvent(newPoseEvent);
-	}
+	publishEventToAllClients(newPoseEvent, makeEventCoalesceKey(newPoseEvent.eventTypeId, newPoseEvent.anchor_id));
 }
 
 void MikanServer::handleAnchorSystemConfigChange(
 	CommonConfigPtr configPtr,
 	const class ConfigPropertyChangeSet& changedPropertySet)
 {
+	markStateSnapshotDirty();
+
+	if (changedPropertySet.hasPropertyName(AnchorObjectSystemConfig::k_anchorListPropertyId))
+	{
+		syncSceneSpatialAnchorIds();
+	}
+	else if (auto anchorConfig= std::dynamic_pointer_cast<AnchorDefinition>(configPtr))
+	{
+		m_sceneVersionTracker.markObjectChanged(eSceneObjectType::spatialAnchor, anchorConfig->getAnchorId());
+	}
+
 	if (changedPropertySet.hasPropertyName(MikanComponentDefinition::k_componentNamePropertyId))
 	{
 		AnchorDefinitionPtr anchorConfig= std::static_pointer_cast<AnchorDefinition>(configPtr);
@@ -717,35 +797,38 @@ void MikanServer::handleAnchorSystemConfigChange(
 	}
 	else if (changedPropertySet.hasPropertyName(AnchorObjectSystemConfig::k_anchorListPropertyId))
 	{
-		publishSimpleEvent<MikanAnchorListUpdateEvent>(m_clientConnections);
+		publishSimpleEvent<MikanAnchorListUpdateEvent>();
 	}
 }
 
 // Stencil Events
 void MikanServer::publishStencilNameUpdatedEvent(const MikanStencilNameUpdateEvent& newNameEvent)
 {
-	EASY_FUNCTION();
-
-	for (auto& connection_it : m_clientConnections)
-	{
-		connection_it.second->publishStencilNameUpdatedEvent(newNameEvent);
-	}
+	publishEventToAllClients(newNameEvent);
 }
 
 void MikanServer::publishStencilPoseUpdatedEvent(const MikanStencilPoseUpdateEvent& newPoseEvent)
 {
-	EASY_FUNCTION();
-
-	for (auto& connection_it : m_clientConnections)
-	{
-		connection_it.second->publishStencilPoseUpdatedEvent(newPoseEvent);
-	}
+	publishEventToAllClients(newPoseEvent, makeEventCoalesceKey(newPoseEvent.eventTypeId, newPoseEvent.stencil_id));
 }
 
 void MikanServer::handleStencilSystemConfigChange(
 	CommonConfigPtr configPtr,
 	const class ConfigPropertyChangeSet& changedPropertySet)
 {
+	markStateSnapshotDirty();
+
+	if (changedPropertySet.hasPropertyName(StencilObjectSystemConfig::k_quadStencilListPropertyId) ||
+		changedPropertySet.hasPropertyName(StencilObjectSystemConfig::k_boxStencilListPropertyId) ||
+		changedPropertySet.hasPropertyName(StencilObjectSystemConfig::k_modelStencilListPropertyId))
+	{
+		syncSceneStencilIds();
+	}
+	else if (auto stencilConfig= std::dynamic_pointer_cast<StencilComponentDefinition>(configPtr))
+	{
+		m_sceneVersionTracker.markObjectChanged(eSceneObjectType::stencil, stencilConfig->getStencilId());
+	}
+
 	if (changedPropertySet.hasPropertyName(MikanComponentDefinition::k_componentNamePropertyId))
 	{
 		auto anchorConfig = std::static_pointer_cast<StencilComponentDefinition>(configPtr);
@@ -770,30 +853,70 @@ void MikanServer::handleStencilSystemConfigChange(
 	}
 	else if (changedPropertySet.hasPropertyName(StencilObjectSystemConfig::k_quadStencilListPropertyId))
 	{
-		publishSimpleEvent<MikanQuadStencilListUpdateEvent>(m_clientConnections);
+		publishSimpleEvent<MikanQuadStencilListUpdateEvent>();
 	}
 	else if (changedPropertySet.hasPropertyName(StencilObjectSystemConfig::k_boxStencilListPropertyId))
 	{
-		publishSimpleEvent<MikanBoxStencilListUpdateEvent>(m_clientConnections);
+		publishSimpleEvent<MikanBoxStencilListUpdateEvent>();
 	}
 	else if (changedPropertySet.hasPropertyName(StencilObjectSystemConfig::k_modelStencilListPropertyId))
 	{
-		publishSimpleEvent<MikanModelStencilListUpdateEvent>(m_clientConnections);
+		publishSimpleEvent<MikanModelStencilListUpdateEvent>();
 	}
 }
 
 // VRManager Callbacks
 void MikanServer::publishVRDeviceListChanged()
 {
-	publishSimpleEvent<MikanVRDeviceListUpdateEvent>(m_clientConnections);
+	syncSceneVRDeviceIds();
+
+	publishSimpleEvent<MikanVRDeviceListUpdateEvent>();
 }
 
-void MikanServer::publishVRDevicePoses(int64_t newFrameIndex)
+// Scene Versioning
+void MikanServer::syncSceneSpatialAnchorIds()
 {
-	for (auto& connection_it : m_clientConnections)
+	auto anchorSystemConfig= AnchorObjectSystem::getSystem()->getAnchorSystemConfigConst();
+
+	std::set<int32_t> anchorIds;
+	for (AnchorDefinitionPtr anchorConfig : anchorSystemConfig->spatialAnchorList)
+	{
+		anchorIds.insert(anchorConfig->getAnchorId());
+	}
+
+	m_sceneVersionTracker.syncObjectIds(eSceneObjectType::spatialAnchor, anchorIds);
+}
+
+void MikanServer::syncSceneStencilIds()
+{
+	auto stencilSystemConfig= StencilObjectSystem::getSystem()->getStencilSystemConfigConst();
+
+	std::set<int32_t> stencilIds;
+	for (QuadStencilDefinitionPtr quadConfig : stencilSystemConfig->quadStencilList)
+	{
+		stencilIds.insert(quadConfig->getStencilId());
+	}
+	for (BoxStencilDefinitionPtr boxConfig : stencilSystemConfig->boxStencilList)
+	{
+		stencilIds.insert(boxConfig->getStencilId());
+	}
+	for (ModelStencilDefinitionPtr modelConfig : stencilSystemConfig->modelStencilList)
+	{
+		stencilIds.insert(modelConfig->getStencilId());
+	}
+
+	m_sceneVersionTracker.syncObjectIds(eSceneObjectType::stencil, stencilIds);
+}
+
+void MikanServer::syncSceneVRDeviceIds()
+{
+	std::set<int32_t> deviceIds;
+	for (VRDeviceViewPtr deviceView : VRDeviceManager::getInstance()->getVRDeviceList())
 	{
-		connection_it.second->publishVRDevicePoses(newFrameIndex);
+		deviceIds.insert(deviceView->getDeviceID());
 	}
+
+	m_sceneVersionTracker.syncObjectIds(eSceneObjectType::vrDevice, deviceIds);
 }
 
 // RPC Callbacks
@@ -808,18 +931,29 @@ void MikanServer::getConnectedClientInfoList(std::vector<const MikanClientConnec
 	}
 }
 
-static VideoSourceViewPtr getCurrentVideoSource()
+// State Snapshot
+void MikanServer::markStateSnapshotDirty()
 {
-	ProfileConfigConstPtr profileConfig = App::getInstance()->getProfileConfig();
-
-	return VideoSourceListIterator(profileConfig->videoSourcePath).getCurrent();
+	m_objectRequestHandlers->markStateSnapshotDirty();
 }
 
-static VRDeviceViewPtr getCurrentCameraVRDevice()
+void MikanServer::publishStateSnapshot()
 {
-	ProfileConfigConstPtr profileConfig = App::getInstance()->getProfileConfig();
+	std::map<std::string, Serialization::BinaryFormat> clientBinaryFormats;
+	for (auto& connection_it : m_clientConnections)
+	{
+		clientBinaryFormats.insert({connection_it.first, connection_it.second->getBinaryFormat()});
+	}
 
-	return VRDeviceManager::getInstance()->getVRDeviceViewByPath(profileConfig->cameraVRDevicePath);
+	m_objectRequestHandlers->publishStateSnapshot(clientBinaryFormats);
+}
+
+void MikanServer::publishStateSnapshotIfDirty()
+{
+	if (m_objectRequestHandlers->getIsStateSnapshotDirty())
+	{
+		publishStateSnapshot();
+	}
 }
 
 // Connection State Management
@@ -843,6 +977,7 @@ MikanClientConnectionStatePtr MikanServer::allocateClientConnectionState(
 				m_messageServer);
 
 		m_clientConnections.insert({connectionId, clientState});
+		m_eventSubscriberCounts.addFilter(clientState->getEventSubscriptionFilter());
 	}
 
 	return clientState;
@@ -860,9 +995,16 @@ void MikanServer::disposeClientConnectionState(const std::string& connectionId)
 		// (Client may have already done this)
 		disposeClientInfo(connectionState);
 
+		// Let another client have its event ring reader
+		freeEventRingReader(connectionState);
+
+		m_eventSubscriberCounts.removeFilter(connectionState->getEventSubscriptionFilter());
+		m_vrDevicePosePublisher->removeConnection(connectionId);
+
 		// Finally, remove the client connection from the connection list 
 		// (which will delete the client state)
 		m_clientConnections.erase(connection_it);
+		markStateSnapshotDirty();
 	}
 }
 
@@ -873,6 +1015,10 @@ void MikanServer::initClientInfo(MikanClientConnectionStatePtr connectionState,
 	// Fill in the client info and allocate render target read accessor
 	// After this point, the connection can allocate render target textures
 	connectionState->setMikanClientInfo(clientInfo);
+	// The snapshot's binary responses have to follow the binary format the client info picked
+	markStateSnapshotDirty();
+	m_vrDevicePosePublisher->setSupportsPoseBatch(
+		connectionState->getConnectionId(), clientInfo.supportsVRDevicePoseBatch);
 
 	// Tell any listeners that the given client ID has initialized new client info
 	if (OnClientInitialized)
@@ -901,6 +1047,8 @@ bool MikanServer::disposeClientInfo(MikanClientConnectionStatePtr connectionStat
 
 		// Dispose any render target textures and reset the client info to defaults
 		connectionState->clearMikanClientInfo();
+		markStateSnapshotDirty();
+		m_vrDevicePosePublisher->setSupportsPoseBatch(connectionState->getConnectionId(), false);
 		return true;
 	}
 
@@ -928,7 +1076,7 @@ void MikanServer::onClientConnectedHandler(const ClientSocketEvent& event)
 
 			if (!versionString.empty())
 			{
-				int clientProtocol = std::atoi(versionString.c_str());
+				clientProtocol = std::atoi(versionString.c_str());
 
 				bIsClientCompatible= clientProtocol >= MIKAN_MIN_ALLOWED_CLIENT_API_VERSION;
 				break;
@@ -938,6 +1086,9 @@ void MikanServer::onClientConnectedHandler(const ClientSocketEvent& event)
 
 	// Create a new client state for the connection
 	MikanClientConnectionStatePtr clientState= allocateClientConnectionState(event.connectionId);
+	clientState->setClientProtocolVersion(clientProtocol);
+	m_vrDevicePosePublisher->addConnection(event.connectionId);
+	markStateSnapshotDirty();
 
 	// Tell the client if they are compatible with the server
 	// Up to the client to trigger disconnect in response
@@ -951,6 +1102,16 @@ void MikanServer::onClientDisconnectedHandler(const ClientSocketEvent& event)
 		<< ", code: " << event.eventArgs[0]
 		<< ", reason: " << event.eventArgs[1];
 
+	OutboundQueueStats outboundStats;
+	if (m_messageServer->getOutboundQueueStats(event.connectionId, outboundStats) &&
+		(outboundStats.droppedMessageCount > 0 || outboundStats.coalescedMessageCount > 0))
+	{
+		MIKAN_LOG_INFO("onClientDisconnected")
+			<< "connectionId: " << event.connectionId
+			<< ", dropped events: " << outboundStats.droppedMessageCount
+			<< ", coalesced events: " << outboundStats.coalescedMessageCount;
+	}
+
 	disposeClientConnectionState(event.connectionId);
 }
 
@@ -965,7 +1126,7 @@ void MikanServer::onClientErrorHandler(const ClientSocketEvent& event)
 void MikanServer::initClientHandler(const ClientRequest& request, ClientResponse& response)
 {
 	InitClientRequest initClientRequest;
-	if (!readTypedRequest(request.utf8RequestString, initClientRequest) || 
+	if (!readTypedRequest(request, initClientRequest) || 
 		initClientRequest.clientInfo.clientId.getValue().empty())
 	{
 		MIKAN_LOG_ERROR("connectHandler") << "Failed to parse client info";
@@ -1037,246 +1198,222 @@ void MikanServer::disposeClientHandler(const ClientRequest& request, ClientRespo
 	}
 }
 
-void MikanServer::invokeScriptMessageHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
+void MikanServer::subscribeToEventsHandler(const ClientRequest& request, ClientResponse& response)
 {
-	SendScriptMessage scriptMessageRequest;
-	if (!readTypedRequest(request.utf8RequestString, scriptMessageRequest))
+	SubscribeToEvents subscribeRequest;
+	if (!readTypedRequest(request, subscribeRequest))
 	{
 		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
 	}
 
-	// Find the first script context that cares about the message
-	for (auto it = m_scriptContexts.begin(); it < m_scriptContexts.end(); it++)
+	auto connection_it = m_clientConnections.find(request.connectionId);
+	if (connection_it == m_clientConnections.end())
 	{
-		CommonScriptContextPtr scriptContext = it->lock();
-
-		if (scriptContext == scriptContext)
-		{
-			if (scriptContext->invokeScriptMessageHandler(scriptMessageRequest.message.content.getValue()))
-			{
-				break;
-			}
-		}
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::UnknownClient, response);
+		return;
 	}
 
+	MikanClientConnectionStatePtr clientState = connection_it->second;
+	m_eventSubscriberCounts.removeFilter(clientState->getEventSubscriptionFilter());
+	clientState->setSubscribedEvents(subscribeRequest.eventTypeIds);
+	m_eventSubscriberCounts.addFilter(clientState->getEventSubscriptionFilter());
+	m_vrDevicePosePublisher->setEventSubscriptionFilter(request.connectionId, clientState->getEventSubscriptionFilter());
 	writeSimpleJsonResponse(request.requestId, MikanAPIResult::Success, response);
 }
 
-void MikanServer::getVideoSourceIntrinsicsHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
+void MikanServer::openEventRingHandler(const ClientRequest& request, ClientResponse& response)
 {
-	VideoSourceViewPtr videoSourceView= getCurrentVideoSource();
-
-	if (videoSourceView)
+	OpenEventRing openRequest;
+	if (!readTypedRequest(request, openRequest))
 	{
-		MikanVideoSourceIntrinsicsResponse intrinsicsResponse;
-		videoSourceView->getCameraIntrinsics(intrinsicsResponse.intrinsics);
-
-		writeTypedJsonResponse(request.requestId, intrinsicsResponse, response);
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
 	}
-	else
+
+	auto connection_it = m_clientConnections.find(request.connectionId);
+	if (connection_it == m_clientConnections.end())
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::NoVideoSource, response);
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::UnknownClient, response);
+		return;
 	}
-}
 
-void MikanServer::getVideoSourceModeHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
-{
-	VideoSourceViewPtr videoSourceView = getCurrentVideoSource();
-
-	if (videoSourceView)
+	MikanClientConnectionStatePtr clientState = connection_it->second;
+	if (!m_eventRing->getIsValid())
 	{
-		const std::string devicePath= videoSourceView->getUSBDevicePath();
-		const IVideoSourceInterface::eDriverType driverType= videoSourceView->getVideoSourceDriverType();
-		const VideoModeConfig* modeConfig= videoSourceView->getVideoMode();
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::RequestFailed, response);
+		return;
+	}
 
-		if (modeConfig != nullptr)
-		{
-			MikanVideoSourceModeResponse info;
-			info.device_path = devicePath;
-			info.frame_rate = modeConfig->frameRate;
-			info.resolution_x = modeConfig->bufferPixelWidth;
-			info.resolution_y = modeConfig->bufferPixelHeight;
-			info.video_mode_name = modeConfig->modeName;
-			switch (driverType)
-			{
-				case IVideoSourceInterface::OpenCV:
-					info.video_source_api = MikanVideoSourceApi_INVALID;
-					break;
-				case IVideoSourceInterface::WindowsMediaFramework:
-					info.video_source_api = MikanVideoSourceApi_WINDOWS_MEDIA_FOUNDATION;
-					break;
-				case IVideoSourceInterface::INVALID:
-				default:
-					info.video_source_api = MikanVideoSourceApi_INVALID;
-					break;
-			}
-			info.video_source_type = videoSourceView->getIsStereoCamera() ? MikanVideoSourceType_STEREO : MikanVideoSourceType_MONO;
+	// Re-opening starts the client over at the current ring position
+	freeEventRingReader(clientState);
 
-			writeTypedJsonResponse(request.requestId, info, response);
-		}
-		else
-		{
-			writeSimpleJsonResponse(request.requestId, MikanAPIResult::NoVideoSource, response);
-		}
-	}
-	else
+	const int readerIndex= allocateEventRingReader();
+	if (readerIndex < 0)
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::NoVideoSource, response);
+		MIKAN_LOG_WARNING("MikanServer::openEventRingHandler()") 
+			<< "No free event ring readers for connection " << request.connectionId;
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::RequestFailed, response);
+		return;
 	}
+
+	// Every event published from here on goes to the ring instead of the socket
+	clientState->setEventRingReaderIndex(readerIndex);
+
+	MikanEventRingResponse ringResponse;
+	ringResponse.ring_name= m_eventRingName;
+	ringResponse.reader_index= readerIndex;
+	ringResponse.start_position= (int64_t)m_eventRing->getWritePosition();
+	writeTypedJsonResponse(request.requestId, ringResponse, response);
 }
 
-void MikanServer::getVideoSourceAttachmentHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
+void MikanServer::closeEventRingHandler(const ClientRequest& request, ClientResponse& response)
 {
-	VideoSourceViewPtr videoSourceView = getCurrentVideoSource();
-
-	if (videoSourceView)
+	CloseEventRing closeRequest;
+	if (!readTypedRequest(request, closeRequest))
 	{
-		VRDeviceViewPtr vrDeviceView = getCurrentCameraVRDevice();
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
+	}
 
-		if (vrDeviceView)
-		{
-			MikanVideoSourceAttachmentInfoResponse info;
+	auto connection_it = m_clientConnections.find(request.connectionId);
+	if (connection_it == m_clientConnections.end())
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::UnknownClient, response);
+		return;
+	}
 
-			// Get the ID of the VR tracker device
-			info.attached_vr_device_id = (vrDeviceView) ? vrDeviceView->getDeviceID() : INVALID_MIKAN_ID;
+	freeEventRingReader(connection_it->second);
+	writeSimpleJsonResponse(request.requestId, MikanAPIResult::Success, response);
+}
 
-			// Get the camera offset
-			const glm::vec3 cameraOffsetPos = MikanVector3d_to_glm_dvec3(videoSourceView->getCameraOffsetPosition());
-			const glm::quat cameraOffsetQuat = MikanQuatd_to_glm_dquat(videoSourceView->getCameraOffsetOrientation());
-			const glm::mat4 cameraOffsetXform =
-				glm::translate(glm::mat4(1.0), cameraOffsetPos) *
-				glm::mat4_cast(cameraOffsetQuat);
-			info.vr_device_offset_xform = glm_mat4_to_MikanMatrix4f(cameraOffsetXform);
+int MikanServer::allocateEventRingReader()
+{
+	for (int readerIndex= 0; readerIndex < SHARED_EVENT_RING_MAX_READERS; ++readerIndex)
+	{
+		const uint64_t readerBit= 1ull << readerIndex;
 
-			writeTypedJsonResponse(request.requestId, info, response);
-		}
-		else
+		if ((m_eventRingReaderMask & readerBit) == 0)
 		{
-			writeSimpleJsonResponse(request.requestId, MikanAPIResult::NoVideoSource, response);
+			m_eventRingReaderMask|= readerBit;
+			return readerIndex;
 		}
 	}
-	else
-	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::NoVideoSource, response);
-	}
+
+	return -1;
 }
 
-void MikanServer::getVRDeviceListHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
+void MikanServer::freeEventRingReader(MikanClientConnectionStatePtr connectionState)
 {
-	VRDeviceList deviceList= VRDeviceManager::getInstance()->getVRDeviceList();
+	const int readerIndex= connectionState->getEventRingReaderIndex();
 
-	MikanVRDeviceListResponse vrDeviceListResult= {};
-	for (VRDeviceViewPtr deviceView : deviceList)
+	if (readerIndex >= 0)
 	{
-		vrDeviceListResult.vr_device_id_list.push_back(deviceView->getDeviceID());
+		m_eventRingReaderMask&= ~(1ull << readerIndex);
+		connectionState->setEventRingReaderIndex(-1);
 	}
-
-	writeTypedJsonResponse(request.requestId, vrDeviceListResult, response);
 }
 
-void MikanServer::getVRDeviceInfoHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
+void MikanServer::batchRequestHandler(const ClientRequest& request, ClientResponse& response)
 {
-	GetVRDeviceInfo deviceRequest;
-	if (!readTypedRequest(request.utf8RequestString, deviceRequest))
-	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
-		return;
-	}
+	EASY_FUNCTION();
 
-	VRDeviceViewPtr vrDeviceView = VRDeviceManager::getInstance()->getVRDeviceViewById(deviceRequest.deviceId);
-	if (!vrDeviceView)
+	MikanBatchRequest batchRequest;
+	if (!readTypedRequest(request, batchRequest))
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidDeviceId, response);
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
 	}
 
-	MikanVRDeviceInfoResponse infoResponse= {};
-	MikanVRDeviceInfo& info= infoResponse.vr_device_info;
-	info.device_path= vrDeviceView->getDevicePath();
+	MikanBatchResponse batchResponse;
+	batchResponse.requestId = request.requestId;
+	batchResponse.resultCode = MikanAPIResult::Success;
+	batchResponse.responses.reserve(batchRequest.requests.size());
 
-	switch (vrDeviceView->getVRTrackerDriverType())
+	// Run every sub-request through its regular handler, in order, within this tick.
+	// Read-only sub-requests see the effects of the mutating sub-requests ahead of them.
+	const std::size_t batchRequestTypeId = MikanBatchRequest::staticGetArchetype().getId();
+	ClientResponse subResponse;
+	ClientRequestMessage subRequestMessage;
+	for (const Serialization::String& subRequestString : batchRequest.requests)
 	{
-	case IVRDeviceInterface::eDriverType::SteamVR:
-		info.vr_device_api= MikanVRDeviceApi_STEAM_VR;
-		break;
-	default:
-		info.vr_device_api = MikanVRDeviceApi_INVALID;
-	}
+		subRequestMessage.payload = subRequestString.getValue();
 
-	switch (vrDeviceView->getVRDeviceType())
-	{
-	case eDeviceType::HMD:
-		info.vr_device_type = MikanVRDeviceType_HMD;
-		break;
-	case eDeviceType::VRController:
-		info.vr_device_type = MikanVRDeviceType_CONTROLLER;
-		break;
-	case eDeviceType::VRTracker:
-		info.vr_device_type = MikanVRDeviceType_TRACKER;
-		break;
-	default:
-		info.vr_device_type= MikanVRDeviceType_INVALID;
-	}
+		subResponse.utf8String.clear();
+		subResponse.binaryData.clear();
 
-	writeTypedJsonResponse(request.requestId, infoResponse, response);
-}
+		int64_t requestTypeId;
+		int subRequestId;
+		if (ClientRequestDispatch::parseRequest(subRequestMessage, requestTypeId, subRequestId))
+		{
+			ClientRequest subRequest;
+			subRequest.connectionId = request.connectionId;
+			subRequest.requestId = subRequestId;
+			subRequest.utf8RequestData = subRequestMessage.payload.data();
+			subRequest.utf8RequestSize = subRequestMessage.payload.size();
+			subRequest.parsedRequest = subRequestMessage.parsedRequest.get();
+
+			// Batches don't nest
+			if ((std::size_t)requestTypeId == batchRequestTypeId ||
+				!m_messageServer->invokeRequestHandler((std::size_t)requestTypeId, subRequest, subResponse))
+			{
+				writeSimpleJsonResponse(subRequest.requestId, MikanAPIResult::UnknownFunction, subResponse);
+			}
+		}
+		else
+		{
+			// Still answer the sub-request if it has an id, so the client's response future doesn't wait forever
+			JsonSaxIntegerValueSearcher requestIdSearcher;
+			if (requestIdSearcher.fetchKeyValuePair(subRequestMessage.payload, "requestId", subRequestId) &&
+				subRequestId != INVALID_MIKAN_ID)
+			{
+				writeSimpleJsonResponse(subRequestId, MikanAPIResult::MalformedParameters, subResponse);
+			}
+		}
 
-void MikanServer::subscribeToVRDevicePoseUpdatesHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
-{
-	SubscribeToVRDevicePoseUpdates deviceRequest;
-	if (!readTypedRequest(request.utf8RequestString, deviceRequest))
-	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
-		return;
+		if (!subResponse.utf8String.empty())
+		{
+			batchResponse.responses.push_back(Serialization::String());
+			batchResponse.responses.back().setValue(subResponse.utf8String);
+		}
+
+		if (!subResponse.binaryData.empty())
+		{
+			m_messageServer->sendBinaryResponseToClient(request.connectionId, subResponse.binaryData);
+		}
 	}
 
-	auto connection_it = m_clientConnections.find(request.connectionId);
-	if (connection_it == m_clientConnections.end())
+	if (request.requestId != INVALID_MIKAN_ID)
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::UnknownClient, response);
-		return;
+		Serialization::serializeToJsonString(batchResponse, response.utf8String);
 	}
-
-	MikanClientConnectionStatePtr clientState = connection_it->second;
-	clientState->subscribeToVRDevicePoseUpdatesHandler(deviceRequest.deviceId);
-	writeSimpleJsonResponse(request.requestId, MikanAPIResult::Success, response);
 }
 
-void MikanServer::unsubscribeFromVRDevicePoseUpdatesHandler(
+void MikanServer::invokeScriptMessageHandler(
 	const ClientRequest& request,
 	ClientResponse& response)
 {
-	UnsubscribeFromVRDevicePoseUpdates deviceRequest;
-	if (!readTypedRequest(request.utf8RequestString, deviceRequest))
+	SendScriptMessage scriptMessageRequest;
+	if (!readTypedRequest(request, scriptMessageRequest))
 	{
 		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
 	}
 
-	auto connection_it = m_clientConnections.find(request.connectionId);
-	if (connection_it == m_clientConnections.end())
+	// Find the first script context that cares about the message
+	for (auto it = m_scriptContexts.begin(); it < m_scriptContexts.end(); it++)
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::UnknownClient, response);
-		return;
+		CommonScriptContextPtr scriptContext = it->lock();
+
+		if (scriptContext == scriptContext)
+		{
+			if (scriptContext->invokeScriptMessageHandler(scriptMessageRequest.message.content.getValue()))
+			{
+				break;
+			}
+		}
 	}
 
-	MikanClientConnectionStatePtr clientState = connection_it->second;
-	clientState->unsubscribeFromVRDevicePoseUpdatesHandler(deviceRequest.deviceId);
 	writeSimpleJsonResponse(request.requestId, MikanAPIResult::Success, response);
 }
 
@@ -1285,7 +1422,7 @@ void MikanServer::allocateRenderTargetTexturesHandler(
 	ClientResponse& response)
 {	
 	AllocateRenderTargetTextures allocateRequest;
-	if (!readTypedRequest(request.utf8RequestString, allocateRequest))
+	if (!readTypedRequest(request, allocateRequest))
 	{
 		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
@@ -1339,7 +1476,7 @@ void MikanServer::frameRenderedHandler(
 	ClientResponse& response)
 {
 	PublishRenderTargetTextures frameRenderedRequest = {};
-	if (!readTypedRequest(request.utf8RequestString, frameRenderedRequest))
+	if (!readTypedRequest(request, frameRenderedRequest))
 	{
 		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
@@ -1367,213 +1504,149 @@ void MikanServer::frameRenderedHandler(
 	}
 }
 
-void MikanServer::getQuadStencilListHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
+static void appendSceneSpatialAnchor(MikanSpatialAnchorID anchorId, MikanSceneObjects& outScene)
 {
-	MikanStencilListResponse stencilListResult = {};
-
-	auto stencilSystemConfig = App::getInstance()->getProfileConfig()->stencilConfig;
-	for (QuadStencilDefinitionPtr quadConfig : stencilSystemConfig->quadStencilList)
+	AnchorComponentPtr anchorPtr= AnchorObjectSystem::getSystem()->getSpatialAnchorById(anchorId);
+	if (anchorPtr)
 	{
-		stencilListResult.stencil_id_list.push_back(quadConfig->getStencilId());
-	}
-
-	writeTypedJsonResponse(request.requestId, stencilListResult, response);
-}
+		MikanSpatialAnchorInfo anchorInfo;
+		anchorPtr->extractAnchorInfoForClientAPI(anchorInfo);
 
-void MikanServer::getQuadStencilHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
-{
-	GetQuadStencil stencilRequest;
-	if (!readTypedRequest(request.utf8RequestString, stencilRequest))
-	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
-		return;
-	}
-
-	auto stencilSystemConfig = App::getInstance()->getProfileConfig()->stencilConfig;
-	auto quadConfig= stencilSystemConfig->getQuadStencilConfigConst(stencilRequest.stencilId);
-	if (quadConfig != nullptr)
-	{
-		MikanStencilQuadInfoResponse stencilResponse= {};
-		stencilResponse.quad_info= quadConfig->getQuadInfo();
-
-		writeTypedJsonResponse(request.requestId, stencilResponse, response);
-	}
-	else
-	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidStencilID, response);
+		outScene.spatial_anchors.push_back(anchorInfo);
 	}
 }
 
-void MikanServer::getBoxStencilListHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
+static void appendSceneStencil(
+	StencilObjectSystemConfigConstPtr stencilSystemConfig, 
+	MikanStencilID stencilId, 
+	MikanSceneObjects& outScene)
 {
-	MikanStencilListResponse stencilListResult = {};
-
-	auto stencilSystemConfig = App::getInstance()->getProfileConfig()->stencilConfig;
-	for (BoxStencilDefinitionPtr boxConfig : stencilSystemConfig->boxStencilList)
+	if (auto quadConfig= stencilSystemConfig->getQuadStencilConfigConst(stencilId))
 	{
-		stencilListResult.stencil_id_list.push_back(boxConfig->getStencilId());
+		outScene.quad_stencils.push_back(quadConfig->getQuadInfo());
 	}
-
-	writeTypedJsonResponse(request.requestId, stencilListResult, response);
-}
-
-void MikanServer::getBoxStencilHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
-{
-	GetBoxStencil stencilRequest;
-	if (!readTypedRequest(request.utf8RequestString, stencilRequest))
+	else if (auto boxConfig= stencilSystemConfig->getBoxStencilConfigConst(stencilId))
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
-		return;
+		outScene.box_stencils.push_back(boxConfig->getBoxInfo());
 	}
-
-	auto stencilSystemConfig = App::getInstance()->getProfileConfig()->stencilConfig;
-	auto boxConfig = stencilSystemConfig->getBoxStencilConfigConst(stencilRequest.stencilId);
-	if (boxConfig != nullptr)
+	else if (auto modelConfig= stencilSystemConfig->getModelStencilConfigConst(stencilId))
 	{
-		MikanStencilBoxInfoResponse stencilResponse;
-		stencilResponse.box_info = boxConfig->getBoxInfo();
-
-		writeTypedJsonResponse(request.requestId, stencilResponse, response);
-	}
-	else
-	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidStencilID, response);
+		outScene.model_stencils.push_back(modelConfig->getModelInfo());
 	}
 }
 
-void MikanServer::getModelStencilListHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
+static void appendSceneVRDevice(
+	const IServerObjectSystems* objectSystems,
+	MikanVRDeviceID deviceId,
+	MikanSceneObjects& outScene)
 {
-	MikanStencilListResponse stencilListResult = {};
-
-	auto stencilSystemConfig = App::getInstance()->getProfileConfig()->stencilConfig;
-	for (ModelStencilDefinitionPtr modelConfig : stencilSystemConfig->modelStencilList)
+	MikanVRDeviceDescriptor descriptor;
+	if (objectSystems->getVRDeviceInfo(deviceId, descriptor.vr_device_info))
 	{
-		stencilListResult.stencil_id_list.push_back(modelConfig->getStencilId());
-	}
+		descriptor.device_id= deviceId;
 
-	writeTypedJsonResponse(request.requestId, stencilListResult, response);
+		outScene.vr_devices.push_back(descriptor);
+	}
 }
 
-void MikanServer::getModelStencilHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
+static void extractSceneObjects(const IServerObjectSystems* objectSystems, MikanSceneObjects& outScene)
 {
-	GetModelStencil stencilRequest;
-	if (!readTypedRequest(request.utf8RequestString, stencilRequest))
+	auto anchorSystemConfig= AnchorObjectSystem::getSystem()->getAnchorSystemConfigConst();
+	for (AnchorDefinitionPtr anchorConfig : anchorSystemConfig->spatialAnchorList)
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
-		return;
+		appendSceneSpatialAnchor(anchorConfig->getAnchorId(), outScene);
 	}
 
-	auto stencilSystemConfig = App::getInstance()->getProfileConfig()->stencilConfig;
-	auto modelConfig = stencilSystemConfig->getModelStencilConfigConst(stencilRequest.stencilId);
-	if (modelConfig != nullptr)
+	auto stencilSystemConfig= StencilObjectSystem::getSystem()->getStencilSystemConfigConst();
+	for (QuadStencilDefinitionPtr quadConfig : stencilSystemConfig->quadStencilList)
 	{
-		MikanStencilModelInfoResponse stencilResponse = {};
-		stencilResponse.model_info = modelConfig->getModelInfo();
-
-		writeTypedJsonResponse(request.requestId, stencilResponse, response);
+		outScene.quad_stencils.push_back(quadConfig->getQuadInfo());
 	}
-	else
+	for (BoxStencilDefinitionPtr boxConfig : stencilSystemConfig->boxStencilList)
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidStencilID, response);
+		outScene.box_stencils.push_back(boxConfig->getBoxInfo());
 	}
-}
-
-void MikanServer::getModelStencilRenderGeometryHandler(const ClientRequest& request, ClientResponse& response)
-{
-	GetModelStencilRenderGeometry stencilRequest;
-	if (!readTypedRequest(request.utf8RequestString, stencilRequest))
+	for (ModelStencilDefinitionPtr modelConfig : stencilSystemConfig->modelStencilList)
 	{
-		writeSimpleBinaryResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
-		return;
+		outScene.model_stencils.push_back(modelConfig->getModelInfo());
 	}
 
-	ModelStencilComponentPtr modelStencil= 
-		StencilObjectSystem::getSystem()->getModelStencilById(stencilRequest.stencilId);
-	if (modelStencil)
-	{
-		MikanStencilModelRenderGeometryResponse renderGeometryResponse = {};
-		modelStencil->extractRenderGeometry(renderGeometryResponse.render_geometry);
-
-		writeTypedBinaryResponse(request.requestId, renderGeometryResponse, response);
-	}
-	else
+	std::vector<MikanVRDeviceID> deviceIds;
+	objectSystems->getVRDeviceIdList(deviceIds);
+	for (MikanVRDeviceID deviceId : deviceIds)
 	{
-		writeSimpleBinaryResponse(request.requestId, MikanAPIResult::InvalidStencilID, response);
+		appendSceneVRDevice(objectSystems, deviceId, outScene);
 	}
 }
 
-void MikanServer::getSpatialAnchorListHandler(
+void MikanServer::getSceneSnapshotHandler(
 	const ClientRequest& request,
 	ClientResponse& response)
 {
-	MikanSpatialAnchorListResponse anchorListResult= {};
+	EASY_FUNCTION();
 
-	auto anchorSystemConfig = App::getInstance()->getProfileConfig()->anchorConfig;
-	for (AnchorDefinitionPtr spatialAnchor : anchorSystemConfig->spatialAnchorList)
-	{
-		anchorListResult.spatial_anchor_id_list.push_back(spatialAnchor->getAnchorId());
-	}
+	MikanSceneSnapshotResponse snapshotResponse= {};
+	snapshotResponse.scene_version= m_sceneVersionTracker.getSceneVersion();
+	extractSceneObjects(m_objectSystems, snapshotResponse.scene);
 
-	writeTypedJsonResponse(request.requestId, anchorListResult, response);
+	writeTypedJsonResponse(request.requestId, snapshotResponse, response);
 }
 
-void MikanServer::getSpatialAnchorInfoHandler(
+void MikanServer::getSceneDeltaHandler(
 	const ClientRequest& request,
 	ClientResponse& response)
 {
-	GetSpatialAnchorInfo anchorRequest;
-	if (!readTypedRequest(request.utf8RequestString, anchorRequest))
+	EASY_FUNCTION();
+
+	GetSceneDelta deltaRequest;
+	if (!readTypedRequest(request, deltaRequest))
 	{
 		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
 	}
 
-	AnchorComponentPtr anchorPtr= AnchorObjectSystem::getSystem()->getSpatialAnchorById(anchorRequest.anchorId);
-	if (anchorPtr == nullptr)
+	MikanSceneDeltaResponse deltaResponse= {};
+	deltaResponse.scene_version= m_sceneVersionTracker.getSceneVersion();
+
+	if (!m_sceneVersionTracker.canComputeDelta(deltaRequest.sinceVersion))
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidAnchorID, response);
+		deltaResponse.is_full_snapshot= true;
+		extractSceneObjects(m_objectSystems, deltaResponse.changed);
+
+		writeTypedJsonResponse(request.requestId, deltaResponse, response);
 		return;
 	}
-	
-	MikanSpatialAnchorInfoResponse anchorInfoResponse = {};
-	anchorPtr->extractAnchorInfoForClientAPI(anchorInfoResponse.anchor_info);
 
-	writeTypedJsonResponse(request.requestId, anchorInfoResponse, response);
-}
+	deltaResponse.is_full_snapshot= false;
 
-void MikanServer::findSpatialAnchorInfoByNameHandler(
-	const ClientRequest& request,
-	ClientResponse& response)
-{
-	FindSpatialAnchorInfoByName anchorRequest;
-	if (!readTypedRequest(request.utf8RequestString, anchorRequest))
+	std::vector<int32_t> objectIds;
+	m_sceneVersionTracker.getChangedObjectIds(eSceneObjectType::spatialAnchor, deltaRequest.sinceVersion, objectIds);
+	for (int32_t anchorId : objectIds)
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
-		return;
+		appendSceneSpatialAnchor(anchorId, deltaResponse.changed);
 	}
 
-	const std::string& anchorName= anchorRequest.anchorName.getValue();
-	AnchorComponentPtr anchorPtr = AnchorObjectSystem::getSystem()->getSpatialAnchorByName(anchorName);
-	if (anchorPtr == nullptr)
+	objectIds.clear();
+	m_sceneVersionTracker.getChangedObjectIds(eSceneObjectType::stencil, deltaRequest.sinceVersion, objectIds);
+	auto stencilSystemConfig= StencilObjectSystem::getSystem()->getStencilSystemConfigConst();
+	for (int32_t stencilId : objectIds)
 	{
-		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidAnchorID, response);
-		return;
+		appendSceneStencil(stencilSystemConfig, stencilId, deltaResponse.changed);
+	}
+
+	objectIds.clear();
+	m_sceneVersionTracker.getChangedObjectIds(eSceneObjectType::vrDevice, deltaRequest.sinceVersion, objectIds);
+	for (int32_t deviceId : objectIds)
+	{
+		appendSceneVRDevice(m_objectSystems, deviceId, deltaResponse.changed);
 	}
 
-	MikanSpatialAnchorInfoResponse anchorInfoResponse = {};
-	anchorPtr->extractAnchorInfoForClientAPI(anchorInfoResponse.anchor_info);
+	m_sceneVersionTracker.getRemovedObjectIds(
+		eSceneObjectType::spatialAnchor, deltaRequest.sinceVersion, deltaResponse.removed_spatial_anchor_ids);
+	m_sceneVersionTracker.getRemovedObjectIds(
+		eSceneObjectType::stencil, deltaRequest.sinceVersion, deltaResponse.removed_stencil_ids);
+	m_sceneVersionTracker.getRemovedObjectIds(
+		eSceneObjectType::vrDevice, deltaRequest.sinceVersion, deltaResponse.removed_vr_device_ids);
 
-	writeTypedJsonResponse(request.requestId, anchorInfoResponse, response);
+	writeTypedJsonResponse(request.requestId, deltaResponse, response);
 }
\ No newline at end of file
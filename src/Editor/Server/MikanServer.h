@@ -3,6 +3,7 @@
 
 //-- includes -----
 #include "CommonConfigFwd.h"
+#include "EventSubscriptionFilter.h"
 #include "InterprocessMessageServerInterface.h"
 #include "ScriptingFwd.h"
 #include "MikanAPITypes.h"
@@ -14,11 +15,14 @@
 #include "MikanVideoSourceEvents.h"
 #include "MikanVRDeviceEvents.h"
 #include "MulticastDelegate.h"
+#include "SceneVersionTracker.h"
 #include "glm/ext/matrix_float4x4.hpp"
 #include "stdint.h"
 
-#include <map>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 class MikanClientConnectionState;
 using MikanClientConnectionStatePtr= std::shared_ptr<MikanClientConnectionState>;
@@ -66,7 +70,8 @@ public:
 	void update();
 	void shutdown();
 
-	void publishMikanJsonEvent(const std::string& mikanJsonEvent);
+	bool hasEventSubscribers(int64_t eventTypeId) const;
+	void publishMikanJsonEvent(int64_t eventTypeId, const std::string& mikanJsonEvent, uint64_t coalesceKey= 0);
 
 	// Scripting
 	void bindScriptContect(CommonScriptContextPtr scriptContext);
@@ -115,45 +120,80 @@ protected:
 	// Request Callbacks
 	void initClientHandler(const ClientRequest& request, ClientResponse& response);
 	void disposeClientHandler(const ClientRequest& request, ClientResponse& response);
+	void subscribeToEventsHandler(const ClientRequest& request, ClientResponse& response);
+	void openEventRingHandler(const ClientRequest& request, ClientResponse& response);
+	void closeEventRingHandler(const ClientRequest& request, ClientResponse& response);
+	void batchRequestHandler(const ClientRequest& request, ClientResponse& response);
 
 	void invokeScriptMessageHandler(const ClientRequest& request, ClientResponse& response);
-	
-	void getVideoSourceIntrinsicsHandler(const ClientRequest& request, ClientResponse& response);
-	void getVideoSourceModeHandler(const ClientRequest& request, ClientResponse& response);
-	void getVideoSourceAttachmentHandler(const ClientRequest& request, ClientResponse& response);
-
-	void getVRDeviceListHandler(const ClientRequest& request, ClientResponse& response);
-	void getVRDeviceInfoHandler(const ClientRequest& request, ClientResponse& response);
-	void subscribeToVRDevicePoseUpdatesHandler(const ClientRequest& request, ClientResponse& response);
-	void unsubscribeFromVRDevicePoseUpdatesHandler(const ClientRequest& request, ClientResponse& response);
 
 	void allocateRenderTargetTexturesHandler(const ClientRequest& request, ClientResponse& response);
 	void freeRenderTargetTexturesHandler(const ClientRequest& request, ClientResponse& response);
 	void frameRenderedHandler(const ClientRequest& request, ClientResponse& response);
 
-	void getQuadStencilListHandler(const ClientRequest& request, ClientResponse& response);
-	void getQuadStencilHandler(const ClientRequest& request, ClientResponse& response);
-	void getBoxStencilListHandler(const ClientRequest& request, ClientResponse& response);
-	void getBoxStencilHandler(const ClientRequest& request, ClientResponse& response);
-	void getModelStencilListHandler(const ClientRequest& request, ClientResponse& response);
-	void getModelStencilHandler(const ClientRequest& request, ClientResponse& response);
-	void getModelStencilRenderGeometryHandler(const ClientRequest& request, ClientResponse& response);
+	void getSceneSnapshotHandler(const ClientRequest& request, ClientResponse& response);
+	void getSceneDeltaHandler(const ClientRequest& request, ClientResponse& response);
+
+	// State Snapshot
+	void markStateSnapshotDirty();
+	void publishStateSnapshotIfDirty();
+	void publishStateSnapshot();
 
-	void getSpatialAnchorListHandler(const ClientRequest& request, ClientResponse& response);
-	void getSpatialAnchorInfoHandler(const ClientRequest& request, ClientResponse& response);
-	void findSpatialAnchorInfoByNameHandler(const ClientRequest& request, ClientResponse& response);
+	// Scene Versioning
+	void syncSceneSpatialAnchorIds();
+	void syncSceneStencilIds();
+	void syncSceneVRDeviceIds();
 
 	// VRManager Callbacks
 	void publishVRDeviceListChanged();
-	void publishVRDevicePoses(int64_t newFrameIndex);
+
+	// Event Ring
+	int allocateEventRingReader();
+	void freeEventRingReader(MikanClientConnectionStatePtr connectionState);
+
+	// Broadcast Helpers
+	void sendEventToClients(
+		const std::vector<std::string>& connectionIds, 
+		const std::string& mikanJsonEvent, 
+		uint64_t coalesceKey);
+	template <typename t_mikan_type>
+	void publishEventToAllClients(const t_mikan_type& mikanEvent, uint64_t coalesceKey= 0);
+	template <typename t_mikan_type>
+	void publishSimpleEvent();
 
 private:
 	static MikanServer* m_instance;
 	class RemoteControlManager* m_remoteControlManager;
 
 	std::vector<CommonScriptContextWeakPtr> m_scriptContexts;
-	std::map<std::string, MikanClientConnectionStatePtr> m_clientConnections;
+	// Looked up by connection id on every event fan-out and request, never iterated in order
+	std::unordered_map<std::string, MikanClientConnectionStatePtr> m_clientConnections;
 	class IInterprocessMessageServer* m_messageServer;
+
+	// Runs the read-only request handlers against the latest state snapshot
+	class RequestWorkerPool* m_requestWorkerPool;
+
+	// Anchor, stencil, video source and VR device requests and pose updates,
+	// which only reach the editor's systems through m_objectSystems
+	class IServerObjectSystems* m_objectSystems;
+	class ServerObjectRequestHandlers* m_objectRequestHandlers;
+	class VRDevicePosePublisher* m_vrDevicePosePublisher;
+
+	// Events for clients on this machine that opened the shared memory event ring.
+	// Each of those clients owns a reader bit in m_eventRingReaderMask.
+	class SharedEventRingWriter* m_eventRing;
+	std::string m_eventRingName;
+	uint64_t m_eventRingReaderMask= 0;
+
+	// Reused by every broadcast so fanning out an event doesn't allocate
+	std::string m_broadcastJsonBuffer;
+	std::vector<std::string> m_broadcastConnectionIds;
+	std::vector<std::string> m_socketConnectionIds;
+	std::vector<std::string> m_oversizedEventConnectionIds;
+
+	SceneVersionTracker m_sceneVersionTracker;
+	// Lets hasEventSubscribers() skip events no connection wants without walking the connections
+	EventSubscriberCounts m_eventSubscriberCounts;
 };
 
 #endif // MIKAN_SERVER_H
\ No newline at end of file
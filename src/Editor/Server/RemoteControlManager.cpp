@@ -15,8 +15,6 @@
 
 #include <functional>
 
-using namespace std::placeholders;
-
 template <typename t_app_stage_class>
 class TypedRemoteControllableAppStageFactory : public RemoteControllableAppStageFactory
 {
@@ -49,16 +47,16 @@ bool RemoteControlManager::startup(MainWindow* mainWindow)
 	// Register remote control request handlers
 	messageServer->setRequestHandler(
 		PushAppStage::staticGetArchetype().getId(),
-		std::bind(&RemoteControlManager::pushAppStageHandler, this, _1, _2));
+		RequestHandler::bind<&RemoteControlManager::pushAppStageHandler>(this));
 	messageServer->setRequestHandler(
 		PopAppStage::staticGetArchetype().getId(),
-		std::bind(&RemoteControlManager::popAppStageHandler, this, _1, _2));
+		RequestHandler::bind<&RemoteControlManager::popAppStageHandler>(this));
 	messageServer->setRequestHandler(
 		GetAppStageInfo::staticGetArchetype().getId(),
-		std::bind(&RemoteControlManager::getAppStageInfoHandler, this, _1, _2));
+		RequestHandler::bind<&RemoteControlManager::getAppStageInfoHandler>(this));
 	messageServer->setRequestHandler(
 		MikanRemoteControlCommand::staticGetArchetype().getId(),
-		std::bind(&RemoteControlManager::remoteControlCommandHandler, this, _1, _2));
+		RequestHandler::bind<&RemoteControlManager::remoteControlCommandHandler>(this));
 
 	// Create the factories for the remote-controllable app stages
 	m_remoteControllableAppStageFactories[AppStage_AlignmentCalibration::APP_STAGE_NAME]=
@@ -78,7 +76,7 @@ void RemoteControlManager::pushAppStageHandler(
 	ClientResponse& response)
 {
 	PushAppStage appStageRequest;
-	if (!readTypedRequest(request.utf8RequestString, appStageRequest))
+	if (!readTypedRequest(request, appStageRequest))
 	{
 		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
@@ -108,7 +106,7 @@ void RemoteControlManager::popAppStageHandler(
 	ClientResponse& response)
 {
 	PopAppStage appStageRequest;
-	if (!readTypedRequest(request.utf8RequestString, appStageRequest))
+	if (!readTypedRequest(request, appStageRequest))
 	{
 		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
@@ -132,7 +130,7 @@ void RemoteControlManager::getAppStageInfoHandler(
 	ClientResponse& response)
 {
 	GetAppStageInfo getAppStageRequest;
-	if (!readTypedRequest(request.utf8RequestString, getAppStageRequest))
+	if (!readTypedRequest(request, getAppStageRequest))
 	{
 		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
@@ -151,7 +149,7 @@ void RemoteControlManager::remoteControlCommandHandler(
 	ClientResponse& response)
 {
 	MikanRemoteControlCommand remoteControlCommand;
-	if (!readTypedRequest(request.utf8RequestString, remoteControlCommand))
+	if (!readTypedRequest(request, remoteControlCommand))
 	{
 		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
 		return;
@@ -229,12 +227,15 @@ void RemoteControlManager::publishAppStageChangedEvent(
 	const std::string& newAppStageName)
 {
 	MikanAppStageChangedEvent appStageChangedEvent = {};
+	if (!m_owner->hasEventSubscribers(appStageChangedEvent.eventTypeId))
+		return;
+
 	appStageChangedEvent.old_app_state_name.setValue(oldAppStageName);
 	appStageChangedEvent.new_app_state_name.setValue(newAppStageName);
 
 	std::string jsonStr;
 	Serialization::serializeToJsonString(appStageChangedEvent, jsonStr);
-	m_owner->publishMikanJsonEvent(jsonStr);
+	m_owner->publishMikanJsonEvent(appStageChangedEvent.eventTypeId, jsonStr);
 }
 
 void RemoteControlManager::sendRemoteControlEvent(
@@ -242,6 +243,9 @@ void RemoteControlManager::sendRemoteControlEvent(
 	const std::vector<std::string>& parameters)
 {
 	MikanRemoteControlEvent remoteControlEvent = {};
+	if (!m_owner->hasEventSubscribers(remoteControlEvent.eventTypeId))
+		return;
+
 	remoteControlEvent.remoteControlEvent.setValue(event);
 
 	const size_t parameterCount = parameters.size();
@@ -257,5 +261,5 @@ void RemoteControlManager::sendRemoteControlEvent(
 
 	std::string jsonStr;
 	Serialization::serializeToJsonString(remoteControlEvent, jsonStr);
-	m_owner->publishMikanJsonEvent(jsonStr);
+	m_owner->publishMikanJsonEvent(remoteControlEvent.eventTypeId, jsonStr);
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "SceneVersionTracker.h"
+
+SceneVersionTracker::SceneVersionTracker(std::size_t maxRemovedObjects, uint32_t runId)
+	: m_maxRemovedObjects(maxRemovedObjects)
+	// Masked so versions stay positive
+	, m_sceneVersion((int64_t)(runId & 0x7fffffff) << 32)
+	, m_oldestDeltaVersion(m_sceneVersion)
+{
+}
+
+bool SceneVersionTracker::canComputeDelta(int64_t sinceVersion) const
+{
+	// Versions from an earlier run of the server fall outside of this run's range
+	return sinceVersion >= m_oldestDeltaVersion && sinceVersion <= m_sceneVersion;
+}
+
+void SceneVersionTracker::markObjectChanged(eSceneObjectType objectType, int32_t objectId)
+{
+	m_sceneVersion++;
+	m_liveObjectVersions[{objectType, objectId}]= m_sceneVersion;
+}
+
+void SceneVersionTracker::markObjectRemoved(eSceneObjectType objectType, int32_t objectId)
+{
+	auto it= m_liveObjectVersions.find({objectType, objectId});
+	if (it == m_liveObjectVersions.end())
+		return;
+
+	m_liveObjectVersions.erase(it);
+
+	m_sceneVersion++;
+	m_removedObjects.push_back({{objectType, objectId}, m_sceneVersion});
+
+	// Deltas that would have needed the forgotten removal now need a full snapshot
+	while (m_removedObjects.size() > m_maxRemovedObjects)
+	{
+		m_oldestDeltaVersion= m_removedObjects.front().version;
+		m_removedObjects.pop_front();
+	}
+}
+
+void SceneVersionTracker::syncObjectIds(eSceneObjectType objectType, const std::set<int32_t>& liveObjectIds)
+{
+	std::vector<int32_t> removedObjectIds;
+	for (auto it= m_liveObjectVersions.lower_bound({objectType, INT32_MIN});
+		 it != m_liveObjectVersions.end() && it->first.first == objectType;
+		 ++it)
+	{
+		if (liveObjectIds.find(it->first.second) == liveObjectIds.end())
+		{
+			removedObjectIds.push_back(it->first.second);
+		}
+	}
+
+	for (int32_t objectId : removedObjectIds)
+	{
+		markObjectRemoved(objectType, objectId);
+	}
+
+	for (int32_t objectId : liveObjectIds)
+	{
+		if (m_liveObjectVersions.find({objectType, objectId}) == m_liveObjectVersions.end())
+		{
+			markObjectChanged(objectType, objectId);
+		}
+	}
+}
+
+void SceneVersionTracker::getChangedObjectIds(
+	eSceneObjectType objectType, 
+	int64_t sinceVersion, 
+	std::vector<int32_t>& outObjectIds) const
+{
+	for (auto it= m_liveObjectVersions.lower_bound({objectType, INT32_MIN});
+		 it != m_liveObjectVersions.end() && it->first.first == objectType;
+		 ++it)
+	{
+		if (it->second > sinceVersion)
+		{
+			outObjectIds.push_back(it->first.second);
+		}
+	}
+}
+
+void SceneVersionTracker::getRemovedObjectIds(
+	eSceneObjectType objectType, 
+	int64_t sinceVersion, 
+	std::vector<int32_t>& outObjectIds) const
+{
+	std::set<int32_t> removedObjectIds;
+	for (const RemovedObject& removedObject : m_removedObjects)
+	{
+		// An object removed and then re-added since is reported as changed instead
+		if (removedObject.version > sinceVersion && 
+			removedObject.key.first == objectType &&
+			m_liveObjectVersions.find(removedObject.key) == m_liveObjectVersions.end())
+		{
+			removedObjectIds.insert(removedObject.key.second);
+		}
+	}
+
+	outObjectIds.insert(outObjectIds.end(), removedObjectIds.begin(), removedObjectIds.end());
+}
\ No newline at end of file
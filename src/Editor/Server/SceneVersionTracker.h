@@ -0,0 +1,53 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <set>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+enum class eSceneObjectType : int
+{
+	spatialAnchor,
+	stencil,
+	vrDevice
+};
+
+// Stamps every scene object change with a monotonically increasing scene version,
+// so clients can fetch only the objects changed since a version they already have.
+// Removals are remembered for a bounded number of objects, deltas from before the
+// oldest forgotten removal need a full snapshot instead.
+// The run id goes in the upper bits of every version, so versions handed out by an
+// earlier run of the server never look like ones from this run.
+class SceneVersionTracker
+{
+public:
+	SceneVersionTracker(std::size_t maxRemovedObjects= 1024, uint32_t runId= 0);
+
+	inline int64_t getSceneVersion() const { return m_sceneVersion; }
+	bool canComputeDelta(int64_t sinceVersion) const;
+
+	void markObjectChanged(eSceneObjectType objectType, int32_t objectId);
+	void markObjectRemoved(eSceneObjectType objectType, int32_t objectId);
+	// Marks the ids not tracked yet as changed and the tracked ids no longer live as removed
+	void syncObjectIds(eSceneObjectType objectType, const std::set<int32_t>& liveObjectIds);
+
+	void getChangedObjectIds(eSceneObjectType objectType, int64_t sinceVersion, std::vector<int32_t>& outObjectIds) const;
+	void getRemovedObjectIds(eSceneObjectType objectType, int64_t sinceVersion, std::vector<int32_t>& outObjectIds) const;
+
+private:
+	using ObjectKey = std::pair<eSceneObjectType, int32_t>;
+
+	struct RemovedObject
+	{
+		ObjectKey key;
+		int64_t version;
+	};
+
+	std::size_t m_maxRemovedObjects;
+	int64_t m_sceneVersion= 0;
+	int64_t m_oldestDeltaVersion= 0;
+	std::map<ObjectKey, int64_t> m_liveObjectVersions;
+	std::deque<RemovedObject> m_removedObjects;
+};
\ No newline at end of file
@@ -0,0 +1,406 @@
+#include "ServerObjectRequestHandlers.h"
+#include "InterprocessMessageServerInterface.h"
+#include "IServerObjectSystems.h"
+#include "MikanSpatialAnchorRequests.h"
+#include "MikanStencilRequests.h"
+#include "MikanVideoSourceRequests.h"
+#include "MikanVRDeviceRequests.h"
+#include "ServerResponseHelpers.h"
+
+#include <easy/profiler.h>
+
+ServerObjectRequestHandlers::ServerObjectRequestHandlers(IServerObjectSystems* objectSystems)
+	: m_objectSystems(objectSystems)
+{
+}
+
+void ServerObjectRequestHandlers::bindRequestHandlers(IInterprocessMessageServer* messageServer)
+{
+	// Spatial Anchor Requests (read-only)
+	messageServer->setRequestHandler(
+		GetSpatialAnchorList::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getSpatialAnchorListHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		GetSpatialAnchorInfo::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getSpatialAnchorInfoHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		FindSpatialAnchorInfoByName::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::findSpatialAnchorInfoByNameHandler>(this),
+		true);
+
+	// Stencil Requests (read-only)
+	messageServer->setRequestHandler(
+		GetQuadStencilList::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getQuadStencilListHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		GetQuadStencil::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getQuadStencilHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		GetBoxStencilList::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getBoxStencilListHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		GetBoxStencil::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getBoxStencilHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		GetModelStencilList::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getModelStencilListHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		GetModelStencil::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getModelStencilHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		GetModelStencilRenderGeometry::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getModelStencilRenderGeometryHandler>(this),
+		true);
+
+	// Video Source Requests (read-only)
+	messageServer->setRequestHandler(
+		GetVideoSourceIntrinsics::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getVideoSourceIntrinsicsHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		GetVideoSourceMode::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getVideoSourceModeHandler>(this),
+		true);
+	messageServer->setRequestHandler(
+		GetVideoSourceAttachment::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getVideoSourceAttachmentHandler>(this),
+		true);
+
+	// VR Device Requests
+	messageServer->setRequestHandler(
+		GetVRDeviceList::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getVRDeviceListHandler>(this));
+	messageServer->setRequestHandler(
+		GetVRDeviceInfo::staticGetArchetype().getId(),
+		RequestHandler::bind<&ServerObjectRequestHandlers::getVRDeviceInfoHandler>(this));
+}
+
+// State Snapshot
+void ServerObjectRequestHandlers::publishStateSnapshot(
+	const std::map<std::string, Serialization::BinaryFormat>& clientBinaryFormats)
+{
+	EASY_FUNCTION();
+
+	ServerStateSnapshotConstPtr previousSnapshot= getStateSnapshot();
+	auto snapshot= std::make_shared<ServerStateSnapshot>();
+
+	m_objectSystems->extractStateSnapshot(previousSnapshot.get(), *snapshot);
+	snapshot->clientBinaryFormats= clientBinaryFormats;
+
+	std::lock_guard<std::mutex> lock(m_stateSnapshotMutex);
+	m_stateSnapshot= snapshot;
+	m_bIsStateSnapshotDirty= false;
+}
+
+ServerStateSnapshotConstPtr ServerObjectRequestHandlers::getStateSnapshot() const
+{
+	std::lock_guard<std::mutex> lock(m_stateSnapshotMutex);
+	return m_stateSnapshot;
+}
+
+// Spatial Anchor Requests
+void ServerObjectRequestHandlers::getSpatialAnchorListHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+
+	MikanSpatialAnchorListResponse anchorListResult= {};
+	anchorListResult.spatial_anchor_id_list.assign(
+		snapshot->spatialAnchorIds.begin(),
+		snapshot->spatialAnchorIds.end());
+
+	writeTypedJsonResponse(request.requestId, anchorListResult, response);
+}
+
+void ServerObjectRequestHandlers::getSpatialAnchorInfoHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	GetSpatialAnchorInfo anchorRequest;
+	if (!readTypedRequest(request, anchorRequest))
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
+	}
+
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+	const MikanSpatialAnchorInfo* anchorInfo= snapshot->findSpatialAnchorById(anchorRequest.anchorId);
+	if (anchorInfo == nullptr)
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidAnchorID, response);
+		return;
+	}
+
+	MikanSpatialAnchorInfoResponse anchorInfoResponse = {};
+	anchorInfoResponse.anchor_info= *anchorInfo;
+
+	writeTypedJsonResponse(request.requestId, anchorInfoResponse, response);
+}
+
+void ServerObjectRequestHandlers::findSpatialAnchorInfoByNameHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	FindSpatialAnchorInfoByName anchorRequest;
+	if (!readTypedRequest(request, anchorRequest))
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
+	}
+
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+	const std::string& anchorName= anchorRequest.anchorName.getValue();
+	const MikanSpatialAnchorInfo* anchorInfo= snapshot->findSpatialAnchorByName(anchorName);
+	if (anchorInfo == nullptr)
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidAnchorID, response);
+		return;
+	}
+
+	MikanSpatialAnchorInfoResponse anchorInfoResponse = {};
+	anchorInfoResponse.anchor_info= *anchorInfo;
+
+	writeTypedJsonResponse(request.requestId, anchorInfoResponse, response);
+}
+
+// Stencil Requests
+template <typename t_stencil_info>
+static void writeStencilListResponse(
+	MikanRequestID requestId,
+	const std::vector<t_stencil_info>& stencilInfos,
+	ClientResponse& response)
+{
+	MikanStencilListResponse stencilListResult = {};
+	for (const t_stencil_info& stencilInfo : stencilInfos)
+	{
+		stencilListResult.stencil_id_list.push_back(stencilInfo.stencil_id);
+	}
+
+	writeTypedJsonResponse(requestId, stencilListResult, response);
+}
+
+void ServerObjectRequestHandlers::getQuadStencilListHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	writeStencilListResponse(request.requestId, getStateSnapshot()->quadStencils, response);
+}
+
+void ServerObjectRequestHandlers::getQuadStencilHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	GetQuadStencil stencilRequest;
+	if (!readTypedRequest(request, stencilRequest))
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
+	}
+
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+	const MikanStencilQuadInfo* quadInfo= snapshot->findQuadStencil(stencilRequest.stencilId);
+	if (quadInfo != nullptr)
+	{
+		MikanStencilQuadInfoResponse stencilResponse= {};
+		stencilResponse.quad_info= *quadInfo;
+
+		writeTypedJsonResponse(request.requestId, stencilResponse, response);
+	}
+	else
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidStencilID, response);
+	}
+}
+
+void ServerObjectRequestHandlers::getBoxStencilListHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	writeStencilListResponse(request.requestId, getStateSnapshot()->boxStencils, response);
+}
+
+void ServerObjectRequestHandlers::getBoxStencilHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	GetBoxStencil stencilRequest;
+	if (!readTypedRequest(request, stencilRequest))
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
+	}
+
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+	const MikanStencilBoxInfo* boxInfo= snapshot->findBoxStencil(stencilRequest.stencilId);
+	if (boxInfo != nullptr)
+	{
+		MikanStencilBoxInfoResponse stencilResponse;
+		stencilResponse.box_info = *boxInfo;
+
+		writeTypedJsonResponse(request.requestId, stencilResponse, response);
+	}
+	else
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidStencilID, response);
+	}
+}
+
+void ServerObjectRequestHandlers::getModelStencilListHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	writeStencilListResponse(request.requestId, getStateSnapshot()->modelStencils, response);
+}
+
+void ServerObjectRequestHandlers::getModelStencilHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	GetModelStencil stencilRequest;
+	if (!readTypedRequest(request, stencilRequest))
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
+	}
+
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+	const MikanStencilModelInfo* modelInfo= snapshot->findModelStencil(stencilRequest.stencilId);
+	if (modelInfo != nullptr)
+	{
+		MikanStencilModelInfoResponse stencilResponse = {};
+		stencilResponse.model_info = *modelInfo;
+
+		writeTypedJsonResponse(request.requestId, stencilResponse, response);
+	}
+	else
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidStencilID, response);
+	}
+}
+
+void ServerObjectRequestHandlers::getModelStencilRenderGeometryHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+	const Serialization::BinaryFormat binaryFormat = snapshot->getClientBinaryFormat(request.connectionId);
+
+	GetModelStencilRenderGeometry stencilRequest;
+	if (!readTypedRequest(request, stencilRequest))
+	{
+		writeSimpleBinaryResponse(request.requestId, MikanAPIResult::MalformedParameters, response, binaryFormat);
+		return;
+	}
+
+	ModelStencilGeometryConstPtr renderGeometry= snapshot->findModelStencilGeometry(stencilRequest.stencilId);
+	if (renderGeometry)
+	{
+		MikanStencilModelRenderGeometryResponse renderGeometryResponse = {};
+		renderGeometryResponse.render_geometry= *renderGeometry;
+
+		writeTypedBinaryResponse(request.requestId, renderGeometryResponse, response, binaryFormat);
+	}
+	else
+	{
+		writeSimpleBinaryResponse(request.requestId, MikanAPIResult::InvalidStencilID, response, binaryFormat);
+	}
+}
+
+// Video Source Requests
+void ServerObjectRequestHandlers::getVideoSourceIntrinsicsHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+
+	if (snapshot->bHasVideoSourceIntrinsics)
+	{
+		MikanVideoSourceIntrinsicsResponse intrinsicsResponse= snapshot->videoSourceIntrinsics;
+
+		writeTypedJsonResponse(request.requestId, intrinsicsResponse, response);
+	}
+	else
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::NoVideoSource, response);
+	}
+}
+
+void ServerObjectRequestHandlers::getVideoSourceModeHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+
+	if (snapshot->bHasVideoSourceMode)
+	{
+		MikanVideoSourceModeResponse info= snapshot->videoSourceMode;
+
+		writeTypedJsonResponse(request.requestId, info, response);
+	}
+	else
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::NoVideoSource, response);
+	}
+}
+
+void ServerObjectRequestHandlers::getVideoSourceAttachmentHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	ServerStateSnapshotConstPtr snapshot= getStateSnapshot();
+
+	if (snapshot->bHasVideoSourceAttachment)
+	{
+		MikanVideoSourceAttachmentInfoResponse info= snapshot->videoSourceAttachment;
+
+		writeTypedJsonResponse(request.requestId, info, response);
+	}
+	else
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::NoVideoSource, response);
+	}
+}
+
+// VR Device Requests
+void ServerObjectRequestHandlers::getVRDeviceListHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	std::vector<MikanVRDeviceID> deviceIds;
+	m_objectSystems->getVRDeviceIdList(deviceIds);
+
+	MikanVRDeviceListResponse vrDeviceListResult= {};
+	vrDeviceListResult.vr_device_id_list.assign(deviceIds.begin(), deviceIds.end());
+
+	writeTypedJsonResponse(request.requestId, vrDeviceListResult, response);
+}
+
+void ServerObjectRequestHandlers::getVRDeviceInfoHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	GetVRDeviceInfo deviceRequest;
+	if (!readTypedRequest(request, deviceRequest))
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
+	}
+
+	MikanVRDeviceInfoResponse infoResponse= {};
+	if (!m_objectSystems->getVRDeviceInfo(deviceRequest.deviceId, infoResponse.vr_device_info))
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::InvalidDeviceId, response);
+		return;
+	}
+
+	writeTypedJsonResponse(request.requestId, infoResponse, response);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "BinaryUtility.h"
+#include "ServerStateSnapshot.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+
+class IInterprocessMessageServer;
+class IServerObjectSystems;
+struct ClientRequest;
+struct ClientResponse;
+
+// Spatial anchor, stencil, video source and VR device requests.
+// The read-only handlers only read the published state snapshot, so they run on the
+// request workers. Everything comes from IServerObjectSystems, never the editor directly.
+class ServerObjectRequestHandlers
+{
+public:
+	ServerObjectRequestHandlers(IServerObjectSystems* objectSystems);
+
+	void bindRequestHandlers(IInterprocessMessageServer* messageServer);
+
+	// State Snapshot
+	inline void markStateSnapshotDirty() { m_bIsStateSnapshotDirty= true; }
+	inline bool getIsStateSnapshotDirty() const { return m_bIsStateSnapshotDirty; }
+	void publishStateSnapshot(const std::map<std::string, Serialization::BinaryFormat>& clientBinaryFormats);
+	ServerStateSnapshotConstPtr getStateSnapshot() const;
+
+	// Spatial Anchor Requests (read-only)
+	void getSpatialAnchorListHandler(const ClientRequest& request, ClientResponse& response);
+	void getSpatialAnchorInfoHandler(const ClientRequest& request, ClientResponse& response);
+	void findSpatialAnchorInfoByNameHandler(const ClientRequest& request, ClientResponse& response);
+
+	// Stencil Requests (read-only)
+	void getQuadStencilListHandler(const ClientRequest& request, ClientResponse& response);
+	void getQuadStencilHandler(const ClientRequest& request, ClientResponse& response);
+	void getBoxStencilListHandler(const ClientRequest& request, ClientResponse& response);
+	void getBoxStencilHandler(const ClientRequest& request, ClientResponse& response);
+	void getModelStencilListHandler(const ClientRequest& request, ClientResponse& response);
+	void getModelStencilHandler(const ClientRequest& request, ClientResponse& response);
+	void getModelStencilRenderGeometryHandler(const ClientRequest& request, ClientResponse& response);
+
+	// Video Source Requests (read-only)
+	void getVideoSourceIntrinsicsHandler(const ClientRequest& request, ClientResponse& response);
+	void getVideoSourceModeHandler(const ClientRequest& request, ClientResponse& response);
+	void getVideoSourceAttachmentHandler(const ClientRequest& request, ClientResponse& response);
+
+	// VR Device Requests
+	void getVRDeviceListHandler(const ClientRequest& request, ClientResponse& response);
+	void getVRDeviceInfoHandler(const ClientRequest& request, ClientResponse& response);
+
+private:
+	IServerObjectSystems* m_objectSystems;
+
+	ServerStateSnapshotConstPtr m_stateSnapshot;
+	mutable std::mutex m_stateSnapshotMutex;
+	// Set by the change callbacks, the snapshot is only rebuilt when something in it changed
+	bool m_bIsStateSnapshotDirty= true;
+};
@@ -17,7 +17,11 @@ void writeSimpleJsonResponse(MikanRequestID requestId, MikanAPIResult result, Cl
 	}
 }
 
-void writeSimpleBinaryResponse(MikanRequestID requestId, MikanAPIResult result, ClientResponse& response)
+void writeSimpleBinaryResponse(
+	MikanRequestID requestId, 
+	MikanAPIResult result, 
+	ClientResponse& response,
+	Serialization::BinaryFormat format)
 {
 	// Only write a response if the request ID is valid (i.e. the client expects a response)
 	if (requestId != INVALID_MIKAN_ID)
@@ -26,10 +30,19 @@ void writeSimpleBinaryResponse(MikanRequestID requestId, MikanAPIResult result,
 		mikanResponse.requestId = requestId;
 		mikanResponse.resultCode = result;
 
-		Serialization::serializeToBytes<MikanResponse>(mikanResponse, response.binaryData);
+		Serialization::serializeToBytes<MikanResponse>(mikanResponse, response.binaryData, format);
 	}
 	else
 	{
 		response.binaryData.clear();
 	}
+}
+
+uint64_t makeEventCoalesceKey(int64_t eventTypeId, int64_t objectId)
+{
+	uint64_t key= (uint64_t)eventTypeId;
+	key^= (uint64_t)objectId + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2);
+
+	// Zero means "never coalesce"
+	return key != 0 ? key : 1;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BinaryDeserializer.h"
 #include "BinarySerializer.h"
 #include "JsonDeserializer.h"
 #include "JsonSerializer.h"
@@ -9,20 +10,49 @@
 
 #include <nlohmann/json.hpp>
 
+#include <typeinfo>
+
 using json = nlohmann::json;
 
 template <typename t_mikan_type>
-bool readTypedRequest(const std::string& utf8RequestString, t_mikan_type& outParameters)
+bool readTypedRequest(const ClientRequest& request, t_mikan_type& outParameters)
 {
+	// The dispatcher usually has already deserialized the request.
+	// Check the instance's actual type, its requestTypeId field came from the client.
+	if (request.parsedRequest != nullptr &&
+		typeid(*request.parsedRequest) == typeid(t_mikan_type))
+	{
+		outParameters = *static_cast<const t_mikan_type*>(request.parsedRequest);
+		return true;
+	}
+
 	try
 	{
-		return Serialization::deserializeFromJsonString(utf8RequestString, outParameters);
+		if (request.binaryRequestData != nullptr)
+		{
+			const Serialization::BinaryFormat format = 
+				Serialization::getBinaryFormat(request.binaryRequestData, request.binaryRequestSize);
+
+			return Serialization::deserializeFromBytes(
+				request.binaryRequestData, request.binaryRequestSize,
+				&outParameters, t_mikan_type::staticGetArchetype(), 
+				format);
+		}
+
+		return Serialization::deserializeFromJsonString(
+			request.utf8RequestData, request.utf8RequestSize,
+			&outParameters, t_mikan_type::staticGetArchetype());
 	}
 	catch (json::exception& e)
 	{
 		MIKAN_LOG_ERROR("MikanServer::readRequestPayload") << "Failed to parse JSON: " << e.what();
 		return false;
 	}
+	catch (std::exception& e)
+	{
+		MIKAN_LOG_ERROR("MikanServer::readRequestPayload") << "Failed to parse binary request: " << e.what();
+		return false;
+	}
 }
 
 template <typename t_mikan_type>
@@ -38,13 +68,21 @@ template <typename t_mikan_type>
 void writeTypedBinaryResponse(
 	MikanRequestID requestId,
 	t_mikan_type& result,
-	ClientResponse& response)
+	ClientResponse& response,
+	Serialization::BinaryFormat format= Serialization::BinaryFormat::V1)
 {
 	result.requestId = requestId;
 	result.resultCode = MikanAPIResult::Success;
 
-	Serialization::serializeToBytes<t_mikan_type>(result, response.binaryData);
+	Serialization::serializeToBytes<t_mikan_type>(result, response.binaryData, format);
 }
 
 void writeSimpleJsonResponse(MikanRequestID requestId, MikanAPIResult result, ClientResponse& response);
-void writeSimpleBinaryResponse(MikanRequestID requestId, MikanAPIResult result, ClientResponse& response);
\ No newline at end of file
+void writeSimpleBinaryResponse(
+	MikanRequestID requestId, 
+	MikanAPIResult result, 
+	ClientResponse& response,
+	Serialization::BinaryFormat format= Serialization::BinaryFormat::V1);
+
+// Key for latest-value events: a queued event with the same key is replaced by the newer one
+uint64_t makeEventCoalesceKey(int64_t eventTypeId, int64_t objectId= 0);
\ No newline at end of file
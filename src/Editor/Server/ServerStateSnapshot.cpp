@@ -0,0 +1,66 @@
+#include "ServerStateSnapshot.h"
+
+template <typename t_stencil_info>
+static const t_stencil_info* findStencilInfo(
+	const std::vector<t_stencil_info>& stencilInfos, 
+	MikanStencilID stencilId)
+{
+	for (const t_stencil_info& stencilInfo : stencilInfos)
+	{
+		if (stencilInfo.stencil_id == stencilId)
+			return &stencilInfo;
+	}
+
+	return nullptr;
+}
+
+const MikanSpatialAnchorInfo* ServerStateSnapshot::findSpatialAnchorById(MikanSpatialAnchorID anchorId) const
+{
+	for (const MikanSpatialAnchorInfo& anchorInfo : spatialAnchors)
+	{
+		if (anchorInfo.anchor_id == anchorId)
+			return &anchorInfo;
+	}
+
+	return nullptr;
+}
+
+const MikanSpatialAnchorInfo* ServerStateSnapshot::findSpatialAnchorByName(const std::string& anchorName) const
+{
+	for (const MikanSpatialAnchorInfo& anchorInfo : spatialAnchors)
+	{
+		if (anchorInfo.anchor_name.getValue() == anchorName)
+			return &anchorInfo;
+	}
+
+	return nullptr;
+}
+
+const MikanStencilQuadInfo* ServerStateSnapshot::findQuadStencil(MikanStencilID stencilId) const
+{
+	return findStencilInfo(quadStencils, stencilId);
+}
+
+const MikanStencilBoxInfo* ServerStateSnapshot::findBoxStencil(MikanStencilID stencilId) const
+{
+	return findStencilInfo(boxStencils, stencilId);
+}
+
+const MikanStencilModelInfo* ServerStateSnapshot::findModelStencil(MikanStencilID stencilId) const
+{
+	return findStencilInfo(modelStencils, stencilId);
+}
+
+ModelStencilGeometryConstPtr ServerStateSnapshot::findModelStencilGeometry(MikanStencilID stencilId) const
+{
+	auto it = modelStencilGeometry.find(stencilId);
+
+	return it != modelStencilGeometry.end() ? it->second.geometry : ModelStencilGeometryConstPtr();
+}
+
+Serialization::BinaryFormat ServerStateSnapshot::getClientBinaryFormat(const std::string& connectionId) const
+{
+	auto it = clientBinaryFormats.find(connectionId);
+
+	return it != clientBinaryFormats.end() ? it->second : Serialization::BinaryFormat::V1;
+}
\ No newline at end of file
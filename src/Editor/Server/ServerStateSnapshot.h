@@ -0,0 +1,54 @@
+#pragma once
+
+#include "BinaryUtility.h"
+#include "MikanSpatialAnchorTypes.h"
+#include "MikanStencilTypes.h"
+#include "MikanVideoSourceRequests.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using ModelStencilGeometryConstPtr = std::shared_ptr<const MikanStencilModelRenderGeometry>;
+
+// Copy of the server state read by the read-only request handlers.
+// Built by the main thread once per frame and never modified once published,
+// so the request worker threads can read it without locking.
+struct ServerStateSnapshot
+{
+	std::vector<MikanSpatialAnchorID> spatialAnchorIds;
+	std::vector<MikanSpatialAnchorInfo> spatialAnchors;
+
+	std::vector<MikanStencilQuadInfo> quadStencils;
+	std::vector<MikanStencilBoxInfo> boxStencils;
+	std::vector<MikanStencilModelInfo> modelStencils;
+
+	struct ModelStencilGeometry
+	{
+		int revision;
+		ModelStencilGeometryConstPtr geometry;
+	};
+	// Only extracted again when the stencil's meshes get rebuilt, otherwise shared between snapshots
+	std::map<MikanStencilID, ModelStencilGeometry> modelStencilGeometry;
+
+	// Unset if there is no video source (or no video mode / camera tracker)
+	bool bHasVideoSourceIntrinsics= false;
+	MikanVideoSourceIntrinsicsResponse videoSourceIntrinsics;
+	bool bHasVideoSourceMode= false;
+	MikanVideoSourceModeResponse videoSourceMode;
+	bool bHasVideoSourceAttachment= false;
+	MikanVideoSourceAttachmentInfoResponse videoSourceAttachment;
+
+	// Binary response format picked by each initialized client, keyed by connection id
+	std::map<std::string, Serialization::BinaryFormat> clientBinaryFormats;
+
+	const MikanSpatialAnchorInfo* findSpatialAnchorById(MikanSpatialAnchorID anchorId) const;
+	const MikanSpatialAnchorInfo* findSpatialAnchorByName(const std::string& anchorName) const;
+	const MikanStencilQuadInfo* findQuadStencil(MikanStencilID stencilId) const;
+	const MikanStencilBoxInfo* findBoxStencil(MikanStencilID stencilId) const;
+	const MikanStencilModelInfo* findModelStencil(MikanStencilID stencilId) const;
+	ModelStencilGeometryConstPtr findModelStencilGeometry(MikanStencilID stencilId) const;
+	Serialization::BinaryFormat getClientBinaryFormat(const std::string& connectionId) const;
+};
+using ServerStateSnapshotConstPtr = std::shared_ptr<const ServerStateSnapshot>;
\ No newline at end of file
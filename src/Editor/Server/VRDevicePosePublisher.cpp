@@ -0,0 +1,214 @@
+#include "VRDevicePosePublisher.h"
+#include "EventSubscriptionFilter.h"
+#include "InterprocessMessageServerInterface.h"
+#include "IServerObjectSystems.h"
+#include "JsonSerializer.h"
+#include "MikanVRDeviceEvents.h"
+#include "MikanVRDeviceRequests.h"
+#include "ServerResponseHelpers.h"
+
+#include <easy/profiler.h>
+
+VRDevicePosePublisher::VRDevicePosePublisher(
+	IServerObjectSystems* objectSystems,
+	EventSender eventSender)
+	: m_objectSystems(objectSystems)
+	, m_eventSender(eventSender)
+{
+}
+
+void VRDevicePosePublisher::bindRequestHandlers(IInterprocessMessageServer* messageServer)
+{
+	messageServer->setRequestHandler(
+		SubscribeToVRDevicePoseUpdates::staticGetArchetype().getId(),
+		RequestHandler::bind<&VRDevicePosePublisher::subscribeToVRDevicePoseUpdatesHandler>(this));
+	messageServer->setRequestHandler(
+		UnsubscribeFromVRDevicePoseUpdates::staticGetArchetype().getId(),
+		RequestHandler::bind<&VRDevicePosePublisher::unsubscribeFromVRDevicePoseUpdatesHandler>(this));
+}
+
+// Connections
+void VRDevicePosePublisher::addConnection(const std::string& connectionId)
+{
+	m_subscriptions[connectionId]= PoseSubscription();
+}
+
+void VRDevicePosePublisher::removeConnection(const std::string& connectionId)
+{
+	m_subscriptions.erase(connectionId);
+}
+
+void VRDevicePosePublisher::clearConnections()
+{
+	m_subscriptions.clear();
+}
+
+void VRDevicePosePublisher::setSupportsPoseBatch(const std::string& connectionId, bool bSupportsPoseBatch)
+{
+	auto subscription_it= m_subscriptions.find(connectionId);
+	if (subscription_it != m_subscriptions.end())
+	{
+		subscription_it->second.bSupportsPoseBatch= bSupportsPoseBatch;
+	}
+}
+
+void VRDevicePosePublisher::setEventSubscriptionFilter(
+	const std::string& connectionId,
+	const EventSubscriptionFilter& filter)
+{
+	auto subscription_it= m_subscriptions.find(connectionId);
+	if (subscription_it != m_subscriptions.end())
+	{
+		subscription_it->second.bIsSubscribedToPoseEvents=
+			filter.getIsSubscribedToEvent(MikanVRDevicePoseUpdateEvent::staticGetArchetype().getId()) ||
+			filter.getIsSubscribedToEvent(MikanVRDevicePoseBatchEvent::staticGetArchetype().getId());
+	}
+}
+
+// VRDeviceManager Callbacks
+void VRDevicePosePublisher::publishVRDevicePoses(int64_t newFrameIndex)
+{
+	EASY_FUNCTION();
+
+	// Gather every device that at least one client is subscribed to
+	std::set<MikanVRDeviceID> subscribedDevices;
+	for (auto& subscription_it : m_subscriptions)
+	{
+		const PoseSubscription& subscription= subscription_it.second;
+
+		if (subscription.bIsSubscribedToPoseEvents)
+		{
+			subscribedDevices.insert(subscription.devices.begin(), subscription.devices.end());
+		}
+	}
+
+	// Fetch each subscribed device pose once
+	std::vector<MikanVRDevicePose> devicePoses;
+	for (MikanVRDeviceID deviceId : subscribedDevices)
+	{
+		MikanVRDevicePose devicePose;
+		if (m_objectSystems->getVRDevicePose(deviceId, devicePose.transform))
+		{
+			devicePose.device_id = deviceId;
+
+			devicePoses.push_back(devicePose);
+		}
+	}
+
+	if (devicePoses.empty())
+		return;
+
+	// Clients that can read pose batches get one message for the whole VR frame.
+	// Clients subscribed to the same set of devices share the same serialized batch.
+	std::map<std::set<MikanVRDeviceID>, std::vector<std::string>> batchRecipients;
+	for (auto& subscription_it : m_subscriptions)
+	{
+		const PoseSubscription& subscription= subscription_it.second;
+
+		if (subscription.bSupportsPoseBatch &&
+			subscription.bIsSubscribedToPoseEvents &&
+			!subscription.devices.empty())
+		{
+			batchRecipients[subscription.devices].push_back(subscription_it.first);
+		}
+	}
+
+	for (auto& recipients_it : batchRecipients)
+	{
+		const std::set<MikanVRDeviceID>& batchDevices= recipients_it.first;
+
+		MikanVRDevicePoseBatchEvent poseBatch;
+		poseBatch.frame = newFrameIndex;
+		for (const MikanVRDevicePose& devicePose : devicePoses)
+		{
+			if (batchDevices.find(devicePose.device_id) != batchDevices.end())
+			{
+				poseBatch.poses.push_back(devicePose);
+			}
+		}
+
+		if (!poseBatch.poses.empty())
+		{
+			Serialization::serializeToJsonString(poseBatch, m_eventJsonBuffer);
+			m_eventSender(
+				recipients_it.second, m_eventJsonBuffer,
+				makeEventCoalesceKey(poseBatch.eventTypeId));
+		}
+	}
+
+	// Older clients get a separate pose update per device,
+	// serialized once for all of the clients subscribed to that device
+	for (const MikanVRDevicePose& devicePose : devicePoses)
+	{
+		m_recipientConnectionIds.clear();
+		for (auto& subscription_it : m_subscriptions)
+		{
+			const PoseSubscription& subscription= subscription_it.second;
+
+			if (!subscription.bSupportsPoseBatch &&
+				subscription.bIsSubscribedToPoseEvents &&
+				subscription.devices.find(devicePose.device_id) != subscription.devices.end())
+			{
+				m_recipientConnectionIds.push_back(subscription_it.first);
+			}
+		}
+
+		if (!m_recipientConnectionIds.empty())
+		{
+			MikanVRDevicePoseUpdateEvent poseUpdate;
+			poseUpdate.transform = devicePose.transform;
+			poseUpdate.device_id = devicePose.device_id;
+			poseUpdate.frame = newFrameIndex;
+
+			Serialization::serializeToJsonString(poseUpdate, m_eventJsonBuffer);
+			m_eventSender(
+				m_recipientConnectionIds, m_eventJsonBuffer,
+				makeEventCoalesceKey(poseUpdate.eventTypeId, poseUpdate.device_id));
+		}
+	}
+}
+
+// Request Callbacks
+void VRDevicePosePublisher::subscribeToVRDevicePoseUpdatesHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	SubscribeToVRDevicePoseUpdates deviceRequest;
+	if (!readTypedRequest(request, deviceRequest))
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
+	}
+
+	auto subscription_it = m_subscriptions.find(request.connectionId);
+	if (subscription_it == m_subscriptions.end())
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::UnknownClient, response);
+		return;
+	}
+
+	subscription_it->second.devices.insert(deviceRequest.deviceId);
+	writeSimpleJsonResponse(request.requestId, MikanAPIResult::Success, response);
+}
+
+void VRDevicePosePublisher::unsubscribeFromVRDevicePoseUpdatesHandler(
+	const ClientRequest& request,
+	ClientResponse& response)
+{
+	UnsubscribeFromVRDevicePoseUpdates deviceRequest;
+	if (!readTypedRequest(request, deviceRequest))
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+		return;
+	}
+
+	auto subscription_it = m_subscriptions.find(request.connectionId);
+	if (subscription_it == m_subscriptions.end())
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::UnknownClient, response);
+		return;
+	}
+
+	subscription_it->second.devices.erase(deviceRequest.deviceId);
+	writeSimpleJsonResponse(request.requestId, MikanAPIResult::Success, response);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "MikanTypeFwd.h"
+
+#include <functional>
+#include <map>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class EventSubscriptionFilter;
+class IInterprocessMessageServer;
+class IServerObjectSystems;
+struct ClientRequest;
+struct ClientResponse;
+
+// Sends each connection the poses of the VR devices it subscribed to, once per VR frame.
+// Owns the per-connection device subscriptions and reads the poses from IServerObjectSystems.
+class VRDevicePosePublisher
+{
+public:
+	using EventSender= std::function<void(
+		const std::vector<std::string>& connectionIds,
+		const std::string& mikanJsonEvent,
+		uint64_t coalesceKey)>;
+
+	VRDevicePosePublisher(IServerObjectSystems* objectSystems, EventSender eventSender);
+
+	void bindRequestHandlers(IInterprocessMessageServer* messageServer);
+
+	// Connections
+	void addConnection(const std::string& connectionId);
+	void removeConnection(const std::string& connectionId);
+	void clearConnections();
+	// Set from the client info, see MikanClientInfo::supportsVRDevicePoseBatch
+	void setSupportsPoseBatch(const std::string& connectionId, bool bSupportsPoseBatch);
+	// Either pose event type opts a connection into the pose updates for its subscribed devices,
+	// whichever of the two it actually gets sent
+	void setEventSubscriptionFilter(const std::string& connectionId, const EventSubscriptionFilter& filter);
+
+	// VRDeviceManager Callbacks
+	void publishVRDevicePoses(int64_t newFrameIndex);
+
+	// Request Callbacks
+	void subscribeToVRDevicePoseUpdatesHandler(const ClientRequest& request, ClientResponse& response);
+	void unsubscribeFromVRDevicePoseUpdatesHandler(const ClientRequest& request, ClientResponse& response);
+
+private:
+	struct PoseSubscription
+	{
+		// Pose updates are sent as one MikanVRDevicePoseBatchEvent per VR frame once the client info opted in
+		bool bSupportsPoseBatch= false;
+		bool bIsSubscribedToPoseEvents= true;
+		std::set<MikanVRDeviceID> devices;
+	};
+
+	IServerObjectSystems* m_objectSystems;
+	EventSender m_eventSender;
+	std::map<std::string, PoseSubscription> m_subscriptions;
+
+	// Reused every frame so publishing doesn't allocate
+	std::string m_eventJsonBuffer;
+	std::vector<std::string> m_recipientConnectionIds;
+};
@@ -1,4 +1,5 @@
 #include "MikanAPI.h"
+#include "MikanClientRequests.h"
 #include "MikanCoreCAPI.h"
 #include "MikanRequestManager.h"
 #include "MikanRenderTargetAPI.h"
@@ -15,6 +16,8 @@
 #include "MikanRemoteControlEvents.rfks.h"
 #include "MikanRemoteControlTypes.rfks.h"
 #include "MikanRemoteControlRequests.rfks.h"
+#include "MikanSceneTypes.rfks.h"
+#include "MikanSceneRequests.rfks.h"
 #include "MikanScriptEvents.rfks.h"
 #include "MikanScriptTypes.rfks.h"
 #include "MikanScriptRequests.rfks.h"
@@ -94,6 +97,11 @@ public:
 		// Stamp the request with the core sdk version and client id
 		clientInfo.clientId = getClientUniqueID();
 
+		// The C++ client api decodes the compact binary responses and pose batch events
+		// (other bindings share the core but not this api, so they leave these off)
+		clientInfo.supportsBinaryFormatV2 = true;
+		clientInfo.supportsVRDevicePoseBatch = true;
+
 		return clientInfo;
 	}
 
@@ -109,11 +117,79 @@ public:
 		return m_requestManager->sendRequest(request);
 	}
 
+	virtual std::vector<MikanResponseFuture> sendBatch(const std::vector<MikanRequest*>& requests) override
+	{
+		// Render target requests are handled locally, the rest go out in one batch
+		std::vector<MikanResponseFuture> localFutures;
+		std::vector<MikanRequest*> remoteRequests;
+		for (MikanRequest* request : requests)
+		{
+			MikanResponseFuture responseFuture= m_renderTargetAPI->tryProcessRequest(*request);
+			if (!responseFuture.isValid())
+			{
+				remoteRequests.push_back(request);
+			}
+
+			localFutures.emplace_back(std::move(responseFuture));
+		}
+
+		std::vector<MikanResponseFuture> remoteFutures;
+		if (!remoteRequests.empty())
+		{
+			remoteFutures= m_requestManager->sendBatch(remoteRequests);
+		}
+
+		// Merge the futures back into request order
+		std::vector<MikanResponseFuture> responseFutures;
+		responseFutures.reserve(requests.size());
+		auto remote_it= remoteFutures.begin();
+		for (MikanResponseFuture& localFuture : localFutures)
+		{
+			if (localFuture.isValid())
+			{
+				responseFutures.emplace_back(std::move(localFuture));
+			}
+			else
+			{
+				responseFutures.emplace_back(std::move(*remote_it));
+				++remote_it;
+			}
+		}
+
+		return responseFutures;
+	}
+
 	virtual MikanAPIResult cancelRequest(const MikanRequestID& requestId) override
 	{
 		return m_requestManager->cancelRequest(requestId);
 	}
 
+	virtual MikanAPIResult sendRequestQueued(MikanRequest& request) override
+	{
+		// Render target requests are handled locally (some forward a request of their own),
+		// so their future is redirected into the completion queue
+		MikanResponseFuture responseFuture= m_renderTargetAPI->tryProcessRequest(request);
+		if (responseFuture.isValid())
+		{
+			MikanRequestManager* requestManager= m_requestManager.get();
+			responseFuture.then(
+				[requestManager](MikanResponsePtr response) {
+					requestManager->queueCompletion(nullptr, response);
+				},
+				MikanResponseExecutor::Immediate);
+			return MikanAPIResult::Success;
+		}
+
+		return m_requestManager->sendRequestQueued(request);
+	}
+
+	virtual MikanAPIResult pollCompletions(std::vector<MikanResponsePtr>& out_responses) override
+	{
+		m_requestManager->pollCompletions(out_responses);
+
+		return MikanAPIResult::Success;
+	}
+
 	// Set client properties before calling connect
 	virtual MikanAPIResult setGraphicsDeviceInterface(MikanClientGraphicsApi api, void* graphicsDeviceInterface) override
 	{
@@ -143,9 +219,87 @@ public:
 
 	virtual MikanAPIResult fetchNextEvent(MikanEventPtr& out_event) override
 	{
+		// Fetching events is the client's update tick, so request deadlines get checked there too
+		m_requestManager->expireTimedOutRequests();
+
 		return m_eventManager->fetchNextEvent(out_event);
 	}
 
+	virtual MikanAPIResult fetchEvents(std::vector<MikanEventPtr>& out_events) override
+	{
+		m_requestManager->expireTimedOutRequests();
+
+		return m_eventManager->fetchEvents(out_events);
+	}
+
+	virtual MikanAPIResult enableSharedMemoryEvents() override
+	{
+		OpenEventRing openRequest;
+		MikanResponsePtr response= m_requestManager->sendRequest(openRequest).fetchResponse();
+		if (response->resultCode != MikanAPIResult::Success)
+		{
+			return response->resultCode;
+		}
+
+		auto ringResponse= std::static_pointer_cast<MikanEventRingResponse>(response);
+		MikanAPIResult result= 
+			(MikanAPIResult)Mikan_OpenEventRing(
+				m_context, 
+				ringResponse->ring_name.getValue().c_str(), 
+				ringResponse->reader_index,
+				ringResponse->start_position);
+
+		// The server is already publishing to the ring, so get it back to using the socket
+		if (result != MikanAPIResult::Success)
+		{
+			disableSharedMemoryEvents();
+		}
+
+		return result;
+	}
+
+	virtual MikanAPIResult disableSharedMemoryEvents() override
+	{
+		CloseEventRing closeRequest;
+		MikanResponsePtr response= m_requestManager->sendRequest(closeRequest).fetchResponse();
+
+		// Any events still unread in the ring are dropped
+		Mikan_CloseEventRing(m_context);
+
+		return response->resultCode;
+	}
+
+	virtual MikanAPIResult setEventPoolEnabled(bool bEnabled) override
+	{
+		return m_eventManager->setEventPoolEnabled(bEnabled);
+	}
+
+	virtual MikanAPIResult releaseEventBatch() override
+	{
+		m_eventManager->releaseEventBatch();
+
+		return MikanAPIResult::Success;
+	}
+
+	virtual MikanAPIResult setBackgroundEventDecodingEnabled(bool bEnabled) override
+	{
+		return m_eventManager->setBackgroundDecodingEnabled(bEnabled);
+	}
+
+	virtual MikanAPIResult setRequestDeadline(uint32_t deadlineMilliseconds) override
+	{
+		m_requestManager->setRequestDeadline(deadlineMilliseconds);
+
+		return MikanAPIResult::Success;
+	}
+
+	virtual MikanAPIResult setMaxOutstandingRequests(uint32_t maxOutstandingRequests) override
+	{
+		m_requestManager->setMaxOutstandingRequests(maxOutstandingRequests);
+
+		return MikanAPIResult::Success;
+	}
+
 	virtual MikanAPIResult disconnect() override
 	{
 		return (MikanAPIResult)Mikan_Disconnect(m_context, 0, "");
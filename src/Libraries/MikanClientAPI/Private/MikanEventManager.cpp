@@ -4,10 +4,12 @@
 #include "MikanClientEvents.h"
 #include "Logger.h"
 #include "JsonDeserializer.h"
+#include "JsonUtils.h"
 #include "StringUtils.h"
 #include "SerializableObjectPtr.h"
 
 #include <Refureku/Refureku.h>
+#include <cstring>
 #include <string>
 
 #include "nlohmann/json.hpp"
@@ -18,8 +20,15 @@
 #define WEBSOCKET_PING_EVENT				"ping"
 #define WEBSOCKET_PONG_EVENT				"pong"
 
+#define INITIAL_EVENT_BUFFER_SIZE			4096
+
 using json = nlohmann::json;
 
+MikanEventManager::MikanEventManager()
+	: m_eventBuffer(INITIAL_EVENT_BUFFER_SIZE)
+{
+}
+
 MikanAPIResult MikanEventManager::init(MikanContext context)
 {
 	m_context = context;
@@ -29,14 +38,34 @@ MikanAPIResult MikanEventManager::init(MikanContext context)
 
 MikanAPIResult MikanEventManager::fetchNextEvent(MikanEventPtr& out_event)
 {
-	char utf8Buffer[1024];
+	// Events already decoded on the socket thread come first.
+	// Shared memory ring events still go through the core api below.
+	if (m_decodedEvents.try_dequeue(out_event))
+	{
+		return MikanAPIResult::Success;
+	}
+
 	size_t utf8BytesWritten = 0;
 
 	MikanAPIResult result = 
 		(MikanAPIResult)Mikan_FetchNextEvent(
-			m_context, sizeof(utf8Buffer), utf8Buffer, &utf8BytesWritten);
+			m_context, m_eventBuffer.size(), m_eventBuffer.data(), &utf8BytesWritten);
+	if (result == MikanAPIResult::BufferTooSmall)
+	{
+		// The event stays queued, so make room for it and fetch it again
+		size_t utf8BytesNeeded = 0;
+		Mikan_FetchNextEvent(m_context, 0, nullptr, &utf8BytesNeeded);
+		m_eventBuffer.resize(utf8BytesNeeded);
+
+		result = 
+			(MikanAPIResult)Mikan_FetchNextEvent(
+				m_context, m_eventBuffer.size(), m_eventBuffer.data(), &utf8BytesWritten);
+	}
+
 	if (result == MikanAPIResult::Success)
 	{
+		const char* utf8Buffer = m_eventBuffer.data();
+
 		out_event = parseEventString(utf8Buffer);
 		if (!out_event)
 		{
@@ -49,20 +78,165 @@ MikanAPIResult MikanEventManager::fetchNextEvent(MikanEventPtr& out_event)
 	return result;
 }
 
+MikanAPIResult MikanEventManager::fetchEvents(std::vector<MikanEventPtr>& out_events)
+{
+	out_events.clear();
+
+	MikanEventPtr decodedEvent;
+	while (m_decodedEvents.try_dequeue(decodedEvent))
+	{
+		out_events.push_back(std::move(decodedEvent));
+	}
+
+	while (true)
+	{
+		size_t eventCount = 0;
+		size_t bytesNeeded = 0;
+
+		MikanAPIResult result =
+			(MikanAPIResult)Mikan_FetchEvents(
+				m_context, 
+				reinterpret_cast<uint8_t*>(m_eventBuffer.data()), m_eventBuffer.size(), 
+				&eventCount, &bytesNeeded);
+		if (result == MikanAPIResult::BufferTooSmall)
+		{
+			m_eventBuffer.resize(bytesNeeded);
+			continue;
+		}
+		else if (result == MikanAPIResult::NoData)
+		{
+			break;
+		}
+		else if (result != MikanAPIResult::Success)
+		{
+			return result;
+		}
+
+		// The buffer starts with a uint32 offset per event, each pointing at a null terminated event
+		for (size_t eventIndex = 0; eventIndex < eventCount; ++eventIndex)
+		{
+			uint32_t eventOffset = 0;
+			memcpy(&eventOffset, m_eventBuffer.data() + eventIndex * sizeof(uint32_t), sizeof(eventOffset));
+
+			const char* utf8Event = m_eventBuffer.data() + eventOffset;
+			MikanEventPtr eventPtr = parseEventString(utf8Event);
+			if (eventPtr)
+			{
+				out_events.push_back(eventPtr);
+			}
+			else
+			{
+				MIKAN_MT_LOG_WARNING("MikanClient::fetchEvents()")
+					<< "Failed to parse event string: " << utf8Event;
+			}
+		}
+
+		// Done once everything that was pending fit, later events can wait for the next call
+		if (bytesNeeded <= m_eventBuffer.size())
+			break;
+
+		m_eventBuffer.resize(bytesNeeded);
+	}
+
+	return out_events.empty() ? MikanAPIResult::NoData : MikanAPIResult::Success;
+}
+
+MikanAPIResult MikanEventManager::setEventPoolEnabled(bool bEnabled)
+{
+	// The socket thread decodes events while connected with background decoding on,
+	// so the pool can't be switched (and cleared) under it then
+	if (m_bBackgroundDecodingEnabled && Mikan_GetIsConnected(m_context))
+	{
+		MIKAN_MT_LOG_WARNING("MikanClient::setEventPoolEnabled()")
+			<< "Event pooling can't be changed while connected with background event decoding";
+		return MikanAPIResult::AlreadyConnected;
+	}
+
+	m_bEventPoolEnabled = bEnabled;
+
+	if (!bEnabled)
+	{
+		m_jsonEventPool.clear();
+	}
+
+	return MikanAPIResult::Success;
+}
+
+void MikanEventManager::releaseEventBatch()
+{
+	m_jsonEventPool.releaseBatch();
+}
+
+MikanAPIResult MikanEventManager::setBackgroundDecodingEnabled(bool bEnabled)
+{
+	// The socket thread decides where to decode (and whether to pool) without a lock
+	if (Mikan_GetIsConnected(m_context))
+	{
+		MIKAN_MT_LOG_WARNING("MikanClient::setBackgroundDecodingEnabled()")
+			<< "Background event decoding can only be changed while disconnected";
+		return MikanAPIResult::AlreadyConnected;
+	}
+
+	MikanAPIResult result = 
+		(MikanAPIResult)Mikan_SetTextEventCallback(
+			m_context, 
+			bEnabled ? &MikanEventManager::textEventHandlerStatic : nullptr, 
+			bEnabled ? this : nullptr);
+	if (result == MikanAPIResult::Success)
+	{
+		m_bBackgroundDecodingEnabled = bEnabled;
+	}
+
+	return result;
+}
+
+void MikanEventManager::textEventHandlerStatic(const char* utf8EventString, void* userdata)
+{
+	auto* eventManager = reinterpret_cast<MikanEventManager*>(userdata);
+
+	MikanEventPtr eventPtr = eventManager->parseEventString(utf8EventString);
+	if (eventPtr)
+	{
+		eventManager->m_decodedEvents.enqueue(std::move(eventPtr));
+	}
+	else
+	{
+		MIKAN_MT_LOG_WARNING("MikanClient::textEventHandlerStatic()")
+			<< "Failed to parse event string: " << utf8EventString;
+	}
+}
+
+MikanEventPtr MikanEventManager::allocateJsonEvent(
+	Serialization::RfkClassId rfkEventTypeId, 
+	rfk::Struct const& eventStruct)
+{
+	// Background decoded events are allocated on the socket thread, which the pool can't be shared with.
+	// The background flag can't change while connected, so it's tested first:
+	// the socket thread never reads the pool flag the client thread may be changing.
+	if (!m_bBackgroundDecodingEnabled && m_bEventPoolEnabled)
+	{
+		return m_jsonEventPool.acquire(
+			rfkEventTypeId,
+			[&eventStruct]() {
+				return eventStruct.makeSharedInstance<MikanEvent>();
+			});
+	}
+
+	return eventStruct.makeSharedInstance<MikanEvent>();
+}
+
 MikanEventPtr MikanEventManager::parseEventString(const char* szUtf8EventString)
 {
 	MikanEventPtr eventPtr;
 
 	try
 	{
-		std::string eventString= szUtf8EventString;
-
-		if (eventString.rfind(WEBSOCKET_DISCONNECT_EVENT, 0) == 0)
+		if (strncmp(szUtf8EventString, WEBSOCKET_DISCONNECT_EVENT, strlen(WEBSOCKET_DISCONNECT_EVENT)) == 0)
 		{
 			int disconnectCode = 0;
 			std::string disconnectReason = "";
 
-			std::vector<std::string> tokens = StringUtils::splitString(eventString, ':');
+			std::vector<std::string> tokens = StringUtils::splitString(szUtf8EventString, ':');
 			if (tokens.size() >= 3)
 			{
 				disconnectCode = std::atoi(tokens[1].c_str());
@@ -82,21 +256,46 @@ MikanEventPtr MikanEventManager::parseEventString(const char* szUtf8EventString)
 		}
 		else
 		{
-			json jsonResponse = json::parse(eventString);
-			auto mikanEventTypeId = jsonResponse["eventTypeId"].get<Serialization::MikanClassId>();
-			auto rfkEventTypeId = Serialization::toRfkClassId(mikanEventTypeId);
+			// Allocate the event as soon as its type id is read and fill it in from the same
+			// SAX pass over the json text, without building a json DOM or re-parsing the string
+			bool bFoundEventTypeId= false;
+			Serialization::MikanClassId mikanEventTypeId= 0;
+			rfk::Struct const* eventStruct= nullptr;
+			bool bParsed= Serialization::deserializeTypedFromJsonString(
+				szUtf8EventString, strlen(szUtf8EventString), "eventTypeId",
+				[&](int64_t eventTypeId, rfk::Struct const*& outStructType) -> void* {
+					bFoundEventTypeId= true;
+					mikanEventTypeId= eventTypeId;
 
-			rfk::Struct const* eventStruct = rfk::getDatabase().getStructById(rfkEventTypeId);
-			if (eventStruct != nullptr)
-			{
-				eventPtr = eventStruct->makeSharedInstance<MikanEvent>();
+					auto rfkEventTypeId = Serialization::toRfkClassId(mikanEventTypeId);
+					eventStruct= rfk::getDatabase().getStructById(rfkEventTypeId);
+					if (eventStruct == nullptr)
+						return nullptr;
 
-				Serialization::deserializeFromJson(jsonResponse, eventPtr.get(), *eventStruct);
-			}
-			else
+					eventPtr= allocateJsonEvent(rfkEventTypeId, *eventStruct);
+					outStructType= eventStruct;
+					return eventPtr.get();
+				});
+
+			if (!bParsed)
 			{
-				MIKAN_MT_LOG_WARNING("MikanClient::parseEventString()")
-					<< "Received response for unknown eventTypeId: " << mikanEventTypeId;
+				if (!bFoundEventTypeId)
+				{
+					MIKAN_MT_LOG_WARNING("MikanClient::parseEventString()")
+						<< "Received event without an eventTypeId";
+				}
+				else if (eventStruct == nullptr)
+				{
+					MIKAN_MT_LOG_WARNING("MikanClient::parseEventString()")
+						<< "Received response for unknown eventTypeId: " << mikanEventTypeId;
+				}
+				else
+				{
+					MIKAN_MT_LOG_WARNING("MikanClient::parseEventString()")
+						<< "Failed to parse event of type " << eventStruct->getName();
+				}
+
+				eventPtr.reset();
 			}
 		}
 	}
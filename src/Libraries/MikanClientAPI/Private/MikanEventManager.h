@@ -2,20 +2,50 @@
 
 #include "MikanAPITypes.h"
 #include "MikanTypeFwd.h"
+#include "SerializableObjectPtr.h"
+#include "SerializationInstancePool.h"
+
+#include "readerwriterqueue.h"
+
+#include <vector>
 
 typedef void* MikanContext;
 
 class MikanEventManager
 {
 public:
-	MikanEventManager() = default;
+	MikanEventManager();
 
 	MikanAPIResult init(MikanContext context);
 	MikanAPIResult fetchNextEvent(MikanEventPtr& out_event);
+	// Replaces the contents of out_events with every pending event, oldest first
+	MikanAPIResult fetchEvents(std::vector<MikanEventPtr>& out_events);
+
+	// When enabled, events are decoded into recycled instances that are reclaimed
+	// by releaseEventBatch() once the client has let go of them
+	// Returns AlreadyConnected while connected with background decoding enabled
+	MikanAPIResult setEventPoolEnabled(bool bEnabled);
+	void releaseEventBatch();
+
+	// When enabled, socket events are decoded on the socket receive thread as they arrive,
+	// leaving fetchNextEvent()/fetchEvents() to just pop them. Returns AlreadyConnected while connected.
+	// Pooling is skipped in this mode since the pool isn't thread safe.
+	MikanAPIResult setBackgroundDecodingEnabled(bool bEnabled);
 
 protected:
+	static void textEventHandlerStatic(const char* utf8EventString, void* userdata);
 	MikanEventPtr parseEventString(const char* utf8EventString);
+	// Only for events decoded from JSON, see Serialization::InstancePool
+	MikanEventPtr allocateJsonEvent(Serialization::RfkClassId rfkEventTypeId, rfk::Struct const& eventStruct);
 
 private:
 	MikanContext m_context = nullptr;
+	// Receives the utf8 events from the core api, grows to fit the biggest event batch seen
+	std::vector<char> m_eventBuffer;
+	bool m_bEventPoolEnabled = false;
+	// Recycled events are not reset, so the pool only backs JSON decoding
+	Serialization::InstancePool<MikanEvent> m_jsonEventPool;
+	bool m_bBackgroundDecodingEnabled = false;
+	// Filled by the socket thread, drained by the thread fetching events
+	moodycamel::ReaderWriterQueue<MikanEventPtr> m_decodedEvents;
 };
\ No newline at end of file
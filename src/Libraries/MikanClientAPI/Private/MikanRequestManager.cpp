@@ -1,19 +1,33 @@
 #include "MikanRequestManager.h"
 #include "MikanAPITypes.h"
+#include "MikanClientRequests.h"
 #include "MikanCoreCAPI.h"
 #include "MikanCoreTypes.h"
 #include "Logger.h"
 #include "BinaryDeserializer.h"
+#include "BinarySerializer.h"
 #include "JsonDeserializer.h"
+#include "JsonUtils.h"
 #include "SerializableObjectPtr.h"
 
 #include <Refureku/Refureku.h>
 #include <nlohmann/json.hpp>
 
+#include <cstring>
+
 #include "assert.h"
 
 using json = nlohmann::json;
 
+// Set while the socket thread is in one of the response handlers (and any Immediate callbacks they run)
+static thread_local bool t_bIsResponseThread = false;
+
+struct ResponseThreadScope
+{
+	ResponseThreadScope() { t_bIsResponseThread = true; }
+	~ResponseThreadScope() { t_bIsResponseThread = false; }
+};
+
 MikanAPIResult MikanRequestManager::init(MikanContext context)
 {
 	m_context= context;
@@ -46,24 +60,139 @@ MikanResponseFuture MikanRequestManager::sendRequest(MikanRequest& inRequest)
 	assert(requestStruct != nullptr);
 
 	// Stamp the request with the next available request ID
-	inRequest.requestId = m_nextRequestID;
-	m_nextRequestID++;
+	inRequest.requestId = m_nextRequestID++;
 
-	std::string	jsonString;
-	Serialization::serializeToJsonString(&inRequest, *requestStruct, jsonString);
+	MikanAPIResult result = waitForRequestCapacity(1);
+	if (result != MikanAPIResult::Success)
+	{
+		return addResponseHandler(inRequest.requestId, result);
+	}
 
-	MikanAPIResult result =
-		(MikanAPIResult)Mikan_SendRequestJSON(
-			m_context,
-			jsonString.c_str());
+	result = sendRequestInternal(inRequest, *requestStruct);
 
 	return addResponseHandler(inRequest.requestId, result);
 }
 
+MikanAPIResult MikanRequestManager::sendRequestInternal(const MikanRequest& inRequest, rfk::Struct const& requestStruct)
+{
+	MikanAPIResult result;
+	if (Mikan_GetIsBinaryRequestSupported(m_context))
+	{
+		// Binary requests skip json encoding here and json parsing on the server
+		std::vector<uint8_t> requestBytes;
+		Serialization::serializeToBytes(&inRequest, requestStruct, requestBytes, Serialization::BinaryFormat::V2);
+
+		result =
+			(MikanAPIResult)Mikan_SendRequestBinary(
+				m_context,
+				requestBytes.data(),
+				requestBytes.size());
+	}
+	else
+	{
+		std::string	jsonString;
+		Serialization::serializeToJsonString(&inRequest, requestStruct, jsonString);
+
+		result =
+			(MikanAPIResult)Mikan_SendRequestJSON(
+				m_context,
+				jsonString.c_str());
+	}
+
+	return result;
+}
+
+std::vector<MikanResponseFuture> MikanRequestManager::sendBatch(const std::vector<MikanRequest*>& requests)
+{
+	std::vector<MikanResponseFuture> responseFutures;
+	responseFutures.reserve(requests.size());
+
+	// Room for the sub-requests and the batch itself
+	const MikanAPIResult capacityResult = waitForRequestCapacity((uint32_t)requests.size() + 1);
+
+	// Every sub-request gets its own request ID and response future,
+	// so the batch response can resolve each of them like a regular response
+	MikanBatchRequest batchRequest;
+	batchRequest.requests.resize(requests.size());
+	std::vector<MikanRequestID> batchedRequestIds;
+	batchedRequestIds.reserve(requests.size());
+	for (size_t requestIndex = 0; requestIndex < requests.size(); ++requestIndex)
+	{
+		MikanRequest& subRequest = *requests[requestIndex];
+
+		Serialization::RfkClassId rfkRequestTypeId = Serialization::toRfkClassId(subRequest.requestTypeId);
+		rfk::Struct const* requestStruct = rfk::getDatabase().getStructById(rfkRequestTypeId);
+		assert(requestStruct != nullptr);
+
+		subRequest.requestId = m_nextRequestID++;
+
+		if (capacityResult != MikanAPIResult::Success)
+		{
+			responseFutures.emplace_back(addResponseHandler(subRequest.requestId, capacityResult));
+			continue;
+		}
+
+		std::string jsonString;
+		Serialization::serializeToJsonString(&subRequest, *requestStruct, jsonString);
+		batchRequest.requests[requestIndex].setValue(jsonString);
+
+		batchedRequestIds.push_back(subRequest.requestId);
+		responseFutures.emplace_back(addResponseHandler(subRequest.requestId, MikanAPIResult::Success));
+	}
+
+	if (capacityResult != MikanAPIResult::Success)
+	{
+		return responseFutures;
+	}
+
+	// The batch is pending before it is sent, so an early response can't miss it.
+	// Its response only carries the sub-request responses, so its future isn't handed out.
+	batchRequest.requestId = m_nextRequestID++;
+
+	auto pendingBatch = std::make_shared<PendingRequest>();
+	pendingBatch->id = batchRequest.requestId;
+	pendingBatch->batchedRequestIds = batchedRequestIds;
+	insertPendingRequest(pendingBatch);
+
+	MikanAPIResult result = sendRequestInternal(batchRequest, MikanBatchRequest::staticGetArchetype());
+	if (result != MikanAPIResult::Success)
+	{
+		removePendingRequest(batchRequest.requestId);
+		failPendingRequests(batchedRequestIds, result);
+	}
+
+	return responseFutures;
+}
+
+void MikanRequestManager::failPendingRequests(const std::vector<MikanRequestID>& requestIds, MikanAPIResult result)
+{
+	for (MikanRequestID requestId : requestIds)
+	{
+		PendingRequestPtr pendingRequest= removePendingRequest(requestId);
+
+		if (pendingRequest)
+		{
+			completePendingRequest(pendingRequest, makeErrorResponse(requestId, result));
+		}
+	}
+}
+
+MikanResponsePtr MikanRequestManager::makeErrorResponse(MikanRequestID requestId, MikanAPIResult result)
+{
+	auto errorResponse = std::make_shared<MikanResponse>();
+	rfk::Struct const& responseStruct = MikanResponse::staticGetArchetype();
+	errorResponse->responseTypeId = responseStruct.getId();
+	errorResponse->responseTypeName = responseStruct.getName();
+	errorResponse->requestId = requestId;
+	errorResponse->resultCode = result;
+
+	return errorResponse;
+}
+
 MikanResponseFuture MikanRequestManager::addResponseHandler(MikanRequestID requestId, MikanAPIResult result)
 {
-	MikanResponsePromise promise;
-	MikanResponseFuture future(this, requestId, promise);
+	auto promise = std::make_unique<MikanResponsePromise>();
+	MikanResponseFuture future(this, requestId, *promise);
 
 	if (result == MikanAPIResult::Success)
 	{
@@ -76,41 +205,259 @@ MikanResponseFuture MikanRequestManager::addResponseHandler(MikanRequestID reque
 	}
 	else
 	{
-		auto errorResponse = std::make_shared<MikanResponse>();
-		rfk::Struct const& responseStruct = MikanResponse::staticGetArchetype();
-		errorResponse->responseTypeId = responseStruct.getId();
-		errorResponse->responseTypeName = responseStruct.getName();
-		errorResponse->requestId = requestId;
-		errorResponse->resultCode = result;
-
-		promise.set_value(errorResponse);
+		promise->set_value(makeErrorResponse(requestId, result));
 	}
 
 	return future;
 }
 
+MikanAPIResult MikanRequestManager::sendRequestQueued(MikanRequest& inRequest)
+{
+	Serialization::RfkClassId rfkRequestTypeId = Serialization::toRfkClassId(inRequest.requestTypeId);
+	rfk::Struct const* requestStruct = rfk::getDatabase().getStructById(rfkRequestTypeId);
+	assert(requestStruct != nullptr);
+
+	inRequest.requestId = m_nextRequestID++;
+
+	MikanAPIResult capacityResult = waitForRequestCapacity(1);
+	if (capacityResult != MikanAPIResult::Success)
+	{
+		return capacityResult;
+	}
+
+	// Pending before it is sent, so an early response can't miss it
+	auto pendingRequest = std::make_shared<PendingRequest>();
+	pendingRequest->id = inRequest.requestId;
+	pendingRequest->bQueueResponse = true;
+	insertPendingRequest(pendingRequest);
+
+	MikanAPIResult result = sendRequestInternal(inRequest, *requestStruct);
+	if (result != MikanAPIResult::Success)
+	{
+		removePendingRequest(inRequest.requestId);
+	}
+
+	return result;
+}
+
+bool MikanRequestManager::setResponseCallback(
+	MikanRequestID requestId,
+	MikanResponseCallback callback,
+	MikanResponseExecutor executor)
+{
+	// Completion removes the request under the same lock, 
+	// so the callback is either seen by the completion or rejected here
+	PendingRequestShard& shard = getPendingRequestShard(requestId);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto it = shard.requests.find(requestId);
+	if (it == shard.requests.end())
+	{
+		return false;
+	}
+
+	it->second->callback = callback;
+	it->second->executor = executor;
+
+	return true;
+}
+
+void MikanRequestManager::completePendingRequest(PendingRequestPtr pendingRequest, MikanResponsePtr response)
+{
+	if (pendingRequest->callback != nullptr)
+	{
+		if (pendingRequest->executor == MikanResponseExecutor::Immediate)
+		{
+			pendingRequest->callback(response);
+		}
+		else
+		{
+			queueCompletion(pendingRequest->callback, response);
+		}
+	}
+	else if (pendingRequest->promise)
+	{
+		pendingRequest->promise->set_value(response);
+	}
+	else if (pendingRequest->bQueueResponse)
+	{
+		queueCompletion(nullptr, response);
+	}
+}
+
+void MikanRequestManager::queueCompletion(MikanResponseCallback callback, MikanResponsePtr response)
+{
+	std::lock_guard<std::mutex> lock(m_completed_response_mutex);
+
+	m_completedResponses.push_back({callback, response});
+}
+
+void MikanRequestManager::pollCompletions(std::vector<MikanResponsePtr>& out_responses)
+{
+	// Timed out requests complete in this same poll
+	expireTimedOutRequests();
+
+	// Swap the queue out so callbacks can send new requests (or poll) without deadlocking,
+	// the two vectors keep their capacity from frame to frame
+	{
+		std::lock_guard<std::mutex> lock(m_completed_response_mutex);
+
+		m_polledResponses.swap(m_completedResponses);
+	}
+
+	for (CompletedResponse& completedResponse : m_polledResponses)
+	{
+		if (completedResponse.callback != nullptr)
+		{
+			completedResponse.callback(completedResponse.response);
+		}
+		else
+		{
+			out_responses.push_back(completedResponse.response);
+		}
+	}
+
+	m_polledResponses.clear();
+}
+
 void MikanRequestManager::insertPendingRequest(MikanRequestManager::PendingRequestPtr pendingRequest)
 {
-	std::lock_guard<std::mutex> lock(m_pending_request_map_mutex);
+	const MikanRequestID requestId = pendingRequest->id;
 
-	m_pendingRequests.insert({pendingRequest->id, pendingRequest});
+	{
+		PendingRequestShard& shard = getPendingRequestShard(requestId);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		shard.requests.insert({requestId, pendingRequest});
+	}
+	m_outstandingRequestCount++;
+
+	const uint32_t deadlineMilliseconds = m_requestDeadlineMilliseconds;
+	if (deadlineMilliseconds > 0)
+	{
+		const RequestDeadlineWheel::Clock::time_point deadline =
+			RequestDeadlineWheel::Clock::now() + std::chrono::milliseconds(deadlineMilliseconds);
+
+		std::lock_guard<std::mutex> lock(m_deadline_wheel_mutex);
+		m_deadlineWheel.addDeadline(requestId, deadline);
+	}
 }
 
 MikanRequestManager::PendingRequestPtr MikanRequestManager::removePendingRequest(MikanRequestID requestId)
 {
-	std::lock_guard<std::mutex> lock(m_pending_request_map_mutex);
-
 	PendingRequestPtr pendingRequest;
-	auto it = m_pendingRequests.find(requestId);
-	if (it != m_pendingRequests.end())
+
 	{
-		pendingRequest = it->second;
-		m_pendingRequests.erase(it);
+		PendingRequestShard& shard = getPendingRequestShard(requestId);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		auto it = shard.requests.find(requestId);
+		if (it != shard.requests.end())
+		{
+			pendingRequest = std::move(it->second);
+			shard.requests.erase(it);
+		}
+	}
+
+	// The request's deadline stays in the wheel, it is ignored when it comes up
+	if (pendingRequest)
+	{
+		m_outstandingRequestCount--;
+
+		if (m_capacityWaiterCount > 0)
+		{
+			m_capacityCondition.notify_all();
+		}
 	}
 
 	return pendingRequest;
 }
 
+void MikanRequestManager::expireTimedOutRequests()
+{
+	std::vector<MikanRequestID> expiredRequestIds;
+
+	{
+		std::lock_guard<std::mutex> lock(m_deadline_wheel_mutex);
+		m_deadlineWheel.collectExpired(RequestDeadlineWheel::Clock::now(), expiredRequestIds);
+	}
+
+	// Sub-requests of a batch have deadlines of their own
+	for (MikanRequestID requestId : expiredRequestIds)
+	{
+		PendingRequestPtr pendingRequest= removePendingRequest(requestId);
+
+		if (pendingRequest)
+		{
+			MIKAN_MT_LOG_WARNING("MikanRequestManager::expireTimedOutRequests()") 
+				<< "Request " << requestId << " timed out";
+			completePendingRequest(pendingRequest, makeErrorResponse(requestId, MikanAPIResult::Timeout));
+		}
+	}
+}
+
+MikanAPIResult MikanRequestManager::waitForRequestCapacity(uint32_t requestCount)
+{
+	expireTimedOutRequests();
+
+	// A batch bigger than the limit can still go out once nothing else is pending
+	auto hasCapacity = [this, requestCount]() {
+		const uint32_t maxOutstandingRequests = m_maxOutstandingRequests;
+		const uint32_t outstandingRequestCount = m_outstandingRequestCount;
+
+		return 
+			maxOutstandingRequests == 0 || 
+			outstandingRequestCount == 0 ||
+			outstandingRequestCount + requestCount <= maxOutstandingRequests;
+	};
+
+	if (hasCapacity())
+	{
+		return MikanAPIResult::Success;
+	}
+
+	// Responses arrive on the thread running this Immediate callback,
+	// so waiting here would only ever end at the deadline
+	if (t_bIsResponseThread)
+	{
+		MIKAN_MT_LOG_WARNING("MikanRequestManager::waitForRequestCapacity()")
+			<< "No room for another request while handling a response on the socket thread";
+		return MikanAPIResult::RequestFailed;
+	}
+
+	// Block the sender until responses (or expired deadlines) make room
+	const uint32_t deadlineMilliseconds = m_requestDeadlineMilliseconds;
+	const RequestDeadlineWheel::Clock::time_point waitDeadline = 
+		RequestDeadlineWheel::Clock::now() + 
+		std::chrono::milliseconds(deadlineMilliseconds > 0 ? deadlineMilliseconds : MIKAN_TIMEOUT_DEFAULT);
+
+	m_capacityWaiterCount++;
+
+	MikanAPIResult result = MikanAPIResult::Success;
+	while (!hasCapacity())
+	{
+		if (RequestDeadlineWheel::Clock::now() >= waitDeadline)
+		{
+			MIKAN_MT_LOG_WARNING("MikanRequestManager::waitForRequestCapacity()")
+				<< "Timed out waiting on " << m_outstandingRequestCount << " outstanding requests";
+			result = MikanAPIResult::Timeout;
+			break;
+		}
+
+		// Wakes up at least every 10ms to expire timed out requests
+		{
+			std::unique_lock<std::mutex> lock(m_capacity_mutex);
+			m_capacityCondition.wait_for(lock, std::chrono::milliseconds(10));
+		}
+
+		expireTimedOutRequests();
+	}
+
+	m_capacityWaiterCount--;
+
+	return result;
+}
+
 MikanAPIResult MikanRequestManager::cancelRequest(MikanRequestID requestId)
 {
 	PendingRequestPtr existingRequest= removePendingRequest(requestId);
@@ -128,6 +475,24 @@ void MikanRequestManager::textResponseHander(MikanRequestID requestId, const cha
 	{
 		MikanResponsePtr response = parseResponseString(utf8ResponseString);
 
+		// Resolve the sub-requests of a batch before the batch itself
+		if (!pendingRequest->batchedRequestIds.empty())
+		{
+			if (response && typeid(*response) == typeid(MikanBatchResponse))
+			{
+				dispatchBatchResponse(*std::static_pointer_cast<MikanBatchResponse>(response));
+			}
+
+			// Sub-requests without a response in the batch (binary responses arrive on their own)
+			// stay pending, unless the batch as a whole failed
+			if (!response || response->resultCode != MikanAPIResult::Success)
+			{
+				failPendingRequests(
+					pendingRequest->batchedRequestIds,
+					response ? response->resultCode : MikanAPIResult::MalformedResponse);
+			}
+		}
+
 		if (!response)
 		{
 			response = std::make_shared<MikanResponse>();
@@ -138,7 +503,7 @@ void MikanRequestManager::textResponseHander(MikanRequestID requestId, const cha
 			response->resultCode = MikanAPIResult::MalformedResponse;
 		}
 
-		pendingRequest->promise.set_value(response);
+		completePendingRequest(pendingRequest, response);
 	}
 	else
 	{
@@ -149,59 +514,75 @@ void MikanRequestManager::textResponseHander(MikanRequestID requestId, const cha
 void MikanRequestManager::textResponseHandlerStatic(MikanRequestID requestId, const char* utf8ResponseString, void* userdata)
 {
 	MikanRequestManager* self = reinterpret_cast<MikanRequestManager*>(userdata);
+	ResponseThreadScope responseThreadScope;
 
 	self->textResponseHander(requestId, utf8ResponseString);
+	// Every response is also a tick for the request deadlines
+	self->expireTimedOutRequests();
 }
 
-MikanResponsePtr MikanRequestManager::parseResponseString(const char* utf8ResponseString)
+void MikanRequestManager::dispatchBatchResponse(const MikanBatchResponse& batchResponse)
 {
-	MikanResponsePtr responsePtr;
-
-	try
+	for (const Serialization::String& subResponseString : batchResponse.responses)
 	{
-		json jsonResponse = json::parse(utf8ResponseString);
+		const std::string& utf8SubResponse = subResponseString.getValue();
 
-		MikanResponse responseHeader= {};
-		bool parseHeader = 
-			Serialization::deserializeFromJson(
-				jsonResponse, &responseHeader, MikanResponse::staticGetArchetype());
-		if (!parseHeader)
+		JsonSaxIntegerValueSearcher requestIdSearcher;
+		int subRequestId = -1;
+		if (requestIdSearcher.fetchKeyValuePair(utf8SubResponse, "requestId", subRequestId))
 		{
-			throw std::runtime_error("Failed to parse response header");
+			textResponseHander((MikanRequestID)subRequestId, utf8SubResponse.c_str());
 		}
-
-		Serialization::MikanClassId mikanResponseTypeId = responseHeader.responseTypeId;
-		Serialization::RfkClassId rfkResponseTypeId = Serialization::toRfkClassId(mikanResponseTypeId);
-		rfk::Struct const* responseStruct = rfk::getDatabase().getStructById(rfkResponseTypeId);
-		if (responseStruct != nullptr)
+		else
 		{
-			responsePtr = responseStruct->makeSharedInstance<MikanResponse>();
+			MIKAN_MT_LOG_ERROR("MikanRequestManager::dispatchBatchResponse()")
+				<< "Batched response missing requestId";
+		}
+	}
+}
 
-			if (!Serialization::deserializeFromJson(jsonResponse, responsePtr.get(), *responseStruct))
-			{
-				std::stringstream ss;
-				ss << "Failed to parse struct of type " << responseHeader.responseTypeName.getValue();
+MikanResponsePtr MikanRequestManager::parseResponseString(const char* utf8ResponseString)
+{
+	MikanResponsePtr responsePtr;
 
-				throw std::runtime_error(ss.str());
-			}
+	// Allocate the response as soon as its type id is read and fill it in from the same
+	// SAX pass over the json text, without building a json DOM or re-parsing the string
+	bool bFoundResponseTypeId= false;
+	Serialization::MikanClassId mikanResponseTypeId= 0;
+	rfk::Struct const* responseStruct= nullptr;
+	bool bParsed= Serialization::deserializeTypedFromJsonString(
+		utf8ResponseString, strlen(utf8ResponseString), "responseTypeId",
+		[&](int64_t responseTypeId, rfk::Struct const*& outStructType) -> void* {
+			bFoundResponseTypeId= true;
+			mikanResponseTypeId= responseTypeId;
+			responseStruct= rfk::getDatabase().getStructById(Serialization::toRfkClassId(responseTypeId));
+			if (responseStruct == nullptr)
+				return nullptr;
+
+			responsePtr= responseStruct->makeSharedInstance<MikanResponse>();
+			outStructType= responseStruct;
+			return responsePtr.get();
+		});
+
+	if (!bParsed)
+	{
+		if (!bFoundResponseTypeId)
+		{
+			MIKAN_MT_LOG_ERROR("MikanClient::parseResponseString()")
+				<< "Failed to find responseTypeId in response";
+		}
+		else if (responseStruct == nullptr)
+		{
+			MIKAN_MT_LOG_ERROR("MikanClient::parseResponseString()")
+				<< "Failed to find struct for responseTypeId: " << mikanResponseTypeId;
 		}
 		else
 		{
-			std::stringstream ss;
-			ss << "Failed to find struct of type " << responseHeader.responseTypeName.getValue();
-
-			throw std::runtime_error(ss.str());
+			MIKAN_MT_LOG_ERROR("MikanClient::parseResponseString()")
+				<< "Failed to parse struct of type " << responseStruct->getName();
 		}
-	}
-	catch (json::parse_error& e)
-	{
-		MIKAN_MT_LOG_ERROR("MikanClient::parseResponseString()")
-			<< "Failed to parse response: " << e.what();
-	}
-	catch (json::exception& e)
-	{
-		MIKAN_MT_LOG_ERROR("MikanClient::parseResponseString()")
-			<< "Failed to parse response: " << e.what();
+
+		responsePtr.reset();
 	}
 
 	return responsePtr;
@@ -216,10 +597,15 @@ void MikanRequestManager::binaryResponseHander(
 
 	try
 	{
+		// Newer servers send the compact V2 format, which starts with a format header
+		const Serialization::BinaryFormat format = Serialization::getBinaryFormat(buffer, bufferSize);
+
+		// The response header fields come first, so the header can be parsed on its own
+		// (the V2 reader skips the rest of the response struct)
 		MikanResponse responseHeader= {};
 		bool parseHeader = 
 			Serialization::deserializeFromBytes(
-				buffer, bufferSize, &responseHeader, MikanResponse::staticGetArchetype());
+				buffer, bufferSize, &responseHeader, MikanResponse::staticGetArchetype(), format);
 		if (!parseHeader)
 		{
 			throw std::runtime_error("Failed to parse response header");
@@ -231,7 +617,7 @@ void MikanRequestManager::binaryResponseHander(
 		// Fulfill the promise with the response
 		if (pendingRequest)
 		{
-			MikanResponsePtr response = parseResponseBinaryReader(responseHeader, buffer, bufferSize);
+			MikanResponsePtr response = parseResponseBinaryReader(responseHeader, buffer, bufferSize, format);
 
 			if (!response)
 			{
@@ -243,7 +629,7 @@ void MikanRequestManager::binaryResponseHander(
 				response->resultCode = MikanAPIResult::MalformedResponse;
 			}
 
-			pendingRequest->promise.set_value(response);
+			completePendingRequest(pendingRequest, response);
 		}
 		else
 		{
@@ -264,14 +650,17 @@ void MikanRequestManager::binaryResponseHandlerStatic(
 	void* userdata)
 {
 	MikanRequestManager* self = reinterpret_cast<MikanRequestManager*>(userdata);
+	ResponseThreadScope responseThreadScope;
 
 	self->binaryResponseHander(buffer, bufferSize);
+	self->expireTimedOutRequests();
 }
 
 MikanResponsePtr MikanRequestManager::parseResponseBinaryReader(
 	const MikanResponse& responseHeader,
 	const uint8_t* buffer,
-	size_t bufferSize)
+	size_t bufferSize,
+	Serialization::BinaryFormat format)
 {
 	MikanResponsePtr responsePtr;
 
@@ -282,7 +671,7 @@ MikanResponsePtr MikanRequestManager::parseResponseBinaryReader(
 	{
 		responsePtr = responseStruct->makeSharedInstance<MikanResponse>();
 
-		Serialization::deserializeFromBytes(buffer, bufferSize, responsePtr.get(), *responseStruct);
+		Serialization::deserializeFromBytes(buffer, bufferSize, responsePtr.get(), *responseStruct, format);
 	}
 	else
 	{
@@ -6,14 +6,24 @@
 #include "MikanResponseFuture.h"
 #include "BinaryUtility.h"
 #include "JsonSerializer.h"
+#include "RequestDeadlineWheel.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <future>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 struct MikanRequest;
 typedef void* MikanContext;
 
+namespace rfk
+{
+	class Struct;
+};
+
 class MikanRequestManager
 {
 public:
@@ -23,33 +33,104 @@ public:
 	MikanContext getContext() const { return m_context; }
 
 	MikanResponseFuture sendRequest(MikanRequest& request);
+	std::vector<MikanResponseFuture> sendBatch(const std::vector<MikanRequest*>& requests);
 	MikanResponseFuture addResponseHandler(MikanRequestID requestId, MikanAPIResult result);
 	MikanAPIResult cancelRequest(MikanRequestID requestId);
 
+	// Completion Queue
+	// Sends a request without a response future (or promise), its response is queued instead
+	MikanAPIResult sendRequestQueued(MikanRequest& request);
+	// Redirects the response of a pending request to the callback, false if it isn't pending anymore
+	bool setResponseCallback(MikanRequestID requestId, MikanResponseCallback callback, MikanResponseExecutor executor);
+	// A null callback means the response is returned by pollCompletions()
+	void queueCompletion(MikanResponseCallback callback, MikanResponsePtr response);
+	// Runs the queued callbacks, then appends the remaining queued responses to out_responses
+	void pollCompletions(std::vector<MikanResponsePtr>& out_responses);
+
+	// Request Limits
+	// 0 = requests never time out
+	void setRequestDeadline(uint32_t deadlineMilliseconds) { m_requestDeadlineMilliseconds= deadlineMilliseconds; }
+	// 0 = no limit on the number of requests waiting on a response
+	void setMaxOutstandingRequests(uint32_t maxOutstandingRequests) { m_maxOutstandingRequests= maxOutstandingRequests; }
+	uint32_t getOutstandingRequestCount() const { return m_outstandingRequestCount; }
+	// Completes the requests whose deadline has passed with a Timeout response.
+	// Runs on every response, event fetch, send, poll and while a future waits without a timeout.
+	void expireTimedOutRequests();
+
 protected:
 	static void textResponseHandlerStatic(MikanRequestID requestId, const char* utf8ResponseString, void* userdata);
 	void textResponseHander(MikanRequestID requestId, const char* utf8ResponseString);
 	MikanResponsePtr parseResponseString(const char* utf8ResponseString);
+	void dispatchBatchResponse(const struct MikanBatchResponse& batchResponse);
+	MikanAPIResult sendRequestInternal(const MikanRequest& request, rfk::Struct const& requestStruct);
+	void failPendingRequests(const std::vector<MikanRequestID>& requestIds, MikanAPIResult result);
+	MikanResponsePtr makeErrorResponse(MikanRequestID requestId, MikanAPIResult result);
+	// Timeout if no room was made before the deadline,
+	// RequestFailed right away on the socket thread (which is the one making room)
+	MikanAPIResult waitForRequestCapacity(uint32_t requestCount);
 
 	static void binaryResponseHandlerStatic(const uint8_t* buffer, size_t bufferSize, void* userdata);
 	void binaryResponseHander(const uint8_t* buffer, size_t bufferSize);
 	MikanResponsePtr parseResponseBinaryReader(
 		const MikanResponse& requestHeader,
 		const uint8_t* buffer, 
-		size_t bufferSize);
+		size_t bufferSize,
+		Serialization::BinaryFormat format);
 
 private:
 	struct PendingRequest
 	{
 		MikanRequestID id;
-		MikanResponsePromise promise;
+		// Only set when a response future is waiting on this request
+		std::unique_ptr<MikanResponsePromise> promise;
+		// Set by MikanResponseFuture::then(), takes precedence over the promise
+		MikanResponseCallback callback;
+		MikanResponseExecutor executor= MikanResponseExecutor::CompletionQueue;
+		// Set by sendRequestQueued(), the response goes to the completion queue
+		bool bQueueResponse= false;
+		// Set for a batch request: the requests resolved by its response
+		std::vector<MikanRequestID> batchedRequestIds;
 	};
 	using PendingRequestPtr = std::shared_ptr<PendingRequest>;
 	void insertPendingRequest(MikanRequestManager::PendingRequestPtr pendingRequest);
 	PendingRequestPtr removePendingRequest(MikanRequestID requestId);
+	void completePendingRequest(PendingRequestPtr pendingRequest, MikanResponsePtr response);
+
+	struct CompletedResponse
+	{
+		MikanResponseCallback callback;
+		MikanResponsePtr response;
+	};
+
+	// Request IDs are sequential, so consecutive requests land in different shards
+	// and the socket thread rarely contends with the sending thread
+	struct PendingRequestShard
+	{
+		std::mutex mutex;
+		std::unordered_map<MikanRequestID, PendingRequestPtr> requests;
+	};
+	static const size_t k_pendingRequestShardCount = 16;
+	PendingRequestShard& getPendingRequestShard(MikanRequestID requestId)
+	{
+		return m_pendingRequestShards[(uint32_t)requestId % k_pendingRequestShardCount];
+	}
 
 	MikanContext m_context= nullptr;
-	std::map<MikanRequestID, PendingRequestPtr> m_pendingRequests;
-	std::mutex m_pending_request_map_mutex;
-	MikanRequestID m_nextRequestID= 0;
+	PendingRequestShard m_pendingRequestShards[k_pendingRequestShardCount];
+	std::atomic<uint32_t> m_outstandingRequestCount= {0};
+	std::atomic<uint32_t> m_maxOutstandingRequests= {MIKAN_MAX_OUTSTANDING_REQUESTS_DEFAULT};
+	// Senders blocked on a full pending request table
+	std::atomic<uint32_t> m_capacityWaiterCount= {0};
+	std::mutex m_capacity_mutex;
+	std::condition_variable m_capacityCondition;
+	// Deadlines of the pending requests
+	std::atomic<uint32_t> m_requestDeadlineMilliseconds= {MIKAN_REQUEST_DEADLINE_DEFAULT};
+	RequestDeadlineWheel m_deadlineWheel;
+	std::mutex m_deadline_wheel_mutex;
+	// Responses and callbacks waiting for the next pollCompletions()
+	std::vector<CompletedResponse> m_completedResponses;
+	std::vector<CompletedResponse> m_polledResponses;
+	std::mutex m_completed_response_mutex;
+	// Requests can be sent from several threads
+	std::atomic<MikanRequestID> m_nextRequestID= {0};
 };
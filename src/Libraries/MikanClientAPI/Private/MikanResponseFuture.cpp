@@ -33,11 +33,9 @@ MikanResponseFuture::MikanResponseFuture(
 }
 
 MikanResponseFuture::MikanResponseFuture(MikanResponseFuture&& other) noexcept
-	: m_impl(new MikanResponseFutureImpl())
+	: m_impl(other.m_impl)
 {
-	m_impl->ownerRequestManager = other.m_impl->ownerRequestManager;
-	m_impl->requestId = other.m_impl->requestId;
-	m_impl->future = std::move(other.m_impl->future);
+	other.m_impl = nullptr;
 }
 
 MikanResponseFuture::~MikanResponseFuture()
@@ -100,6 +98,15 @@ MikanResponsePtr MikanResponseFuture::fetchResponse(uint32_t timeoutMilliseconds
 		}
 		else
 		{
+			// The request deadline still applies: this thread may be the only one left to expire it
+			while (m_impl->future.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready)
+			{
+				if (m_impl->ownerRequestManager != nullptr)
+				{
+					m_impl->ownerRequestManager->expireTimedOutRequests();
+				}
+			}
+
 			return m_impl->future.get();
 		}
 	}
@@ -115,6 +122,48 @@ void MikanResponseFuture::awaitResponse(uint32_t timeoutMilliseconds)
 	fetchResponse(timeoutMilliseconds);
 }
 
+void MikanResponseFuture::then(MikanResponseCallback callback, MikanResponseExecutor executor)
+{
+	if (!isValid() || callback == nullptr)
+	{
+		return;
+	}
+
+	// The response now belongs to the callback
+	MikanResponseFutureImpl* impl = m_impl;
+	m_impl = nullptr;
+
+	MikanRequestManager* owner = impl->ownerRequestManager;
+	const bool bAttached =
+		owner != nullptr &&
+		impl->requestId != INVALID_MIKAN_ID &&
+		owner->setResponseCallback(impl->requestId, callback, executor);
+
+	if (!bAttached)
+	{
+		// No longer pending, so the response is either in the future already
+		// or about to be, unless the request was cancelled (broken promise)
+		try
+		{
+			MikanResponsePtr response = impl->future.get();
+
+			if (owner != nullptr && executor == MikanResponseExecutor::CompletionQueue)
+			{
+				owner->queueCompletion(callback, response);
+			}
+			else
+			{
+				callback(response);
+			}
+		}
+		catch (std::future_error&)
+		{
+		}
+	}
+
+	delete impl;
+}
+
 MikanResponsePtr MikanResponseFuture::makeSimpleMikanResponse(MikanAPIResult result)
 {
 	auto response = std::make_shared<MikanResponse>();
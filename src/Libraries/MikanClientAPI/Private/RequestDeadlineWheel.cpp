@@ -0,0 +1,60 @@
+#include "RequestDeadlineWheel.h"
+
+#include <algorithm>
+
+RequestDeadlineWheel::RequestDeadlineWheel(uint32_t tickMilliseconds, size_t slotCount)
+	: m_slots(std::max(slotCount, (size_t)1))
+	, m_startTime(Clock::now())
+	, m_tickDuration(std::chrono::milliseconds(std::max(tickMilliseconds, (uint32_t)1)))
+{
+}
+
+uint64_t RequestDeadlineWheel::getTick(Clock::time_point time) const
+{
+	return time > m_startTime ? (uint64_t)((time - m_startTime) / m_tickDuration) : 0;
+}
+
+void RequestDeadlineWheel::addDeadline(MikanRequestID requestId, Clock::time_point deadline)
+{
+	// Round up so a request never expires before its deadline
+	uint64_t deadlineTick = getTick(deadline) + 1;
+	if (deadlineTick <= m_currentTick)
+	{
+		deadlineTick = m_currentTick + 1;
+	}
+
+	m_slots[deadlineTick % m_slots.size()].push_back({requestId, deadlineTick});
+	++m_entryCount;
+}
+
+void RequestDeadlineWheel::collectExpired(Clock::time_point now, std::vector<MikanRequestID>& outRequestIds)
+{
+	const uint64_t nowTick = getTick(now);
+	if (nowTick <= m_currentTick)
+		return;
+
+	// After more than a full turn every slot gets visited once
+	const uint64_t elapsedTicks = std::min(nowTick - m_currentTick, (uint64_t)m_slots.size());
+	for (uint64_t tickOffset = 1; tickOffset <= elapsedTicks; ++tickOffset)
+	{
+		std::vector<Entry>& slot = m_slots[(m_currentTick + tickOffset) % m_slots.size()];
+
+		for (size_t entryIndex = 0; entryIndex < slot.size();)
+		{
+			if (slot[entryIndex].deadlineTick <= nowTick)
+			{
+				outRequestIds.push_back(slot[entryIndex].requestId);
+
+				slot[entryIndex] = slot.back();
+				slot.pop_back();
+				--m_entryCount;
+			}
+			else
+			{
+				++entryIndex;
+			}
+		}
+	}
+
+	m_currentTick = nowTick;
+}
\ No newline at end of file
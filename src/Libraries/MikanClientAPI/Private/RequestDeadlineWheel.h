@@ -0,0 +1,43 @@
+#pragma once
+
+#include "MikanCoreTypes.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <vector>
+
+// Hashed timer wheel holding the deadline of every pending request.
+// Each slot covers one tick, a deadline more than one turn of the wheel away
+// waits in its slot until the wheel comes around to it again.
+// Adding a deadline is O(1) and expiring only visits the slots of the elapsed ticks.
+// Requests that complete early are not removed, their entries are dropped when their slot comes up.
+// Not thread safe.
+class RequestDeadlineWheel
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	RequestDeadlineWheel(uint32_t tickMilliseconds = 10, size_t slotCount = 256);
+
+	void addDeadline(MikanRequestID requestId, Clock::time_point deadline);
+	// Appends the requests whose deadline has passed since the last call
+	void collectExpired(Clock::time_point now, std::vector<MikanRequestID>& outRequestIds);
+
+	inline size_t getEntryCount() const { return m_entryCount; }
+
+private:
+	struct Entry
+	{
+		MikanRequestID requestId;
+		uint64_t deadlineTick;
+	};
+
+	uint64_t getTick(Clock::time_point time) const;
+
+	std::vector<std::vector<Entry>> m_slots;
+	Clock::time_point m_startTime;
+	Clock::duration m_tickDuration;
+	// Every deadline up to this tick has been expired
+	uint64_t m_currentTick= 0;
+	size_t m_entryCount= 0;
+};
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 using IMikanAPIPtr = std::shared_ptr<class IMikanAPI>;
 
@@ -39,6 +40,49 @@ public:
 
 	// Messaging
 	virtual MikanResponseFuture sendRequest(MikanRequest& request) = 0;
+	// Sends the requests in a single message, returning one response future per request (in order)
+	virtual std::vector<MikanResponseFuture> sendBatch(const std::vector<MikanRequest*>& requests) = 0;
 	virtual MikanAPIResult cancelRequest(const MikanRequestID& requestId) = 0;
+
+	// Completion Queue
+	// Sends a request without a response future, its response is returned by pollCompletions().
+	// The request ID stamped on the request matches the requestId of its response.
+	virtual MikanAPIResult sendRequestQueued(MikanRequest& request) = 0;
+	// Runs the MikanResponseFuture::then() callbacks waiting on the completion queue,
+	// then appends the responses of sendRequestQueued() requests to out_responses (oldest first).
+	// Meant to be called once per frame.
+	virtual MikanAPIResult pollCompletions(std::vector<MikanResponsePtr>& out_responses) = 0;
+
 	virtual MikanAPIResult fetchNextEvent(MikanEventPtr& out_event) = 0;
+	// Fetches every pending event in one call (oldest first), cheaper than a fetchNextEvent loop
+	virtual MikanAPIResult fetchEvents(std::vector<MikanEventPtr>& out_events) = 0;
+
+	// Shared Memory Events (optional, server on the same machine only)
+	// Enabled: events are read from a shared memory ring instead of arriving over the socket.
+	// Responses and connection events still use the socket. Blocks until the server replies.
+	virtual MikanAPIResult enableSharedMemoryEvents() = 0;
+	virtual MikanAPIResult disableSharedMemoryEvents() = 0;
+
+	// Event Pooling (optional)
+	// Enabled: fetched events are recycled by releaseEventBatch(), which should be called
+	// once per frame after the fetched events were handled. Events still held by the client are not recycled.
+	// Without releaseEventBatch() calls, the pool releases its batch every few thousand events by itself.
+	// Returns MikanAPIResult::AlreadyConnected if changed while connected with background event decoding.
+	virtual MikanAPIResult setEventPoolEnabled(bool bEnabled) = 0;
+	virtual MikanAPIResult releaseEventBatch() = 0;
+
+	// Background Event Decoding (optional, call before connect)
+	// Enabled: socket events are decoded on the socket receive thread as they arrive,
+	// so fetchNextEvent()/fetchEvents() only pop already decoded events. Disables event pooling.
+	// Returns MikanAPIResult::AlreadyConnected if called while connected.
+	virtual MikanAPIResult setBackgroundEventDecodingEnabled(bool bEnabled) = 0;
+
+	// Request Limits
+	// Requests still without a response after the deadline complete with MikanAPIResult::Timeout (0 = never).
+	// Deadlines are checked on every response received, when sending, fetching events and in pollCompletions(),
+	// and while a response future waits without a timeout of its own.
+	virtual MikanAPIResult setRequestDeadline(uint32_t deadlineMilliseconds) = 0;
+	// Sending blocks while this many requests are waiting on a response (0 = no limit),
+	// failing with MikanAPIResult::Timeout if none complete before the request deadline.
+	virtual MikanAPIResult setMaxOutstandingRequests(uint32_t maxOutstandingRequests) = 0;
 };
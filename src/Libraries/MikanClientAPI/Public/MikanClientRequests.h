@@ -3,6 +3,7 @@
 #include "MikanAPIExport.h"
 #include "MikanAPITypes.h"
 #include "MikanClientTypes.h"
+#include "SerializableList.h"
 #include "SerializationProperty.h"
 
 #ifdef MIKANAPI_REFLECTION_ENABLED
@@ -43,6 +44,118 @@ public:
 	#endif
 };
 
+// Carries several json encoded requests that the server handles in the same tick.
+// Use IMikanAPI::sendBatch rather than sending this directly.
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanClientRequests")) MikanBatchRequest :
+	public MikanRequest
+{
+public:
+	MikanBatchRequest()
+	{
+		MIKAN_REQUEST_TYPE_INFO_INIT(MikanBatchRequest)
+	}
+
+	FIELD()
+	Serialization::List<Serialization::String> requests;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	MikanBatchRequest_GENERATED
+	#endif
+};
+
+// The json encoded responses to a MikanBatchRequest's sub-requests.
+// Binary encoded sub-responses are sent as their own messages instead.
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanClientRequests")) MikanBatchResponse :
+	public MikanResponse
+{
+public:
+	MikanBatchResponse()
+	{
+		MIKAN_RESPONSE_TYPE_INFO_INIT(MikanBatchResponse)
+	}
+
+	FIELD()
+	Serialization::List<Serialization::String> responses;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	MikanBatchResponse_GENERATED
+	#endif
+};
+
+// Limits the events the server sends this client to the given event types (see MikanEvent::eventTypeId).
+// Until this is sent, or after it is sent with an empty list, the client receives every event.
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanClientRequests")) SubscribeToEvents :
+	public MikanRequest
+{
+public:
+	SubscribeToEvents()
+	{
+		MIKAN_REQUEST_TYPE_INFO_INIT(SubscribeToEvents)
+	}
+
+	FIELD()
+	Serialization::List<int64_t> eventTypeIds;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	SubscribeToEvents_GENERATED
+	#endif
+};
+
+// Asks the server to publish this client's events through its shared memory event ring.
+// Only works for clients on the same machine as the server.
+// Use IMikanAPI::enableSharedMemoryEvents rather than sending this directly.
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanClientRequests")) OpenEventRing :
+	public MikanRequest
+{
+public:
+	OpenEventRing()
+	{
+		MIKAN_REQUEST_TYPE_INFO_INIT(OpenEventRing)
+	}
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	OpenEventRing_GENERATED
+	#endif
+};
+
+// Sends this client's events back over its socket connection
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanClientRequests")) CloseEventRing :
+	public MikanRequest
+{
+public:
+	CloseEventRing()
+	{
+		MIKAN_REQUEST_TYPE_INFO_INIT(CloseEventRing)
+	}
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	CloseEventRing_GENERATED
+	#endif
+};
+
+// Where to read the events published for this client, see Mikan_OpenEventRing
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanClientRequests")) MikanEventRingResponse :
+	public MikanResponse
+{
+public:
+	MikanEventRingResponse()
+	{
+		MIKAN_RESPONSE_TYPE_INFO_INIT(MikanEventRingResponse)
+	}
+
+	FIELD()
+	Serialization::String ring_name;
+	FIELD()
+	int32_t reader_index;
+	// Ring position of the first event published for this client
+	FIELD()
+	int64_t start_position;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	MikanEventRingResponse_GENERATED
+	#endif
+};
+
 #ifdef MIKANAPI_REFLECTION_ENABLED
 File_MikanClientRequests_GENERATED
 #endif
\ No newline at end of file
@@ -35,6 +35,14 @@ struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanClientTypes")) MikanC
 	bool supportsBGRA32= false;
 	FIELD()
 	bool supportsDepth= false;
+	// Set by clients that can read BinaryFormat::V2 responses,
+	// independent of the core version they connected with
+	FIELD()
+	bool supportsBinaryFormatV2= false;
+	// Set by clients that handle MikanVRDevicePoseBatchEvent,
+	// everyone else keeps getting a MikanVRDevicePoseUpdateEvent per device
+	FIELD()
+	bool supportsVRDevicePoseBatch= false;
 
 	#ifdef MIKANAPI_REFLECTION_ENABLED
 	MikanClientInfo_GENERATED
@@ -3,6 +3,18 @@
 #include "MikanAPITypes.h"
 
 #define MIKAN_TIMEOUT_DEFAULT		1000
+// Requests still without a response after this long complete with MikanAPIResult::Timeout
+#define MIKAN_REQUEST_DEADLINE_DEFAULT		10000
+#define MIKAN_MAX_OUTSTANDING_REQUESTS_DEFAULT	1024
+
+// Where a response callback attached with MikanResponseFuture::then() runs
+enum class MikanResponseExecutor
+{
+	// On the socket thread, as soon as the response arrives
+	Immediate,
+	// On the thread calling IMikanAPI::pollCompletions()
+	CompletionQueue
+};
 
 class MIKAN_API MikanResponseFuture
 {
@@ -34,6 +46,14 @@ public:
 	// Returns once the response has been received or the timeout is reached
 	void awaitResponse(uint32_t timeoutMilliseconds = MIKAN_TIMEOUT_DEFAULT);
 
+	// Non-Blocking Continuation
+	// Hands the response to the callback instead, which leaves this future invalid.
+	// A response that already arrived (or was produced locally) is handed over right away.
+	// The callback is dropped if the request gets cancelled.
+	void then(
+		MikanResponseCallback callback, 
+		MikanResponseExecutor executor = MikanResponseExecutor::CompletionQueue);
+
 protected:
 	static MikanResponsePtr makeSimpleMikanResponse(MikanAPIResult result);
 
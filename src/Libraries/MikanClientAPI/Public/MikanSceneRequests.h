@@ -0,0 +1,100 @@
+#pragma once
+
+#include "MikanAPIExport.h"
+#include "MikanAPITypes.h"
+#include "MikanSceneTypes.h"
+#include "SerializationProperty.h"
+
+#ifdef MIKANAPI_REFLECTION_ENABLED
+#include "MikanSceneRequests.rfkh.h"
+#endif
+
+// Scene Request Types
+// ------
+
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanSceneRequest")) GetSceneSnapshot :
+	public MikanRequest
+{
+public:
+	GetSceneSnapshot()
+	{
+		MIKAN_REQUEST_TYPE_INFO_INIT(GetSceneSnapshot)
+	}
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	GetSceneSnapshot_GENERATED
+	#endif
+};
+
+// Fetches the scene objects changed since the scene_version of an earlier snapshot or delta
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanSceneRequest")) GetSceneDelta :
+	public MikanRequest
+{
+public:
+	GetSceneDelta()
+	{
+		MIKAN_REQUEST_TYPE_INFO_INIT(GetSceneDelta)
+	}
+
+	FIELD()
+	int64_t sinceVersion;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	GetSceneDelta_GENERATED
+	#endif
+};
+
+// Scene Response Types
+// ------
+
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanSceneRequest")) MikanSceneSnapshotResponse : 
+	public MikanResponse
+{
+public:
+	MikanSceneSnapshotResponse()
+	{
+		MIKAN_RESPONSE_TYPE_INFO_INIT(MikanSceneSnapshotResponse)
+	}
+
+	FIELD()
+	int64_t scene_version;
+	FIELD()
+	MikanSceneObjects scene;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	MikanSceneSnapshotResponse_GENERATED
+	#endif
+};
+
+// When is_full_snapshot is set the server no longer had the changes since the requested version
+// (or never issued it), so changed holds the whole scene and anything not in it was removed
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanSceneRequest")) MikanSceneDeltaResponse : 
+	public MikanResponse
+{
+public:
+	MikanSceneDeltaResponse()
+	{
+		MIKAN_RESPONSE_TYPE_INFO_INIT(MikanSceneDeltaResponse)
+	}
+
+	FIELD()
+	int64_t scene_version;
+	FIELD()
+	bool is_full_snapshot;
+	FIELD()
+	MikanSceneObjects changed;
+	FIELD()
+	Serialization::List<MikanSpatialAnchorID> removed_spatial_anchor_ids;
+	FIELD()
+	Serialization::List<MikanStencilID> removed_stencil_ids;
+	FIELD()
+	Serialization::List<MikanVRDeviceID> removed_vr_device_ids;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	MikanSceneDeltaResponse_GENERATED
+	#endif
+};
+
+#ifdef MIKANAPI_REFLECTION_ENABLED
+File_MikanSceneRequests_GENERATED
+#endif
\ No newline at end of file
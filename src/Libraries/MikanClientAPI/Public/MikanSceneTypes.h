@@ -0,0 +1,48 @@
+#pragma once
+
+#include "MikanAPIExport.h"
+#include "MikanAPITypes.h"
+#include "MikanSpatialAnchorTypes.h"
+#include "MikanStencilTypes.h"
+#include "MikanVRDeviceTypes.h"
+#include "SerializableList.h"
+#include "SerializationProperty.h"
+
+#ifdef MIKANAPI_REFLECTION_ENABLED
+#include "MikanSceneTypes.rfkh.h"
+#endif
+
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanSceneTypes")) MikanVRDeviceDescriptor
+{
+	FIELD()
+	MikanVRDeviceID device_id;
+	FIELD()
+	MikanVRDeviceInfo vr_device_info;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	MikanVRDeviceDescriptor_GENERATED
+	#endif
+};
+
+// The scene objects a client can query, either the whole scene or the ones changed in a delta
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanSceneTypes")) MikanSceneObjects
+{
+	FIELD()
+	Serialization::List<MikanSpatialAnchorInfo> spatial_anchors;
+	FIELD()
+	Serialization::List<MikanStencilQuadInfo> quad_stencils;
+	FIELD()
+	Serialization::List<MikanStencilBoxInfo> box_stencils;
+	FIELD()
+	Serialization::List<MikanStencilModelInfo> model_stencils;
+	FIELD()
+	Serialization::List<MikanVRDeviceDescriptor> vr_devices;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	MikanSceneObjects_GENERATED
+	#endif
+};
+
+#ifdef MIKANAPI_REFLECTION_ENABLED
+File_MikanSceneTypes_GENERATED
+#endif
\ No newline at end of file
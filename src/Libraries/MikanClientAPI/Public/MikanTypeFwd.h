@@ -16,5 +16,6 @@ using MikanSpatialAnchorID = int32_t;
 
 using MikanResponsePtr = std::shared_ptr<struct MikanResponse>;
 using MikanResponsePromise = std::promise<MikanResponsePtr>;
+using MikanResponseCallback = std::function<void(MikanResponsePtr response)>;
 
 using MikanEventPtr = std::shared_ptr<struct MikanEvent>;
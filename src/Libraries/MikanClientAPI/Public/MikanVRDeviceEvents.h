@@ -3,6 +3,8 @@
 #include "MikanAPIExport.h"
 #include "MikanAPITypes.h"
 #include "MikanMathTypes.h"
+#include "MikanVRDeviceTypes.h"
+#include "SerializableList.h"
 #include "SerializableString.h"
 #include "SerializationProperty.h"
 
@@ -30,6 +32,26 @@ struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanVRDeviceEvents")) Mik
 	#endif
 };
 
+// All of the subscribed device poses for a single VR frame.
+// Sent instead of MikanVRDevicePoseUpdateEvent to clients that support it.
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanVRDeviceEvents")) MikanVRDevicePoseBatchEvent : 
+	public MikanEvent
+{
+	MikanVRDevicePoseBatchEvent()
+	{
+		MIKAN_EVENT_TYPE_INFO_INIT(MikanVRDevicePoseBatchEvent)
+	}
+
+	FIELD()
+	Serialization::List<MikanVRDevicePose> poses;
+	FIELD()
+	int64_t frame;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	MikanVRDevicePoseBatchEvent_GENERATED
+	#endif
+};
+
 struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanVRDeviceEvents")) MikanVRDeviceListUpdateEvent : 
 	public MikanEvent
 {
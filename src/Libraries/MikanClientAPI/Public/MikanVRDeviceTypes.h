@@ -2,6 +2,7 @@
 
 #include "MikanAPIExport.h"
 #include "MikanAPITypes.h"
+#include "MikanMathTypes.h"
 #include "SerializableList.h"
 #include "SerializationProperty.h"
 
@@ -44,6 +45,19 @@ struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanVRDeviceTypes")) Mika
 	#endif
 };
 
+// VR Device Event Types
+struct MIKAN_API STRUCT(Serialization::CodeGenModule("MikanVRDeviceTypes")) MikanVRDevicePose
+{
+	FIELD()
+	MikanMatrix4f transform;
+	FIELD()
+	MikanVRDeviceID device_id;
+
+	#ifdef MIKANAPI_REFLECTION_ENABLED
+	MikanVRDevicePose_GENERATED
+	#endif
+};
+
 #ifdef MIKANAPI_REFLECTION_ENABLED
 File_MikanVRDeviceTypes_GENERATED
 #endif
\ No newline at end of file
@@ -15,11 +15,15 @@
 #define WEBSOCKET_PING_EVENT				"ping"
 #define WEBSOCKET_PONG_EVENT				"pong"
 
+// Oldest server API version that accepts binary encoded requests
+#define WEBSOCKET_BINARY_REQUEST_MIN_SERVER_VERSION	2
+
 class IInterprocessMessageClient
 {
 public:
 	using TextResponseHandler = std::function<void(const std::string& utf8ResponseString)>;
 	using BinaryResponseHandler = std::function<void(const uint8_t* buffer, size_t bufferSize)>;
+	using TextEventHandler = std::function<void(const std::string& utf8EventString)>;
 
 	virtual ~IInterprocessMessageClient() {}
 
@@ -28,14 +32,17 @@ public:
 
 	virtual void setTextResponseHandler(TextResponseHandler handler) = 0;
 	virtual void setBinaryResponseHandler(BinaryResponseHandler handler) = 0;
+	// Set: server events are handed to the handler on the socket thread instead of being queued.
+	// Only change this while disconnected.
+	virtual void setTextEventHandler(TextEventHandler handler) = 0;
 
 	virtual MikanCoreResult connect(const std::string& host, const std::string& port) = 0;
 	virtual void disconnect(uint16_t code, const std::string& reason) = 0;
 	virtual const bool getIsConnected() const = 0;
 
-	virtual MikanCoreResult fetchNextEvent(
-		size_t utf8BufferSize,
-		char* outUtf8Buffer,
-		size_t* outUtf8BufferSizeNeeded) = 0;
+	// Moves the oldest queued server event into outEvent, returns false if there isn't one
+	virtual bool tryDequeueEvent(std::string& outEvent) = 0;
 	virtual MikanCoreResult sendRequest(const std::string& utf8RequestString) = 0;
+	virtual MikanCoreResult sendRequestBinary(const uint8_t* buffer, size_t bufferSize) = 0;
+	virtual const bool getIsBinaryRequestSupported() const = 0;
 };
\ No newline at end of file
@@ -0,0 +1,410 @@
+#include "UnixSocketInterprocessMessageClient.h"
+#include "JsonUtils.h"
+#include "MikanClientLogger.h"
+#include "UnixSocketUtils.h"
+
+#include "readerwriterqueue.h"
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace UnixSocketUtils;
+
+using LockFreeEventQueue = moodycamel::ReaderWriterQueue<std::string>;
+using LockFreeEventQueuePtr = std::shared_ptr<LockFreeEventQueue>;
+
+static const int k_socketPollTimeoutMilliseconds = 100;
+static const uint16_t k_normalClosureCode = 1000;
+
+//-- UnixSocketConnectionState -----
+class UnixSocketConnectionState
+{
+public:
+	UnixSocketConnectionState(int protocolVersion)
+		: m_protocolVersion(protocolVersion)
+		, m_eventQueue(std::make_shared<LockFreeEventQueue>())
+	{}
+
+	~UnixSocketConnectionState()
+	{
+		disconnect();
+		joinReaderThread();
+	}
+
+	const bool getIsConnected() const { return m_bIsConnected; }
+
+	// Protocol version the server answered the handshake with (-1 until connected)
+	inline int getServerProtocolVersion() const { return m_serverProtocolVersion; }
+
+	inline LockFreeEventQueuePtr getServerEventQueue() { return m_eventQueue; }
+	inline void setTextResponseHandler(IInterprocessMessageClient::TextResponseHandler handler) { 
+		m_textResponseHandler= handler;  
+	}
+	inline void setBinaryResponseHandler(IInterprocessMessageClient::BinaryResponseHandler handler)
+	{
+		m_binaryResponseHandler = handler;
+	}
+	inline void setTextEventHandler(IInterprocessMessageClient::TextEventHandler handler)
+	{
+		m_textEventHandler = handler;
+	}
+
+	MikanCoreResult connect(const std::string& host)
+	{
+		if (getIsConnected())
+		{
+			MIKAN_MT_LOG_ERROR("UnixSocketConnectionState::connect()") << "Already connected";
+			return MikanCoreResult_AlreadyConnected;
+		}
+
+		// Clean up after the previous connection
+		joinReaderThread();
+		closeSocket(m_socket);
+		m_socket= k_invalidSocket;
+
+		const std::string socketPath= getSocketPathFromHost(host);
+		std::string error;
+		m_socket= connectSocket(socketPath, error);
+		if (m_socket == k_invalidSocket)
+		{
+			MIKAN_MT_LOG_ERROR("UnixSocketConnectionState::connect()") << error;
+			return MikanCoreResult_SocketError;
+		}
+
+		m_serverProtocolVersion= -1;
+		m_bSendFailed= false;
+		m_bLocalCloseRequested= false;
+		m_bIsConnected= true;
+
+		// The server replies with its own version, then sends the client connected event
+		std::stringstream ss;
+		ss << WEBSOCKET_PROTOCOL_PREFIX << m_protocolVersion;
+		const std::string clientProtocol= ss.str();
+		sendFrame(eFrameType::handshake, clientProtocol.data(), clientProtocol.size());
+
+		m_readerThread= std::thread(&UnixSocketConnectionState::readerThreadFunc, this);
+
+		return MikanCoreResult_Success;
+	}
+
+	bool disconnect(uint16_t code = 0, const std::string& reason = "")
+	{
+		if (getIsConnected())
+		{
+			std::stringstream ss;
+			ss << (code != 0 ? code : k_normalClosureCode) << ":" << (code != 0 ? reason : "Normal closure");
+			const std::string closeArgs= ss.str();
+
+			// Reported in our own disconnect event, like a websocket close
+			m_localCloseArgs= closeArgs;
+			m_bLocalCloseRequested= true;
+
+			sendFrame(eFrameType::close, closeArgs.data(), closeArgs.size());
+
+			// The reader thread sees the socket close and posts the disconnect event
+			shutdownSocket(m_socket);
+
+			// Handlers run on the reader thread, which can't join itself
+			if (std::this_thread::get_id() != m_readerThread.get_id())
+			{
+				joinReaderThread();
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	MikanCoreResult sendFrame(eFrameType frameType, const void* payload, size_t payloadSize)
+	{
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+
+		if (m_bSendFailed)
+			return MikanCoreResult_SocketError;
+
+		// Requests are sent whole, waiting for room in the socket buffer if needed
+		m_sendBuffer.clear();
+		appendFrame(m_sendBuffer, frameType, payload, payloadSize);
+
+		size_t sendOffset= 0;
+		while (sendOffset < m_sendBuffer.size())
+		{
+			const int64_t sent= sendSome(m_socket, m_sendBuffer.data() + sendOffset, m_sendBuffer.size() - sendOffset);
+			if (sent < 0)
+			{
+				m_bSendFailed= true;
+				return MikanCoreResult_SocketError;
+			}
+
+			sendOffset+= (size_t)sent;
+			if (sendOffset < m_sendBuffer.size() && 
+				pollSocket(m_socket, true, k_socketPollTimeoutMilliseconds) < 0)
+			{
+				m_bSendFailed= true;
+				return MikanCoreResult_SocketError;
+			}
+		}
+
+		return MikanCoreResult_Success;
+	}
+
+protected:
+	void joinReaderThread()
+	{
+		if (m_readerThread.joinable())
+		{
+			m_readerThread.join();
+		}
+	}
+
+	void readerThreadFunc()
+	{
+		FrameReader frameReader;
+		std::vector<uint8_t> readBuffer(64 * 1024);
+		std::string closeArgs= "1006:Connection lost";
+
+		while (true)
+		{
+			const int pollResult= pollSocket(m_socket, false, k_socketPollTimeoutMilliseconds);
+			if (pollResult < 0)
+				break;
+			if (pollResult == 0)
+				continue;
+
+			const int64_t received= recvSome(m_socket, readBuffer.data(), readBuffer.size());
+			if (received < 0)
+				break;
+
+			frameReader.append(readBuffer.data(), (size_t)received);
+
+			eFrameType frameType;
+			std::string payload;
+			bool bIsClosing= false;
+			while (!bIsClosing && frameReader.tryReadFrame(frameType, payload))
+			{
+				switch (frameType)
+				{
+					case eFrameType::handshake:
+						handleHandshake(payload);
+						break;
+					case eFrameType::text:
+						handleTextMessage(payload);
+						break;
+					case eFrameType::binary:
+						handleBinaryMessage(payload);
+						break;
+					case eFrameType::close:
+						closeArgs= payload;
+						bIsClosing= true;
+						break;
+				}
+			}
+
+			if (bIsClosing)
+				break;
+
+			if (frameReader.getHasError())
+			{
+				MIKAN_MT_LOG_ERROR("UnixSocketConnectionState::readerThreadFunc") << "Corrupt frame from server";
+				closeArgs= "1002:Protocol error";
+				break;
+			}
+		}
+
+		if (m_bLocalCloseRequested)
+		{
+			closeArgs= m_localCloseArgs;
+		}
+
+		m_serverProtocolVersion= -1;
+		m_bIsConnected= false;
+
+		handleEvent(std::string(WEBSOCKET_DISCONNECT_EVENT) + ":" + closeArgs);
+	}
+
+	void handleHandshake(const std::string& protocol)
+	{
+		MIKAN_MT_LOG_INFO("UnixSocketConnectionState::handleHandshake") 
+			<< "New connection, protocol: " << protocol;
+
+		// The server responds with its own API version ("Mikan-<version>")
+		const std::string prefix= WEBSOCKET_PROTOCOL_PREFIX;
+		if (protocol.rfind(prefix, 0) == 0 && protocol.length() > prefix.length())
+		{
+			m_serverProtocolVersion= std::atoi(protocol.c_str() + prefix.length());
+		}
+	}
+
+	void handleTextMessage(const std::string& message)
+	{
+		JsonSaxInt64ValueSearcher searcher;
+
+		if (searcher.hasKey(message, "eventTypeId"))
+		{
+			handleEvent(message);
+		}
+		else if (searcher.hasKey(message, "responseTypeId"))
+		{
+			if (m_textResponseHandler != nullptr)
+			{
+				m_textResponseHandler(message);
+			}
+			else
+			{
+				MIKAN_MT_LOG_ERROR("UnixSocketConnectionState::handleTextMessage")
+					<< "Received response message but no handler set: " << message;
+			}
+		}
+		else
+		{
+			MIKAN_MT_LOG_ERROR("UnixSocketConnectionState::handleTextMessage")
+				<< "Received unsupported message: " << message;
+		}
+	}
+
+	void handleEvent(const std::string& eventString)
+	{
+		if (m_textEventHandler != nullptr)
+		{
+			m_textEventHandler(eventString);
+		}
+		else
+		{
+			m_eventQueue->enqueue(eventString);
+		}
+	}
+
+	void handleBinaryMessage(const std::string& message)
+	{
+		// Binary message always assumed to be a response (and not an event)
+		if (m_binaryResponseHandler != nullptr)
+		{
+			m_binaryResponseHandler(reinterpret_cast<const uint8_t*>(message.data()), message.size());
+		}
+		else
+		{
+			MIKAN_MT_LOG_ERROR("UnixSocketConnectionState::handleBinaryMessage")
+				<< "Received binary message but no handler set";
+		}
+	}
+
+private:
+	int m_protocolVersion= 0;
+	std::atomic_int m_serverProtocolVersion= {-1};
+	std::atomic_bool m_bIsConnected= {false};
+	std::atomic_bool m_bLocalCloseRequested= {false};
+	std::string m_localCloseArgs;
+	SocketHandle m_socket= k_invalidSocket;
+	std::thread m_readerThread;
+	LockFreeEventQueuePtr m_eventQueue;
+	IInterprocessMessageClient::TextResponseHandler m_textResponseHandler;
+	IInterprocessMessageClient::BinaryResponseHandler m_binaryResponseHandler;
+	IInterprocessMessageClient::TextEventHandler m_textEventHandler;
+
+	// Requests can be sent from any thread
+	std::mutex m_sendMutex;
+	std::vector<uint8_t> m_sendBuffer;
+	bool m_bSendFailed= false;
+};
+
+//-- UnixSocketInterprocessMessageClient -----
+UnixSocketInterprocessMessageClient::UnixSocketInterprocessMessageClient(int protocolVersion)
+	: m_connectionState(std::make_shared<UnixSocketConnectionState>(protocolVersion))
+{
+}
+
+UnixSocketInterprocessMessageClient::~UnixSocketInterprocessMessageClient()
+{
+	dispose();
+}
+
+MikanCoreResult UnixSocketInterprocessMessageClient::initialize()
+{
+	return MikanCoreResult_Success;
+}
+
+void UnixSocketInterprocessMessageClient::dispose()
+{
+	disconnect(0, "");
+}
+
+const bool UnixSocketInterprocessMessageClient::getIsConnected() const
+{ 
+	return m_connectionState->getIsConnected(); 
+}
+
+void UnixSocketInterprocessMessageClient::setTextResponseHandler(
+	IInterprocessMessageClient::TextResponseHandler handler) 
+{ 
+	m_connectionState->setTextResponseHandler(handler);
+}
+
+void UnixSocketInterprocessMessageClient::setBinaryResponseHandler(
+	IInterprocessMessageClient::BinaryResponseHandler handler)
+{
+	m_connectionState->setBinaryResponseHandler(handler);
+}
+
+void UnixSocketInterprocessMessageClient::setTextEventHandler(
+	IInterprocessMessageClient::TextEventHandler handler)
+{
+	m_connectionState->setTextEventHandler(handler);
+}
+
+MikanCoreResult UnixSocketInterprocessMessageClient::connect(
+	const std::string& host, 
+	const std::string& port)
+{
+	// The socket path stands in for the address, the port isn't used
+	return m_connectionState->connect(host);
+}
+
+void UnixSocketInterprocessMessageClient::disconnect(uint16_t code, const std::string& reason)
+{
+	m_connectionState->disconnect(code, reason);
+}
+
+bool UnixSocketInterprocessMessageClient::tryDequeueEvent(std::string& outEvent)
+{
+	return m_connectionState->getServerEventQueue()->try_dequeue(outEvent);
+}
+
+MikanCoreResult UnixSocketInterprocessMessageClient::sendRequest(const std::string& utf8RequestString)
+{
+	MikanCoreResult result= 
+		m_connectionState->sendFrame(eFrameType::text, utf8RequestString.data(), utf8RequestString.size());
+
+	if (result != MikanCoreResult_Success)
+	{
+		MIKAN_LOG_ERROR("UnixSocketInterprocessMessageClient::sendRequest()") 
+			<< "Failed to send request: " << utf8RequestString;
+	}
+
+	return result;
+}
+
+MikanCoreResult UnixSocketInterprocessMessageClient::sendRequestBinary(const uint8_t* buffer, size_t bufferSize)
+{
+	if (!getIsBinaryRequestSupported())
+	{
+		return MikanCoreResult_UnknownFunction;
+	}
+
+	MikanCoreResult result= m_connectionState->sendFrame(eFrameType::binary, buffer, bufferSize);
+
+	if (result != MikanCoreResult_Success)
+	{
+		MIKAN_LOG_ERROR("UnixSocketInterprocessMessageClient::sendRequestBinary()") 
+			<< "Failed to send binary request of " << bufferSize << " bytes";
+	}
+
+	return result;
+}
+
+const bool UnixSocketInterprocessMessageClient::getIsBinaryRequestSupported() const
+{
+	return m_connectionState->getServerProtocolVersion() >= WEBSOCKET_BINARY_REQUEST_MIN_SERVER_VERSION;
+}
\ No newline at end of file
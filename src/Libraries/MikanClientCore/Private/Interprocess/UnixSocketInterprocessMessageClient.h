@@ -0,0 +1,39 @@
+#pragma once
+
+#include "InterprocessMessageClientInterface.h"
+
+#include <memory>
+
+class UnixSocketConnectionState;
+using UnixSocketConnectionStatePtr = std::shared_ptr<UnixSocketConnectionState>;
+
+// Talks to a MikanXR server on the same machine over a Unix domain socket.
+// Selected by passing a "unix:<socket path>" host to Mikan_Connect.
+class UnixSocketInterprocessMessageClient : public IInterprocessMessageClient
+{
+public:
+	UnixSocketInterprocessMessageClient(int protocolVersion);
+	virtual ~UnixSocketInterprocessMessageClient();
+
+	virtual MikanCoreResult initialize() override;
+	virtual void dispose() override;
+
+	virtual void setTextResponseHandler(TextResponseHandler handler) override;
+	virtual void setBinaryResponseHandler(BinaryResponseHandler handler) override;
+	virtual void setTextEventHandler(TextEventHandler handler) override;
+
+	MikanCoreResult connect(
+		const std::string& host, 
+		const std::string& port) override;
+	void disconnect(uint16_t code, const std::string& reason) override;
+
+	virtual bool tryDequeueEvent(std::string& outEvent) override;
+	virtual MikanCoreResult sendRequest(const std::string& utf8RequestString) override;
+	virtual MikanCoreResult sendRequestBinary(const uint8_t* buffer, size_t bufferSize) override;
+	virtual const bool getIsBinaryRequestSupported() const override;
+
+	const bool getIsConnected() const override;
+
+private:
+	UnixSocketConnectionStatePtr m_connectionState;
+};
\ No newline at end of file
@@ -6,6 +6,9 @@
 #include "readerwriterqueue.h"
 
 #include <ixwebsocket/IXWebSocket.h>
+#include <ixwebsocket/IXWebSocketSendData.h>
+
+#include <atomic>
 
 
 using LockFreeEventQueue = moodycamel::ReaderWriterQueue<std::string>;
@@ -40,6 +43,9 @@ public:
 	
 	inline WebSocketPtr getWebSocket() { return m_websocket; }
 
+	// Protocol version the server answered the handshake with (-1 until connected)
+	inline int getServerProtocolVersion() const { return m_serverProtocolVersion; }
+
 	inline LockFreeEventQueuePtr getServerEventQueue() { return m_eventQueue; }
 	inline void setTextResponseHandler(IInterprocessMessageClient::TextResponseHandler handler) { 
 		m_textResponseHandler= handler;  
@@ -48,6 +54,10 @@ public:
 	{
 		m_binaryResponseHandler = handler;
 	}
+	inline void setTextEventHandler(IInterprocessMessageClient::TextEventHandler handler)
+	{
+		m_textEventHandler = handler;
+	}
 
 	MikanCoreResult connect(
 		const std::string& host,
@@ -63,6 +73,7 @@ public:
 		std::string hostPort= port.empty() ? WEBSOCKET_SERVER_PORT : port;
 		std::stringstream ss;
 		ss << WEBSOCKET_PROTOCOL_PREFIX << m_protocolVersion;
+		m_serverProtocolVersion= -1;
 		m_websocket->addSubProtocol(ss.str());
 		m_websocket->setUrl(hostAddress + ":" + hostPort);
 		m_websocket->start();
@@ -101,17 +112,27 @@ public:
 						<< "New connection"
 						<< ", uri: " << msg->openInfo.uri
 						<< ", protocol: " << msg->openInfo.protocol;
+
+					// The server responds with its own API version ("Mikan-<version>")
+					const std::string& protocol= msg->openInfo.protocol;
+					const std::string prefix= WEBSOCKET_PROTOCOL_PREFIX;
+					if (protocol.rfind(prefix, 0) == 0 && protocol.length() > prefix.length())
+					{
+						m_serverProtocolVersion= std::atoi(protocol.c_str() + prefix.length());
+					}
 				}
 				break;
 			case ix::WebSocketMessageType::Close:
 				{
+					m_serverProtocolVersion= -1;
+
 					std::stringstream ss;
 
 					ss << WEBSOCKET_DISCONNECT_EVENT;
 					ss << ":" << msg->closeInfo.code;
 					ss << ":" << msg->closeInfo.reason;
 
-					m_eventQueue->enqueue(ss.str());
+					handleEvent(ss.str());
 				}
 				break;
 			case ix::WebSocketMessageType::Message:
@@ -122,7 +143,7 @@ public:
 
 						if (searcher.hasKey(msg->str, "eventTypeId"))
 						{
-							m_eventQueue->enqueue(msg->str);
+							handleEvent(msg->str);
 						}
 						else if (searcher.hasKey(msg->str, "responseTypeId"))
 						{
@@ -182,13 +203,27 @@ public:
 		}
 	}
 
+	void handleEvent(const std::string& eventString)
+	{
+		if (m_textEventHandler != nullptr)
+		{
+			m_textEventHandler(eventString);
+		}
+		else
+		{
+			m_eventQueue->enqueue(eventString);
+		}
+	}
+
 private:
 	int m_protocolVersion= 0;
+	std::atomic_int m_serverProtocolVersion= {-1};
 	WebSocketPtr m_websocket;
 	ix::WebSocketHttpHeaders m_headers;
 	LockFreeEventQueuePtr m_eventQueue;
 	IInterprocessMessageClient::TextResponseHandler m_textResponseHandler;
 	IInterprocessMessageClient::BinaryResponseHandler m_binaryResponseHandler;
+	IInterprocessMessageClient::TextEventHandler m_textEventHandler;
 	std::string m_connectionRequestJson;
 };
 
@@ -230,6 +265,12 @@ void WebsocketInterprocessMessageClient::setBinaryResponseHandler(
 	m_connectionState->setBinaryResponseHandler(handler);
 }
 
+void WebsocketInterprocessMessageClient::setTextEventHandler(
+	IInterprocessMessageClient::TextEventHandler handler)
+{
+	m_connectionState->setTextEventHandler(handler);
+}
+
 MikanCoreResult WebsocketInterprocessMessageClient::connect(
 	const std::string& host, 
 	const std::string& port)
@@ -242,59 +283,46 @@ void WebsocketInterprocessMessageClient::disconnect(uint16_t code, const std::st
 	m_connectionState->disconnect(code, reason);
 }
 
-MikanCoreResult WebsocketInterprocessMessageClient::fetchNextEvent(
-	size_t utf8BufferSize, 
-	char* outUtf8Buffer, 
-	size_t* outUtf8BufferSizeNeeded)
+bool WebsocketInterprocessMessageClient::tryDequeueEvent(std::string& outEvent)
 {
-	auto eventQueue= m_connectionState->getServerEventQueue();
-	const std::string* nextEvent = eventQueue->peek();
-
-	if (nextEvent == nullptr)
-		return MikanCoreResult_NoData;
+	return m_connectionState->getServerEventQueue()->try_dequeue(outEvent);
+}
 
-	const size_t eventSize= nextEvent->size();
-	const size_t bytesNeeded= eventSize + 1; // Include null terminator
+MikanCoreResult WebsocketInterprocessMessageClient::sendRequest(const std::string& utf8RequestString)
+{
+	ix::WebSocketSendInfo sendInfo= m_connectionState->getWebSocket()->sendText(utf8RequestString);
 
-	if (outUtf8Buffer != nullptr)
+	if (!sendInfo.success)
 	{
-		if (bytesNeeded > utf8BufferSize)
-			return MikanCoreResult_BufferTooSmall;
-
-		// Copy the utf-8 buffer from the event queue into the output buffer
-		memcpy(outUtf8Buffer, nextEvent->c_str(), eventSize);
-
-		// Null terminate the end of the string
-		outUtf8Buffer[eventSize]= '\0';
-
-		// Remove the event string from the queue
-		eventQueue->pop();
-
-		if (outUtf8BufferSizeNeeded != nullptr)
-			*outUtf8BufferSizeNeeded= bytesNeeded;
-
-		return MikanCoreResult_Success;
+		MIKAN_LOG_ERROR("WebsocketInterprocessMessageClient::sendRequest()") 
+			<< "Failed to send request: " << utf8RequestString;
+		return MikanCoreResult_SocketError;
 	}
-	else 
-	{
-		if (outUtf8BufferSizeNeeded == nullptr)
-			return MikanCoreResult_NullParam;
 
-		*outUtf8BufferSizeNeeded= bytesNeeded;
-		return MikanCoreResult_Success;
-	}
+	return MikanCoreResult_Success;
 }
 
-MikanCoreResult WebsocketInterprocessMessageClient::sendRequest(const std::string& utf8RequestString)
+MikanCoreResult WebsocketInterprocessMessageClient::sendRequestBinary(const uint8_t* buffer, size_t bufferSize)
 {
-	ix::WebSocketSendInfo sendInfo= m_connectionState->getWebSocket()->sendText(utf8RequestString);
+	if (!getIsBinaryRequestSupported())
+	{
+		return MikanCoreResult_UnknownFunction;
+	}
+
+	ix::IXWebSocketSendData sendData(buffer, bufferSize);
+	ix::WebSocketSendInfo sendInfo= m_connectionState->getWebSocket()->sendBinary(sendData);
 
 	if (!sendInfo.success)
 	{
-		MIKAN_LOG_ERROR("WebsocketInterprocessMessageClient::sendRequest()") 
-			<< "Failed to send request: " << utf8RequestString;
+		MIKAN_LOG_ERROR("WebsocketInterprocessMessageClient::sendRequestBinary()") 
+			<< "Failed to send binary request of " << bufferSize << " bytes";
 		return MikanCoreResult_SocketError;
 	}
 
 	return MikanCoreResult_Success;
-}
\ No newline at end of file
+}
+
+const bool WebsocketInterprocessMessageClient::getIsBinaryRequestSupported() const
+{
+	return m_connectionState->getServerProtocolVersion() >= WEBSOCKET_BINARY_REQUEST_MIN_SERVER_VERSION;
+}
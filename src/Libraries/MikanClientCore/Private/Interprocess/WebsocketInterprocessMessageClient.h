@@ -18,17 +18,17 @@ public:
 
 	virtual void setTextResponseHandler(TextResponseHandler handler) override;
 	virtual void setBinaryResponseHandler(BinaryResponseHandler handler) override;
+	virtual void setTextEventHandler(TextEventHandler handler) override;
 
 	MikanCoreResult connect(
 		const std::string& host, 
 		const std::string& port) override;
 	void disconnect(uint16_t code, const std::string& reason) override;
 
-	virtual MikanCoreResult fetchNextEvent(
-		size_t utf8BufferSize,
-		char* outUtf8Buffer,
-		size_t* outUtf8BufferSizeNeeded) override;
+	virtual bool tryDequeueEvent(std::string& outEvent) override;
 	virtual MikanCoreResult sendRequest(const std::string& utf8RequestString) override;
+	virtual MikanCoreResult sendRequestBinary(const uint8_t* buffer, size_t bufferSize) override;
+	virtual const bool getIsBinaryRequestSupported() const override;
 
 	const bool getIsConnected() const override;
 
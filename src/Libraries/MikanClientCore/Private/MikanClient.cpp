@@ -1,4 +1,5 @@
 //-- includes -----
+#include "UnixSocketInterprocessMessageClient.h"
 #include "WebsocketInterprocessMessageClient.h"
 #include "MikanClientLogger.h"
 #include "MikanClient.h"
@@ -7,35 +8,46 @@
 #include "JsonUtils.h"
 #include "JsonSerializer.h"
 #include "RandomUtils.h"
+#include "SharedEventRing.h"
 #include "SharedTextureWriter.h"
+#include "UnixSocketUtils.h"
 
 #include "ixwebsocket/IXNetSystem.h"
 
 #include <assert.h>
+#include <string.h>
 
 // -- methods -----
 MikanClient::MikanClient()
 	: m_clientUniqueID(RandomUtils::RandomHexString(16))
 	, m_renderTargetWriter(createSharedTextureWriteAccessor(m_clientUniqueID))
-	, m_messageClient(new WebsocketInterprocessMessageClient(MikanConstants_ClientAPIVersion))
+	, m_websocketClient(new WebsocketInterprocessMessageClient(MikanConstants_ClientAPIVersion))
+	, m_unixSocketClient(new UnixSocketInterprocessMessageClient(MikanConstants_ClientAPIVersion))
+	, m_messageClient(m_websocketClient)
+	, m_eventRingReader(new SharedEventRingReader())
 {
 	for (int i = 0; i < MikanClientGraphicsApi_COUNT; i++)
 	{
 		m_graphicsDeviceInterfaces[i] = nullptr;
 	};
 
-	m_messageClient->setTextResponseHandler([this](const std::string& utf8ResponseString) {
-		textResponseHandler(utf8ResponseString);
-	});
-	m_messageClient->setBinaryResponseHandler([this](const uint8_t* buffer, size_t bufferSize) {
-		binaryResponseHandler(buffer, bufferSize);
-	});
+	for (IInterprocessMessageClient* messageClient : {m_websocketClient, m_unixSocketClient})
+	{
+		messageClient->setTextResponseHandler([this](const std::string& utf8ResponseString) {
+			textResponseHandler(utf8ResponseString);
+		});
+		messageClient->setBinaryResponseHandler([this](const uint8_t* buffer, size_t bufferSize) {
+			binaryResponseHandler(buffer, bufferSize);
+		});
+	}
 }
 
 MikanClient::~MikanClient()
 {
 	freeRenderTargetTextures();
-	delete m_messageClient;
+	delete m_eventRingReader;
+	delete m_unixSocketClient;
+	delete m_websocketClient;
 }
 
 // -- ClientMikanAPI System -----
@@ -66,6 +78,20 @@ MikanCoreResult MikanClient::connect(
 	const std::string& host, 
 	const std::string& port)
 {
+	if (m_messageClient->getIsConnected())
+	{
+		return MikanCoreResult_AlreadyConnected;
+	}
+
+	// Any ring left open belonged to the previous connection
+	closeEventRing();
+
+	// "unix:<socket path>" talks to a server on this machine over a unix domain socket
+	m_messageClient= 
+		UnixSocketUtils::isUnixSocketHost(host) 
+		? m_unixSocketClient 
+		: m_websocketClient;
+
 	return m_messageClient->connect(host, port);
 }
 
@@ -85,6 +111,7 @@ MikanCoreResult MikanClient::disconnect(uint16_t code, const std::string& reason
 
 	// Free any existing buffer if we called allocate already
 	freeRenderTargetTextures();
+	closeEventRing();
 
 	if (m_messageClient->getIsConnected())
 	{
@@ -102,7 +129,204 @@ MikanCoreResult MikanClient::fetchNextEvent(
 {
 	// Events can arrive even when not connected (e.g. disconnect event)
 	// So we don't check for connection here
-	return m_messageClient->fetchNextEvent(utf8_buffer_size, out_utf8_buffer, out_utf8_bytes_written);
+	if (m_pendingEvents.empty() && !pullNextEvent())
+		return MikanCoreResult_NoData;
+
+	const std::string& nextEvent= m_pendingEvents.front();
+	const size_t eventSize= nextEvent.size();
+	const size_t bytesNeeded= eventSize + 1; // Include null terminator
+
+	if (out_utf8_buffer != nullptr)
+	{
+		if (bytesNeeded > utf8_buffer_size)
+			return MikanCoreResult_BufferTooSmall;
+
+		// Copy the utf-8 event into the output buffer, null terminated
+		memcpy(out_utf8_buffer, nextEvent.c_str(), eventSize);
+		out_utf8_buffer[eventSize]= '\0';
+
+		m_pendingEvents.pop_front();
+
+		if (out_utf8_bytes_written != nullptr)
+			*out_utf8_bytes_written= bytesNeeded;
+
+		return MikanCoreResult_Success;
+	}
+	else
+	{
+		if (out_utf8_bytes_written == nullptr)
+			return MikanCoreResult_NullParam;
+
+		*out_utf8_bytes_written= bytesNeeded;
+		return MikanCoreResult_Success;
+	}
+}
+
+MikanCoreResult MikanClient::fetchEvents(
+	uint8_t* out_buffer,
+	size_t buffer_size,
+	size_t* out_event_count,
+	size_t* out_bytes_needed)
+{
+	if (out_event_count == nullptr || out_bytes_needed == nullptr)
+		return MikanCoreResult_NullParam;
+
+	// Take everything that has arrived so far
+	while (pullNextEvent())
+	{
+	}
+
+	*out_event_count= 0;
+	*out_bytes_needed= 0;
+
+	if (m_pendingEvents.empty())
+		return MikanCoreResult_NoData;
+
+	// Find how many events fit (in order), and how big a buffer would hold all of them
+	size_t fitCount= 0;
+	size_t totalBytes= 0;
+	for (const std::string& pendingEvent : m_pendingEvents)
+	{
+		// Offset table entry + null terminated event
+		totalBytes+= sizeof(uint32_t) + pendingEvent.size() + 1;
+
+		if (totalBytes <= buffer_size)
+		{
+			fitCount++;
+		}
+	}
+	*out_bytes_needed= totalBytes;
+
+	if (out_buffer == nullptr)
+	{
+		*out_event_count= m_pendingEvents.size();
+		return MikanCoreResult_Success;
+	}
+
+	if (fitCount == 0)
+		return MikanCoreResult_BufferTooSmall;
+
+	// Offset table first, then the null terminated events back to back
+	size_t eventOffset= fitCount * sizeof(uint32_t);
+	for (size_t eventIndex= 0; eventIndex < fitCount; ++eventIndex)
+	{
+		const std::string& pendingEvent= m_pendingEvents.front();
+		const uint32_t offset= (uint32_t)eventOffset;
+
+		memcpy(out_buffer + eventIndex * sizeof(uint32_t), &offset, sizeof(offset));
+		memcpy(out_buffer + eventOffset, pendingEvent.c_str(), pendingEvent.size() + 1);
+		eventOffset+= pendingEvent.size() + 1;
+
+		m_pendingEvents.pop_front();
+	}
+
+	*out_event_count= fitCount;
+	return MikanCoreResult_Success;
+}
+
+bool MikanClient::pullNextEvent()
+{
+	std::string nextEvent;
+
+	// Without the event ring every event comes over the socket, already in order
+	if (!m_eventRingReader->getIsValid())
+	{
+		if (pullHeldSocketEvent())
+			return true;
+
+		if (m_messageClient->tryDequeueEvent(nextEvent))
+		{
+			m_pendingEvents.push_back(std::move(nextEvent));
+			return true;
+		}
+
+		return false;
+	}
+
+	// Take the next socket event before reading the ring.
+	// The server writes the ring marker of an event before sending it over the socket,
+	// so if this socket event has a marker, that marker can already be read from the ring.
+	if (!m_bHasHeldSocketEvent)
+	{
+		m_bHasHeldSocketEvent= m_messageClient->tryDequeueEvent(m_heldSocketEvent);
+	}
+
+	// The ring stays parked on a marker until its event comes in over the socket
+	if (m_bIsWaitingOnSocketEvent)
+	{
+		if (!pullHeldSocketEvent())
+			return false;
+
+		m_bIsWaitingOnSocketEvent= false;
+		return true;
+	}
+
+	const uint64_t overrunCount= m_eventRingReader->getOverrunCount();
+
+	if (m_eventRingReader->tryReadEvent(nextEvent))
+	{
+		if (m_eventRingReader->getOverrunCount() != overrunCount)
+		{
+			MIKAN_LOG_WARNING("MikanClient::pullNextEvent()") 
+				<< "Fell behind the event ring, some events were lost";
+		}
+
+		// Stands in for an event too big for the ring
+		if (nextEvent == SHARED_EVENT_RING_SOCKET_EVENT_MARKER)
+		{
+			if (pullHeldSocketEvent())
+				return true;
+
+			m_bIsWaitingOnSocketEvent= true;
+			return false;
+		}
+
+		m_pendingEvents.push_back(std::move(nextEvent));
+		return true;
+	}
+
+	// Socket events without a ring marker (e.g. connection events)
+	return pullHeldSocketEvent();
+}
+
+bool MikanClient::pullHeldSocketEvent()
+{
+	if (!m_bHasHeldSocketEvent)
+		return false;
+
+	m_pendingEvents.push_back(std::move(m_heldSocketEvent));
+	m_heldSocketEvent.clear();
+	m_bHasHeldSocketEvent= false;
+
+	return true;
+}
+
+MikanCoreResult MikanClient::openEventRing(
+	const std::string& ringName, 
+	int32_t readerIndex, 
+	int64_t startPosition)
+{
+	if (!m_messageClient->getIsConnected())
+		return MikanCoreResult_NotConnected;
+
+	closeEventRing();
+
+	if (!m_eventRingReader->open(ringName, readerIndex, (uint64_t)startPosition))
+	{
+		MIKAN_LOG_WARNING("MikanClient::openEventRing()") << "Failed to open event ring: " << ringName;
+		return MikanCoreResult_RequestFailed;
+	}
+
+	return MikanCoreResult_Success;
+}
+
+MikanCoreResult MikanClient::closeEventRing()
+{
+	m_eventRingReader->dispose();
+	// Socket events no longer wait on ring markers
+	m_bIsWaitingOnSocketEvent= false;
+
+	return MikanCoreResult_Success;
 }
 
 MikanCoreResult MikanClient::setTextResponseCallback(MikanTextResponseCallback callback, void* callback_userdata)
@@ -121,6 +345,34 @@ MikanCoreResult MikanClient::setBinaryResponseCallback(MikanBinaryResponseCallba
 	return MikanCoreResult_Success;
 }
 
+MikanCoreResult MikanClient::setTextEventCallback(MikanTextEventCallback callback, void* callback_userdata)
+{
+	// The socket thread reads the handler without a lock
+	if (m_messageClient->getIsConnected())
+	{
+		return MikanCoreResult_AlreadyConnected;
+	}
+
+	m_textEventCallback= callback;
+	m_textEventCallbackUserData= callback_userdata;
+
+	for (IInterprocessMessageClient* messageClient : {m_websocketClient, m_unixSocketClient})
+	{
+		if (callback != nullptr)
+		{
+			messageClient->setTextEventHandler([this](const std::string& utf8EventString) {
+				m_textEventCallback(utf8EventString.c_str(), m_textEventCallbackUserData);
+			});
+		}
+		else
+		{
+			messageClient->setTextEventHandler(nullptr);
+		}
+	}
+
+	return MikanCoreResult_Success;
+}
+
 MikanCoreResult MikanClient::sendRequestJSON(const char* utf8_request_json)
 {
 	if (m_messageClient->getIsConnected())
@@ -131,6 +383,21 @@ MikanCoreResult MikanClient::sendRequestJSON(const char* utf8_request_json)
 	return MikanCoreResult_NotConnected;
 }
 
+MikanCoreResult MikanClient::sendRequestBinary(const uint8_t* request_bytes, size_t request_size)
+{
+	if (m_messageClient->getIsConnected())
+	{
+		return m_messageClient->sendRequestBinary(request_bytes, request_size);
+	}
+
+	return MikanCoreResult_NotConnected;
+}
+
+bool MikanClient::getIsBinaryRequestSupported() const
+{
+	return m_messageClient->getIsConnected() && m_messageClient->getIsBinaryRequestSupported();
+}
+
 void MikanClient::textResponseHandler(const std::string& utf8ResponseString)
 {
 	if (m_textResponseCallback != nullptr)
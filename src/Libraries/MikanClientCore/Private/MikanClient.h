@@ -4,8 +4,10 @@
 #include "SharedTextureFwd.h"
 #include "MikanCoreTypes.h"
 
+#include <deque>
 #include <map>
 #include <mutex>
+#include <string>
 
 //-- definitions -----
 class MikanClient
@@ -23,9 +25,15 @@ public:
 	MikanCoreResult connect(const std::string& host, const std::string& port);
 	MikanCoreResult disconnect(uint16_t code, const std::string& reason);
 	MikanCoreResult fetchNextEvent(size_t utf8_buffer_size, char* out_utf8_buffer, size_t* out_utf8_bytes_written);
+	MikanCoreResult fetchEvents(uint8_t* out_buffer, size_t buffer_size, size_t* out_event_count, size_t* out_bytes_needed);
+	MikanCoreResult openEventRing(const std::string& ringName, int32_t readerIndex, int64_t startPosition);
+	MikanCoreResult closeEventRing();
 	MikanCoreResult setTextResponseCallback(MikanTextResponseCallback callback, void* callback_userdata);
 	MikanCoreResult setBinaryResponseCallback(MikanBinaryResponseCallback callback, void* callback_userdata);
+	MikanCoreResult setTextEventCallback(MikanTextEventCallback callback, void* callback_userdata);
 	MikanCoreResult sendRequestJSON(const char* utf8_request_json);
+	MikanCoreResult sendRequestBinary(const uint8_t* request_bytes, size_t request_size);
+	bool getIsBinaryRequestSupported() const;
 	MikanCoreResult shutdown();
 
 	MikanCoreResult allocateRenderTargetTextures(const MikanRenderTargetDescriptor& descriptor);
@@ -44,6 +52,8 @@ public:
 protected:
 	void textResponseHandler(const std::string& utf8ResponseString);
 	void binaryResponseHandler(const uint8_t* buffer, size_t bufferSize);
+	bool pullNextEvent();
+	bool pullHeldSocketEvent();
 
 private:
 	std::array<void*, MikanClientGraphicsApi_COUNT> m_graphicsDeviceInterfaces;
@@ -52,9 +62,24 @@ private:
 	void* m_textResponseCallbackUserData= nullptr;
 	MikanBinaryResponseCallback m_binaryResponseCallback = nullptr;
 	void* m_binaryResponseCallbackUserData= nullptr;
+	MikanTextEventCallback m_textEventCallback= nullptr;
+	void* m_textEventCallbackUserData= nullptr;
 
 	std::string m_clientUniqueID;
 	ISharedTextureWriteAccessorPtr m_renderTargetWriter;
+	// Connection transport, picked by connect() from the host
+	class IInterprocessMessageClient* m_websocketClient;
+	class IInterprocessMessageClient* m_unixSocketClient;
 	class IInterprocessMessageClient* m_messageClient;
 	bool m_bIsConnected;
+
+	// Events published through the server's shared memory event ring (optional)
+	class SharedEventRingReader* m_eventRingReader;
+	// Socket event taken off the queue before reading the ring, waiting for its turn
+	std::string m_heldSocketEvent;
+	bool m_bHasHeldSocketEvent= false;
+	// Reached a ring marker whose event hasn't come in over the socket yet
+	bool m_bIsWaitingOnSocketEvent= false;
+	// Events taken off the socket queue or the ring, but not yet copied out to the caller
+	std::deque<std::string> m_pendingEvents;
 };
\ No newline at end of file
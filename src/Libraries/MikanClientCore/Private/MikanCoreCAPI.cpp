@@ -169,6 +169,20 @@ MikanCoreResult Mikan_FetchNextEvent(
 	return mikanClient->fetchNextEvent(utf8_buffer_size, out_utf8_buffer, out_utf8_bytes_written);
 }
 
+MikanCoreResult Mikan_FetchEvents(
+	MikanContext context,
+	uint8_t* out_buffer,
+	size_t buffer_size,
+	size_t* out_event_count,
+	size_t* out_bytes_needed)
+{
+	auto* mikanClient= reinterpret_cast<MikanClient*>(context);
+	if (mikanClient == nullptr)
+		return MikanCoreResult_Uninitialized;
+
+	return mikanClient->fetchEvents(out_buffer, buffer_size, out_event_count, out_bytes_needed);
+}
+
 MikanCoreResult Mikan_SendRequestJSON(
 	MikanContext context,
 	const char* utf8_request_json)
@@ -180,6 +194,51 @@ MikanCoreResult Mikan_SendRequestJSON(
 	return mikanClient->sendRequestJSON(utf8_request_json);
 }
 
+MikanCoreResult Mikan_SendRequestBinary(
+	MikanContext context,
+	const uint8_t* request_bytes,
+	size_t request_size)
+{
+	auto* mikanClient = reinterpret_cast<MikanClient*>(context);
+	if (mikanClient == nullptr)
+		return MikanCoreResult_Uninitialized;
+	if (request_bytes == nullptr)
+		return MikanCoreResult_NullParam;
+
+	return mikanClient->sendRequestBinary(request_bytes, request_size);
+}
+
+MikanCoreResult Mikan_OpenEventRing(
+	MikanContext context,
+	const char* ring_name,
+	int32_t reader_index,
+	int64_t start_position)
+{
+	auto* mikanClient = reinterpret_cast<MikanClient*>(context);
+	if (mikanClient == nullptr)
+		return MikanCoreResult_Uninitialized;
+	if (ring_name == nullptr)
+		return MikanCoreResult_NullParam;
+
+	return mikanClient->openEventRing(ring_name, reader_index, start_position);
+}
+
+MikanCoreResult Mikan_CloseEventRing(MikanContext context)
+{
+	auto* mikanClient = reinterpret_cast<MikanClient*>(context);
+	if (mikanClient == nullptr)
+		return MikanCoreResult_Uninitialized;
+
+	return mikanClient->closeEventRing();
+}
+
+bool Mikan_GetIsBinaryRequestSupported(MikanContext context)
+{
+	auto* mikanClient = reinterpret_cast<MikanClient*>(context);
+
+	return mikanClient != nullptr && mikanClient->getIsBinaryRequestSupported();
+}
+
 
 MikanCoreResult Mikan_SetTextResponseCallback(
 	MikanContext context,
@@ -207,6 +266,19 @@ MikanCoreResult Mikan_SetBinaryResponseCallback(
 	return mikanClient->setBinaryResponseCallback(callback, callback_userdata);
 }
 
+MikanCoreResult Mikan_SetTextEventCallback(
+	MikanContext context,
+	MikanTextEventCallback callback,
+	void* callback_userdata)
+{
+	auto* mikanClient= reinterpret_cast<MikanClient*>(context);
+
+	if (mikanClient == nullptr)
+		return MikanCoreResult_Uninitialized;
+
+	return mikanClient->setTextEventCallback(callback, callback_userdata);
+}
+
 MikanCoreResult Mikan_SetGraphicsDeviceInterface(
 	MikanContext context,
 	MikanClientGraphicsApi api, 
@@ -53,8 +53,10 @@ MIKAN_CORE_CAPI(void*) Mikan_GetPackDepthTextureResourcePtr(MikanContext context
 /** \brief Initializes a connection to MikanXR.
  Starts connection process to MikanXR at the given address and port. 
 	.   
- \param host The address that MikanXR is running at, usually MIKANXR_DEFAULT_ADDRESS
- \param port The port that MikanXR is running at, usually MIKANXR_DEFAULT_PORT
+ \param host The address that MikanXR is running at, usually MIKANXR_DEFAULT_ADDRESS.
+	Pass "unix:<socket path>" to connect over a unix domain socket instead of a websocket
+	(an empty path uses MikanXR.sock in the temp directory).
+ \param port The port that MikanXR is running at, usually MIKANXR_DEFAULT_PORT (unused for unix sockets)
  */
 MIKAN_CORE_CAPI(MikanCoreResult) Mikan_Connect(
 	MikanContext context, 
@@ -73,17 +75,62 @@ MIKAN_CORE_CAPI(bool) Mikan_GetIsConnected(MikanContext context);
 
 // Copies the buffer into the provided buffer and returns the number of bytes written
 // If no buffer is provided, the function will return the size of the buffer needed to store the event
+// Events queued on the socket are returned before events read from the shared memory event ring
 MIKAN_CORE_CAPI(MikanCoreResult) Mikan_FetchNextEvent(
 	MikanContext context,
 	size_t utf8_buffer_size,
 	char* out_utf8_buffer,
 	size_t* out_utf8_bytes_written);
 
+/** \brief Copies every pending event into one buffer
+ The buffer starts with a table of out_event_count uint32_t byte offsets (from the start of the buffer),
+ followed by the null terminated UTF8 events they point at, oldest event first.
+ Events that don't fit stay queued for the next call.
+ \param out_buffer The buffer to fill, or null to only query out_event_count and out_bytes_needed
+ \param out_event_count The number of events copied into the buffer
+ \param out_bytes_needed The buffer size needed to return every pending event in one call
+ \return MikanCoreResult_NoData if there were no events, 
+   MikanCoreResult_BufferTooSmall if not even the oldest event fits
+ */
+MIKAN_CORE_CAPI(MikanCoreResult) Mikan_FetchEvents(
+	MikanContext context,
+	uint8_t* out_buffer,
+	size_t buffer_size,
+	size_t* out_event_count,
+	size_t* out_bytes_needed);
+
 // Sends a MikanRequest as a UTF8 encoded JSON string
 MIKAN_CORE_CAPI(MikanCoreResult) Mikan_SendRequestJSON(
 	MikanContext context,
 	const char* utf8_request_json);
 
+// Sends a MikanRequest encoded with the binary serializer
+// Returns MikanCoreResult_UnknownFunction if the connected server only accepts JSON requests
+MIKAN_CORE_CAPI(MikanCoreResult) Mikan_SendRequestBinary(
+	MikanContext context,
+	const uint8_t* request_bytes,
+	size_t request_size);
+
+/** \brief Start reading events from the server's shared memory event ring
+ Events the server publishes for this client are then read straight out of shared memory
+ by Mikan_FetchNextEvent, rather than being sent over the socket.
+ The ring name, reader index and start position come from the server's MikanEventRingResponse
+ to an OpenEventRing request. Only works when the server runs on the same machine.
+ The ring is closed again on disconnect.
+ */
+MIKAN_CORE_CAPI(MikanCoreResult) Mikan_OpenEventRing(
+	MikanContext context,
+	const char* ring_name,
+	int32_t reader_index,
+	int64_t start_position);
+
+MIKAN_CORE_CAPI(MikanCoreResult) Mikan_CloseEventRing(MikanContext context);
+
+/** \brief Get if the connected server accepts binary encoded requests
+    \return true if Mikan_SendRequestBinary can be used
+ */
+MIKAN_CORE_CAPI(bool) Mikan_GetIsBinaryRequestSupported(MikanContext context);
+
 MIKAN_CORE_CAPI(MikanCoreResult) Mikan_SetTextResponseCallback(
 	MikanContext context,
 	MikanTextResponseCallback callback, 
@@ -94,6 +141,17 @@ MIKAN_CORE_CAPI(MikanCoreResult) Mikan_SetBinaryResponseCallback(
 	MikanBinaryResponseCallback callback,
 	void* callback_userdata);
 
+/** \brief Hands events received over the socket to a callback instead of queuing them
+ The callback is invoked on the socket receive thread, so it must be thread safe and return quickly.
+ Events from the shared memory event ring are still returned by Mikan_FetchNextEvent/Mikan_FetchEvents.
+ Must be called while disconnected, pass a null callback to go back to queuing events.
+ \return MikanCoreResult_AlreadyConnected if called while connected
+ */
+MIKAN_CORE_CAPI(MikanCoreResult) Mikan_SetTextEventCallback(
+	MikanContext context,
+	MikanTextEventCallback callback,
+	void* callback_userdata);
+
 /** \brief Cleans up the MikanXR Client API
  Free the resources allocated by the MikanXR Client API.
  Calling this function again after the api already cleaned up will return MikanCoreResult_Uninitialized.
@@ -142,6 +142,10 @@ typedef void(MIKAN_CALLBACK* MikanTextResponseCallback)(
 typedef void(MIKAN_CALLBACK* MikanBinaryResponseCallback)(
 	const uint8_t* buffer, size_t buffer_size, void* userdata);
 
+/// Registered callback for events received over the socket, called on the socket thread
+typedef void(MIKAN_CALLBACK* MikanTextEventCallback)(
+	const char* utf8_event_string, void* userdata);
+
 
 typedef void (MIKAN_CALLBACK* MikanLogCallback)(
 	int /*log_level*/, const char* /*log_message*/);
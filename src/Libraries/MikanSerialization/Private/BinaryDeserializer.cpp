@@ -1,105 +1,162 @@
 #include "BinaryDeserializer.h"
 #include "BinaryUtility.h"
+#include "SerializationPlan.h"
 #include "SerializationUtility.h"
 #include "SerializableList.h"
 #include "SerializableMap.h"
 #include "SerializableObjectPtr.h"
 #include "SerializableString.h"
-#include "SerializationProperty.h"
 
 #include "Refureku/Refureku.h"
 
+#include <algorithm>
+
 
 namespace Serialization
 {
-	class BinaryReadVisitor : public IVisitor
+	class BinaryPlanReader
 	{
 	public:
-		BinaryReadVisitor(BinaryReader& binaryReader) : m_binaryReader(binaryReader) {}
+		BinaryPlanReader(BinaryReader& binaryReader) : m_binaryReader(binaryReader) {}
 
-		virtual void visitClass(ValueAccessor const& accessor) override
+		void readStruct(void* structInstance, StructPlan const& structPlan)
 		{
-			rfk::Type const& fieldType= accessor.getType();
-			rfk::Class const* fieldClassType = accessor.getClassType();
-			rfk::EClassKind classKind = fieldClassType->getClassKind();
-
-			if (fieldType == rfk::getType<Serialization::String>())
-			{
-				visitString(accessor);
-			}
-			else if (fieldType == rfk::getType<Serialization::BoolList>())
+			for (FieldPlan const& fieldPlan : structPlan.fields)
 			{
-				visitBoolList(accessor);
+				readValue(fieldPlan.getValueMutablePtr(structInstance), fieldPlan.value);
 			}
-			else if (fieldType == rfk::getType<Serialization::PolymorphicObjectPtr>())
+		}
+
+		void readValue(void* valuePtr, ValuePlan const& valuePlan)
+		{
+			switch (valuePlan.kind)
 			{
-				visitObjectPtr(accessor);
+				case ValueKind::Bool:
+					readTypedValue<bool>(valuePtr);
+					break;
+				case ValueKind::Byte:
+					readTypedValue<int8_t>(valuePtr);
+					break;
+				case ValueKind::UByte:
+					readTypedValue<uint8_t>(valuePtr);
+					break;
+				case ValueKind::Short:
+					readTypedValue<int16_t>(valuePtr);
+					break;
+				case ValueKind::UShort:
+					readTypedValue<uint16_t>(valuePtr);
+					break;
+				case ValueKind::Int:
+					readTypedValue<int32_t>(valuePtr);
+					break;
+				case ValueKind::UInt:
+					readTypedValue<uint32_t>(valuePtr);
+					break;
+				case ValueKind::Long:
+					readTypedValue<int64_t>(valuePtr);
+					break;
+				case ValueKind::ULong:
+					readTypedValue<uint64_t>(valuePtr);
+					break;
+				case ValueKind::Float:
+					readTypedValue<float>(valuePtr);
+					break;
+				case ValueKind::Double:
+					readTypedValue<double>(valuePtr);
+					break;
+				case ValueKind::Enum:
+					readEnum(valuePtr, valuePlan);
+					break;
+				case ValueKind::String:
+					readString(valuePtr);
+					break;
+				case ValueKind::BoolList:
+					readBoolList(valuePtr);
+					break;
+				case ValueKind::ObjectPtr:
+					readObjectPtr(valuePtr, valuePlan);
+					break;
+				case ValueKind::List:
+					readList(valuePtr, valuePlan);
+					break;
+				case ValueKind::Map:
+					readMap(valuePtr, valuePlan);
+					break;
+				case ValueKind::Struct:
+					readStruct(valuePtr, *valuePlan.structPlan);
+					break;
 			}
-			else if (classKind == rfk::EClassKind::TemplateInstantiation)
-			{
-				void* arrayInstance = accessor.getUntypedValueMutablePtr();
-				const auto* templateClassInstanceType = rfk::classTemplateInstantiationCast(fieldClassType);
-				std::string templateTypeName = templateClassInstanceType->getClassTemplate().getName();
+		}
 
-				// See if the field is a Serialization::List<T>
-				if (templateTypeName == "List" &&
-					templateClassInstanceType->getTemplateArgumentsCount() == 1)
-				{
-					visitList(accessor, *templateClassInstanceType);
-				}
-				// See if the field is a Serialization::Map<K,V>
-				else if (templateTypeName == "Map" &&
-							templateClassInstanceType->getTemplateArgumentsCount() == 2)
-				{
-					visitMap(accessor, *templateClassInstanceType);
-				}
-			}
-			else
+	private:
+		template <typename T>
+		void readTypedValue(void* valuePtr)
+		{
+			T value = T();
+			from_binary(m_binaryReader, value);
+			*reinterpret_cast<T*>(valuePtr) = value;
+		}
+
+		void readString(void* valuePtr)
+		{
+			int32_t stringLength = 0;
+			from_binary(m_binaryReader, stringLength);
+			if (stringLength < 0)
 			{
-				throw std::runtime_error(
-					stringify("BinaryReadVisitor::visitClass() ",
-								"Class Field ", accessor.getName(),
-								" was not of expected type IEnumerable to deserialize json array value"));
+				throw std::out_of_range("BinaryPlanReader::readString() - Invalid string length");
 			}
+
+			// Assign straight from the message so the String reuses its existing storage
+			const uint8_t* chars = m_binaryReader.readBytesNoCopy(stringLength);
+			reinterpret_cast<Serialization::String*>(valuePtr)->setValue(
+				reinterpret_cast<const char*>(chars), static_cast<size_t>(stringLength));
 		}
 
-		void visitString(ValueAccessor const& accessor)
+		void readEnum(void* valuePtr, ValuePlan const& valuePlan)
 		{
-			std::string value;
-			auto* variablePtr = accessor.getTypedValueMutablePtr<Serialization::String>();
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
 
-			from_binary(m_binaryReader, value);
-			variablePtr->setValue(value);
+			std::string enumStringValue;
+			from_binary(m_binaryReader, enumStringValue);
+
+			EnumEntry const* enumEntry = enumPlan.findByString(enumStringValue.c_str());
+			if (enumEntry == nullptr)
+			{
+				throw std::runtime_error(
+					stringify("BinaryPlanReader::readEnum() ",
+							  "Enum Value ", valuePlan.name,
+							  " has an invalid value ", enumStringValue));
+			}
+
+			writeEnumIntValue(valuePtr, enumPlan.memorySize, enumEntry->value);
 		}
 
-		void visitObjectPtr(ValueAccessor const& accessor)
+		void readObjectPtr(void* valuePtr, ValuePlan const& valuePlan)
 		{
-			// Get the shared pointer we are writing 
-			void* objPtrInstance = accessor.getUntypedValueMutablePtr();
-			rfk::Class const* objPtrClassType = accessor.getClassType();
+			auto* objectPtr = reinterpret_cast<Serialization::PolymorphicObjectPtr*>(valuePtr);
 
-			// Get the class for the object by type id
-			std::string objectClassName;
-			from_binary(m_binaryReader, objectClassName);
+			// Get the class for the object by type id (the class name is only informational)
+			int32_t classNameLength = 0;
+			from_binary(m_binaryReader, classNameLength);
+			if (classNameLength < 0)
+			{
+				throw std::out_of_range("BinaryPlanReader::readObjectPtr() - Invalid class name length");
+			}
+			m_binaryReader.skipBytes(static_cast<size_t>(classNameLength));
 			Serialization::MikanClassId mikanObjectClassId;
 			from_binary(m_binaryReader, mikanObjectClassId);
-			Serialization::RfkClassId rfkClassId= Serialization::toRfkClassId(mikanObjectClassId);
-			rfk::Struct const* objectStruct = rfk::getDatabase().getStructById(rfkClassId);
-			if (objectStruct == nullptr)
+			Serialization::RfkClassId rfkClassId = Serialization::toRfkClassId(mikanObjectClassId);
+			StructPlan const* objectPlan = getStructPlanById(rfkClassId);
+			if (objectPlan == nullptr)
 			{
 				throw std::runtime_error(
-					stringify("BinaryReadVisitor::visitObjectPtr() ",
-							  "TypedObjectPtr Accessor ", accessor.getName(),
+					stringify("BinaryPlanReader::readObjectPtr() ",
+							  "TypedObjectPtr Value ", valuePlan.name,
 							  " used an unknown class_id ", mikanObjectClassId));
 			}
 
-			// Use reflection to get the methods to create and initialize the object
-			rfk::Method const* allocateMethod = objPtrClassType->getMethodByName("allocateByClassId");
-
 			// Allocate a default instance of the object assigned to the shared pointer
-			void* objectInstance =
-				allocateMethod->invokeUnsafe<void*, const std::size_t&>(
-					objPtrInstance, rfkClassId);
+			void* objectInstance = objectPtr->allocateByClassId(std::move(rfkClassId));
 
 			// See if the serialized object is not null
 			bool isValid = false;
@@ -108,16 +165,13 @@ namespace Serialization
 			// Deserialize the object if it is valid
 			if (isValid)
 			{
-				// Deserialize the object from the json
-				BinaryReadVisitor objectVisitor(m_binaryReader);
-				Serialization::visitStruct(objectInstance, *objectStruct, &objectVisitor);
+				readStruct(objectInstance, *objectPlan);
 			}
 		}
 
-		void visitBoolList(ValueAccessor const& arrayAccessor)
+		void readBoolList(void* valuePtr)
 		{
-			auto& boolListWrapper = arrayAccessor.getTypedValueMutableRef<Serialization::BoolList>();
-			auto& boolList = boolListWrapper.getVectorMutable();
+			auto& boolList = reinterpret_cast<Serialization::BoolList*>(valuePtr)->getVectorMutable();
 
 			// Resize the array to the desired target size
 			int32_t int32ArraySize = 0;
@@ -125,7 +179,6 @@ namespace Serialization
 			size_t arraySize = static_cast<size_t>(int32ArraySize);
 
 			// Deserialize each element of the array
-
 			boolList.resize(arraySize);
 			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
 			{
@@ -135,226 +188,459 @@ namespace Serialization
 			}
 		}
 
-		void visitList(
-			ValueAccessor const& arrayAccessor,
-			rfk::ClassTemplateInstantiation const& templatedArrayType)
+		void readList(void* arrayInstance, ValuePlan const& valuePlan)
 		{
-			void* arrayInstance = arrayAccessor.getUntypedValueMutablePtr();
-
-			// Get the type of the elements in the array from the template argument
-			auto const& templateArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedArrayType.getTemplateArgumentAt(0));
-			rfk::Type const& elementType = templateArg.getType();
-
-			// Use reflection to get the methods to resize the array and get a mutable reference to an element
-			rfk::Method const* resizeMethod = templatedArrayType.getMethodByName("resize");
-			rfk::Method const* getRawElementMutableMethod = templatedArrayType.getMethodByName("getRawElementMutable");
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
 
 			// Resize the array to the desired target size
-			int32_t int32ArraySize= 0;
+			int32_t int32ArraySize = 0;
 			from_binary(m_binaryReader, int32ArraySize);
 			size_t arraySize = static_cast<size_t>(int32ArraySize);
-			resizeMethod->invokeUnsafe<void>(arrayInstance, arraySize);
+
+			// Lists of packed numeric data were written as one contiguous block
+			if (elementPlan.blittableSize > 0 && isHostLittleEndian())
+			{
+				const size_t blockSize = arraySize * elementPlan.blittableSize;
+				if (int32ArraySize < 0 || blockSize > m_binaryReader.getRemainingByteCount())
+				{
+					throw std::out_of_range("BinaryPlanReader::readList() - Not enough bytes to read");
+				}
+
+				valuePlan.resizeMethod->invokeUnsafe<void>(arrayInstance, arraySize);
+				if (arraySize > 0)
+				{
+					void* firstElement =
+						valuePlan.getRawElementMutableMethod->invokeUnsafe<void*, const std::size_t&>(
+							arrayInstance, 0);
+
+					m_binaryReader.readBytes(reinterpret_cast<uint8_t*>(firstElement), blockSize);
+				}
+				return;
+			}
+
+			valuePlan.resizeMethod->invokeUnsafe<void>(arrayInstance, arraySize);
 
 			// Deserialize each element of the array
 			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
 			{
-				// Get the target element instance in the array
 				void* elementInstance =
-					getRawElementMutableMethod->invokeUnsafe<void*, const std::size_t&>(
+					valuePlan.getRawElementMutableMethod->invokeUnsafe<void*, const std::size_t&>(
 						arrayInstance, elementIndex);
 
-				// Make a fake "field" for an element in the array
-				ValueAccessor elementAccessor(elementInstance, elementType);
-
-				// Deserialize the element
-				BinaryReadVisitor elementVisitor(m_binaryReader);
-				Serialization::visitValue(elementAccessor, &elementVisitor);
+				readValue(elementInstance, elementPlan);
 			}
 		}
 
-		void visitMap(
-			ValueAccessor const& mapAccessor,
-			rfk::ClassTemplateInstantiation const& templatedMapType)
+		void readMap(void* mapInstance, ValuePlan const& valuePlan)
 		{
-			// Get the key type of the map from the template argument
-			auto const& templateKeyArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedMapType.getTemplateArgumentAt(0));
-			rfk::Type const& keyType = templateKeyArg.getType();
-
-			if (keyType == rfk::getType<int32_t>())
+			if (valuePlan.mapKeyKind == ValueKind::Int)
 			{
-				visitMapOfKey<int32_t>(mapAccessor, templatedMapType);
-			}
-			else if (keyType == rfk::getType<std::string>())
-			{
-				visitMapOfKey<std::string>(mapAccessor, templatedMapType);
+				readMapOfKey<int32_t>(mapInstance, valuePlan);
 			}
 			else
 			{
-				rfk::Archetype const* keyArchetype = keyType.getArchetype();
-
-				throw std::runtime_error(
-					stringify("BinaryReadVisitor::visitMap() ",
-							  "Map Key Archetype ", keyArchetype != nullptr ? keyArchetype->getName() : "<Null Archetype>",
-							  " is not supported"));
+				readMapOfKey<std::string>(mapInstance, valuePlan);
 			}
 		}
 
 		template<typename t_key>
-		void visitMapOfKey(
-			ValueAccessor const& mapAccessor,
-			rfk::ClassTemplateInstantiation const& templatedMapType)
+		void readMapOfKey(void* mapInstance, ValuePlan const& valuePlan)
 		{
-			void* mapInstance = mapAccessor.getUntypedValueMutablePtr();
+			ValuePlan const& mapValuePlan = *valuePlan.elementPlan;
 
-			// Get the type of the elements in the array from the template argument
-			auto const& templateValueArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedMapType.getTemplateArgumentAt(1));
-			rfk::Type const& valueType = templateValueArg.getType();
-
-			// Use reflection to get the method use to clear and add pairs to the map
-			rfk::Method const* clearMethod = templatedMapType.getMethodByName("clear");
-			rfk::Method const* getOrAddValueMethod = templatedMapType.getMethodByName("getOrAddRawValueMutable");
-
-			// Resize the array to the desired target size
-			clearMethod->invokeUnsafe<void>(mapInstance);
+			valuePlan.clearMethod->invokeUnsafe<void>(mapInstance);
 
 			// Get the number of pairs in the map
 			int32_t pairCount = 0;
 			from_binary(m_binaryReader, pairCount);
 
-			// Deserialize each element of the array
-			for (size_t pairIndex = 0; pairIndex < pairCount; ++pairIndex)
+			// Deserialize each key-value pair
+			for (int32_t pairIndex = 0; pairIndex < pairCount; ++pairIndex)
 			{
-				t_key key= t_key();
+				t_key key = t_key();
 				from_binary(m_binaryReader, key);
 
 				// Get or Add the target value instance in the map
 				void* valueInstance =
-					getOrAddValueMethod->invokeUnsafe<void*, const t_key&>(
+					valuePlan.getOrAddRawValueMutableMethod->invokeUnsafe<void*, const t_key&>(
 						mapInstance, key);
 
-				// Make a fake "field" for an element in the array
-				ValueAccessor valueAccessor(valueInstance, valueType);
-
-				// Deserialize the value
-				BinaryReadVisitor valueVisitor(m_binaryReader);
-				Serialization::visitValue(valueAccessor, &valueVisitor);
+				readValue(valueInstance, mapValuePlan);
 			}
 		}
 
-		virtual void visitStruct(ValueAccessor const& accessor) override
-		{
-			void* childObjectInstance = accessor.getUntypedValueMutablePtr();
-			rfk::Struct const* structType = accessor.getStructType();
-			BinaryReadVisitor jsonVisitor(m_binaryReader);
+		BinaryReader& m_binaryReader;
+	};
 
-			Serialization::visitStruct(childObjectInstance, *structType, &jsonVisitor);
-		}
+	// Reads BinaryFormat::V2 (see BinaryPlanWriterV2).
+	// Fields missing from the end of a struct keep their default values
+	// and trailing fields this build doesn't know about are skipped.
+	class BinaryPlanReaderV2
+	{
+	public:
+		BinaryPlanReaderV2(BinaryReader& binaryReader) 
+			: m_binaryReader(binaryReader)
+			, m_fixedWidthReader(binaryReader)
+		{}
 
-		virtual void visitEnum(ValueAccessor const& accessor) override
+		void readHeader()
 		{
-			rfk::Enum const& enumType = *accessor.getEnumType();
-			rfk::Archetype const& enumArchetype = enumType.getUnderlyingArchetype();
-			rfk::EnumValue const* enumValue = nullptr;
+			uint8_t header[4];
+			m_binaryReader.readBytes(header, sizeof(header));
 
-			std::string enumStringValue;
-			from_binary(m_binaryReader, enumStringValue);
-			enumValue = Serialization::findEnumValueByString(enumType, enumStringValue.c_str());
-			if (enumValue == nullptr)
+			if (header[0] != 'M' || header[1] != 'K' || header[2] != 'B' ||
+				header[3] != static_cast<uint8_t>(BinaryFormat::V2))
 			{
-				throw std::runtime_error(
-					stringify("BinaryReadVisitor::visitEnum() ",
-								"Enum Accessor ", accessor.getName(),
-								" has an invalid value ", enumStringValue));
+				throw std::runtime_error("BinaryPlanReaderV2::readHeader() - Invalid binary format header");
 			}
+		}
 
-			void* enumInstance = accessor.getInstanceMutable();
-			rfk::Field const* enumField = accessor.getField();
-			const int64_t enumInt64Value = enumValue->getValue();
+		void readStruct(void* structInstance, StructPlan const& structPlan)
+		{
+			const size_t structSize = readSize();
+			const size_t structEnd = m_binaryReader.getBytesRead() + structSize;
 
-			if (enumField != nullptr)
+			for (FieldPlan const& fieldPlan : structPlan.fields)
 			{
-				enumField->setUnsafe(enumInstance, &enumInt64Value, enumArchetype.getMemorySize());
+				if (m_binaryReader.getBytesRead() >= structEnd)
+					break;
+
+				readValue(fieldPlan.getValueMutablePtr(structInstance), fieldPlan.value);
 			}
-			else
+
+			const size_t bytesRead = m_binaryReader.getBytesRead();
+			if (bytesRead > structEnd)
 			{
-				std::memcpy(enumInstance, &enumInt64Value, enumArchetype.getMemorySize());
+				throw std::runtime_error(
+					stringify("BinaryPlanReaderV2::readStruct() ",
+							  "Struct ", structPlan.structName,
+							  " read past its serialized length"));
 			}
+
+			// Skip over any fields added by a newer writer
+			m_binaryReader.skipBytes(structEnd - bytesRead);
 		}
 
-		virtual void visitBool(ValueAccessor const& accessor) override
+		void readValue(void* valuePtr, ValuePlan const& valuePlan)
 		{
-			deserializeValue<bool>(accessor);
+			switch (valuePlan.kind)
+			{
+				case ValueKind::Bool:
+				case ValueKind::Byte:
+				case ValueKind::UByte:
+				case ValueKind::Float:
+				case ValueKind::Double:
+					m_fixedWidthReader.readValue(valuePtr, valuePlan);
+					break;
+				case ValueKind::Short:
+					*reinterpret_cast<int16_t*>(valuePtr) = static_cast<int16_t>(readSignedVarint());
+					break;
+				case ValueKind::UShort:
+					*reinterpret_cast<uint16_t*>(valuePtr) = static_cast<uint16_t>(readVarint());
+					break;
+				case ValueKind::Int:
+					*reinterpret_cast<int32_t*>(valuePtr) = static_cast<int32_t>(readSignedVarint());
+					break;
+				case ValueKind::UInt:
+					*reinterpret_cast<uint32_t*>(valuePtr) = static_cast<uint32_t>(readVarint());
+					break;
+				case ValueKind::Long:
+					*reinterpret_cast<int64_t*>(valuePtr) = readSignedVarint();
+					break;
+				case ValueKind::ULong:
+					*reinterpret_cast<uint64_t*>(valuePtr) = readVarint();
+					break;
+				case ValueKind::Enum:
+					readEnum(valuePtr, valuePlan);
+					break;
+				case ValueKind::String:
+					readString(valuePtr);
+					break;
+				case ValueKind::BoolList:
+					readBoolList(valuePtr);
+					break;
+				case ValueKind::ObjectPtr:
+					readObjectPtr(valuePtr, valuePlan);
+					break;
+				case ValueKind::List:
+					readList(valuePtr, valuePlan);
+					break;
+				case ValueKind::Map:
+					readMap(valuePtr, valuePlan);
+					break;
+				case ValueKind::Struct:
+					readStruct(valuePtr, *valuePlan.structPlan);
+					break;
+			}
 		}
 
-		virtual void visitByte(ValueAccessor const& accessor) override
+	private:
+		struct ClassTableEntry
 		{
-			deserializeValue<int8_t>(accessor);
+			Serialization::RfkClassId rfkClassId;
+			StructPlan const* objectPlan;
+		};
+
+		uint64_t readVarint()
+		{
+			uint64_t value = 0;
+			from_binary_varint(m_binaryReader, value);
+			return value;
 		}
 
-		virtual void visitUByte(ValueAccessor const& accessor) override
+		int64_t readSignedVarint()
 		{
-			deserializeValue<uint8_t>(accessor);
+			return zigzag_decode(readVarint());
 		}
 
-		virtual void visitShort(ValueAccessor const& accessor) override
+		// Reads a count or length, rejecting values larger than the remaining message
+		size_t readSize()
 		{
-			deserializeValue<int16_t>(accessor);
+			const uint64_t size = readVarint();
+			if (size > m_binaryReader.getRemainingByteCount())
+			{
+				throw std::out_of_range("BinaryPlanReaderV2::readSize() - Not enough bytes to read");
+			}
+
+			return static_cast<size_t>(size);
 		}
 
-		virtual void visitUShort(ValueAccessor const& accessor) override
+		void readString(void* valuePtr)
 		{
-			deserializeValue<uint16_t>(accessor);
+			const size_t stringLength = readSize();
+
+			// Assign straight from the message so the String reuses its existing storage
+			const uint8_t* chars = m_binaryReader.readBytesNoCopy(stringLength);
+			reinterpret_cast<Serialization::String*>(valuePtr)->setValue(
+				reinterpret_cast<const char*>(chars), stringLength);
 		}
 
-		virtual void visitInt(ValueAccessor const& accessor) override
+		std::string readString()
 		{
-			deserializeValue<int32_t>(accessor);
+			const size_t stringLength = readSize();
+
+			std::string value(stringLength, '\0');
+			if (stringLength > 0)
+			{
+				m_binaryReader.readBytes(reinterpret_cast<uint8_t*>(&value[0]), stringLength);
+			}
+
+			return value;
 		}
 
-		virtual void visitUInt(ValueAccessor const& accessor) override
+		void readEnum(void* valuePtr, ValuePlan const& valuePlan)
 		{
-			deserializeValue<uint32_t>(accessor);
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
+
+			const int64_t enumIntValue = readSignedVarint();
+			if (enumPlan.findByValue(enumIntValue) == nullptr)
+			{
+				throw std::runtime_error(
+					stringify("BinaryPlanReaderV2::readEnum() ",
+							  "Enum Value ", valuePlan.name,
+							  " has an invalid value ", enumIntValue));
+			}
+
+			writeEnumIntValue(valuePtr, enumPlan.memorySize, enumIntValue);
 		}
 
-		virtual void visitLong(ValueAccessor const& accessor) override
+		void readObjectPtr(void* valuePtr, ValuePlan const& valuePlan)
 		{
-			deserializeValue<int64_t>(accessor);
+			auto* objectPtr = reinterpret_cast<Serialization::PolymorphicObjectPtr*>(valuePtr);
+
+			// Classes are written in full the first time they appear in the message
+			const uint64_t classIndex = readVarint();
+			if (classIndex == m_classTable.size())
+			{
+				const std::string objectClassName = readString();
+				const Serialization::MikanClassId mikanObjectClassId = readSignedVarint();
+				const Serialization::RfkClassId rfkClassId = Serialization::toRfkClassId(mikanObjectClassId);
+
+				m_classTable.push_back({rfkClassId, getStructPlanById(rfkClassId)});
+			}
+			else if (classIndex > m_classTable.size())
+			{
+				throw std::runtime_error(
+					stringify("BinaryPlanReaderV2::readObjectPtr() ",
+							  "TypedObjectPtr Value ", valuePlan.name,
+							  " used an invalid class index ", classIndex));
+			}
+
+			ClassTableEntry const& classEntry = m_classTable[classIndex];
+
+			// See if the serialized object is not null
+			bool isValid = false;
+			from_binary(m_binaryReader, isValid);
+
+			if (classEntry.objectPlan == nullptr)
+			{
+				// Step over objects of a class this build doesn't know about
+				if (isValid)
+				{
+					const size_t structSize = readSize();
+					m_binaryReader.skipBytes(structSize);
+				}
+				return;
+			}
+
+			// Allocate a default instance of the object assigned to the shared pointer
+			void* objectInstance = objectPtr->allocateByClassId(Serialization::RfkClassId(classEntry.rfkClassId));
+
+			// Deserialize the object if it is valid
+			if (isValid)
+			{
+				readStruct(objectInstance, *classEntry.objectPlan);
+			}
 		}
 
-		virtual void visitULong(ValueAccessor const& accessor)
+		void readBoolList(void* valuePtr)
 		{
-			deserializeValue<uint64_t>(accessor);
+			auto& boolList = reinterpret_cast<Serialization::BoolList*>(valuePtr)->getVectorMutable();
+			const size_t arraySize = readSize();
+
+			boolList.resize(arraySize);
+			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
+			{
+				bool value = false;
+				from_binary(m_binaryReader, value);
+				boolList[elementIndex] = value;
+			}
 		}
 
-		virtual void visitFloat(ValueAccessor const& accessor) override
+		void readList(void* arrayInstance, ValuePlan const& valuePlan)
 		{
-			deserializeValue<float>(accessor);
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
+			const size_t arraySize = readSize();
+
+			if (elementPlan.blittableSize > 0)
+			{
+				readPackedList(arrayInstance, valuePlan, arraySize);
+				return;
+			}
+
+			valuePlan.resizeMethod->invokeUnsafe<void>(arrayInstance, arraySize);
+
+			// Deserialize each element of the array
+			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
+			{
+				void* elementInstance =
+					valuePlan.getRawElementMutableMethod->invokeUnsafe<void*, const std::size_t&>(
+						arrayInstance, elementIndex);
+
+				readValue(elementInstance, elementPlan);
+			}
 		}
 
-		virtual void visitDouble(ValueAccessor const& accessor) override
+		void readPackedList(void* arrayInstance, ValuePlan const& valuePlan, const size_t arraySize)
 		{
-			deserializeValue<double>(accessor);
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
+			const size_t localElementSize = elementPlan.blittableSize;
+
+			// The writer's element size can differ from ours if the element struct gained fields
+			const uint64_t wireElementSize = readVarint();
+			if (wireElementSize == 0 ||
+				arraySize > m_binaryReader.getRemainingByteCount() / wireElementSize)
+			{
+				throw std::out_of_range("BinaryPlanReaderV2::readPackedList() - Not enough bytes to read");
+			}
+
+			valuePlan.resizeMethod->invokeUnsafe<void>(arrayInstance, arraySize);
+			if (arraySize == 0)
+				return;
+
+			uint8_t* firstElement =
+				reinterpret_cast<uint8_t*>(
+					valuePlan.getRawElementMutableMethod->invokeUnsafe<void*, const std::size_t&>(
+						arrayInstance, 0));
+
+			if (isHostLittleEndian())
+			{
+				if (wireElementSize == localElementSize)
+				{
+					m_binaryReader.readBytes(firstElement, arraySize * localElementSize);
+				}
+				else
+				{
+					const size_t copySize = std::min(static_cast<size_t>(wireElementSize), localElementSize);
+
+					for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
+					{
+						m_binaryReader.readBytes(firstElement + elementIndex * localElementSize, copySize);
+						m_binaryReader.skipBytes(static_cast<size_t>(wireElementSize) - copySize);
+					}
+				}
+			}
+			else
+			{
+				if (wireElementSize != localElementSize)
+				{
+					throw std::runtime_error(
+						stringify("BinaryPlanReaderV2::readPackedList() ",
+								  "List Value ", valuePlan.name,
+								  " has an unexpected element size ", wireElementSize));
+				}
+
+				for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
+				{
+					void* elementInstance =
+						valuePlan.getRawElementMutableMethod->invokeUnsafe<void*, const std::size_t&>(
+							arrayInstance, elementIndex);
+
+					m_fixedWidthReader.readValue(elementInstance, elementPlan);
+				}
+			}
 		}
 
-	private:
-		template <typename T>
-		void deserializeValue(ValueAccessor const& accessor)
+		void readMap(void* mapInstance, ValuePlan const& valuePlan)
 		{
-			T value = T();
-			from_binary(m_binaryReader, value);
-			accessor.setValueByType(value);
+			ValuePlan const& mapValuePlan = *valuePlan.elementPlan;
+
+			valuePlan.clearMethod->invokeUnsafe<void>(mapInstance);
+
+			// Deserialize each key-value pair
+			const size_t pairCount = readSize();
+			for (size_t pairIndex = 0; pairIndex < pairCount; ++pairIndex)
+			{
+				void* valueInstance = nullptr;
+				if (valuePlan.mapKeyKind == ValueKind::Int)
+				{
+					const int32_t key = static_cast<int32_t>(readSignedVarint());
+
+					valueInstance =
+						valuePlan.getOrAddRawValueMutableMethod->invokeUnsafe<void*, const int32_t&>(
+							mapInstance, key);
+				}
+				else
+				{
+					const std::string key = readString();
+
+					valueInstance =
+						valuePlan.getOrAddRawValueMutableMethod->invokeUnsafe<void*, const std::string&>(
+							mapInstance, key);
+				}
+
+				readValue(valueInstance, mapValuePlan);
+			}
 		}
 
 		BinaryReader& m_binaryReader;
+		BinaryPlanReader m_fixedWidthReader;
+		std::vector<ClassTableEntry> m_classTable;
 	};
 
 	// Public API
+	BinaryFormat getBinaryFormat(const uint8_t* inBytes, const size_t inSize)
+	{
+		if (inSize >= 4 &&
+			inBytes[0] == 'M' && inBytes[1] == 'K' && inBytes[2] == 'B' &&
+			inBytes[3] == static_cast<uint8_t>(BinaryFormat::V2))
+		{
+			return BinaryFormat::V2;
+		}
+
+		return BinaryFormat::V1;
+	}
+
 	bool deserializeFromBytes(
 		const std::vector<uint8_t>& inBytes,
 		void* instance,
@@ -372,8 +658,8 @@ namespace Serialization
 		try
 		{
 			BinaryReader reader(inBytes, inSize);
-			BinaryReadVisitor visitor(reader);
-			Serialization::visitStruct(instance, structType, &visitor);
+			BinaryPlanReader planReader(reader);
+			planReader.readStruct(instance, getStructPlan(structType));
 
 			return true;
 		}
@@ -382,5 +668,31 @@ namespace Serialization
 			return false;
 		}
 	}
-};
 
+	bool deserializeFromBytes(
+		const uint8_t* inBytes,
+		const size_t inSize,
+		void* instance,
+		rfk::Struct const& structType,
+		BinaryFormat format)
+	{
+		if (format == BinaryFormat::V1)
+		{
+			return deserializeFromBytes(inBytes, inSize, instance, structType);
+		}
+
+		try
+		{
+			BinaryReader reader(inBytes, inSize);
+			BinaryPlanReaderV2 planReader(reader);
+			planReader.readHeader();
+			planReader.readStruct(instance, getStructPlan(structType));
+
+			return true;
+		}
+		catch (std::runtime_error* e)
+		{
+			return false;
+		}
+	}
+};
@@ -1,377 +1,849 @@
 #include "BinarySerializer.h"
 #include "BinaryUtility.h"
+#include "SerializationPlan.h"
 #include "SerializationUtility.h"
 #include "SerializableList.h"
 #include "SerializableMap.h"
 #include "SerializableObjectPtr.h"
 #include "SerializableString.h"
-#include "SerializationProperty.h"
 
 #include "Refureku/Refureku.h"
 
+#include <algorithm>
+
 namespace Serialization
 {
-	class BinaryWriteVisitor : public IVisitor
+	class BinaryPlanWriter
 	{
 	public:
-		BinaryWriteVisitor(BinaryWriter& writer) : m_binaryWriter(writer) {}
+		BinaryPlanWriter(BinaryWriter& writer) : m_binaryWriter(writer) {}
 
-		virtual void visitClass(ValueAccessor const& accessor) override
+		void writeStruct(const void* structInstance, StructPlan const& structPlan)
 		{
-			rfk::Type const& fieldType= accessor.getType();
-			rfk::Class const* fieldClassType = accessor.getClassType();
-			rfk::EClassKind classKind = fieldClassType->getClassKind();
-
-			if (fieldType == rfk::getType<Serialization::String>())
+			for (FieldPlan const& fieldPlan : structPlan.fields)
 			{
-				visitString(accessor);
+				writeValue(fieldPlan.getValuePtr(structInstance), fieldPlan.value);
 			}
-			else if (fieldType == rfk::getType<Serialization::BoolList>())
-			{
-				visitBoolList(accessor);
-			}
-			else if (fieldType == rfk::getType<Serialization::PolymorphicObjectPtr>())
-			{
-				visitObjectPtr(accessor);
-			}
-			else if (classKind == rfk::EClassKind::TemplateInstantiation)
-			{
-				const auto* templateClassInstanceType = rfk::classTemplateInstantiationCast(fieldClassType);
-				std::string templateTypeName = templateClassInstanceType->getClassTemplate().getName();
-
-				// See if the field is a Serialization::List<T>
-				if (templateTypeName == "List" &&
-					templateClassInstanceType->getTemplateArgumentsCount() == 1)
-				{
-					visitList(accessor, *templateClassInstanceType);
-				}
-				// See if the field is a Serialization::Map<K,V>
-				else if (templateTypeName == "Map" &&
-						 templateClassInstanceType->getTemplateArgumentsCount() == 2)
-				{
-					visitMap(accessor, *templateClassInstanceType);
-				}
-				else
-				{
-					throw std::runtime_error(
-						stringify("BinaryWriteVisitor::visitClass() ",
-								  "Class Field ", accessor.getName(),
-								  " was of expected type"));
+		}
 
-				}
-			}
-			else
+		void writeValue(const void* valuePtr, ValuePlan const& valuePlan)
+		{
+			switch (valuePlan.kind)
 			{
-				BinaryWriteVisitor::visitStruct(accessor);
+				case ValueKind::Bool:
+					to_binary(m_binaryWriter, *reinterpret_cast<const bool*>(valuePtr));
+					break;
+				case ValueKind::Byte:
+					to_binary(m_binaryWriter, *reinterpret_cast<const int8_t*>(valuePtr));
+					break;
+				case ValueKind::UByte:
+					to_binary(m_binaryWriter, *reinterpret_cast<const uint8_t*>(valuePtr));
+					break;
+				case ValueKind::Short:
+					to_binary(m_binaryWriter, *reinterpret_cast<const int16_t*>(valuePtr));
+					break;
+				case ValueKind::UShort:
+					to_binary(m_binaryWriter, *reinterpret_cast<const uint16_t*>(valuePtr));
+					break;
+				case ValueKind::Int:
+					to_binary(m_binaryWriter, *reinterpret_cast<const int32_t*>(valuePtr));
+					break;
+				case ValueKind::UInt:
+					to_binary(m_binaryWriter, *reinterpret_cast<const uint32_t*>(valuePtr));
+					break;
+				case ValueKind::Long:
+					to_binary(m_binaryWriter, *reinterpret_cast<const int64_t*>(valuePtr));
+					break;
+				case ValueKind::ULong:
+					to_binary(m_binaryWriter, *reinterpret_cast<const uint64_t*>(valuePtr));
+					break;
+				case ValueKind::Float:
+					to_binary(m_binaryWriter, *reinterpret_cast<const float*>(valuePtr));
+					break;
+				case ValueKind::Double:
+					to_binary(m_binaryWriter, *reinterpret_cast<const double*>(valuePtr));
+					break;
+				case ValueKind::Enum:
+					writeEnum(valuePtr, valuePlan);
+					break;
+				case ValueKind::String:
+					to_binary(m_binaryWriter, reinterpret_cast<const Serialization::String*>(valuePtr)->getValue());
+					break;
+				case ValueKind::BoolList:
+					writeBoolList(valuePtr);
+					break;
+				case ValueKind::ObjectPtr:
+					writeObjectPtr(valuePtr, valuePlan);
+					break;
+				case ValueKind::List:
+					writeList(valuePtr, valuePlan);
+					break;
+				case ValueKind::Map:
+					writeMap(valuePtr, valuePlan);
+					break;
+				case ValueKind::Struct:
+					writeStruct(valuePtr, *valuePlan.structPlan);
+					break;
 			}
 		}
 
-		void visitString(ValueAccessor const& accessor)
+	private:
+		void writeEnum(const void* valuePtr, ValuePlan const& valuePlan)
 		{
-			const auto* stringPtr= accessor.getTypedValuePtr<Serialization::String>();
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
+			const int64_t enumIntValue = readEnumIntValue(valuePtr, enumPlan.memorySize);
 
-			to_binary(m_binaryWriter, stringPtr->getValue());
+			EnumEntry const* enumEntry = enumPlan.findByValue(enumIntValue);
+			if (enumEntry == nullptr)
+			{
+				throw std::runtime_error(
+					stringify("BinaryPlanWriter::writeEnum() ",
+							  "Enum Value ", valuePlan.name,
+							  " has an invalid int value ", enumIntValue));
+			}
+
+			to_binary(m_binaryWriter, enumEntry->stringValue);
 		}
 
-		void visitObjectPtr(ValueAccessor const& accessor)
+		void writeObjectPtr(const void* valuePtr, ValuePlan const& valuePlan)
 		{
-			// Get the shared pointer instance
-			const void* objPtrInstance = accessor.getUntypedValuePtr();
-			rfk::Class const* objPtrClassType = accessor.getClassType();
+			const auto* objectPtr = reinterpret_cast<const Serialization::PolymorphicObjectPtr*>(valuePtr);
 
-			// Use reflection to get the runtime class id of the object pointed at
-			rfk::Method const* getRuntimeClassIdMethod = 
-				objPtrClassType->getMethodByName(
-					"getRuntimeClassId", rfk::EMethodFlags::Default, true);
-			const Serialization::RfkClassId rfkClassId = 
-				getRuntimeClassIdMethod->invokeUnsafe<std::size_t>(objPtrInstance);
+			// Get the runtime class of the object pointed at
+			const Serialization::RfkClassId rfkClassId = objectPtr->getRuntimeClassId();
 			const Serialization::MikanClassId mikanClassId = Serialization::toMikanClassId(rfkClassId);
-
-			// Get the runtime class for the object
-			rfk::Struct const* objectStruct = rfk::getDatabase().getStructById(rfkClassId);
-			if (objectStruct == nullptr)
+			StructPlan const* objectPlan = getStructPlanById(rfkClassId);
+			if (objectPlan == nullptr)
 			{
 				throw std::runtime_error(
-					stringify("BinaryWriteVisitor::visitObjectPtr() ",
-							  "TypedObjectPtr Accessor ", accessor.getName(),
+					stringify("BinaryPlanWriter::writeObjectPtr() ",
+							  "TypedObjectPtr Value ", valuePlan.name,
 							  " has an invalid class id ", rfkClassId));
 			}
 
-			// Get the type of the elements in the array from the template argument
-			std::string className = objectStruct->getName();
-
-			// Write the runtime class id of the object
-			to_binary(m_binaryWriter, className);
+			// Write the runtime class of the object
+			to_binary(m_binaryWriter, objectPlan->structName);
 			to_binary(m_binaryWriter, mikanClassId);
 
-			// Get the raw pointer to the object pointed to by the shared pointer
-			rfk::Method const* getRawPtrMethod = 
-				objPtrClassType->getMethodByName(
-					"getRawPtr", rfk::EMethodFlags::Default, true);
-			const void* objectInstance = getRawPtrMethod->invokeUnsafe<const void*>(objPtrInstance);
-
 			// Write out whether the object is valid or not
+			const void* objectInstance = objectPtr->getRawPtr();
 			bool isValidObject = objectInstance != nullptr;
 			to_binary(m_binaryWriter, isValidObject);
 
 			// Serialize the object
 			if (isValidObject)
 			{
-				BinaryWriteVisitor elementVisitor(m_binaryWriter);
-				Serialization::visitStruct(objectInstance, *objectStruct, &elementVisitor);
+				writeStruct(objectInstance, *objectPlan);
 			}
 		}
 
-		void visitBoolList(ValueAccessor const& arrayAccessor)
+		void writeBoolList(const void* valuePtr)
 		{
-			auto& boolListWrapper = arrayAccessor.getTypedValueRef<Serialization::BoolList>();
-			auto& boolList = boolListWrapper.getVector();
-
-			// Resize the array to the desired target size
+			const auto& boolList = reinterpret_cast<const Serialization::BoolList*>(valuePtr)->getVector();
 			const size_t arraySize = boolList.size();
-			const int32_t int32ArraySize = static_cast<int32_t>(arraySize);
-			to_binary(m_binaryWriter, int32ArraySize);
 
-			// Deserialize each element of the array
+			to_binary(m_binaryWriter, static_cast<int32_t>(arraySize));
 			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
 			{
-				const bool value = boolList[elementIndex];
-
-				to_binary(m_binaryWriter, value);
+				to_binary(m_binaryWriter, (bool)boolList[elementIndex]);
 			}
 		}
 
-		void visitList(
-			ValueAccessor const& arrayAccessor,
-			rfk::ClassTemplateInstantiation const& templatedArrayType)
+		void writeList(const void* arrayInstance, ValuePlan const& valuePlan)
 		{
-			const void* arrayInstance = arrayAccessor.getUntypedValuePtr();
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
 
-			// Get the type of the elements in the array from the template argument
-			auto const& templateArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedArrayType.getTemplateArgumentAt(0));
-			rfk::Type const& elementType = templateArg.getType();
+			// Write the size of the array
+			const std::size_t arraySize = valuePlan.sizeMethod->invokeUnsafe<std::size_t>(arrayInstance);
+			to_binary(m_binaryWriter, static_cast<int32_t>(arraySize));
 
-			// Use reflection to get the methods to resize the array and get a reference to an element
-			rfk::Method const* getSizeMethod = templatedArrayType.getMethodByName("size");
-			rfk::Method const* getRawElementMethod = templatedArrayType.getMethodByName("getRawElement");
+			// Lists of packed numeric data (vertices, indices, ...) are stored contiguously
+			// and already match the wire encoding, so they can be written as one block
+			if (elementPlan.blittableSize > 0 && isHostLittleEndian())
+			{
+				if (arraySize > 0)
+				{
+					const void* firstElement =
+						valuePlan.getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
+							arrayInstance, 0);
 
-			// Write the size of the array
-			int32_t arraySize = (int32_t)getSizeMethod->invokeUnsafe<std::size_t>(arrayInstance, arraySize);
-			to_binary(m_binaryWriter, arraySize);
+					m_binaryWriter.appendBytes(
+						reinterpret_cast<const uint8_t*>(firstElement),
+						arraySize * elementPlan.blittableSize);
+				}
+				return;
+			}
 
 			// Serialize each element of the array
 			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
 			{
-				// Get the target element instance in the array
 				const void* elementInstance =
-					getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
+					valuePlan.getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
 						arrayInstance, elementIndex);
 
-				// Make a fake "field" for an element in the array
-				ValueAccessor elementAccessor(elementInstance, elementType);
-
-				// Serialize the element into the json object
-				Serialization::visitValue(elementAccessor, this);
+				writeValue(elementInstance, elementPlan);
 			}
 		}
 
-		void visitMap(
-			ValueAccessor const& mapAccessor,
-			rfk::ClassTemplateInstantiation const& templatedMapType)
+		void writeMap(const void* mapInstance, ValuePlan const& valuePlan)
 		{
-			// Get the key type of the map from the template argument
-			auto const& templateKeyArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedMapType.getTemplateArgumentAt(0));
-			rfk::Type const& keyType = templateKeyArg.getType();
-
-			// Use reflection to get the the number of elements in the map
-			rfk::Method const* getSizeMethod = templatedMapType.getMethodByName("size");
+			ValuePlan const& mapValuePlan = *valuePlan.elementPlan;
 
 			// Write the number of elements in the map
-			const void* mapInstance = mapAccessor.getUntypedValuePtr();
-			int32_t arraySize = (int32_t)getSizeMethod->invokeUnsafe<std::size_t>(mapInstance);
-			to_binary(m_binaryWriter, arraySize);
+			const std::size_t pairCount = valuePlan.sizeMethod->invokeUnsafe<std::size_t>(mapInstance);
+			to_binary(m_binaryWriter, static_cast<int32_t>(pairCount));
 
-			// Do serialization based on the key type
-			if (keyType == rfk::getType<int32_t>())
+			// Serialize each key-value pair of the map
+			for (auto enumerator =
+				 valuePlan.getConstEnumeratorMethod->invokeUnsafe<std::shared_ptr<IMapConstEnumerator>>(mapInstance);
+				 enumerator->isValid();
+				 enumerator->next())
 			{
-				visitMapOfKey<int32_t>(mapAccessor, templatedMapType);
+				const void* rawKey = enumerator->getKeyRaw();
+				if (valuePlan.mapKeyKind == ValueKind::Int)
+				{
+					to_binary(m_binaryWriter, *reinterpret_cast<const int32_t*>(rawKey));
+				}
+				else
+				{
+					to_binary(m_binaryWriter, *reinterpret_cast<const std::string*>(rawKey));
+				}
+
+				writeValue(enumerator->getValueRaw(), mapValuePlan);
 			}
-			else if (keyType == rfk::getType<std::string>())
+		}
+
+		BinaryWriter& m_binaryWriter;
+	};
+
+	// Writes BinaryFormat::V2: varint integers, class names written once per message
+	// and a varint byte length in front of every struct so readers can skip fields they don't know
+	class BinaryPlanWriterV2
+	{
+	public:
+		static const std::size_t k_headerSize = 4;
+
+		// structBodySizes comes from BinaryPlanSizerV2 run over the same instance
+		BinaryPlanWriterV2(std::vector<uint8_t>& buffer, const std::vector<uint64_t>& structBodySizes)
+			: m_buffer(buffer)
+			, m_binaryWriter(buffer)
+			, m_fixedWidthWriter(m_binaryWriter)
+			, m_structBodySizes(structBodySizes)
+		{}
+
+		void writeHeader()
+		{
+			const uint8_t header[k_headerSize] = {'M', 'K', 'B', static_cast<uint8_t>(BinaryFormat::V2)};
+
+			m_binaryWriter.appendBytes(header, sizeof(header));
+		}
+
+		void writeStruct(const void* structInstance, StructPlan const& structPlan)
+		{
+			// The sizer visited the structs in the same order, so the length prefix
+			// goes in front of the body without having to move the body afterwards
+			if (m_nextStructIndex >= m_structBodySizes.size())
 			{
-				visitMapOfKey<std::string>(mapAccessor, templatedMapType);
+				throw std::runtime_error(
+					stringify("BinaryPlanWriterV2::writeStruct() ",
+							  "No size computed for struct ", structPlan.structName));
 			}
-			else
+
+			const uint64_t bodySize = m_structBodySizes[m_nextStructIndex++];
+			to_binary_varint(m_binaryWriter, bodySize);
+
+			const size_t bodyOffset = m_buffer.size();
+			for (FieldPlan const& fieldPlan : structPlan.fields)
 			{
-				rfk::Archetype const* keyArchetype = keyType.getArchetype();
+				writeValue(fieldPlan.getValuePtr(structInstance), fieldPlan.value);
+			}
 
+			if (m_buffer.size() - bodyOffset != bodySize)
+			{
 				throw std::runtime_error(
-					stringify("BinaryWriteVisitor::visitMap() ",
-							  "Map Key Archetype ", keyArchetype != nullptr ? keyArchetype->getName() : "<Null Archetype>",
-							  " is not supported"));
+					stringify("BinaryPlanWriterV2::writeStruct() ",
+							  "Struct ", structPlan.structName,
+							  " doesn't match its computed size ", bodySize));
+			}
+		}
+
+		void writeValue(const void* valuePtr, ValuePlan const& valuePlan)
+		{
+			switch (valuePlan.kind)
+			{
+				case ValueKind::Bool:
+					to_binary(m_binaryWriter, *reinterpret_cast<const bool*>(valuePtr));
+					break;
+				case ValueKind::Byte:
+					to_binary(m_binaryWriter, *reinterpret_cast<const int8_t*>(valuePtr));
+					break;
+				case ValueKind::UByte:
+					to_binary(m_binaryWriter, *reinterpret_cast<const uint8_t*>(valuePtr));
+					break;
+				case ValueKind::Short:
+					to_binary_varint(m_binaryWriter, zigzag_encode(*reinterpret_cast<const int16_t*>(valuePtr)));
+					break;
+				case ValueKind::UShort:
+					to_binary_varint(m_binaryWriter, *reinterpret_cast<const uint16_t*>(valuePtr));
+					break;
+				case ValueKind::Int:
+					to_binary_varint(m_binaryWriter, zigzag_encode(*reinterpret_cast<const int32_t*>(valuePtr)));
+					break;
+				case ValueKind::UInt:
+					to_binary_varint(m_binaryWriter, *reinterpret_cast<const uint32_t*>(valuePtr));
+					break;
+				case ValueKind::Long:
+					to_binary_varint(m_binaryWriter, zigzag_encode(*reinterpret_cast<const int64_t*>(valuePtr)));
+					break;
+				case ValueKind::ULong:
+					to_binary_varint(m_binaryWriter, *reinterpret_cast<const uint64_t*>(valuePtr));
+					break;
+				case ValueKind::Float:
+					to_binary(m_binaryWriter, *reinterpret_cast<const float*>(valuePtr));
+					break;
+				case ValueKind::Double:
+					to_binary(m_binaryWriter, *reinterpret_cast<const double*>(valuePtr));
+					break;
+				case ValueKind::Enum:
+					writeEnum(valuePtr, valuePlan);
+					break;
+				case ValueKind::String:
+					writeString(reinterpret_cast<const Serialization::String*>(valuePtr)->getValue());
+					break;
+				case ValueKind::BoolList:
+					writeBoolList(valuePtr);
+					break;
+				case ValueKind::ObjectPtr:
+					writeObjectPtr(valuePtr, valuePlan);
+					break;
+				case ValueKind::List:
+					writeList(valuePtr, valuePlan);
+					break;
+				case ValueKind::Map:
+					writeMap(valuePtr, valuePlan);
+					break;
+				case ValueKind::Struct:
+					writeStruct(valuePtr, *valuePlan.structPlan);
+					break;
 			}
 		}
 
-		template<typename t_key>
-		void visitMapOfKey(
-			ValueAccessor const& mapAccessor,
-			rfk::ClassTemplateInstantiation const& templatedMapType)
+	private:
+		void writeString(const std::string& stringValue)
 		{
-			// Get the type of the elements in the array from the template argument
-			auto const& templateValueArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedMapType.getTemplateArgumentAt(1));
-			rfk::Type const& valueType = templateValueArg.getType();
+			to_binary_varint(m_binaryWriter, stringValue.size());
+			m_binaryWriter.appendBytes(reinterpret_cast<const uint8_t*>(stringValue.data()), stringValue.size());
+		}
 
-			// Use reflection to get the method used to enumerate key-value pairs in the map
-			rfk::Method const* getConstEnumeratorMethod = templatedMapType.getMethodByName("getConstEnumerator");
+		void writeEnum(const void* valuePtr, ValuePlan const& valuePlan)
+		{
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
+			const int64_t enumIntValue = readEnumIntValue(valuePtr, enumPlan.memorySize);
 
-			// Get a const enumerator to the map
-			const void* mapInstance = mapAccessor.getUntypedValuePtr();
+			if (enumPlan.findByValue(enumIntValue) == nullptr)
+			{
+				throw std::runtime_error(
+					stringify("BinaryPlanWriterV2::writeEnum() ",
+							  "Enum Value ", valuePlan.name,
+							  " has an invalid int value ", enumIntValue));
+			}
 
-			// Serialize each element of the map
-			for (auto enumerator =
-				 getConstEnumeratorMethod->invokeUnsafe<std::shared_ptr<IMapConstEnumerator>>(mapInstance);
-				 enumerator->isValid();
-				 enumerator->next())
+			// Enum values are kept stable across API versions, so the int value is written
+			to_binary_varint(m_binaryWriter, zigzag_encode(enumIntValue));
+		}
+
+		void writeObjectPtr(const void* valuePtr, ValuePlan const& valuePlan)
+		{
+			const auto* objectPtr = reinterpret_cast<const Serialization::PolymorphicObjectPtr*>(valuePtr);
+
+			// Get the runtime class of the object pointed at
+			const Serialization::RfkClassId rfkClassId = objectPtr->getRuntimeClassId();
+			StructPlan const* objectPlan = getStructPlanById(rfkClassId);
+			if (objectPlan == nullptr)
 			{
-				// Serialize the key
-				const void* rawKey = enumerator->getKeyRaw();
-				const t_key& key= *reinterpret_cast<const t_key*>(rawKey);
-				to_binary(m_binaryWriter, key);
+				throw std::runtime_error(
+					stringify("BinaryPlanWriterV2::writeObjectPtr() ",
+							  "TypedObjectPtr Value ", valuePlan.name,
+							  " has an invalid class id ", rfkClassId));
+			}
 
-				// Serialize the value
-				const void* rawValue = enumerator->getValueRaw();
-				ValueAccessor valueAccessor(rawValue, valueType);
-				Serialization::visitValue(valueAccessor, this);
+			// Refer to the class by its index in the message's class table,
+			// only writing the class name and id the first time the class is seen
+			auto classIt = std::find(m_classTable.begin(), m_classTable.end(), rfkClassId);
+			to_binary_varint(m_binaryWriter, classIt - m_classTable.begin());
+			if (classIt == m_classTable.end())
+			{
+				m_classTable.push_back(rfkClassId);
+
+				writeString(objectPlan->structName);
+				to_binary_varint(m_binaryWriter, zigzag_encode(Serialization::toMikanClassId(rfkClassId)));
+			}
+
+			// Write out whether the object is valid or not
+			const void* objectInstance = objectPtr->getRawPtr();
+			bool isValidObject = objectInstance != nullptr;
+			to_binary(m_binaryWriter, isValidObject);
+
+			// Serialize the object
+			if (isValidObject)
+			{
+				writeStruct(objectInstance, *objectPlan);
 			}
 		}
 
-		virtual void visitStruct(ValueAccessor const& accessor) override
+		void writeBoolList(const void* valuePtr)
 		{
-			const void* childObjectInstance = accessor.getUntypedValuePtr();
-			rfk::Struct const* structType = accessor.getStructType();
+			const auto& boolList = reinterpret_cast<const Serialization::BoolList*>(valuePtr)->getVector();
+			const size_t arraySize = boolList.size();
 
-			Serialization::visitStruct(childObjectInstance, *structType, this);
+			to_binary_varint(m_binaryWriter, arraySize);
+			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
+			{
+				to_binary(m_binaryWriter, (bool)boolList[elementIndex]);
+			}
 		}
 
-		virtual void visitEnum(ValueAccessor const& accessor) override
+		void writeList(const void* arrayInstance, ValuePlan const& valuePlan)
 		{
-			rfk::Enum const& enumType = *accessor.getEnumType();
-			rfk::Archetype const& enumArchetype = enumType.getUnderlyingArchetype();
-			const void* untypedValue = accessor.getUntypedValuePtr();
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
+
+			// Write the size of the array
+			const std::size_t arraySize = valuePlan.sizeMethod->invokeUnsafe<std::size_t>(arrayInstance);
+			to_binary_varint(m_binaryWriter, arraySize);
 
-			int64_t enumIntValue = 0;
-			if (enumArchetype.getMemorySize() == sizeof(int64_t))
+			// Packed numeric elements keep the fixed width V1 encoding so they can be block copied.
+			// The element size is written first so a reader with a different element layout can step over them.
+			if (elementPlan.blittableSize > 0)
 			{
-				enumIntValue = *reinterpret_cast<const int64_t*>(untypedValue);
+				to_binary_varint(m_binaryWriter, elementPlan.blittableSize);
+
+				if (isHostLittleEndian())
+				{
+					if (arraySize > 0)
+					{
+						const void* firstElement =
+							valuePlan.getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
+								arrayInstance, 0);
+
+						m_binaryWriter.appendBytes(
+							reinterpret_cast<const uint8_t*>(firstElement),
+							arraySize * elementPlan.blittableSize);
+					}
+				}
+				else
+				{
+					for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
+					{
+						const void* elementInstance =
+							valuePlan.getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
+								arrayInstance, elementIndex);
+
+						m_fixedWidthWriter.writeValue(elementInstance, elementPlan);
+					}
+				}
+				return;
 			}
-			else if (enumArchetype.getMemorySize() == sizeof(int32_t))
+
+			// Serialize each element of the array
+			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
 			{
-				enumIntValue = (int64_t)(*reinterpret_cast<const int32_t*>(untypedValue));
+				const void* elementInstance =
+					valuePlan.getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
+						arrayInstance, elementIndex);
+
+				writeValue(elementInstance, elementPlan);
 			}
-			else if (enumArchetype.getMemorySize() == sizeof(int16_t))
+		}
+
+		void writeMap(const void* mapInstance, ValuePlan const& valuePlan)
+		{
+			ValuePlan const& mapValuePlan = *valuePlan.elementPlan;
+
+			// Write the number of elements in the map
+			const std::size_t pairCount = valuePlan.sizeMethod->invokeUnsafe<std::size_t>(mapInstance);
+			to_binary_varint(m_binaryWriter, pairCount);
+
+			// Serialize each key-value pair of the map
+			for (auto enumerator =
+				 valuePlan.getConstEnumeratorMethod->invokeUnsafe<std::shared_ptr<IMapConstEnumerator>>(mapInstance);
+				 enumerator->isValid();
+				 enumerator->next())
 			{
-				enumIntValue = (int64_t)(*reinterpret_cast<const int16_t*>(untypedValue));
+				const void* rawKey = enumerator->getKeyRaw();
+				if (valuePlan.mapKeyKind == ValueKind::Int)
+				{
+					to_binary_varint(m_binaryWriter, zigzag_encode(*reinterpret_cast<const int32_t*>(rawKey)));
+				}
+				else
+				{
+					writeString(*reinterpret_cast<const std::string*>(rawKey));
+				}
+
+				writeValue(enumerator->getValueRaw(), mapValuePlan);
 			}
-			else if (enumArchetype.getMemorySize() == sizeof(int8_t))
+		}
+
+		std::vector<uint8_t>& m_buffer;
+		BinaryWriter m_binaryWriter;
+		BinaryPlanWriter m_fixedWidthWriter;
+		std::vector<Serialization::RfkClassId> m_classTable;
+		const std::vector<uint64_t>& m_structBodySizes;
+		std::size_t m_nextStructIndex = 0;
+	};
+
+	// Computes the exact number of bytes BinaryPlanWriter will produce,
+	// so the output buffer can be reserved once instead of growing per primitive
+	class BinaryPlanSizer
+	{
+	public:
+		std::size_t sizeOfStruct(const void* structInstance, StructPlan const& structPlan)
+		{
+			if (structPlan.blittableSize > 0)
 			{
-				enumIntValue = (int64_t)(*reinterpret_cast<const int8_t*>(untypedValue));
+				return structPlan.blittableSize;
 			}
-			else
+
+			std::size_t structSize = 0;
+			for (FieldPlan const& fieldPlan : structPlan.fields)
 			{
-				throw std::runtime_error(
-					stringify("BinaryWriteVisitor::visitEnum() ",
-							  "Enum Accessor ", accessor.getName(),
-							  " has an invalid memory size ", enumArchetype.getMemorySize()));
+				structSize += sizeOfValue(fieldPlan.getValuePtr(structInstance), fieldPlan.value);
 			}
 
+			return structSize;
+		}
 
-			rfk::EnumValue const* enumValue = enumType.getEnumValue(enumIntValue);
-			if (enumValue == nullptr)
+		std::size_t sizeOfValue(const void* valuePtr, ValuePlan const& valuePlan)
+		{
+			// Numeric values and packed structs of them have a fixed encoded size
+			if (valuePlan.blittableSize > 0)
 			{
-				throw std::runtime_error(
-					stringify("BinaryWriteVisitor::visitEnum() ",
-							  "Enum Accessor ", accessor.getName(),
-							  " has an invalid int value ", enumIntValue));
+				return valuePlan.blittableSize;
 			}
 
+			switch (valuePlan.kind)
+			{
+				case ValueKind::Bool:
+				case ValueKind::Byte:
+				case ValueKind::UByte:
+					return sizeof(uint8_t);
+				case ValueKind::Short:
+				case ValueKind::UShort:
+					return sizeof(uint16_t);
+				case ValueKind::Int:
+				case ValueKind::UInt:
+				case ValueKind::Float:
+					return sizeof(uint32_t);
+				case ValueKind::Long:
+				case ValueKind::ULong:
+				case ValueKind::Double:
+					return sizeof(uint64_t);
+				case ValueKind::Enum:
+					return sizeOfEnum(valuePtr, valuePlan);
+				case ValueKind::String:
+					return sizeOfString(reinterpret_cast<const Serialization::String*>(valuePtr)->getValue());
+				case ValueKind::BoolList:
+					return sizeof(int32_t) + reinterpret_cast<const Serialization::BoolList*>(valuePtr)->getVector().size();
+				case ValueKind::ObjectPtr:
+					return sizeOfObjectPtr(valuePtr);
+				case ValueKind::List:
+					return sizeOfList(valuePtr, valuePlan);
+				case ValueKind::Map:
+					return sizeOfMap(valuePtr, valuePlan);
+				case ValueKind::Struct:
+					return sizeOfStruct(valuePtr, *valuePlan.structPlan);
+			}
 
-			std::string enumValueString = Serialization::getEnumStringValue(*enumValue);
-			to_binary(m_binaryWriter, enumValueString);
+			return 0;
 		}
 
-		virtual void visitBool(ValueAccessor const& accessor) override
+	private:
+		static std::size_t sizeOfString(const std::string& stringValue)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<bool>());
+			return sizeof(int32_t) + stringValue.size();
 		}
 
-		virtual void visitByte(ValueAccessor const& accessor) override
+		std::size_t sizeOfEnum(const void* valuePtr, ValuePlan const& valuePlan)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<int8_t>());
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
+			const int64_t enumIntValue = readEnumIntValue(valuePtr, enumPlan.memorySize);
+
+			// Invalid values are reported by the writer
+			EnumEntry const* enumEntry = enumPlan.findByValue(enumIntValue);
+
+			return enumEntry != nullptr ? sizeOfString(enumEntry->stringValue) : 0;
 		}
 
-		virtual void visitUByte(ValueAccessor const& accessor) override
+		std::size_t sizeOfObjectPtr(const void* valuePtr)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<uint8_t>());
+			const auto* objectPtr = reinterpret_cast<const Serialization::PolymorphicObjectPtr*>(valuePtr);
+			StructPlan const* objectPlan = getStructPlanById(objectPtr->getRuntimeClassId());
+			if (objectPlan == nullptr)
+			{
+				return 0;
+			}
+
+			// class name + class id + valid flag + object
+			std::size_t objectPtrSize =
+				sizeOfString(objectPlan->structName) + sizeof(Serialization::MikanClassId) + sizeof(uint8_t);
+
+			const void* objectInstance = objectPtr->getRawPtr();
+			if (objectInstance != nullptr)
+			{
+				objectPtrSize += sizeOfStruct(objectInstance, *objectPlan);
+			}
+
+			return objectPtrSize;
 		}
 
-		virtual void visitShort(ValueAccessor const& accessor) override
+		std::size_t sizeOfList(const void* arrayInstance, ValuePlan const& valuePlan)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<int16_t>());
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
+			const std::size_t arraySize = valuePlan.sizeMethod->invokeUnsafe<std::size_t>(arrayInstance);
+
+			if (elementPlan.blittableSize > 0)
+			{
+				return sizeof(int32_t) + arraySize * elementPlan.blittableSize;
+			}
+
+			std::size_t listSize = sizeof(int32_t);
+			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
+			{
+				const void* elementInstance =
+					valuePlan.getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
+						arrayInstance, elementIndex);
+
+				listSize += sizeOfValue(elementInstance, elementPlan);
+			}
+
+			return listSize;
 		}
 
-		virtual void visitUShort(ValueAccessor const& accessor) override
+		std::size_t sizeOfMap(const void* mapInstance, ValuePlan const& valuePlan)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<uint16_t>());
+			ValuePlan const& mapValuePlan = *valuePlan.elementPlan;
+
+			std::size_t mapSize = sizeof(int32_t);
+			for (auto enumerator =
+				 valuePlan.getConstEnumeratorMethod->invokeUnsafe<std::shared_ptr<IMapConstEnumerator>>(mapInstance);
+				 enumerator->isValid();
+				 enumerator->next())
+			{
+				const void* rawKey = enumerator->getKeyRaw();
+				if (valuePlan.mapKeyKind == ValueKind::Int)
+				{
+					mapSize += sizeof(int32_t);
+				}
+				else
+				{
+					mapSize += sizeOfString(*reinterpret_cast<const std::string*>(rawKey));
+				}
+
+				mapSize += sizeOfValue(enumerator->getValueRaw(), mapValuePlan);
+			}
+
+			return mapSize;
 		}
+	};
 
-		virtual void visitInt(ValueAccessor const& accessor) override
+	// Computes the exact number of bytes BinaryPlanWriterV2 will produce, and the body size
+	// of every struct in the order the writer visits them, for the struct length prefixes
+	class BinaryPlanSizerV2
+	{
+	public:
+		std::size_t sizeOfStruct(const void* structInstance, StructPlan const& structPlan)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<int32_t>());
+			const std::size_t sizeIndex = m_structBodySizes.size();
+			m_structBodySizes.push_back(0);
+
+			uint64_t bodySize = 0;
+			for (FieldPlan const& fieldPlan : structPlan.fields)
+			{
+				bodySize += sizeOfValue(fieldPlan.getValuePtr(structInstance), fieldPlan.value);
+			}
+
+			m_structBodySizes[sizeIndex] = bodySize;
+
+			return get_varint_size(bodySize) + bodySize;
 		}
 
-		virtual void visitUInt(ValueAccessor const& accessor) override
+		std::size_t sizeOfValue(const void* valuePtr, ValuePlan const& valuePlan)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<uint32_t>());
+			switch (valuePlan.kind)
+			{
+				case ValueKind::Bool:
+				case ValueKind::Byte:
+				case ValueKind::UByte:
+					return sizeof(uint8_t);
+				case ValueKind::Short:
+					return get_varint_size(zigzag_encode(*reinterpret_cast<const int16_t*>(valuePtr)));
+				case ValueKind::UShort:
+					return get_varint_size(*reinterpret_cast<const uint16_t*>(valuePtr));
+				case ValueKind::Int:
+					return get_varint_size(zigzag_encode(*reinterpret_cast<const int32_t*>(valuePtr)));
+				case ValueKind::UInt:
+					return get_varint_size(*reinterpret_cast<const uint32_t*>(valuePtr));
+				case ValueKind::Long:
+					return get_varint_size(zigzag_encode(*reinterpret_cast<const int64_t*>(valuePtr)));
+				case ValueKind::ULong:
+					return get_varint_size(*reinterpret_cast<const uint64_t*>(valuePtr));
+				case ValueKind::Float:
+					return sizeof(float);
+				case ValueKind::Double:
+					return sizeof(double);
+				case ValueKind::Enum:
+					return sizeOfEnum(valuePtr, valuePlan);
+				case ValueKind::String:
+					return sizeOfString(reinterpret_cast<const Serialization::String*>(valuePtr)->getValue());
+				case ValueKind::BoolList:
+				{
+					const std::size_t boolCount = reinterpret_cast<const Serialization::BoolList*>(valuePtr)->getVector().size();
+					return get_varint_size(boolCount) + boolCount;
+				}
+				case ValueKind::ObjectPtr:
+					return sizeOfObjectPtr(valuePtr);
+				case ValueKind::List:
+					return sizeOfList(valuePtr, valuePlan);
+				case ValueKind::Map:
+					return sizeOfMap(valuePtr, valuePlan);
+				case ValueKind::Struct:
+					return sizeOfStruct(valuePtr, *valuePlan.structPlan);
+			}
+
+			return 0;
 		}
 
-		virtual void visitLong(ValueAccessor const& accessor) override
+		const std::vector<uint64_t>& getStructBodySizes() const { return m_structBodySizes; }
+
+	private:
+		static std::size_t sizeOfString(const std::string& stringValue)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<int64_t>());
+			return get_varint_size(stringValue.size()) + stringValue.size();
 		}
 
-		virtual void visitULong(ValueAccessor const& accessor)
+		std::size_t sizeOfEnum(const void* valuePtr, ValuePlan const& valuePlan)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<uint64_t>());
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
+			const int64_t enumIntValue = readEnumIntValue(valuePtr, enumPlan.memorySize);
+
+			// Invalid values are reported by the writer
+			return 
+				enumPlan.findByValue(enumIntValue) != nullptr 
+				? get_varint_size(zigzag_encode(enumIntValue)) 
+				: 0;
 		}
 
-		virtual void visitFloat(ValueAccessor const& accessor) override
+		std::size_t sizeOfObjectPtr(const void* valuePtr)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<float>());
+			const auto* objectPtr = reinterpret_cast<const Serialization::PolymorphicObjectPtr*>(valuePtr);
+			const Serialization::RfkClassId rfkClassId = objectPtr->getRuntimeClassId();
+			StructPlan const* objectPlan = getStructPlanById(rfkClassId);
+			if (objectPlan == nullptr)
+			{
+				return 0;
+			}
+
+			// class table index (+ class name and id the first time) + valid flag + object
+			auto classIt = std::find(m_classTable.begin(), m_classTable.end(), rfkClassId);
+			std::size_t objectPtrSize = get_varint_size(classIt - m_classTable.begin());
+			if (classIt == m_classTable.end())
+			{
+				m_classTable.push_back(rfkClassId);
+
+				objectPtrSize += 
+					sizeOfString(objectPlan->structName) + 
+					get_varint_size(zigzag_encode(Serialization::toMikanClassId(rfkClassId)));
+			}
+			objectPtrSize += sizeof(uint8_t);
+
+			const void* objectInstance = objectPtr->getRawPtr();
+			if (objectInstance != nullptr)
+			{
+				objectPtrSize += sizeOfStruct(objectInstance, *objectPlan);
+			}
+
+			return objectPtrSize;
 		}
 
-		virtual void visitDouble(ValueAccessor const& accessor) override
+		std::size_t sizeOfList(const void* arrayInstance, ValuePlan const& valuePlan)
 		{
-			to_binary(m_binaryWriter, *accessor.getTypedValuePtr<double>());
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
+			const std::size_t arraySize = valuePlan.sizeMethod->invokeUnsafe<std::size_t>(arrayInstance);
+
+			std::size_t listSize = get_varint_size(arraySize);
+			if (elementPlan.blittableSize > 0)
+			{
+				return listSize + get_varint_size(elementPlan.blittableSize) + arraySize * elementPlan.blittableSize;
+			}
+
+			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
+			{
+				const void* elementInstance =
+					valuePlan.getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
+						arrayInstance, elementIndex);
+
+				listSize += sizeOfValue(elementInstance, elementPlan);
+			}
+
+			return listSize;
 		}
 
-	private:
+		std::size_t sizeOfMap(const void* mapInstance, ValuePlan const& valuePlan)
+		{
+			ValuePlan const& mapValuePlan = *valuePlan.elementPlan;
 
-		BinaryWriter& m_binaryWriter;
+			const std::size_t pairCount = valuePlan.sizeMethod->invokeUnsafe<std::size_t>(mapInstance);
+			std::size_t mapSize = get_varint_size(pairCount);
+			for (auto enumerator =
+				 valuePlan.getConstEnumeratorMethod->invokeUnsafe<std::shared_ptr<IMapConstEnumerator>>(mapInstance);
+				 enumerator->isValid();
+				 enumerator->next())
+			{
+				const void* rawKey = enumerator->getKeyRaw();
+				if (valuePlan.mapKeyKind == ValueKind::Int)
+				{
+					mapSize += get_varint_size(zigzag_encode(*reinterpret_cast<const int32_t*>(rawKey)));
+				}
+				else
+				{
+					mapSize += sizeOfString(*reinterpret_cast<const std::string*>(rawKey));
+				}
+
+				mapSize += sizeOfValue(enumerator->getValueRaw(), mapValuePlan);
+			}
+
+			return mapSize;
+		}
+
+		std::vector<uint64_t> m_structBodySizes;
+		std::vector<Serialization::RfkClassId> m_classTable;
 	};
 
+	// Only grows the buffer when the appended bytes don't fit, and then at least doubles it,
+	// so a buffer reused across many messages isn't reallocated on every append
+	static void reserveAppendCapacity(std::vector<uint8_t>& outBytes, std::size_t appendSize)
+	{
+		const std::size_t neededCapacity = outBytes.size() + appendSize;
+
+		if (neededCapacity > outBytes.capacity())
+		{
+			outBytes.reserve(std::max(outBytes.capacity() * 2, neededCapacity));
+		}
+	}
+
 	// Public API
 	bool serializeToBytes(const void* instance, rfk::Struct const& structType, std::vector<uint8_t>& outBytes)
 	{
 		try
 		{
+			StructPlan const& structPlan = getStructPlan(structType);
+
+			// Size the buffer once so the writer never reallocates mid-write
+			BinaryPlanSizer planSizer;
+			reserveAppendCapacity(outBytes, planSizer.sizeOfStruct(instance, structPlan));
+
 			BinaryWriter writer(outBytes);
-			BinaryWriteVisitor visitor(writer);
-			Serialization::visitStruct(const_cast<void*>(instance), structType, &visitor);
+			BinaryPlanWriter planWriter(writer);
+			planWriter.writeStruct(instance, structPlan);
 
 			return true;
 		}
@@ -380,5 +852,44 @@ namespace Serialization
 			return false;
 		}
 	}
-};
 
+	bool serializeToBytes(
+		const void* instance,
+		rfk::Struct const& structType,
+		std::vector<uint8_t>& outBytes,
+		BinaryFormat format)
+	{
+		if (format == BinaryFormat::V1)
+		{
+			return serializeToBytes(instance, structType, outBytes);
+		}
+
+		try
+		{
+			StructPlan const& structPlan = getStructPlan(structType);
+
+			// Sizing every struct body first lets the writer put each length prefix in front of its body
+			BinaryPlanSizerV2 planSizer;
+			const std::size_t messageSize = 
+				BinaryPlanWriterV2::k_headerSize + planSizer.sizeOfStruct(instance, structPlan);
+			reserveAppendCapacity(outBytes, messageSize);
+
+			BinaryPlanWriterV2 planWriter(outBytes, planSizer.getStructBodySizes());
+			planWriter.writeHeader();
+			planWriter.writeStruct(instance, structPlan);
+
+			return true;
+		}
+		catch (std::runtime_error* e)
+		{
+			return false;
+		}
+	}
+
+	std::size_t computeSerializedSize(const void* instance, rfk::Struct const& structType)
+	{
+		BinaryPlanSizer planSizer;
+
+		return planSizer.sizeOfStruct(instance, getStructPlan(structType));
+	}
+};
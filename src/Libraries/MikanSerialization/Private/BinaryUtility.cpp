@@ -253,6 +253,34 @@ void to_binary(BinaryWriter& writer, const std::string& inString)
 	writer.appendBytes((const uint8_t*)inString.c_str(), stringLength);
 }
 
+void to_binary_varint(BinaryWriter& writer, uint64_t inValue)
+{
+	std::array<uint8_t, 10> outValue;
+	size_t byteCount = 0;
+
+	while (inValue >= 0x80)
+	{
+		outValue[byteCount++] = static_cast<uint8_t>(inValue | 0x80);
+		inValue >>= 7;
+	}
+	outValue[byteCount++] = static_cast<uint8_t>(inValue);
+
+	writer.appendBytes(outValue.data(), byteCount);
+}
+
+size_t get_varint_size(uint64_t inValue)
+{
+	size_t byteCount = 1;
+
+	while (inValue >= 0x80)
+	{
+		inValue >>= 7;
+		++byteCount;
+	}
+
+	return byteCount;
+}
+
 // -- BinaryReader -----
 BinaryReader::BinaryReader(const uint8_t* buffer, size_t bufferSize)
 	: m_buffer(buffer), m_bufferSize(bufferSize), m_bytesRead(0)
@@ -293,6 +321,16 @@ uint8_t* BinaryReader::readBytesNoCopy(size_t byteCount)
 	return result;
 }
 
+void BinaryReader::skipBytes(size_t byteCount)
+{
+	if (m_bytesRead + byteCount > m_bufferSize)
+	{
+		throw std::out_of_range("BinaryReader::skipBytes() - Not enough bytes to skip");
+	}
+
+	m_bytesRead += byteCount;
+}
+
 void from_binary(BinaryReader& reader, bool& outValue)
 {
 	outValue= reader.readByte() != 0;
@@ -370,4 +408,22 @@ void from_binary(BinaryReader& reader, std::string& outString)
 	from_binary(reader, stringLength);
 
 	outString= std::string((const char*)reader.readBytesNoCopy(stringLength), stringLength);
-}
\ No newline at end of file
+}
+
+void from_binary_varint(BinaryReader& reader, uint64_t& outValue)
+{
+	outValue = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		const uint8_t byte = reader.readByte();
+
+		outValue |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return;
+		}
+	}
+
+	throw std::out_of_range("from_binary_varint() - Varint is longer than 64 bits");
+}
@@ -1,642 +1,1420 @@
 #include "JsonDeserializer.h"
+#include "SerializationPlan.h"
 #include "SerializationUtility.h"
 #include "SerializableList.h"
 #include "SerializableMap.h"
 #include "SerializableObjectPtr.h"
 #include "SerializableString.h"
-#include "SerializationProperty.h"
 
 #include "nlohmann/json.hpp"
 #include "Refureku/Refureku.h"
 
+#include <algorithm>
+#include <optional>
+
 using json = nlohmann::json;
 
 namespace Serialization
 {
-	class JsonReadVisitor : public IVisitor
+	class JsonPlanReader
 	{
 	public:
-		JsonReadVisitor(const nlohmann::json& jsonObject) : m_jsonObject(jsonObject) {}
-
-		virtual void visitClass(ValueAccessor const& accessor) override
+		void readStruct(const json& jsonObject, void* structInstance, StructPlan const& structPlan)
 		{
-			const json& fieldJsonObject = getJsonObjectFromAccessor(accessor);
-
-			rfk::Type const& fieldType = accessor.getType();
-			rfk::Class const* fieldClassType = accessor.getClassType();
-			rfk::EClassKind classKind = fieldClassType->getClassKind();
-
-			if (fieldJsonObject.is_array())
+			for (FieldPlan const& fieldPlan : structPlan.fields)
 			{
-				if (fieldType == rfk::getType<Serialization::BoolList>())
+				auto it = jsonObject.find(fieldPlan.name);
+				if (it == jsonObject.end())
 				{
-					visitBoolList(accessor, fieldJsonObject);
-					return;
+					throw std::runtime_error(stringify("Field ", fieldPlan.name, " not found in json"));
 				}
-				else if (classKind == rfk::EClassKind::TemplateInstantiation)
-				{
-					void* arrayInstance = accessor.getUntypedValueMutablePtr();
-					const auto* templateClassInstanceType = rfk::classTemplateInstantiationCast(fieldClassType);
-					std::string templateTypeName = templateClassInstanceType->getClassTemplate().getName();
 
-					// See if the field is a Serialization::List<T>
-					if (templateTypeName == "List" &&
-						templateClassInstanceType->getTemplateArgumentsCount() == 1)
-					{
-						visitList(accessor, *templateClassInstanceType, fieldJsonObject);
-						return;
-					}
-					// See if the field is a Serialization::Map<K,V>
-					else if (templateTypeName == "Map" &&
-						templateClassInstanceType->getTemplateArgumentsCount() == 2)
+				readValue(*it, fieldPlan.getValueMutablePtr(structInstance), fieldPlan.value);
+			}
+		}
+
+		void readValue(const json& jsonValue, void* valuePtr, ValuePlan const& valuePlan)
+		{
+			switch (valuePlan.kind)
+			{
+				case ValueKind::Bool:
+					readBool(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::Byte:
+					readSignedInteger<int8_t>(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::UByte:
+					readUnsignedInteger<uint8_t, int8_t>(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::Short:
+					readSignedInteger<int16_t>(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::UShort:
+					readUnsignedInteger<uint16_t, int16_t>(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::Int:
+					readSignedInteger<int32_t>(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::UInt:
+					readUnsignedInteger<uint32_t, int32_t>(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::Long:
+					readSignedInteger<int64_t>(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::ULong:
+					throw std::runtime_error(
+						stringify("JsonPlanReader::readValue() ",
+								  "ULong Value ", valuePlan.name,
+								  " type not supported by all JSON libraries"));
+				case ValueKind::Float:
+					readFloat<float>(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::Double:
+					readFloat<double>(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::Enum:
+					readEnum(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::String:
+					readString(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::BoolList:
+					readBoolList(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::ObjectPtr:
+					readObjectPtr(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::List:
+					readList(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::Map:
+					readMap(jsonValue, valuePtr, valuePlan);
+					break;
+				case ValueKind::Struct:
+					if (!jsonValue.is_object())
 					{
-						visitMap(accessor, *templateClassInstanceType, fieldJsonObject);
-						return;
+						throw std::runtime_error(
+							stringify("JsonPlanReader::readValue() ",
+									  "Struct Value ", valuePlan.name,
+									  " was not of expected type object to deserialize json object value"));
 					}
-				}
-				else
-				{
-					throw std::runtime_error(
-						stringify("JsonReadVisitor::visitClass() ",
-							"Class Field ", accessor.getName(),
-							" was not of expected type Serializable::List to deserialize json array value"));
-				}
+					readStruct(jsonValue, valuePtr, *valuePlan.structPlan);
+					break;
+			}
+		}
+
+	private:
+		void readBool(const json& jsonValue, void* valuePtr, ValuePlan const& valuePlan)
+		{
+			if (!jsonValue.is_boolean())
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readBool() ",
+							  "Bool Value ", valuePlan.name,
+							  " was not a bool json value"));
+			}
+
+			*reinterpret_cast<bool*>(valuePtr) = jsonValue.get<bool>();
+		}
+
+		template <typename t_signed>
+		void readSignedInteger(const json& jsonValue, void* valuePtr, ValuePlan const& valuePlan)
+		{
+			if (!jsonValue.is_number_integer())
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readSignedInteger() ",
+							  "Integer Value ", valuePlan.name,
+							  " was not a integer json value"));
+			}
+
+			*reinterpret_cast<t_signed*>(valuePtr) = jsonValue.get<t_signed>();
+		}
+
+		template <typename t_unsigned, typename t_signed>
+		void readUnsignedInteger(const json& jsonValue, void* valuePtr, ValuePlan const& valuePlan)
+		{
+			if (jsonValue.is_number_unsigned())
+			{
+				*reinterpret_cast<t_unsigned*>(valuePtr) = jsonValue.get<t_unsigned>();
+			}
+			else if (jsonValue.is_number_integer())
+			{
+				*reinterpret_cast<t_unsigned*>(valuePtr) = (t_unsigned)jsonValue.get<t_signed>();
+			}
+			else
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readUnsignedInteger() ",
+							  "Unsigned Integer Value ", valuePlan.name,
+							  " was not a integer json value"));
+			}
+		}
+
+		template <typename t_float>
+		void readFloat(const json& jsonValue, void* valuePtr, ValuePlan const& valuePlan)
+		{
+			if (!jsonValue.is_number_float())
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readFloat() ",
+							  "Float Value ", valuePlan.name,
+							  " was not a float json value"));
 			}
-			else if (fieldJsonObject.is_object())
+
+			*reinterpret_cast<t_float*>(valuePtr) = jsonValue.get<t_float>();
+		}
+
+		void readString(const json& jsonValue, void* valuePtr, ValuePlan const& valuePlan)
+		{
+			if (!jsonValue.is_string())
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readString() ",
+							  "String Value ", valuePlan.name,
+							  " was not a string json value"));
+			}
+
+			reinterpret_cast<Serialization::String*>(valuePtr)->setValue(jsonValue.get_ref<const std::string&>());
+		}
+
+		void readEnum(const json& jsonValue, void* valuePtr, ValuePlan const& valuePlan)
+		{
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
+			EnumEntry const* enumEntry = nullptr;
+
+			if (jsonValue.is_number_integer())
 			{
-				if (fieldType == rfk::getType<PolymorphicObjectPtr>())
+				int value = jsonValue.get<int>();
+
+				enumEntry = enumPlan.findByValue(value);
+				if (enumEntry == nullptr)
 				{
-					visitObjectPtr(accessor, fieldJsonObject);
-					return;
+					throw std::runtime_error(
+						stringify("JsonPlanReader::readEnum() ",
+								  "Enum Value ", valuePlan.name,
+								  " has an invalid value ", value));
 				}
 			}
-			else if (fieldJsonObject.is_string())
+			else if (jsonValue.is_string())
 			{
-				if (fieldType == rfk::getType<Serialization::String>())
-				{
-					// A Serialization::String is a std::string
-					std::string value = fieldJsonObject.get<std::string>();
-					auto* variablePtr = accessor.getTypedValueMutablePtr<Serialization::String>();
+				const std::string& value = jsonValue.get_ref<const std::string&>();
 
-					variablePtr->setValue(value);
-					return;
-				}
-				else
+				enumEntry = enumPlan.findByString(value.c_str());
+				if (enumEntry == nullptr)
 				{
 					throw std::runtime_error(
-						stringify("JsonReadVisitor::visitClass() ",
-								  "Class Field ", accessor.getName(),
-								  " was not of expected type Serializable::List to deserialize json array value"));
+						stringify("JsonPlanReader::readEnum() ",
+								  "Enum Value ", valuePlan.name,
+								  " has an invalid value ", value));
 				}
 			}
+			else
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readEnum() ",
+							  "Enum Value ", valuePlan.name,
+							  " was not an int or a string json value"));
+			}
 
-			JsonReadVisitor::visitStruct(accessor);
+			writeEnumIntValue(valuePtr, enumPlan.memorySize, enumEntry->value);
 		}
 
-		void visitObjectPtr(
-			ValueAccessor const& accessor,
-			const json& ownerJsonObject)
+		void readObjectPtr(const json& jsonValue, void* valuePtr, ValuePlan const& valuePlan)
 		{
-			// Get the shared pointer we are writing 
-			void* objPtrInstance = accessor.getUntypedValueMutablePtr();
-			rfk::Class const* objPtrClassType = accessor.getClassType();
+			auto* objectPtr = reinterpret_cast<Serialization::PolymorphicObjectPtr*>(valuePtr);
+
+			auto classNameIt = jsonValue.find("class_name");
+			auto classIdIt = jsonValue.find("class_id");
+			auto valueIt = jsonValue.find("value");
+			if (classNameIt == jsonValue.end() || classIdIt == jsonValue.end() || valueIt == jsonValue.end())
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readObjectPtr() ",
+							  "TypedObjectPtr Value ", valuePlan.name,
+							  " missing class_name, class_id or value"));
+			}
 
 			// Get the class for the object by type id
-			std::string objectClassName = ownerJsonObject["class_name"].get<std::string>();
-			Serialization::MikanClassId mikanClassId = 
-				ownerJsonObject["class_id"].get<Serialization::MikanClassId>();
+			Serialization::MikanClassId mikanClassId = classIdIt->get<Serialization::MikanClassId>();
 			Serialization::RfkClassId rfkClassId = Serialization::toRfkClassId(mikanClassId);
-			rfk::Struct const* objectStruct = rfk::getDatabase().getStructById(rfkClassId);
-			if (objectStruct == nullptr)
+			StructPlan const* objectPlan = getStructPlanById(rfkClassId);
+			if (objectPlan == nullptr)
 			{
 				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitObjectPtr() ",
-							  "TypedObjectPtr Accessor ", accessor.getName(),
-							  " used an unknown runtime class_name: ", objectClassName,
+					stringify("JsonPlanReader::readObjectPtr() ",
+							  "TypedObjectPtr Value ", valuePlan.name,
+							  " used an unknown runtime class_name: ", classNameIt->get<std::string>(),
 							  " (runtime class_id: ", rfkClassId, ")"));
 			}
 
-			// Use reflection to get the methods to create and initialize the object
-			rfk::Method const* allocateMethod = 
-				objPtrClassType->getMethodByName(
-					"allocateByClassId", rfk::EMethodFlags::Default, true);
-
 			// Allocate a default instance of the object assigned to the shared pointer
-			void* objectInstance =
-				allocateMethod->invokeUnsafe<void*, const std::size_t&>(
-					objPtrInstance, rfkClassId);
+			void* objectInstance = objectPtr->allocateByClassId(std::move(rfkClassId));
 
 			// Deserialize the object from the json
-			json objectJson= ownerJsonObject["value"];
-			JsonReadVisitor objectVisitor(objectJson);
-			Serialization::visitStruct(objectInstance, *objectStruct, &objectVisitor);
+			readStruct(*valueIt, objectInstance, *objectPlan);
 		}
 
-		void visitBoolList(
-			ValueAccessor const& arrayAccessor,
-			const json& arrayJsonObject)
+		void readBoolList(const json& jsonValue, void* valuePtr, ValuePlan const& valuePlan)
 		{
-			auto& boolListWrapper= arrayAccessor.getTypedValueMutableRef<Serialization::BoolList>();
-			auto& boolList= boolListWrapper.getVectorMutable();
-			std::size_t arraySize = arrayJsonObject.size();
+			if (!jsonValue.is_array())
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readBoolList() ",
+							  "BoolList Value ", valuePlan.name,
+							  " was not a json array value"));
+			}
+
+			auto& boolList = reinterpret_cast<Serialization::BoolList*>(valuePtr)->getVectorMutable();
+			const std::size_t arraySize = jsonValue.size();
 
 			boolList.resize(arraySize);
 			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
 			{
-				// Get the source json array element
-				const json& elementJson = arrayJsonObject[elementIndex];
-
-				if (elementJson.is_boolean())
-				{
-					bool value = elementJson.get<bool>();
-
-					boolList[elementIndex] = value;
-				}
-				else
+				const json& elementJson = jsonValue[elementIndex];
+				if (!elementJson.is_boolean())
 				{
 					throw std::runtime_error(
-						stringify("JsonReadVisitor::visitBool() ",
-								  "Bool Accessor ", arrayAccessor.getName(),
+						stringify("JsonPlanReader::readBoolList() ",
+								  "BoolList Value ", valuePlan.name,
 								  "[", elementIndex, "] ",
 								  " was not a bool json value"));
 				}
+
+				boolList[elementIndex] = elementJson.get<bool>();
 			}
 		}
 
-		void visitList(
-			ValueAccessor const& arrayAccessor,
-			rfk::ClassTemplateInstantiation const& templatedArrayType,
-			const json& arrayJsonObject)
+		void readList(const json& jsonValue, void* arrayInstance, ValuePlan const& valuePlan)
 		{
-			void* arrayInstance= arrayAccessor.getUntypedValueMutablePtr();
-
-			// Get the type of the elements in the array from the template argument
-			auto const& templateArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedArrayType.getTemplateArgumentAt(0));
-			rfk::Type const& elementType = templateArg.getType();
-
-			// Use reflection to get the methods to resize the array and get a mutable reference to an element
-			rfk::Method const* resizeMethod = templatedArrayType.getMethodByName("resize");
-			rfk::Method const* getRawElementMutableMethod = templatedArrayType.getMethodByName("getRawElementMutable");
+			if (!jsonValue.is_array())
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readList() ",
+							  "List Value ", valuePlan.name,
+							  " was not a json array value"));
+			}
 
-			// Resize the array to the desired target size
-			std::size_t arraySize = arrayJsonObject.size();
-			resizeMethod->invokeUnsafe<void>(arrayInstance, arraySize);
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
+			const std::size_t arraySize = jsonValue.size();
+			valuePlan.resizeMethod->invokeUnsafe<void>(arrayInstance, arraySize);
 
-			// Deserialize each element of the array
-			for (size_t elementIndex= 0; elementIndex < arraySize; ++elementIndex) 
+			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
 			{
-				// Get the source json array element
-				const json& elementJson = arrayJsonObject[elementIndex];
-
-				// Get the target element instance in the array
-				void* elementInstance= 
-					getRawElementMutableMethod->invokeUnsafe<void*, const std::size_t&>(
+				void* elementInstance =
+					valuePlan.getRawElementMutableMethod->invokeUnsafe<void*, const std::size_t&>(
 						arrayInstance, elementIndex);
 
-				// Make a fake "field" for an element in the array
-				ValueAccessor elementAccessor(elementInstance, elementType);
-
-				// Deserialize the element
-				JsonReadVisitor elementVisitor(elementJson);
-				Serialization::visitValue(elementAccessor, &elementVisitor);
+				readValue(jsonValue[elementIndex], elementInstance, elementPlan);
 			}
 		}
 
-		void visitMap(
-			ValueAccessor const& mapAccessor,
-			rfk::ClassTemplateInstantiation const& templatedMapType,
-			const json& mapArrayJsonObject)
+		void readMap(const json& jsonValue, void* mapInstance, ValuePlan const& valuePlan)
 		{
-			// Get the key type of the map from the template argument
-			auto const& templateKeyArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedMapType.getTemplateArgumentAt(0));
-			rfk::Type const& keyType = templateKeyArg.getType();
-
-			if (keyType == rfk::getType<int32_t>())
+			if (!jsonValue.is_array())
 			{
-				visitMapOfKey<int32_t>(mapAccessor, templatedMapType, mapArrayJsonObject);
+				throw std::runtime_error(
+					stringify("JsonPlanReader::readMap() ",
+							  "Map Value ", valuePlan.name,
+							  " was not a json array value"));
 			}
-			else if (keyType == rfk::getType<std::string>())
+
+			if (valuePlan.mapKeyKind == ValueKind::Int)
 			{
-				visitMapOfKey<std::string>(mapAccessor, templatedMapType, mapArrayJsonObject);
+				readMapOfKey<int32_t>(jsonValue, mapInstance, valuePlan);
 			}
 			else
 			{
-				rfk::Archetype const* keyArchetype= keyType.getArchetype();
-
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitMap() ",
-						"Map Key Archetype ", keyArchetype != nullptr ? keyArchetype->getName() : "<Null Archetype>",
-						" is not supported"));
+				readMapOfKey<std::string>(jsonValue, mapInstance, valuePlan);
 			}
 		}
 
 		template<typename t_key>
-		void visitMapOfKey(
-			ValueAccessor const& mapAccessor,
-			rfk::ClassTemplateInstantiation const& templatedMapType,
-			const json& mapArrayJsonObject)
+		void readMapOfKey(const json& mapArrayJsonObject, void* mapInstance, ValuePlan const& valuePlan)
 		{
-			void* mapInstance = mapAccessor.getUntypedValueMutablePtr();
-
-			// Get the type of the elements in the array from the template argument
-			auto const& templateValueArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedMapType.getTemplateArgumentAt(1));
-			rfk::Type const& valueType = templateValueArg.getType();
+			ValuePlan const& mapValuePlan = *valuePlan.elementPlan;
 
-			// Use reflection to get the method use to clear and add pairs to the map
-			rfk::Method const* clearMethod = templatedMapType.getMethodByName("clear");
-			rfk::Method const* getOrAddValueMethod = templatedMapType.getMethodByName("getOrAddRawValueMutable");
+			valuePlan.clearMethod->invokeUnsafe<void>(mapInstance);
 
-			// Resize the array to the desired target size
-			clearMethod->invokeUnsafe<void>(mapInstance);
-
-			// Deserialize each element of the array
-			std::size_t pairCount = mapArrayJsonObject.size();
+			const std::size_t pairCount = mapArrayJsonObject.size();
 			for (size_t pairIndex = 0; pairIndex < pairCount; ++pairIndex)
 			{
-				// Get the source json array element
 				const json& pairJson = mapArrayJsonObject[pairIndex];
 
-				if (!pairJson.contains("key"))
+				auto keyIt = pairJson.find("key");
+				if (keyIt == pairJson.end())
 				{
 					throw std::runtime_error(
-						stringify("JsonReadVisitor::visitMapOfKey() ",
+						stringify("JsonPlanReader::readMapOfKey() ",
 								  "Map Pair ", pairIndex,
 								  " does not contain key"));
 				}
 
-				if (!pairJson.contains("value"))
+				auto valueIt = pairJson.find("value");
+				if (valueIt == pairJson.end())
 				{
 					throw std::runtime_error(
-						stringify("JsonReadVisitor::visitMapOfKey() ",
+						stringify("JsonPlanReader::readMapOfKey() ",
 								  "Map Pair ", pairIndex,
 								  " does not contain value"));
 				}
 
-				// Parse the key from json
-				t_key key= pairJson["key"].get<t_key>();
-
 				// Get or Add the target value instance in the map
+				t_key key = keyIt->get<t_key>();
 				void* valueInstance =
-					getOrAddValueMethod->invokeUnsafe<void*, const t_key&>(
+					valuePlan.getOrAddRawValueMutableMethod->invokeUnsafe<void*, const t_key&>(
 						mapInstance, key);
 
-				// Make a fake "field" for an element in the array
-				ValueAccessor valueAccessor(valueInstance, valueType);
-
-				// Deserialize the value
-				JsonReadVisitor valueVisitor(pairJson["value"]);
-				Serialization::visitValue(valueAccessor, &valueVisitor);
+				readValue(*valueIt, valueInstance, mapValuePlan);
 			}
 		}
+	};
 
-		virtual void visitStruct(ValueAccessor const& accessor) override
+	// Deserializes straight from the json text using nlohmann's SAX interface,
+	// walking the struct plan alongside the parser instead of building a DOM first.
+	// Follows the same rules as JsonPlanReader (every field is required, unknown keys are ignored),
+	// with one extra requirement: a map pair's "key" and an object pointer's "class_id"
+	// must come before their "value" (which is always the case for json we write, since keys are sorted).
+	class JsonSaxPlanReader : public json::json_sax_t
+	{
+	public:
+		JsonSaxPlanReader(void* rootInstance, StructPlan const& rootPlan)
+			: m_rootInstance(rootInstance)
+			, m_rootPlan(rootPlan)
+			, m_scratch(getThreadScratch())
+			, m_frames(m_scratch.frames)
+			, m_seenFields(m_scratch.seenFields)
+		{}
+
+		const std::string& getErrorMessage() const { return m_errorMessage; }
+
+		// -- json_sax_t -----
+		bool null() override
 		{
-			const json& childJsonObject= getJsonObjectFromAccessor(accessor);
+			SaxScalar scalar(SaxScalarType::Null);
+			return onScalar(scalar);
+		}
 
-			if (childJsonObject.is_object())
-			{
-				void* childObjectInstance = accessor.getUntypedValueMutablePtr();
-				rfk::Struct const* structType= accessor.getStructType();
-				JsonReadVisitor jsonVisitor(childJsonObject);
+		bool boolean(bool val) override
+		{
+			SaxScalar scalar(SaxScalarType::Bool);
+			scalar.boolValue = val;
+			return onScalar(scalar);
+		}
 
-				Serialization::visitStruct(childObjectInstance, *structType, &jsonVisitor);
+		bool number_integer(number_integer_t val) override
+		{
+			SaxScalar scalar(SaxScalarType::Integer);
+			scalar.intValue = val;
+			return onScalar(scalar);
+		}
+
+		bool number_unsigned(number_unsigned_t val) override
+		{
+			SaxScalar scalar(SaxScalarType::Unsigned);
+			scalar.unsignedValue = val;
+			return onScalar(scalar);
+		}
+
+		bool number_float(number_float_t val, const string_t& s) override
+		{
+			SaxScalar scalar(SaxScalarType::Float);
+			scalar.floatValue = val;
+			return onScalar(scalar);
+		}
+
+		bool string(string_t& val) override
+		{
+			SaxScalar scalar(SaxScalarType::String);
+			scalar.stringValue = &val;
+			return onScalar(scalar);
+		}
+
+		bool binary(json::binary_t& val) override
+		{
+			return fail("Unexpected binary json value");
+		}
+
+		bool start_object(std::size_t elements) override
+		{
+			SaxTarget target;
+			if (!beginValue(target))
+				return false;
+
+			switch (target.kind)
+			{
+				case SaxTargetKind::Root:
+					pushStructFrame(m_rootPlan, m_rootInstance);
+					return true;
+				case SaxTargetKind::Skip:
+					pushFrame(SaxFrameType::Skip);
+					return true;
+				case SaxTargetKind::ObjectValue:
+					pushStructFrame(*target.structPlan, target.ptr);
+					return true;
+				case SaxTargetKind::MapPair:
+					{
+						SaxFrame& frame = pushFrame(SaxFrameType::MapPair);
+						frame.valuePlan = target.plan;
+						frame.instance = target.ptr;
+					}
+					return true;
+				case SaxTargetKind::Value:
+					if (target.plan->kind == ValueKind::Struct)
+					{
+						pushStructFrame(*target.plan->structPlan, target.ptr);
+						return true;
+					}
+					else if (target.plan->kind == ValueKind::ObjectPtr)
+					{
+						SaxFrame& frame = pushFrame(SaxFrameType::ObjectPtr);
+						frame.valuePlan = target.plan;
+						frame.instance = target.ptr;
+						return true;
+					}
+					return fail(stringify("Value ", target.plan->name, " was not expecting a json object"));
+				default:
+					return fail("Unexpected json object");
 			}
-			else
+		}
+
+		bool key(string_t& val) override
+		{
+			SaxFrame& frame = m_frames.back();
+
+			switch (frame.type)
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitStruct() ",
-						"Struct Field ", accessor.getName(),
-						" was not of expected type object to deserialize json object value"));
+				case SaxFrameType::Struct:
+					frame.currentField = findField(frame, val);
+					break;
+				case SaxFrameType::MapPair:
+					frame.member =
+						val == "key" ? SaxMember::Key :
+						val == "value" ? SaxMember::Value :
+						SaxMember::Skip;
+					break;
+				case SaxFrameType::ObjectPtr:
+					frame.member =
+						val == "class_id" ? SaxMember::ClassId :
+						val == "class_name" ? SaxMember::ClassName :
+						val == "value" ? SaxMember::Value :
+						SaxMember::Skip;
+					break;
+				default:
+					break;
 			}
+
+			return true;
 		}
 
-		virtual void visitEnum(ValueAccessor const& accessor) override
+		bool end_object() override
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
-			rfk::Enum const& enumType = *accessor.getEnumType();
-			rfk::Archetype const& enumArchetype = enumType.getUnderlyingArchetype();
-			rfk::EnumValue const* enumValue = nullptr;
+			SaxFrame& frame = m_frames.back();
 
-			if (fieldJsonObject.is_number_integer())
+			if (frame.type == SaxFrameType::Struct)
 			{
-				int value = fieldJsonObject.get<int>();
-				enumValue = enumType.getEnumValue(value);
+				StructPlan const& structPlan = *frame.structPlan;
 
-				if (enumValue == nullptr)
+				for (std::size_t fieldIndex = 0; fieldIndex < structPlan.fields.size(); ++fieldIndex)
 				{
-					throw std::runtime_error(
-						stringify("JsonReadVisitor::visitEnum() ",
-								  "Enum Accessor ", accessor.getName(),
-								  " has an invalid value ", value));
+					if (m_seenFields[frame.seenOffset + fieldIndex] == 0)
+					{
+						return fail(stringify("Field ", structPlan.fields[fieldIndex].name, " not found in json"));
+					}
 				}
+
+				m_seenFields.resize(frame.seenOffset);
 			}
-			else if (fieldJsonObject.is_string())
+			else if (frame.type == SaxFrameType::MapPair)
 			{
-				std::string value = fieldJsonObject.get<std::string>();
-				enumValue = Serialization::findEnumValueByString(enumType, value.c_str());
-
-				if (enumValue == nullptr)
+				if (frame.mapValueInstance == nullptr || !frame.bHasValue)
 				{
-					throw std::runtime_error(
-						stringify("JsonReadVisitor::visitEnum() ",
-									"Enum Accessor ", accessor.getName(),
-									" has an invalid value ", value));
+					return fail(stringify("Map ", frame.valuePlan->name, " pair does not contain key and value"));
 				}
 			}
-			else
+			else if (frame.type == SaxFrameType::ObjectPtr)
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitEnum() ",
-								"Enum Accessor ", accessor.getName(),
-								" was not an int or a string json value"));
+				if (frame.objectPlan == nullptr || !frame.bHasClassName || !frame.bHasValue)
+				{
+					return fail(
+						stringify("TypedObjectPtr Value ", frame.valuePlan->name,
+								  " missing class_name, class_id or value"));
+				}
 			}
 
-			if (enumValue != nullptr)
+			m_frames.pop_back();
+			if (m_frames.empty())
 			{
-				void* enumInstance= accessor.getInstanceMutable();
-				rfk::Field const* enumField= accessor.getField();
-				const int64_t enumInt64Value= enumValue->getValue();
-
-				if (enumField != nullptr)
-				{
-					enumField->setUnsafe(enumInstance, &enumInt64Value, enumArchetype.getMemorySize());
-				}
-				else
-				{
-					std::memcpy(enumInstance, &enumInt64Value, enumArchetype.getMemorySize());
-				}
+				m_bRootDone = true;
 			}
+
+			return true;
 		}
 
-		virtual void visitBool(ValueAccessor const& accessor) override
+		bool start_array(std::size_t elements) override
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
+			SaxTarget target;
+			if (!beginValue(target))
+				return false;
+
+			if (target.kind == SaxTargetKind::Skip)
+			{
+				pushFrame(SaxFrameType::Skip);
+				return true;
+			}
 
-			if (fieldJsonObject.is_boolean())
+			if (target.kind != SaxTargetKind::Value)
 			{
-				bool value = fieldJsonObject.get<bool>();
+				return fail("Unexpected json array");
+			}
 
-				accessor.setValueByType(value);
+			ValuePlan const& valuePlan = *target.plan;
+			if (valuePlan.kind == ValueKind::List)
+			{
+				const std::size_t emptySize = 0;
+				valuePlan.resizeMethod->invokeUnsafe<void>(target.ptr, emptySize);
+			}
+			else if (valuePlan.kind == ValueKind::BoolList)
+			{
+				reinterpret_cast<Serialization::BoolList*>(target.ptr)->clear();
+			}
+			else if (valuePlan.kind == ValueKind::Map)
+			{
+				valuePlan.clearMethod->invokeUnsafe<void>(target.ptr);
 			}
 			else
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitBool() ",
-							  "Bool Accessor ", accessor.getName(),
-							  " was not a bool json value"));
+				return fail(stringify("Value ", valuePlan.name, " was not expecting a json array"));
 			}
+
+			SaxFrame& frame =
+				pushFrame(
+					valuePlan.kind == ValueKind::List ? SaxFrameType::List :
+					valuePlan.kind == ValueKind::BoolList ? SaxFrameType::BoolList :
+					SaxFrameType::Map);
+			frame.valuePlan = &valuePlan;
+			frame.instance = target.ptr;
+
+			return true;
 		}
 
-		virtual void visitByte(ValueAccessor const& accessor) override
+		bool end_array() override
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
+			m_frames.pop_back();
+			return true;
+		}
 
-			if (fieldJsonObject.is_number())
-			{
-				int8_t value = fieldJsonObject.get<int8_t>();
+		bool parse_error(std::size_t position, const std::string& last_token, const json::exception& ex) override
+		{
+			return fail(ex.what());
+		}
 
-				accessor.setValueByType(value);
-			}
-			else
+	private:
+		enum class SaxFrameType : uint8_t
+		{
+			Struct,
+			List,
+			BoolList,
+			Map,
+			MapPair,
+			ObjectPtr,
+			Skip
+		};
+
+		enum class SaxMember : uint8_t
+		{
+			None,
+			Skip,
+			Key,
+			Value,
+			ClassId,
+			ClassName
+		};
+
+		struct SaxFrame
+		{
+			SaxFrameType type;
+			ValuePlan const* valuePlan= nullptr;
+			StructPlan const* structPlan= nullptr;
+			void* instance= nullptr;
+
+			// Struct state
+			FieldPlan const* currentField= nullptr;
+			std::size_t fieldCursor= 0;
+			std::size_t seenOffset= 0;
+
+			// List state
+			std::size_t elementCount= 0;
+
+			// MapPair / ObjectPtr state
+			SaxMember member= SaxMember::None;
+			void* mapValueInstance= nullptr;
+			StructPlan const* objectPlan= nullptr;
+			void* objectInstance= nullptr;
+			bool bHasClassName= false;
+			bool bHasValue= false;
+		};
+
+		// Frame and seen field stacks are kept per thread
+		// so that repeated parses (e.g. a stream of events) don't reallocate them
+		struct SaxScratch
+		{
+			std::vector<SaxFrame> frames;
+			std::vector<uint8_t> seenFields;
+		};
+
+		static SaxScratch& getThreadScratch()
+		{
+			static thread_local SaxScratch scratch;
+
+			scratch.frames.clear();
+			scratch.seenFields.clear();
+
+			return scratch;
+		}
+
+		enum class SaxTargetKind : uint8_t
+		{
+			Root,
+			Value,
+			Skip,
+			BoolListElement,
+			MapPair,
+			MapKey,
+			ClassId,
+			ClassName,
+			ObjectValue
+		};
+
+		struct SaxTarget
+		{
+			SaxTargetKind kind= SaxTargetKind::Skip;
+			ValuePlan const* plan= nullptr;
+			StructPlan const* structPlan= nullptr;
+			void* ptr= nullptr;
+		};
+
+		enum class SaxScalarType : uint8_t
+		{
+			Null,
+			Bool,
+			Integer,
+			Unsigned,
+			Float,
+			String
+		};
+
+		struct SaxScalar
+		{
+			SaxScalar(SaxScalarType inType) : type(inType) {}
+
+			SaxScalarType type;
+			bool boolValue= false;
+			int64_t intValue= 0;
+			uint64_t unsignedValue= 0;
+			double floatValue= 0.0;
+			const std::string* stringValue= nullptr;
+
+			bool isInteger() const { return type == SaxScalarType::Integer || type == SaxScalarType::Unsigned; }
+			int64_t asInt64() const { return type == SaxScalarType::Integer ? intValue : (int64_t)unsignedValue; }
+		};
+
+		bool fail(const std::string& message)
+		{
+			if (m_errorMessage.empty())
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitByte() ",
-							  "Byte Accessor ", accessor.getName(),
-							  " was not a integer json value"));
+				m_errorMessage = message;
 			}
+
+			return false;
 		}
 
-		virtual void visitUByte(ValueAccessor const& accessor) override
+		SaxFrame& pushFrame(SaxFrameType type)
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
+			m_frames.emplace_back();
+
+			SaxFrame& frame = m_frames.back();
+			frame.type = type;
 
-			if (fieldJsonObject.is_number_unsigned())
+			return frame;
+		}
+
+		void pushStructFrame(StructPlan const& structPlan, void* instance)
+		{
+			const std::size_t seenOffset = m_seenFields.size();
+			m_seenFields.resize(seenOffset + structPlan.fields.size(), 0);
+
+			SaxFrame& frame = pushFrame(SaxFrameType::Struct);
+			frame.structPlan = &structPlan;
+			frame.instance = instance;
+			frame.seenOffset = seenOffset;
+		}
+
+		FieldPlan const* findField(SaxFrame& frame, const std::string& name)
+		{
+			StructPlan const& structPlan = *frame.structPlan;
+			std::vector<std::size_t> const& fieldOrder = structPlan.jsonFieldOrder;
+
+			// Keys normally arrive in sorted order, so check the next expected field first
+			std::size_t orderIndex = frame.fieldCursor;
+			if (orderIndex >= fieldOrder.size() || structPlan.fields[fieldOrder[orderIndex]].name != name)
 			{
-				uint8_t value = fieldJsonObject.get<uint8_t>();
+				auto it = std::lower_bound(
+					fieldOrder.begin(), fieldOrder.end(), name,
+					[&structPlan](std::size_t fieldIndex, const std::string& key) {
+						return structPlan.fields[fieldIndex].name < key;
+					});
+				if (it == fieldOrder.end() || structPlan.fields[*it].name != name)
+				{
+					// Unknown key, skip its value
+					return nullptr;
+				}
 
-				accessor.setValueByType(value);
+				orderIndex = it - fieldOrder.begin();
 			}
-			else if (fieldJsonObject.is_number_integer())
+
+			frame.fieldCursor = orderIndex + 1;
+			m_seenFields[frame.seenOffset + fieldOrder[orderIndex]] = 1;
+
+			return &structPlan.fields[fieldOrder[orderIndex]];
+		}
+
+		// Work out where the next json value (scalar, object or array) should be written
+		bool beginValue(SaxTarget& outTarget)
+		{
+			if (m_frames.empty())
 			{
-				uint8_t value = (uint8_t)fieldJsonObject.get<int8_t>();
+				if (m_bRootDone)
+					return fail("Unexpected json value after root object");
 
-				accessor.setValueByType(value);
+				outTarget.kind = SaxTargetKind::Root;
+				return true;
 			}
-			else
+
+			SaxFrame& frame = m_frames.back();
+			switch (frame.type)
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitUByte() ",
-							  "UByte Accessor ", accessor.getName(),
-							  " was not a integer json value"));
+				case SaxFrameType::Struct:
+					if (frame.currentField != nullptr)
+					{
+						outTarget.kind = SaxTargetKind::Value;
+						outTarget.plan = &frame.currentField->value;
+						outTarget.ptr = frame.currentField->getValueMutablePtr(frame.instance);
+						frame.currentField = nullptr;
+					}
+					else
+					{
+						outTarget.kind = SaxTargetKind::Skip;
+					}
+					break;
+				case SaxFrameType::List:
+					{
+						const std::size_t elementIndex = frame.elementCount++;
+						const std::size_t newSize = frame.elementCount;
+						frame.valuePlan->resizeMethod->invokeUnsafe<void>(frame.instance, newSize);
+
+						outTarget.kind = SaxTargetKind::Value;
+						outTarget.plan = frame.valuePlan->elementPlan.get();
+						outTarget.ptr =
+							frame.valuePlan->getRawElementMutableMethod->invokeUnsafe<void*, const std::size_t&>(
+								frame.instance, elementIndex);
+					}
+					break;
+				case SaxFrameType::BoolList:
+					outTarget.kind = SaxTargetKind::BoolListElement;
+					outTarget.ptr = frame.instance;
+					break;
+				case SaxFrameType::Map:
+					outTarget.kind = SaxTargetKind::MapPair;
+					outTarget.plan = frame.valuePlan;
+					outTarget.ptr = frame.instance;
+					break;
+				case SaxFrameType::MapPair:
+					if (frame.member == SaxMember::Key)
+					{
+						outTarget.kind = SaxTargetKind::MapKey;
+					}
+					else if (frame.member == SaxMember::Value)
+					{
+						if (frame.mapValueInstance == nullptr)
+						{
+							return fail(stringify("Map ", frame.valuePlan->name, " pair value came before its key"));
+						}
+
+						outTarget.kind = SaxTargetKind::Value;
+						outTarget.plan = frame.valuePlan->elementPlan.get();
+						outTarget.ptr = frame.mapValueInstance;
+						frame.bHasValue = true;
+					}
+					else
+					{
+						outTarget.kind = SaxTargetKind::Skip;
+					}
+					frame.member = SaxMember::None;
+					break;
+				case SaxFrameType::ObjectPtr:
+					if (frame.member == SaxMember::ClassId)
+					{
+						outTarget.kind = SaxTargetKind::ClassId;
+					}
+					else if (frame.member == SaxMember::ClassName)
+					{
+						outTarget.kind = SaxTargetKind::ClassName;
+					}
+					else if (frame.member == SaxMember::Value)
+					{
+						if (frame.objectPlan == nullptr)
+						{
+							return fail(
+								stringify("TypedObjectPtr Value ", frame.valuePlan->name,
+										  " value came before its class_id"));
+						}
+
+						outTarget.kind = SaxTargetKind::ObjectValue;
+						outTarget.structPlan = frame.objectPlan;
+						outTarget.ptr = frame.objectInstance;
+						frame.bHasValue = true;
+					}
+					else
+					{
+						outTarget.kind = SaxTargetKind::Skip;
+					}
+					frame.member = SaxMember::None;
+					break;
+				case SaxFrameType::Skip:
+					outTarget.kind = SaxTargetKind::Skip;
+					break;
 			}
+
+			return true;
 		}
 
-		virtual void visitShort(ValueAccessor const& accessor) override
+		bool onScalar(const SaxScalar& scalar)
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
-
-			if (fieldJsonObject.is_number_integer())
-			{
-				int16_t value = fieldJsonObject.get<int16_t>();
+			SaxTarget target;
+			if (!beginValue(target))
+				return false;
 
-				accessor.setValueByType(value);
-			}
-			else
+			switch (target.kind)
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitShort() ",
-							  "Short Accessor ", accessor.getName(),
-							  " was not a integer json value"));
+				case SaxTargetKind::Skip:
+					return true;
+				case SaxTargetKind::Value:
+					return assignScalar(*target.plan, target.ptr, scalar);
+				case SaxTargetKind::BoolListElement:
+					if (scalar.type != SaxScalarType::Bool)
+					{
+						return fail(stringify("BoolList Value ", m_frames.back().valuePlan->name, " element was not a bool json value"));
+					}
+					reinterpret_cast<Serialization::BoolList*>(target.ptr)->push_back(scalar.boolValue);
+					return true;
+				case SaxTargetKind::MapKey:
+					return readMapKey(m_frames.back(), scalar);
+				case SaxTargetKind::ClassId:
+					return readObjectClassId(m_frames.back(), scalar);
+				case SaxTargetKind::ClassName:
+					if (scalar.type != SaxScalarType::String)
+					{
+						return fail(stringify("TypedObjectPtr Value ", m_frames.back().valuePlan->name, " class_name was not a string"));
+					}
+					m_frames.back().bHasClassName = true;
+					return true;
+				default:
+					return fail("Expected a json object");
 			}
 		}
 
-		virtual void visitUShort(ValueAccessor const& accessor) override
+		bool readMapKey(SaxFrame& frame, const SaxScalar& scalar)
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
+			ValuePlan const& mapPlan = *frame.valuePlan;
 
-			if (fieldJsonObject.is_number_unsigned())
+			if (mapPlan.mapKeyKind == ValueKind::Int)
 			{
-				uint16_t value = fieldJsonObject.get<uint16_t>();
+				if (!scalar.isInteger())
+				{
+					return fail(stringify("Map ", mapPlan.name, " key was not a integer json value"));
+				}
 
-				accessor.setValueByType(value);
+				const int32_t key = (int32_t)scalar.asInt64();
+				frame.mapValueInstance =
+					mapPlan.getOrAddRawValueMutableMethod->invokeUnsafe<void*, const int32_t&>(
+						frame.instance, key);
 			}
-			else if (fieldJsonObject.is_number_integer())
+			else
 			{
-				uint16_t value = (uint16_t)fieldJsonObject.get<int16_t>();
+				if (scalar.type != SaxScalarType::String)
+				{
+					return fail(stringify("Map ", mapPlan.name, " key was not a string json value"));
+				}
 
-				accessor.setValueByType(value);
+				const std::string& key = *scalar.stringValue;
+				frame.mapValueInstance =
+					mapPlan.getOrAddRawValueMutableMethod->invokeUnsafe<void*, const std::string&>(
+						frame.instance, key);
 			}
-			else
+
+			return true;
+		}
+
+		bool readObjectClassId(SaxFrame& frame, const SaxScalar& scalar)
+		{
+			if (!scalar.isInteger())
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitUShort() ",
-							  "UShort Accessor ", accessor.getName(),
-							  " was not a integer json value"));
+				return fail(stringify("TypedObjectPtr Value ", frame.valuePlan->name, " class_id was not an integer"));
 			}
+
+			Serialization::MikanClassId mikanClassId = scalar.asInt64();
+			Serialization::RfkClassId rfkClassId = Serialization::toRfkClassId(mikanClassId);
+			StructPlan const* objectPlan = getStructPlanById(rfkClassId);
+			if (objectPlan == nullptr)
+			{
+				return fail(
+					stringify("TypedObjectPtr Value ", frame.valuePlan->name,
+							  " used an unknown runtime class_id: ", rfkClassId));
+			}
+
+			auto* objectPtr = reinterpret_cast<Serialization::PolymorphicObjectPtr*>(frame.instance);
+			frame.objectPlan = objectPlan;
+			frame.objectInstance = objectPtr->allocateByClassId(std::move(rfkClassId));
+
+			return true;
 		}
 
-		virtual void visitInt(ValueAccessor const& accessor) override
+		template <typename t_value>
+		bool assignInteger(void* valuePtr, ValuePlan const& valuePlan, const SaxScalar& scalar)
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
-
-			if (fieldJsonObject.is_number_integer())
+			if (!scalar.isInteger())
 			{
-				int32_t value = fieldJsonObject.get<int32_t>();
+				return fail(stringify("Integer Value ", valuePlan.name, " was not a integer json value"));
+			}
 
-				accessor.setValueByType(value);
+			*reinterpret_cast<t_value*>(valuePtr) =
+				scalar.type == SaxScalarType::Integer ? (t_value)scalar.intValue : (t_value)scalar.unsignedValue;
+			return true;
+		}
+
+		template <typename t_value>
+		bool assignFloat(void* valuePtr, ValuePlan const& valuePlan, const SaxScalar& scalar)
+		{
+			if (scalar.type != SaxScalarType::Float)
+			{
+				return fail(stringify("Float Value ", valuePlan.name, " was not a float json value"));
 			}
-			else
+
+			*reinterpret_cast<t_value*>(valuePtr) = (t_value)scalar.floatValue;
+			return true;
+		}
+
+		bool assignScalar(ValuePlan const& valuePlan, void* valuePtr, const SaxScalar& scalar)
+		{
+			switch (valuePlan.kind)
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitInt() ",
-							  "Int32 Accessor ", accessor.getName(),
-							  " was not a integer json value"));
+				case ValueKind::Bool:
+					if (scalar.type != SaxScalarType::Bool)
+					{
+						return fail(stringify("Bool Value ", valuePlan.name, " was not a bool json value"));
+					}
+					*reinterpret_cast<bool*>(valuePtr) = scalar.boolValue;
+					return true;
+				case ValueKind::Byte:
+					return assignInteger<int8_t>(valuePtr, valuePlan, scalar);
+				case ValueKind::UByte:
+					return assignInteger<uint8_t>(valuePtr, valuePlan, scalar);
+				case ValueKind::Short:
+					return assignInteger<int16_t>(valuePtr, valuePlan, scalar);
+				case ValueKind::UShort:
+					return assignInteger<uint16_t>(valuePtr, valuePlan, scalar);
+				case ValueKind::Int:
+					return assignInteger<int32_t>(valuePtr, valuePlan, scalar);
+				case ValueKind::UInt:
+					return assignInteger<uint32_t>(valuePtr, valuePlan, scalar);
+				case ValueKind::Long:
+					return assignInteger<int64_t>(valuePtr, valuePlan, scalar);
+				case ValueKind::ULong:
+					return fail(stringify("ULong Value ", valuePlan.name, " type not supported by all JSON libraries"));
+				case ValueKind::Float:
+					return assignFloat<float>(valuePtr, valuePlan, scalar);
+				case ValueKind::Double:
+					return assignFloat<double>(valuePtr, valuePlan, scalar);
+				case ValueKind::Enum:
+					return assignEnum(valuePtr, valuePlan, scalar);
+				case ValueKind::String:
+					if (scalar.type != SaxScalarType::String)
+					{
+						return fail(stringify("String Value ", valuePlan.name, " was not a string json value"));
+					}
+					reinterpret_cast<Serialization::String*>(valuePtr)->setValue(*scalar.stringValue);
+					return true;
+				case ValueKind::Struct:
+					// Structs without any fields are written as null
+					if (scalar.type == SaxScalarType::Null && valuePlan.structPlan->fields.empty())
+					{
+						return true;
+					}
+					return fail(stringify("Struct Value ", valuePlan.name, " was not a json object"));
+				default:
+					return fail(stringify("Value ", valuePlan.name, " has an unexpected json value type"));
 			}
 		}
 
-		virtual void visitUInt(ValueAccessor const& accessor) override
+		bool assignEnum(void* valuePtr, ValuePlan const& valuePlan, const SaxScalar& scalar)
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
+			EnumEntry const* enumEntry = nullptr;
 
-			if (fieldJsonObject.is_number_unsigned())
+			if (scalar.isInteger())
 			{
-				uint32_t value = fieldJsonObject.get<uint32_t>();
-
-				accessor.setValueByType(value);
+				enumEntry = enumPlan.findByValue((int)scalar.asInt64());
 			}
-			else if (fieldJsonObject.is_number_integer())
+			else if (scalar.type == SaxScalarType::String)
 			{
-				uint32_t value = (uint32_t)fieldJsonObject.get<int32_t>();
-
-				accessor.setValueByType(value);
+				enumEntry = enumPlan.findByString(scalar.stringValue->c_str());
 			}
 			else
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitUInt() ",
-							  "UInt32 Accessor ", accessor.getName(),
-							  " was not a integer json value"));
+				return fail(stringify("Enum Value ", valuePlan.name, " was not an int or a string json value"));
 			}
+
+			if (enumEntry == nullptr)
+			{
+				return fail(stringify("Enum Value ", valuePlan.name, " has an invalid value"));
+			}
+
+			writeEnumIntValue(valuePtr, enumPlan.memorySize, enumEntry->value);
+			return true;
 		}
 
-		virtual void visitLong(ValueAccessor const& accessor) override
+		void* m_rootInstance;
+		StructPlan const& m_rootPlan;
+		bool m_bRootDone= false;
+		SaxScratch& m_scratch;
+		std::vector<SaxFrame>& m_frames;
+		std::vector<uint8_t>& m_seenFields;
+		std::string m_errorMessage;
+	};
+
+	// Deserializes json whose struct type is given by one of its own integer fields
+	// (e.g. a request's "requestTypeId") in the same single SAX pass as JsonSaxPlanReader.
+	// Everything before the type field is buffered, then replayed into a JsonSaxPlanReader
+	// once the instance has been allocated. Keys are sorted, so that is usually just a few scalars.
+	class JsonSaxTypedReader : public json::json_sax_t
+	{
+	public:
+		JsonSaxTypedReader(const char* typeIdFieldName, const JsonTypedInstanceAllocator& allocateInstance)
+			: m_typeIdFieldName(typeIdFieldName)
+			, m_allocateInstance(allocateInstance)
+			, m_bufferedEvents(getThreadEventBuffer())
+		{}
+
+		// False if the json ended before the type field was read
+		bool getHasInstance() const { return m_planReader.has_value(); }
+
+		// -- json_sax_t -----
+		bool null() override
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
+			if (m_planReader)
+				return m_planReader->null();
 
-			if (fieldJsonObject.is_number_integer())
-			{
-				int64_t value = fieldJsonObject.get<int64_t>();
+			return bufferValue(SaxEventType::Null);
+		}
 
-				accessor.setValueByType(value);
-			}
-			else
-			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitLong() ",
-							  "Int64 Accessor ", accessor.getName(),
-							  " was not a integer json value"));
-			}
+		bool boolean(bool val) override
+		{
+			if (m_planReader)
+				return m_planReader->boolean(val);
+
+			if (!bufferValue(SaxEventType::Boolean))
+				return false;
+
+			m_bufferedEvents.back().boolValue = val;
+			return true;
 		}
 
-		virtual void visitULong(ValueAccessor const& accessor)
+		bool number_integer(number_integer_t val) override
 		{
-			throw std::runtime_error(
-				stringify("JsonWriteVisitor::visitULong() ",
-						  "ULong Accessor ", accessor.getName(),
-						  " type not supported by all JSON libraries"));
+			if (m_planReader)
+				return m_planReader->number_integer(val);
+
+			const bool bIsTypeId = m_bTypeIdPending;
+			if (!bufferValue(SaxEventType::Integer))
+				return false;
+
+			m_bufferedEvents.back().intValue = val;
+			return !bIsTypeId || beginTypedInstance((int64_t)val);
 		}
 
-		virtual void visitFloat(ValueAccessor const& accessor) override
+		bool number_unsigned(number_unsigned_t val) override
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
+			if (m_planReader)
+				return m_planReader->number_unsigned(val);
 
-			if (fieldJsonObject.is_number_float())
-			{
-				float value = fieldJsonObject.get<float>();
+			const bool bIsTypeId = m_bTypeIdPending;
+			if (!bufferValue(SaxEventType::Unsigned))
+				return false;
 
-				accessor.setValueByType(value);
-			}
-			else
+			m_bufferedEvents.back().unsignedValue = val;
+			return !bIsTypeId || beginTypedInstance((int64_t)val);
+		}
+
+		bool number_float(number_float_t val, const string_t& s) override
+		{
+			if (m_planReader)
+				return m_planReader->number_float(val, s);
+
+			if (!bufferValue(SaxEventType::Float))
+				return false;
+
+			m_bufferedEvents.back().floatValue = val;
+			return true;
+		}
+
+		bool string(string_t& val) override
+		{
+			if (m_planReader)
+				return m_planReader->string(val);
+
+			if (!bufferValue(SaxEventType::String))
+				return false;
+
+			m_bufferedEvents.back().text = val;
+			return true;
+		}
+
+		bool binary(json::binary_t& val) override
+		{
+			return false;
+		}
+
+		bool start_object(std::size_t elements) override
+		{
+			if (m_planReader)
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitFloat() ",
-							  "Float Accessor ", accessor.getName(),
-							  " was not a float json value"));
+				++m_depth;
+				return m_planReader->start_object(elements);
 			}
+
+			if (!bufferValue(SaxEventType::StartObject))
+				return false;
+
+			m_bufferedEvents.back().elements = elements;
+			++m_depth;
+			return true;
 		}
 
-		virtual void visitDouble(ValueAccessor const& accessor) override
+		bool end_object() override
 		{
-			const json& fieldJsonObject= getJsonObjectFromAccessor(accessor);
-
-			if (fieldJsonObject.is_number_float())
+			if (m_planReader)
 			{
-				double value = fieldJsonObject.get<double>();
+				--m_depth;
+				return m_planReader->end_object();
+			}
+
+			// The root object ended without a type field
+			--m_depth;
+			return m_depth > 0 && bufferEvent(SaxEventType::EndObject);
+		}
 
-				accessor.setValueByType(value);
+		bool start_array(std::size_t elements) override
+		{
+			if (m_planReader)
+			{
+				++m_depth;
+				return m_planReader->start_array(elements);
 			}
-			else
+
+			// The root has to be an object
+			if (m_depth == 0 || !bufferValue(SaxEventType::StartArray))
+				return false;
+
+			m_bufferedEvents.back().elements = elements;
+			++m_depth;
+			return true;
+		}
+
+		bool end_array() override
+		{
+			if (m_planReader)
 			{
-				throw std::runtime_error(
-					stringify("JsonReadVisitor::visitDouble() ",
-							  "Double Accessor ", accessor.getName(),
-							  " was not a float json value"));
+				--m_depth;
+				return m_planReader->end_array();
 			}
+
+			--m_depth;
+			return bufferEvent(SaxEventType::EndArray);
+		}
+
+		bool key(string_t& val) override
+		{
+			// A second type field would overwrite the type of the already allocated instance
+			const bool bIsTypeIdKey = m_depth == 1 && val == m_typeIdFieldName;
+
+			if (m_planReader)
+				return !bIsTypeIdKey && m_planReader->key(val);
+
+			m_bTypeIdPending = bIsTypeIdKey;
+			if (!bufferEvent(SaxEventType::Key))
+				return false;
+
+			m_bufferedEvents.back().text = val;
+			return true;
+		}
+
+		bool parse_error(std::size_t position, const std::string& last_token, const json::exception& ex) override
+		{
+			if (m_planReader)
+				return m_planReader->parse_error(position, last_token, ex);
+
+			return false;
 		}
 
 	private:
-		const json& getJsonObjectFromAccessor(ValueAccessor const& accessor) const
+		enum class SaxEventType : uint8_t
+		{
+			Null,
+			Boolean,
+			Integer,
+			Unsigned,
+			Float,
+			String,
+			Key,
+			StartObject,
+			EndObject,
+			StartArray,
+			EndArray
+		};
+
+		struct SaxEvent
 		{
-			rfk::Field const* field = accessor.getField();
+			SaxEventType type;
+			bool boolValue= false;
+			int64_t intValue= 0;
+			uint64_t unsignedValue= 0;
+			double floatValue= 0.0;
+			std::size_t elements= 0;
+			std::string text;
+		};
+
+		// Kept per thread so that repeated parses don't reallocate the buffer
+		static std::vector<SaxEvent>& getThreadEventBuffer()
+		{
+			static thread_local std::vector<SaxEvent> eventBuffer;
 
-			if (field != nullptr)
-			{
-				char const* fieldName = field->getName();
+			eventBuffer.clear();
+			return eventBuffer;
+		}
 
-				if (!m_jsonObject.contains(fieldName))
-				{
-					throw std::runtime_error(stringify("Field ", field->getName(), " not found in json"));
-				}
+		bool bufferEvent(SaxEventType type)
+		{
+			m_bufferedEvents.emplace_back();
+			m_bufferedEvents.back().type = type;
+			return true;
+		}
+
+		// The value of the type field has to be an integer
+		bool bufferValue(SaxEventType type)
+		{
+			if (m_bTypeIdPending && type != SaxEventType::Integer && type != SaxEventType::Unsigned)
+				return false;
+
+			m_bTypeIdPending = false;
+			return bufferEvent(type);
+		}
+
+		bool beginTypedInstance(int64_t typeId)
+		{
+			rfk::Struct const* structType = nullptr;
+			void* instance = m_allocateInstance(typeId, structType);
+			if (instance == nullptr || structType == nullptr)
+				return false;
+
+			m_planReader.emplace(instance, getStructPlan(*structType));
 
-				return m_jsonObject[field->getName()];
+			// Catch the reader up on everything up to and including the type field
+			for (SaxEvent& event : m_bufferedEvents)
+			{
+				if (!replayEvent(event))
+					return false;
 			}
-			else
+
+			m_bufferedEvents.clear();
+			return true;
+		}
+
+		bool replayEvent(SaxEvent& event)
+		{
+			switch (event.type)
 			{
-				// The json object should contain the value we want to deserialize
-				return m_jsonObject;
+				case SaxEventType::Null:
+					return m_planReader->null();
+				case SaxEventType::Boolean:
+					return m_planReader->boolean(event.boolValue);
+				case SaxEventType::Integer:
+					return m_planReader->number_integer(event.intValue);
+				case SaxEventType::Unsigned:
+					return m_planReader->number_unsigned(event.unsignedValue);
+				case SaxEventType::Float:
+					return m_planReader->number_float(event.floatValue, event.text);
+				case SaxEventType::String:
+					return m_planReader->string(event.text);
+				case SaxEventType::Key:
+					return m_planReader->key(event.text);
+				case SaxEventType::StartObject:
+					return m_planReader->start_object(event.elements);
+				case SaxEventType::EndObject:
+					return m_planReader->end_object();
+				case SaxEventType::StartArray:
+					return m_planReader->start_array(event.elements);
+				case SaxEventType::EndArray:
+					return m_planReader->end_array();
 			}
+
+			return false;
 		}
 
-		const nlohmann::json& m_jsonObject;
+		const char* m_typeIdFieldName;
+		const JsonTypedInstanceAllocator& m_allocateInstance;
+		std::vector<SaxEvent>& m_bufferedEvents;
+		std::optional<JsonSaxPlanReader> m_planReader;
+		int m_depth= 0;
+		bool m_bTypeIdPending= false;
 	};
 
 	// Public API
 	bool deserializeFromJsonString(const std::string& jsonString, void* instance, rfk::Struct const& structType)
 	{
-		try
-		{
-			json jsonObject = json::parse(jsonString);
+		return deserializeFromJsonString(jsonString.data(), jsonString.size(), instance, structType);
+	}
 
-			return deserializeFromJson(jsonObject, instance, structType);
-		}
-		catch (json::parse_error* e)
-		{
-			return false;
-		}
+	bool deserializeFromJsonString(
+		const char* utf8JsonString,
+		std::size_t jsonLength,
+		void* instance,
+		rfk::Struct const& structType)
+	{
+		JsonSaxPlanReader saxReader(instance, getStructPlan(structType));
+
+		return json::sax_parse(utf8JsonString, utf8JsonString + jsonLength, &saxReader);
+	}
+
+	bool deserializeTypedFromJsonString(
+		const char* utf8JsonString,
+		std::size_t jsonLength,
+		const char* typeIdFieldName,
+		const JsonTypedInstanceAllocator& allocateInstance)
+	{
+		JsonSaxTypedReader saxReader(typeIdFieldName, allocateInstance);
+
+		return
+			json::sax_parse(utf8JsonString, utf8JsonString + jsonLength, &saxReader) &&
+			saxReader.getHasInstance();
 	}
 
 	bool deserializeFromJson(const nlohmann::json& jsonObject, void* instance, rfk::Struct const& structType)
 	{
 		try
 		{
-			JsonReadVisitor visitor(jsonObject);
-			Serialization::visitStruct(instance, structType, &visitor);
+			JsonPlanReader planReader;
+			planReader.readStruct(jsonObject, instance, getStructPlan(structType));
 
 			return true;
 		}
@@ -1,445 +1,493 @@
 #include "JsonSerializer.h"
+#include "SerializationPlan.h"
 #include "SerializationUtility.h"
 #include "SerializableList.h"
 #include "SerializableMap.h"
 #include "SerializableObjectPtr.h"
 #include "SerializableString.h"
-#include "SerializationProperty.h"
 
 #include "nlohmann/json.hpp"
 #include "Refureku/Refureku.h"
 
+#include <array>
+#include <charconv>
+#include <cmath>
+
 using json = nlohmann::json;
 
 namespace Serialization
 {
-	class JsonWriteVisitor : public IVisitor
+	class JsonPlanWriter
 	{
 	public:
-		JsonWriteVisitor(json& jsonObject) : m_jsonObject(jsonObject) {}
-
-		virtual void visitClass(ValueAccessor const& accessor) override
+		void writeStruct(const void* structInstance, StructPlan const& structPlan, json& outJsonObject)
 		{
-			rfk::Type const& fieldType = accessor.getType();
-			rfk::Class const* fieldClassType = accessor.getClassType();
-			rfk::EClassKind classKind = fieldClassType->getClassKind();
-
-			if (fieldType == rfk::getType<Serialization::String>())
-			{
-				visitString(accessor);
-			}
-			else if (fieldType == rfk::getType<Serialization::BoolList>())
+			for (FieldPlan const& fieldPlan : structPlan.fields)
 			{
-				visitBoolList(accessor, m_jsonObject);
+				writeValue(fieldPlan.getValuePtr(structInstance), fieldPlan.value, outJsonObject[fieldPlan.name]);
 			}
-			else if (fieldType == rfk::getType<Serialization::PolymorphicObjectPtr>())
+		}
+
+		void writeValue(const void* valuePtr, ValuePlan const& valuePlan, json& outJsonValue)
+		{
+			switch (valuePlan.kind)
 			{
-				visitObjectPtr(accessor, m_jsonObject);
+				case ValueKind::Bool:
+					outJsonValue = *reinterpret_cast<const bool*>(valuePtr);
+					break;
+				case ValueKind::Byte:
+					outJsonValue = *reinterpret_cast<const int8_t*>(valuePtr);
+					break;
+				case ValueKind::UByte:
+					outJsonValue = *reinterpret_cast<const uint8_t*>(valuePtr);
+					break;
+				case ValueKind::Short:
+					outJsonValue = *reinterpret_cast<const int16_t*>(valuePtr);
+					break;
+				case ValueKind::UShort:
+					outJsonValue = *reinterpret_cast<const uint16_t*>(valuePtr);
+					break;
+				case ValueKind::Int:
+					outJsonValue = *reinterpret_cast<const int32_t*>(valuePtr);
+					break;
+				case ValueKind::UInt:
+					outJsonValue = *reinterpret_cast<const uint32_t*>(valuePtr);
+					break;
+				case ValueKind::Long:
+					outJsonValue = *reinterpret_cast<const int64_t*>(valuePtr);
+					break;
+				case ValueKind::ULong:
+					throw std::runtime_error(
+						stringify("JsonPlanWriter::writeValue() ",
+								  "ULong Value ", valuePlan.name,
+								  " type not supported by all JSON libraries"));
+				case ValueKind::Float:
+					outJsonValue = *reinterpret_cast<const float*>(valuePtr);
+					break;
+				case ValueKind::Double:
+					outJsonValue = *reinterpret_cast<const double*>(valuePtr);
+					break;
+				case ValueKind::Enum:
+					writeEnum(valuePtr, valuePlan, outJsonValue);
+					break;
+				case ValueKind::String:
+					outJsonValue = reinterpret_cast<const Serialization::String*>(valuePtr)->getValue();
+					break;
+				case ValueKind::BoolList:
+					writeBoolList(valuePtr, outJsonValue);
+					break;
+				case ValueKind::ObjectPtr:
+					writeObjectPtr(valuePtr, valuePlan, outJsonValue);
+					break;
+				case ValueKind::List:
+					writeList(valuePtr, valuePlan, outJsonValue);
+					break;
+				case ValueKind::Map:
+					writeMap(valuePtr, valuePlan, outJsonValue);
+					break;
+				case ValueKind::Struct:
+					writeStruct(valuePtr, *valuePlan.structPlan, outJsonValue);
+					break;
 			}
-			else if (classKind == rfk::EClassKind::TemplateInstantiation)
-			{
-				const auto* templateClassInstanceType = rfk::classTemplateInstantiationCast(fieldClassType);
-				std::string templateTypeName = templateClassInstanceType->getClassTemplate().getName();
+		}
 
-				// See if the field is a Serialization::List<T>
-				if (templateTypeName == "List" &&
-						 templateClassInstanceType->getTemplateArgumentsCount() == 1)
-				{
-					visitList(accessor, *templateClassInstanceType, m_jsonObject);
-				}
-				// See if the field is a Serialization::Map<K,V>
-				else if (templateTypeName == "Map" &&
-						 templateClassInstanceType->getTemplateArgumentsCount() == 2)
-				{
-					visitMap(accessor, *templateClassInstanceType, m_jsonObject);
-				}
-				else
-				{
-					throw std::runtime_error(
-						stringify("JsonWriteVisitor::visitClass() ",
-								  "Class Field ", accessor.getName(),
-								  " was of expected type"));
+	private:
+		void writeEnum(const void* valuePtr, ValuePlan const& valuePlan, json& outJsonValue)
+		{
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
+			const int64_t enumIntValue = readEnumIntValue(valuePtr, enumPlan.memorySize);
 
-				}
-			}
-			else
+			EnumEntry const* enumEntry = enumPlan.findByValue(enumIntValue);
+			if (enumEntry == nullptr)
 			{
-				JsonWriteVisitor::visitStruct(accessor);
+				throw std::runtime_error(
+					stringify("JsonPlanWriter::writeEnum() ",
+							  "Enum Value ", valuePlan.name,
+							  " has an invalid int value ", enumIntValue));
 			}
+
+			outJsonValue = enumEntry->stringValue;
 		}
 
-		void visitObjectPtr(
-			ValueAccessor const& accessor,
-			json& ownerJsonObject)
+		void writeObjectPtr(const void* valuePtr, ValuePlan const& valuePlan, json& outJsonValue)
 		{
-			// Get the shared pointer instance
-			const void* objPtrInstance = accessor.getUntypedValuePtr();
-			rfk::Class const* objPtrClassType = accessor.getClassType();
-
-			// Use reflection to get the runtime class id of the object pointed at
-			rfk::Method const* getRuntimeClassIdMethod = 
-				objPtrClassType->getMethodByName(
-					"getRuntimeClassId", rfk::EMethodFlags::Default, true);
-			const Serialization::RfkClassId rfkClassId= 
-				getRuntimeClassIdMethod->invokeUnsafe<std::size_t>(objPtrInstance);
-			const Serialization::MikanClassId mikanClassId=
-				Serialization::toMikanClassId(rfkClassId);
-
-			// Get the runtime class for the object
-			rfk::Struct const* objectStruct = rfk::getDatabase().getStructById(rfkClassId);
-			if (objectStruct == nullptr)
+			const auto* objectPtr = reinterpret_cast<const Serialization::PolymorphicObjectPtr*>(valuePtr);
+
+			// Get the runtime class of the object pointed at
+			const Serialization::RfkClassId rfkClassId = objectPtr->getRuntimeClassId();
+			const Serialization::MikanClassId mikanClassId = Serialization::toMikanClassId(rfkClassId);
+			StructPlan const* objectPlan = getStructPlanById(rfkClassId);
+			if (objectPlan == nullptr)
 			{
 				throw std::runtime_error(
-					stringify("JsonWriteVisitor::visitObjectPtr() ",
-							  "TypedObjectPtr Accessor ", accessor.getName(),
+					stringify("JsonPlanWriter::writeObjectPtr() ",
+							  "TypedObjectPtr Value ", valuePlan.name,
 							  " has an invalid class id ", rfkClassId));
 			}
 
-			// Get the type of the elements in the array from the template argument
-			std::string className = objectStruct->getName();
-
-			// Resize the array to the desired target size
-			json objectPtrJson = json::object();
-
-			// Write the runtime class id of the object
-			objectPtrJson["class_name"] = className;
-			objectPtrJson["class_id"] = mikanClassId;
-
-			// Get the raw pointer to the object pointed to by the shared pointer
-			rfk::Method const* getRawPtrMethod = 
-				objPtrClassType->getMethodByName(
-					"getRawPtr", rfk::EMethodFlags::Default, true);
-			const void* objectInstance = getRawPtrMethod->invokeUnsafe<const void*>(objPtrInstance);
+			// Write the runtime class of the object
+			outJsonValue = json::object();
+			outJsonValue["class_name"] = objectPlan->structName;
+			outJsonValue["class_id"] = mikanClassId;
 
 			// Serialize the object into json
-			json objectJson = json::object();
+			json& objectJson = outJsonValue["value"];
+			objectJson = json::object();
+
+			const void* objectInstance = objectPtr->getRawPtr();
 			if (objectInstance != nullptr)
 			{
-				JsonWriteVisitor elementVisitor(objectJson);
-				Serialization::visitStruct(objectInstance, *objectStruct, &elementVisitor);
+				writeStruct(objectInstance, *objectPlan, objectJson);
 			}
-
-			// Add the child serialized object
-			objectPtrJson["value"] = objectJson;
-
-			// Add the json array to the owner json object
-			ownerJsonObject[accessor.getName()] = objectPtrJson;
 		}
 
-		void visitBoolList(
-			ValueAccessor const& arrayAccessor,
-			json& ownerJsonObject)
+		void writeBoolList(const void* valuePtr, json& outJsonValue)
 		{
-			const auto& boolListWrapper = arrayAccessor.getTypedValueRef<Serialization::BoolList>();
-			const auto& boolList = boolListWrapper.getVector();
-			std::size_t arraySize = boolList.size();
-			
-			json arrayJson = json::array();
-			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
+			const auto& boolList = reinterpret_cast<const Serialization::BoolList*>(valuePtr)->getVector();
+
+			outJsonValue = json::array();
+			for (size_t elementIndex = 0; elementIndex < boolList.size(); ++elementIndex)
 			{
-				arrayJson.push_back(boolList[elementIndex]);
+				outJsonValue.push_back((bool)boolList[elementIndex]);
 			}
-
-			// Add the json array to the owner json object
-			ownerJsonObject[arrayAccessor.getName()] = arrayJson;
 		}
 
-		void visitList(
-			ValueAccessor const& arrayAccessor,
-			rfk::ClassTemplateInstantiation const& templatedArrayType,
-			json& ownerJsonObject)
+		void writeList(const void* arrayInstance, ValuePlan const& valuePlan, json& outJsonValue)
 		{
-			void* arrayInstance = arrayAccessor.getUntypedValueMutablePtr();
-
-			// Get the type of the elements in the array from the template argument
-			auto const& templateArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedArrayType.getTemplateArgumentAt(0));
-			rfk::Type const& elementType = templateArg.getType();
-
-			// Use reflection to get the methods to resize the array and get a mutable reference to an element
-			rfk::Method const* getSizeMethod = templatedArrayType.getMethodByName("size");
-			rfk::Method const* getRawElementMethod = templatedArrayType.getMethodByName("getRawElement");
-
-			// Resize the array to the desired target size
-			std::size_t arraySize = getSizeMethod->invokeUnsafe<std::size_t>(arrayInstance, arraySize);
-			json arrayJson = json::array();
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
+			const std::size_t arraySize = valuePlan.sizeMethod->invokeUnsafe<std::size_t>(arrayInstance);
 
-			// Serialize each element of the array
+			outJsonValue = json::array();
 			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
 			{
-				// Get the target element instance in the array
 				const void* elementInstance =
-					getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
+					valuePlan.getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
 						arrayInstance, elementIndex);
 
-				// Make a fake "field" for an element in the array
-				ValueAccessor elementAccessor(elementInstance, elementType);
-
-				// Serialize the element into the json object
 				json elementJson;
-				JsonWriteVisitor elementVisitor(elementJson);
-				Serialization::visitValue(elementAccessor, &elementVisitor);
-
-				// Add the json element to the json array
-				arrayJson.push_back(elementJson);
+				writeValue(elementInstance, elementPlan, elementJson);
+				outJsonValue.push_back(std::move(elementJson));
 			}
-
-			// Add the json array to the owner json object
-			ownerJsonObject[arrayAccessor.getName()] = arrayJson;
 		}
 
-		void visitMap(
-			ValueAccessor const& mapAccessor,
-			rfk::ClassTemplateInstantiation const& templatedMapType,
-			json& ownerJsonObject)
+		void writeMap(const void* mapInstance, ValuePlan const& valuePlan, json& outJsonValue)
 		{
-			// Get the key type of the map from the template argument
-			auto const& templateKeyArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedMapType.getTemplateArgumentAt(0));
-			rfk::Type const& keyType = templateKeyArg.getType();
-
-			if (keyType == rfk::getType<int32_t>())
-			{
-				visitMapOfKey<int32_t>(mapAccessor, templatedMapType, ownerJsonObject);
-			}
-			else if (keyType == rfk::getType<std::string>())
-			{
-				visitMapOfKey<std::string>(mapAccessor, templatedMapType, ownerJsonObject);
-			}
-			else
-			{
-				rfk::Archetype const* keyArchetype = keyType.getArchetype();
+			ValuePlan const& mapValuePlan = *valuePlan.elementPlan;
 
-				throw std::runtime_error(
-					stringify("JsonWriteVisitor::visitMap() ",
-							  "Map Key Archetype ", keyArchetype != nullptr ? keyArchetype->getName() : "<Null Archetype>",
-							  " is not supported"));
-			}
-		}
-
-		template<typename t_key>
-		void visitMapOfKey(
-			ValueAccessor const& mapAccessor,
-			rfk::ClassTemplateInstantiation const& templatedMapType,
-			json& ownerJsonObject)
-		{
-			// Get the type of the elements in the array from the template argument
-			auto const& templateValueArg =
-				static_cast<rfk::TypeTemplateArgument const&>(
-					templatedMapType.getTemplateArgumentAt(1));
-			rfk::Type const& valueType = templateValueArg.getType();
-
-			// Use reflection to get the method used to enumerate key-value pairs in the map
-			rfk::Method const* getConstEnumeratorMethod = templatedMapType.getMethodByName("getConstEnumerator");
-
-			// Get a const enumerator to the map
-			void* mapInstance = mapAccessor.getUntypedValueMutablePtr();
-
-			// Serialize each element of the map
-			json arrayJson = json::array();
-			for (auto enumerator = 
-					getConstEnumeratorMethod->invokeUnsafe<std::shared_ptr<IMapConstEnumerator>>(mapInstance);
-				enumerator->isValid();
-				enumerator->next())
+			outJsonValue = json::array();
+			for (auto enumerator =
+				 valuePlan.getConstEnumeratorMethod->invokeUnsafe<std::shared_ptr<IMapConstEnumerator>>(mapInstance);
+				 enumerator->isValid();
+				 enumerator->next())
 			{
 				json pairJson;
 
 				// Serialize the key
 				const void* rawKey = enumerator->getKeyRaw();
-				pairJson["key"] = *reinterpret_cast<const t_key *>(rawKey);
+				if (valuePlan.mapKeyKind == ValueKind::Int)
+				{
+					pairJson["key"] = *reinterpret_cast<const int32_t*>(rawKey);
+				}
+				else
+				{
+					pairJson["key"] = *reinterpret_cast<const std::string*>(rawKey);
+				}
 
 				// Serialize the value
-				json valueJson;
-				const void* rawValue = enumerator->getValueRaw();
-				ValueAccessor valueAccessor(rawValue, valueType);
-				JsonWriteVisitor valueVisitor(valueJson);
-				Serialization::visitValue(valueAccessor, &valueVisitor);
-				pairJson["value"]= valueJson;
-
-				// Add the key-value json object to the json array
-				arrayJson.push_back(pairJson);
-			}
+				writeValue(enumerator->getValueRaw(), mapValuePlan, pairJson["value"]);
 
-			// Add the json map-array to the owner json object
-			ownerJsonObject[mapAccessor.getName()] = arrayJson;
+				outJsonValue.push_back(std::move(pairJson));
+			}
 		}
+	};
 
-		virtual void visitStruct(ValueAccessor const& accessor) override
-		{
-			const void* childObjectInstance = accessor.getUntypedValuePtr();
-			rfk::Struct const* structType = accessor.getStructType();
-			rfk::Field const* field = accessor.getField();
-
-			if (field != nullptr)
-			{
-				char const* fieldName = field->getName();
-				json childJsonObject;
-				JsonWriteVisitor jsonVisitor(childJsonObject);
-				Serialization::visitStruct(childObjectInstance, *structType, &jsonVisitor);
+	// Writes a plan straight into a string, producing exactly what nlohmann::json::dump()
+	// would produce for the DOM built by JsonPlanWriter, without allocating the DOM
+	class JsonPlanStreamWriter
+	{
+	public:
+		JsonPlanStreamWriter(std::string& outJsonString) : m_out(outJsonString) {}
 
-				m_jsonObject[fieldName] = childJsonObject;
-			}
-			else
+		void writeStruct(const void* structInstance, StructPlan const& structPlan)
+		{
+			// A struct with no fields never creates any keys, so the DOM value stays null
+			if (structPlan.jsonFieldOrder.empty())
 			{
-				Serialization::visitStruct(childObjectInstance, *structType, this);
+				m_out.append("null", 4);
+				return;
 			}
 
+			writeStructObject(structInstance, structPlan);
 		}
 
-		virtual void visitEnum(ValueAccessor const& accessor) override
+		void writeValue(const void* valuePtr, ValuePlan const& valuePlan)
 		{
-			rfk::Enum const& enumType = *accessor.getEnumType();
-			rfk::Archetype const& enumArchetype = enumType.getUnderlyingArchetype();
-			const void *untypedValue= accessor.getUntypedValuePtr();
-
-			int64_t enumIntValue = 0;
-			if (enumArchetype.getMemorySize() == sizeof(int64_t))
-			{
-				enumIntValue = *reinterpret_cast<const int64_t*>(untypedValue);
-			}
-			else if (enumArchetype.getMemorySize() == sizeof(int32_t))
-			{
-				enumIntValue = (int64_t)(*reinterpret_cast<const int32_t*>(untypedValue));
-			}
-			else if (enumArchetype.getMemorySize() == sizeof(int16_t))
-			{
-				enumIntValue = (int64_t)(*reinterpret_cast<const int16_t*>(untypedValue));
-			}
-			else if (enumArchetype.getMemorySize() == sizeof(int8_t))
-			{
-				enumIntValue = (int64_t)(*reinterpret_cast<const int8_t*>(untypedValue));
-			}
-			else
+			switch (valuePlan.kind)
 			{
-				throw std::runtime_error(
-					stringify("JsonWriteVisitor::visitEnum() ",
-							  "Enum Accessor ", accessor.getName(),
-							  " has an invalid memory size ", enumArchetype.getMemorySize()));
+				case ValueKind::Bool:
+					writeBool(*reinterpret_cast<const bool*>(valuePtr));
+					break;
+				case ValueKind::Byte:
+					writeInteger(*reinterpret_cast<const int8_t*>(valuePtr));
+					break;
+				case ValueKind::UByte:
+					writeInteger(*reinterpret_cast<const uint8_t*>(valuePtr));
+					break;
+				case ValueKind::Short:
+					writeInteger(*reinterpret_cast<const int16_t*>(valuePtr));
+					break;
+				case ValueKind::UShort:
+					writeInteger(*reinterpret_cast<const uint16_t*>(valuePtr));
+					break;
+				case ValueKind::Int:
+					writeInteger(*reinterpret_cast<const int32_t*>(valuePtr));
+					break;
+				case ValueKind::UInt:
+					writeInteger(*reinterpret_cast<const uint32_t*>(valuePtr));
+					break;
+				case ValueKind::Long:
+					writeInteger(*reinterpret_cast<const int64_t*>(valuePtr));
+					break;
+				case ValueKind::ULong:
+					throw std::runtime_error(
+						stringify("JsonPlanStreamWriter::writeValue() ",
+								  "ULong Value ", valuePlan.name,
+								  " type not supported by all JSON libraries"));
+				case ValueKind::Float:
+					writeFloat(*reinterpret_cast<const float*>(valuePtr));
+					break;
+				case ValueKind::Double:
+					writeFloat(*reinterpret_cast<const double*>(valuePtr));
+					break;
+				case ValueKind::Enum:
+					writeEnum(valuePtr, valuePlan);
+					break;
+				case ValueKind::String:
+					writeString(reinterpret_cast<const Serialization::String*>(valuePtr)->getValue());
+					break;
+				case ValueKind::BoolList:
+					writeBoolList(valuePtr);
+					break;
+				case ValueKind::ObjectPtr:
+					writeObjectPtr(valuePtr, valuePlan);
+					break;
+				case ValueKind::List:
+					writeList(valuePtr, valuePlan);
+					break;
+				case ValueKind::Map:
+					writeMap(valuePtr, valuePlan);
+					break;
+				case ValueKind::Struct:
+					writeStruct(valuePtr, *valuePlan.structPlan);
+					break;
 			}
+		}
 
+	private:
+		void writeStructObject(const void* structInstance, StructPlan const& structPlan)
+		{
+			m_out.push_back('{');
 
-			rfk::EnumValue const* enumValue = enumType.getEnumValue(enumIntValue);
-			if (enumValue == nullptr)
+			bool bFirst = true;
+			for (std::size_t fieldIndex : structPlan.jsonFieldOrder)
 			{
-				throw std::runtime_error(
-					stringify("JsonWriteVisitor::visitEnum() ",
-							  "Enum Accessor ", accessor.getName(),
-							  " has an invalid int value ", enumIntValue));
-			}
+				FieldPlan const& fieldPlan = structPlan.fields[fieldIndex];
 
-			std::string enumValueString= Serialization::getEnumStringValue(*enumValue);
-			rfk::Field const* field = accessor.getField();
-			if (field != nullptr)
-			{
-				char const* fieldName = field->getName();
+				if (!bFirst)
+					m_out.push_back(',');
+				bFirst = false;
 
-				m_jsonObject[fieldName] = enumValueString;
+				writeString(fieldPlan.name);
+				m_out.push_back(':');
+				writeValue(fieldPlan.getValuePtr(structInstance), fieldPlan.value);
 			}
-			else
-			{
-				m_jsonObject = enumValueString;
-			}
-		}
 
-		virtual void visitBool(ValueAccessor const& accessor) override
-		{
-			setJsonValueFromAccessor<bool>(accessor);
+			m_out.push_back('}');
 		}
 
-		virtual void visitByte(ValueAccessor const& accessor) override
+		void writeBool(bool value)
 		{
-			setJsonValueFromAccessor<int8_t>(accessor);
+			if (value)
+				m_out.append("true", 4);
+			else
+				m_out.append("false", 5);
 		}
 
-		virtual void visitUByte(ValueAccessor const& accessor) override
+		template <typename t_integer>
+		void writeInteger(t_integer value)
 		{
-			setJsonValueFromAccessor<uint8_t>(accessor);
-		}
+			char buffer[24];
+			auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
 
-		virtual void visitShort(ValueAccessor const& accessor) override
-		{
-			setJsonValueFromAccessor<int16_t>(accessor);
+			m_out.append(buffer, result.ptr - buffer);
 		}
 
-		virtual void visitUShort(ValueAccessor const& accessor) override
+		void writeFloat(double value)
 		{
-			setJsonValueFromAccessor<uint16_t>(accessor);
-		}
+			// Floats are stored as doubles in the DOM, so format them the same way dump() does
+			if (!std::isfinite(value))
+			{
+				m_out.append("null", 4);
+				return;
+			}
 
-		virtual void visitInt(ValueAccessor const& accessor) override
-		{
-			setJsonValueFromAccessor<int32_t>(accessor);
-		}
+			std::array<char, 64> buffer;
+			char* end = nlohmann::detail::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
 
-		virtual void visitUInt(ValueAccessor const& accessor) override
-		{
-			setJsonValueFromAccessor<uint32_t>(accessor);
+			m_out.append(buffer.data(), end - buffer.data());
 		}
 
-		virtual void visitLong(ValueAccessor const& accessor) override
+		void writeString(const std::string& value)
 		{
-			setJsonValueFromAccessor<int64_t>(accessor);
-		}
+			// Common case: printable ASCII with nothing to escape
+			bool bNeedsEscaping = false;
+			for (char c : value)
+			{
+				const unsigned char uc = static_cast<unsigned char>(c);
 
-		virtual void visitULong(ValueAccessor const& accessor)
-		{
-			throw std::runtime_error(
-				stringify("JsonWriteVisitor::visitULong() ",
-						  "ULong Accessor ", accessor.getName(),
-						  " type not supported by all JSON libraries"));
-		}
+				if (uc < 0x20 || uc >= 0x80 || c == '"' || c == '\\')
+				{
+					bNeedsEscaping = true;
+					break;
+				}
+			}
 
-		virtual void visitFloat(ValueAccessor const& accessor) override
-		{
-			setJsonValueFromAccessor<float>(accessor);
+			if (bNeedsEscaping)
+			{
+				// Let nlohmann handle escaping and utf-8 validation so the output (and errors) match dump()
+				m_out.append(json(value).dump());
+			}
+			else
+			{
+				m_out.push_back('"');
+				m_out.append(value);
+				m_out.push_back('"');
+			}
 		}
 
-		virtual void visitDouble(ValueAccessor const& accessor) override
+		void writeEnum(const void* valuePtr, ValuePlan const& valuePlan)
 		{
-			setJsonValueFromAccessor<double>(accessor);
+			EnumPlan const& enumPlan = *valuePlan.enumPlan;
+			const int64_t enumIntValue = readEnumIntValue(valuePtr, enumPlan.memorySize);
+
+			EnumEntry const* enumEntry = enumPlan.findByValue(enumIntValue);
+			if (enumEntry == nullptr)
+			{
+				throw std::runtime_error(
+					stringify("JsonPlanStreamWriter::writeEnum() ",
+							  "Enum Value ", valuePlan.name,
+							  " has an invalid int value ", enumIntValue));
+			}
+
+			writeString(enumEntry->stringValue);
 		}
 
-	private:
-		void visitString(ValueAccessor const& accessor) const
+		void writeObjectPtr(const void* valuePtr, ValuePlan const& valuePlan)
 		{
-			rfk::Field const* field = accessor.getField();
-			const auto* stringPtr = accessor.getTypedValuePtr<Serialization::String>();
+			const auto* objectPtr = reinterpret_cast<const Serialization::PolymorphicObjectPtr*>(valuePtr);
 
-			if (field != nullptr)
+			// Get the runtime class of the object pointed at
+			const Serialization::RfkClassId rfkClassId = objectPtr->getRuntimeClassId();
+			const Serialization::MikanClassId mikanClassId = Serialization::toMikanClassId(rfkClassId);
+			StructPlan const* objectPlan = getStructPlanById(rfkClassId);
+			if (objectPlan == nullptr)
 			{
-				char const* fieldName = field->getName();
+				throw std::runtime_error(
+					stringify("JsonPlanStreamWriter::writeObjectPtr() ",
+							  "TypedObjectPtr Value ", valuePlan.name,
+							  " has an invalid class id ", rfkClassId));
+			}
+
+			// Keys in sorted order: class_id, class_name, value
+			m_out.append("{\"class_id\":");
+			writeInteger(mikanClassId);
+			m_out.append(",\"class_name\":");
+			writeString(objectPlan->structName);
+			m_out.append(",\"value\":");
 
-				m_jsonObject[fieldName] = stringPtr->getValue();
+			// The value is always an object here, even for a null pointer or an empty struct
+			const void* objectInstance = objectPtr->getRawPtr();
+			if (objectInstance != nullptr && !objectPlan->jsonFieldOrder.empty())
+			{
+				writeStructObject(objectInstance, *objectPlan);
 			}
 			else
 			{
-				// The json object should contain the value we want to deserialize
-				m_jsonObject = stringPtr->getValue();
+				m_out.append("{}", 2);
 			}
+
+			m_out.push_back('}');
 		}
 
-		template<typename T>
-		void setJsonValueFromAccessor(ValueAccessor const& accessor) const
+		void writeBoolList(const void* valuePtr)
 		{
-			rfk::Field const* field = accessor.getField();
+			const auto& boolList = reinterpret_cast<const Serialization::BoolList*>(valuePtr)->getVector();
 
-			if (field != nullptr)
+			m_out.push_back('[');
+			for (size_t elementIndex = 0; elementIndex < boolList.size(); ++elementIndex)
 			{
-				char const* fieldName = field->getName();
+				if (elementIndex > 0)
+					m_out.push_back(',');
 
-				m_jsonObject[fieldName] = *accessor.getTypedValuePtr<T>();
+				writeBool(boolList[elementIndex]);
 			}
-			else
+			m_out.push_back(']');
+		}
+
+		void writeList(const void* arrayInstance, ValuePlan const& valuePlan)
+		{
+			ValuePlan const& elementPlan = *valuePlan.elementPlan;
+			const std::size_t arraySize = valuePlan.sizeMethod->invokeUnsafe<std::size_t>(arrayInstance);
+
+			m_out.push_back('[');
+			for (size_t elementIndex = 0; elementIndex < arraySize; ++elementIndex)
 			{
+				const void* elementInstance =
+					valuePlan.getRawElementMethod->invokeUnsafe<const void*, const std::size_t&>(
+						arrayInstance, elementIndex);
 
-				// The json object should contain the value we want to deserialize
-				m_jsonObject = *accessor.getTypedValuePtr<T>();
+				if (elementIndex > 0)
+					m_out.push_back(',');
+
+				writeValue(elementInstance, elementPlan);
 			}
+			m_out.push_back(']');
 		}
 
-		nlohmann::json& m_jsonObject;
+		void writeMap(const void* mapInstance, ValuePlan const& valuePlan)
+		{
+			ValuePlan const& mapValuePlan = *valuePlan.elementPlan;
+			bool bFirst = true;
+
+			m_out.push_back('[');
+			for (auto enumerator =
+				 valuePlan.getConstEnumeratorMethod->invokeUnsafe<std::shared_ptr<IMapConstEnumerator>>(mapInstance);
+				 enumerator->isValid();
+				 enumerator->next())
+			{
+				if (!bFirst)
+					m_out.push_back(',');
+				bFirst = false;
+
+				m_out.append("{\"key\":");
+				const void* rawKey = enumerator->getKeyRaw();
+				if (valuePlan.mapKeyKind == ValueKind::Int)
+				{
+					writeInteger(*reinterpret_cast<const int32_t*>(rawKey));
+				}
+				else
+				{
+					writeString(*reinterpret_cast<const std::string*>(rawKey));
+				}
+
+				m_out.append(",\"value\":");
+				writeValue(enumerator->getValueRaw(), mapValuePlan);
+				m_out.push_back('}');
+			}
+			m_out.push_back(']');
+		}
+
+		std::string& m_out;
 	};
 
 	// Public API
@@ -447,17 +495,15 @@ namespace Serialization
 	{
 		try
 		{
-			json jsonObject;
+			// Clearing keeps the string's capacity, so callers can reuse one buffer across calls
+			jsonString.clear();
 
-			if (serializeToJson(instance, structType, jsonObject))
-			{
-				jsonString = jsonObject.dump();
-				return true;
-			}
+			JsonPlanStreamWriter streamWriter(jsonString);
+			streamWriter.writeStruct(instance, getStructPlan(structType));
 
-			return false;
+			return true;
 		}
-		catch (json::parse_error* e)
+		catch (std::runtime_error* e)
 		{
 			return false;
 		}
@@ -467,8 +513,8 @@ namespace Serialization
 	{
 		try
 		{
-			JsonWriteVisitor visitor(jsonObject);
-			Serialization::visitStruct(const_cast<void *>(instance), structType, &visitor);
+			JsonPlanWriter planWriter;
+			planWriter.writeStruct(instance, getStructPlan(structType), jsonObject);
 
 			return true;
 		}
@@ -43,6 +43,11 @@ namespace Serialization
 	{
 		m_pimpl->value= string;
 	}
+
+	void String::setValue(const char* chars, std::size_t length)
+	{
+		m_pimpl->value.assign(chars, length);
+	}
 	const std::string& String::getValue() const
 	{
 		return m_pimpl->value;
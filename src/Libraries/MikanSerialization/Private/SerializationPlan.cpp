@@ -0,0 +1,433 @@
+#include "SerializationPlan.h"
+#include "SerializationUtility.h"
+#include "BinaryUtility.h"
+#include "SerializationVisitor.h"
+#include "SerializableList.h"
+#include "SerializableMap.h"
+#include "SerializableString.h"
+#include "SerializationProperty.h"
+
+#include "Refureku/Refureku.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace Serialization
+{
+	// -- EnumPlan -----
+	EnumEntry const* EnumPlan::findByValue(int64_t value) const
+	{
+		for (EnumEntry const& entry : entries)
+		{
+			if (entry.value == value)
+				return &entry;
+		}
+
+		return nullptr;
+	}
+
+	EnumEntry const* EnumPlan::findByString(const char* stringValue) const
+	{
+		// Same precedence as findEnumValueByString():
+		// EnumStringValue properties first, then fall back to the enum value name
+		for (EnumEntry const& entry : entries)
+		{
+			if (entry.hasStringProperty && entry.stringValue == stringValue)
+				return &entry;
+		}
+
+		for (EnumEntry const& entry : entries)
+		{
+			if (entry.name == stringValue)
+				return &entry;
+		}
+
+		return nullptr;
+	}
+
+	bool isHostLittleEndian()
+	{
+		static const bool s_isLittleEndian = get_system_endianness() == Endian::Little;
+
+		return s_isLittleEndian;
+	}
+
+	int64_t readEnumIntValue(const void* enumValuePtr, std::size_t memorySize)
+	{
+		switch (memorySize)
+		{
+			case sizeof(int64_t):
+				return *reinterpret_cast<const int64_t*>(enumValuePtr);
+			case sizeof(int32_t):
+				return (int64_t)(*reinterpret_cast<const int32_t*>(enumValuePtr));
+			case sizeof(int16_t):
+				return (int64_t)(*reinterpret_cast<const int16_t*>(enumValuePtr));
+			case sizeof(int8_t):
+				return (int64_t)(*reinterpret_cast<const int8_t*>(enumValuePtr));
+		}
+
+		throw std::runtime_error(stringify("readEnumIntValue() invalid enum memory size ", memorySize));
+	}
+
+	void writeEnumIntValue(void* enumValuePtr, std::size_t memorySize, int64_t value)
+	{
+		switch (memorySize)
+		{
+			case sizeof(int64_t):
+				*reinterpret_cast<int64_t*>(enumValuePtr) = value;
+				return;
+			case sizeof(int32_t):
+				*reinterpret_cast<int32_t*>(enumValuePtr) = (int32_t)value;
+				return;
+			case sizeof(int16_t):
+				*reinterpret_cast<int16_t*>(enumValuePtr) = (int16_t)value;
+				return;
+			case sizeof(int8_t):
+				*reinterpret_cast<int8_t*>(enumValuePtr) = (int8_t)value;
+				return;
+		}
+
+		throw std::runtime_error(stringify("writeEnumIntValue() invalid enum memory size ", memorySize));
+	}
+
+	// -- Plan Compilation -----
+	class StructPlanCache
+	{
+	public:
+		StructPlan const& getOrCompile(rfk::Struct const& structType)
+		{
+			std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+			auto it = m_plans.find(structType.getId());
+			if (it != m_plans.end())
+			{
+				return *it->second;
+			}
+
+			// Register the plan before compiling its fields so that
+			// self referential types resolve to the in-progress plan
+			StructPlan* plan = new StructPlan;
+			plan->structType = &structType;
+			plan->structName = structType.getName();
+			m_plans.insert({structType.getId(), std::unique_ptr<StructPlan>(plan)});
+
+			try
+			{
+				compileStructFields(structType, *plan);
+			}
+			catch (...)
+			{
+				m_plans.erase(structType.getId());
+				throw;
+			}
+
+			return *plan;
+		}
+
+	private:
+		void compileStructFields(rfk::Struct const& structType, StructPlan& outPlan)
+		{
+			FieldList fields;
+			memoryOffsetSortStructFields(structType, fields);
+
+			outPlan.fields.resize(fields.size());
+			for (size_t fieldIndex = 0; fieldIndex < fields.size(); ++fieldIndex)
+			{
+				rfk::Field const* field = fields[fieldIndex];
+				FieldPlan& fieldPlan = outPlan.fields[fieldIndex];
+
+				fieldPlan.name = field->getName();
+				fieldPlan.field = field;
+				fieldPlan.memoryOffset = field->getMemoryOffset();
+				compileValuePlan(field->getType(), fieldPlan.name, fieldPlan.value);
+			}
+
+			outPlan.blittableSize = computeStructBlittableSize(structType, outPlan);
+			outPlan.jsonFieldOrder = computeJsonFieldOrder(outPlan);
+		}
+
+		std::vector<std::size_t> computeJsonFieldOrder(StructPlan const& structPlan)
+		{
+			// nlohmann::json objects keep their keys sorted, and a field that shadows
+			// a parent field of the same name overwrites it (the last one written wins)
+			std::map<std::string, std::size_t> sortedFieldIndices;
+			for (std::size_t fieldIndex = 0; fieldIndex < structPlan.fields.size(); ++fieldIndex)
+			{
+				sortedFieldIndices[structPlan.fields[fieldIndex].name] = fieldIndex;
+			}
+
+			std::vector<std::size_t> fieldOrder;
+			fieldOrder.reserve(sortedFieldIndices.size());
+			for (const auto& pair : sortedFieldIndices)
+			{
+				fieldOrder.push_back(pair.second);
+			}
+
+			return fieldOrder;
+		}
+
+		std::size_t computeStructBlittableSize(rfk::Struct const& structType, StructPlan const& structPlan)
+		{
+			// A struct can only be block copied if its fields are all blittable
+			// and are packed back to back with no padding anywhere in the struct
+			std::size_t packedSize = 0;
+			for (FieldPlan const& fieldPlan : structPlan.fields)
+			{
+				if (fieldPlan.value.blittableSize == 0 || fieldPlan.memoryOffset != packedSize)
+				{
+					return 0;
+				}
+
+				packedSize += fieldPlan.value.blittableSize;
+			}
+
+			return (packedSize > 0 && packedSize == structType.getMemorySize()) ? packedSize : 0;
+		}
+
+		void compileValuePlan(rfk::Type const& type, const std::string& name, ValuePlan& outPlan)
+		{
+			rfk::Archetype const* archetype = type.getArchetype();
+			rfk::EEntityKind archetypeKind = archetype ? archetype->getKind() : rfk::EEntityKind::Undefined;
+
+			outPlan.type = &type;
+			outPlan.name = name;
+
+			if (archetypeKind == rfk::EEntityKind::Class)
+			{
+				rfk::Class const* classType = rfk::classCast(archetype);
+				if (classType == nullptr)
+				{
+					throw std::runtime_error(stringify("Value ", name, " was not an class type"));
+				}
+
+				compileClassValuePlan(*classType, outPlan);
+			}
+			else if (archetypeKind == rfk::EEntityKind::Struct)
+			{
+				rfk::Struct const* structType = rfk::structCast(archetype);
+				if (structType == nullptr)
+				{
+					throw std::runtime_error(stringify("Value ", name, " was not a struct type"));
+				}
+
+				outPlan.kind = ValueKind::Struct;
+				outPlan.structPlan = &getOrCompile(*structType);
+				outPlan.blittableSize = outPlan.structPlan->blittableSize;
+			}
+			else if (archetypeKind == rfk::EEntityKind::Enum)
+			{
+				rfk::Enum const* enumType = rfk::enumCast(archetype);
+				if (enumType == nullptr)
+				{
+					throw std::runtime_error(stringify("Value ", name, " was not an enum type"));
+				}
+
+				outPlan.kind = ValueKind::Enum;
+				outPlan.enumPlan = compileEnumPlan(*enumType, name);
+			}
+			else if (archetypeKind == rfk::EEntityKind::FundamentalArchetype)
+			{
+				if (type == rfk::getType<bool>())
+					outPlan.kind = ValueKind::Bool;
+				else if (type == rfk::getType<uint8_t>())
+					outPlan.kind = ValueKind::UByte;
+				else if (type == rfk::getType<int8_t>())
+					outPlan.kind = ValueKind::Byte;
+				else if (type == rfk::getType<uint16_t>())
+					outPlan.kind = ValueKind::UShort;
+				else if (type == rfk::getType<int16_t>())
+					outPlan.kind = ValueKind::Short;
+				else if (type == rfk::getType<uint32_t>())
+					outPlan.kind = ValueKind::UInt;
+				else if (type == rfk::getType<int32_t>())
+					outPlan.kind = ValueKind::Int;
+				else if (type == rfk::getType<uint64_t>())
+					outPlan.kind = ValueKind::ULong;
+				else if (type == rfk::getType<int64_t>())
+					outPlan.kind = ValueKind::Long;
+				else if (type == rfk::getType<float>())
+					outPlan.kind = ValueKind::Float;
+				else if (type == rfk::getType<double>())
+					outPlan.kind = ValueKind::Double;
+				else
+					throw std::runtime_error(stringify("Value ", name, " has unsupported type"));
+
+				// Every numeric value is written as its raw little-endian bytes.
+				// Bools are excluded since they are normalized to 0/1 when read.
+				if (outPlan.kind != ValueKind::Bool)
+				{
+					outPlan.blittableSize = archetype->getMemorySize();
+				}
+			}
+			else
+			{
+				throw std::runtime_error(stringify("Unsupported archetype kind ", (int)archetypeKind));
+			}
+		}
+
+		void compileClassValuePlan(rfk::Class const& classType, ValuePlan& outPlan)
+		{
+			rfk::Type const& type = *outPlan.type;
+
+			if (type == rfk::getType<Serialization::String>())
+			{
+				outPlan.kind = ValueKind::String;
+			}
+			else if (type == rfk::getType<Serialization::BoolList>())
+			{
+				outPlan.kind = ValueKind::BoolList;
+			}
+			else if (type == rfk::getType<Serialization::PolymorphicObjectPtr>())
+			{
+				outPlan.kind = ValueKind::ObjectPtr;
+			}
+			else if (classType.getClassKind() == rfk::EClassKind::TemplateInstantiation)
+			{
+				const auto* templateClassInstanceType = rfk::classTemplateInstantiationCast(&classType);
+				const char* templateTypeName = templateClassInstanceType->getClassTemplate().getName();
+
+				// See if the field is a Serialization::List<T>
+				if (std::strcmp(templateTypeName, "List") == 0 &&
+					templateClassInstanceType->getTemplateArgumentsCount() == 1)
+				{
+					compileListValuePlan(*templateClassInstanceType, outPlan);
+				}
+				// See if the field is a Serialization::Map<K,V>
+				else if (std::strcmp(templateTypeName, "Map") == 0 &&
+						 templateClassInstanceType->getTemplateArgumentsCount() == 2)
+				{
+					compileMapValuePlan(*templateClassInstanceType, outPlan);
+				}
+				else
+				{
+					throw std::runtime_error(
+						stringify("Class Value ", outPlan.name,
+								  " has unsupported template type ", templateTypeName));
+				}
+			}
+			else
+			{
+				outPlan.kind = ValueKind::Struct;
+				outPlan.structPlan = &getOrCompile(classType);
+				outPlan.blittableSize = outPlan.structPlan->blittableSize;
+			}
+		}
+
+		void compileListValuePlan(
+			rfk::ClassTemplateInstantiation const& templatedArrayType,
+			ValuePlan& outPlan)
+		{
+			// Get the type of the elements in the array from the template argument
+			auto const& templateArg =
+				static_cast<rfk::TypeTemplateArgument const&>(
+					templatedArrayType.getTemplateArgumentAt(0));
+			rfk::Type const& elementType = templateArg.getType();
+
+			outPlan.kind = ValueKind::List;
+			outPlan.sizeMethod = templatedArrayType.getMethodByName("size");
+			outPlan.resizeMethod = templatedArrayType.getMethodByName("resize");
+			outPlan.getRawElementMethod = templatedArrayType.getMethodByName("getRawElement");
+			outPlan.getRawElementMutableMethod = templatedArrayType.getMethodByName("getRawElementMutable");
+
+			outPlan.elementPlan = std::make_unique<ValuePlan>();
+			compileValuePlan(elementType, elementType.getArchetype()->getName(), *outPlan.elementPlan);
+		}
+
+		void compileMapValuePlan(
+			rfk::ClassTemplateInstantiation const& templatedMapType,
+			ValuePlan& outPlan)
+		{
+			// Get the key and value types of the map from the template arguments
+			auto const& templateKeyArg =
+				static_cast<rfk::TypeTemplateArgument const&>(
+					templatedMapType.getTemplateArgumentAt(0));
+			rfk::Type const& keyType = templateKeyArg.getType();
+			auto const& templateValueArg =
+				static_cast<rfk::TypeTemplateArgument const&>(
+					templatedMapType.getTemplateArgumentAt(1));
+			rfk::Type const& valueType = templateValueArg.getType();
+
+			if (keyType == rfk::getType<int32_t>())
+			{
+				outPlan.mapKeyKind = ValueKind::Int;
+			}
+			else if (keyType == rfk::getType<std::string>())
+			{
+				outPlan.mapKeyKind = ValueKind::String;
+			}
+			else
+			{
+				rfk::Archetype const* keyArchetype = keyType.getArchetype();
+
+				throw std::runtime_error(
+					stringify("Map Key Archetype ", keyArchetype != nullptr ? keyArchetype->getName() : "<Null Archetype>",
+							  " is not supported"));
+			}
+
+			outPlan.kind = ValueKind::Map;
+			outPlan.sizeMethod = templatedMapType.getMethodByName("size");
+			outPlan.clearMethod = templatedMapType.getMethodByName("clear");
+			outPlan.getConstEnumeratorMethod = templatedMapType.getMethodByName("getConstEnumerator");
+			outPlan.getOrAddRawValueMutableMethod = templatedMapType.getMethodByName("getOrAddRawValueMutable");
+
+			outPlan.elementPlan = std::make_unique<ValuePlan>();
+			compileValuePlan(valueType, valueType.getArchetype()->getName(), *outPlan.elementPlan);
+		}
+
+		std::unique_ptr<EnumPlan> compileEnumPlan(rfk::Enum const& enumType, const std::string& name)
+		{
+			auto enumPlan = std::make_unique<EnumPlan>();
+			enumPlan->enumType = &enumType;
+			enumPlan->memorySize = enumType.getUnderlyingArchetype().getMemorySize();
+
+			if (enumPlan->memorySize != sizeof(int64_t) &&
+				enumPlan->memorySize != sizeof(int32_t) &&
+				enumPlan->memorySize != sizeof(int16_t) &&
+				enumPlan->memorySize != sizeof(int8_t))
+			{
+				throw std::runtime_error(
+					stringify("Enum Value ", name,
+							  " has an invalid memory size ", enumPlan->memorySize));
+			}
+
+			enumType.foreachEnumValue([](rfk::EnumValue const& enumValue, void* userData) -> bool {
+				EnumPlan* enumPlan = reinterpret_cast<EnumPlan*>(userData);
+				auto const* property = enumValue.getProperty<Serialization::EnumStringValue>();
+
+				EnumEntry entry;
+				entry.value = enumValue.getValue();
+				entry.stringValue = Serialization::getEnumStringValue(enumValue);
+				entry.name = enumValue.getName();
+				entry.hasStringProperty = property != nullptr;
+				enumPlan->entries.push_back(entry);
+
+				return true;
+			}, enumPlan.get());
+
+			return enumPlan;
+		}
+
+		std::recursive_mutex m_mutex;
+		std::unordered_map<std::size_t, std::unique_ptr<StructPlan>> m_plans;
+	};
+
+	static StructPlanCache& getStructPlanCache()
+	{
+		static StructPlanCache s_cache;
+		return s_cache;
+	}
+
+	StructPlan const& getStructPlan(rfk::Struct const& structType)
+	{
+		return getStructPlanCache().getOrCompile(structType);
+	}
+
+	StructPlan const* getStructPlanById(RfkClassId rfkClassId)
+	{
+		rfk::Struct const* structType = rfk::getDatabase().getStructById(rfkClassId);
+
+		return structType != nullptr ? &getStructPlan(*structType) : nullptr;
+	}
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "SerializableObjectPtr.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rfk
+{
+	class Enum;
+	class Field;
+	class Method;
+	class Struct;
+	class Type;
+};
+
+namespace Serialization
+{
+	// The kind of encode/decode operation to perform on a value.
+	// Resolved once per field when a struct plan is compiled so that the serializers
+	// never have to re-inspect reflection data (or compare template names) per value.
+	enum class ValueKind : uint8_t
+	{
+		Bool,
+		Byte,
+		UByte,
+		Short,
+		UShort,
+		Int,
+		UInt,
+		Long,
+		ULong,
+		Float,
+		Double,
+		Enum,
+		String,
+		BoolList,
+		ObjectPtr,
+		List,
+		Map,
+		Struct
+	};
+
+	struct EnumEntry
+	{
+		int64_t value;
+		std::string stringValue; // EnumStringValue property (or the value name if no property)
+		std::string name;
+		bool hasStringProperty;
+	};
+
+	struct EnumPlan
+	{
+		rfk::Enum const* enumType= nullptr;
+		std::size_t memorySize= 0;
+		std::vector<EnumEntry> entries;
+
+		EnumEntry const* findByValue(int64_t value) const;
+		EnumEntry const* findByString(const char* stringValue) const;
+	};
+
+	struct StructPlan;
+
+	struct ValuePlan
+	{
+		ValueKind kind= ValueKind::Struct;
+		rfk::Type const* type= nullptr;
+		std::string name;
+
+		// Non-zero when the in-memory layout of the value is byte-for-byte identical
+		// to its little-endian binary encoding (numeric fundamentals and tightly packed
+		// structs of them), i.e. a List of them can be copied as a single block
+		std::size_t blittableSize= 0;
+
+		// ValueKind::Enum
+		std::unique_ptr<EnumPlan> enumPlan;
+
+		// ValueKind::Struct
+		StructPlan const* structPlan= nullptr;
+
+		// ValueKind::List
+		rfk::Method const* sizeMethod= nullptr;
+		rfk::Method const* resizeMethod= nullptr;
+		rfk::Method const* getRawElementMethod= nullptr;
+		rfk::Method const* getRawElementMutableMethod= nullptr;
+
+		// ValueKind::Map (keys are either ValueKind::Int or ValueKind::String (a std::string))
+		ValueKind mapKeyKind= ValueKind::Int;
+		rfk::Method const* clearMethod= nullptr;
+		rfk::Method const* getConstEnumeratorMethod= nullptr;
+		rfk::Method const* getOrAddRawValueMutableMethod= nullptr;
+
+		// List element or Map value
+		std::unique_ptr<ValuePlan> elementPlan;
+	};
+
+	struct FieldPlan
+	{
+		std::string name;
+		rfk::Field const* field= nullptr;
+		std::size_t memoryOffset= 0;
+		ValuePlan value;
+
+		inline const void* getValuePtr(const void* instance) const
+		{
+			return reinterpret_cast<const uint8_t*>(instance) + memoryOffset;
+		}
+
+		inline void* getValueMutablePtr(void* instance) const
+		{
+			return reinterpret_cast<uint8_t*>(instance) + memoryOffset;
+		}
+	};
+
+	struct StructPlan
+	{
+		rfk::Struct const* structType= nullptr;
+		std::string structName;
+		std::vector<FieldPlan> fields;
+		std::size_t blittableSize= 0;
+
+		// Indices into fields, in the order a JSON object writes its keys (sorted by name)
+		std::vector<std::size_t> jsonFieldOrder;
+	};
+
+	// Returns the cached plan for the given struct, compiling it on first use.
+	// Plans live for the lifetime of the process and are safe to share across threads.
+	StructPlan const& getStructPlan(rfk::Struct const& structType);
+	StructPlan const* getStructPlanById(RfkClassId rfkClassId);
+
+	// True if in-memory numeric values already use the little-endian wire byte order
+	bool isHostLittleEndian();
+
+	// Enum helpers shared by the plan driven serializers
+	int64_t readEnumIntValue(const void* enumValuePtr, std::size_t memorySize);
+	void writeEnumIntValue(void* enumValuePtr, std::size_t memorySize, int64_t value);
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BinaryUtility.h"
 #include "SerializationExport.h"
 #include "SerializationVisitor.h"
 
@@ -22,4 +23,20 @@ namespace Serialization
 		const size_t inSize,
 		void* instance,
 		rfk::Struct const& structType);
+
+	template<typename t_object_type>
+	bool deserializeFromBytes(const std::vector<uint8_t>& inBytes, t_object_type& instance, BinaryFormat format)
+	{
+		return deserializeFromBytes(
+			inBytes.data(), inBytes.size(), &instance, t_object_type::staticGetArchetype(), format);
+	}
+
+	// Messages written in BinaryFormat::V2 start with a "MKB" + version header, V1 messages have none
+	SERIALIZATION_API BinaryFormat getBinaryFormat(const uint8_t* inBytes, const size_t inSize);
+	SERIALIZATION_API bool deserializeFromBytes(
+		const uint8_t* inBytes,
+		const size_t inSize,
+		void* instance,
+		rfk::Struct const& structType,
+		BinaryFormat format);
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "BinaryUtility.h"
 #include "SerializationExport.h"
 #include "SerializationVisitor.h"
 
@@ -13,10 +14,37 @@ namespace Serialization
 		return serializeToBytes(&instance, t_object_type::staticGetArchetype(), outBytes);
 	}
 
+	// Appends the serialized instance to outBytes, reserving the exact size up front.
+	// Pass in a cleared, previously used vector to reuse its capacity.
 	SERIALIZATION_API bool serializeToBytes(
 		const void* instance, 
 		rfk::Struct const& structType, 
 		std::vector<uint8_t>& outBytes);
+
+	template<typename t_object_type>
+	bool serializeToBytes(const t_object_type& instance, std::vector<uint8_t>& outBytes, BinaryFormat format)
+	{
+		return serializeToBytes(&instance, t_object_type::staticGetArchetype(), outBytes, format);
+	}
+
+	// Appends the instance serialized in the requested wire format.
+	// Only send BinaryFormat::V2 to peers that have negotiated support for it.
+	SERIALIZATION_API bool serializeToBytes(
+		const void* instance,
+		rfk::Struct const& structType,
+		std::vector<uint8_t>& outBytes,
+		BinaryFormat format);
+
+	template<typename t_object_type>
+	std::size_t computeSerializedSize(const t_object_type& instance)
+	{
+		return computeSerializedSize(&instance, t_object_type::staticGetArchetype());
+	}
+
+	// Number of bytes serializeToBytes will append for the given instance (BinaryFormat::V1)
+	SERIALIZATION_API std::size_t computeSerializedSize(
+		const void* instance,
+		rfk::Struct const& structType);
 };
 
 #pragma once
\ No newline at end of file
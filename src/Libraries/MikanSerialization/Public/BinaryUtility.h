@@ -33,6 +33,27 @@ namespace Serialization
 	SERIALIZATION_API void write_int64(uint8_t* outData, int64_t inValue, Endian desired);
 	SERIALIZATION_API void write_float(uint8_t* outData, float inValue, Endian desired);
 	SERIALIZATION_API void write_double(uint8_t* outData, double inValue, Endian desired);
+
+	// Binary wire formats understood by the binary serializers
+	//  V1: fixed width integers, no header (original format)
+	//  V2: "MKB" + version byte header, varint integers, interned class names
+	//      and length prefixed structs (so readers can skip unknown trailing fields)
+	enum class BinaryFormat : uint8_t
+	{
+		V1 = 1,
+		V2 = 2
+	};
+
+	// ZigZag maps signed integers to unsigned ones so small negative values stay small as varints
+	inline uint64_t zigzag_encode(int64_t value)
+	{
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+
+	inline int64_t zigzag_decode(uint64_t value)
+	{
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
 };
 
 class SERIALIZATION_API BinaryWriter
@@ -43,6 +64,7 @@ public:
 
 	void appendByte(uint8_t value);
 	void appendBytes(const uint8_t* byteArray, size_t byteCount);
+	size_t getByteCount() const { return m_buffer.size(); }
 
 	template<int Count>
 	void appendBytes(const std::array<uint8_t, Count>& byteArray)
@@ -67,6 +89,10 @@ SERIALIZATION_API void to_binary(BinaryWriter& writer, float inValue);
 SERIALIZATION_API void to_binary(BinaryWriter& writer, double inValue);
 SERIALIZATION_API void to_binary(BinaryWriter& writer, const std::string& inString);
 
+// LEB128 variable length unsigned integer (7 bits per byte, high bit = continuation)
+SERIALIZATION_API void to_binary_varint(BinaryWriter& writer, uint64_t inValue);
+SERIALIZATION_API size_t get_varint_size(uint64_t inValue);
+
 template<typename T, int Count>
 inline void to_binary(BinaryWriter& writer, const std::array<T, Count>& inArray)
 {
@@ -98,6 +124,9 @@ public:
 	uint8_t readByte();
 	void readBytes(uint8_t* outBuffer, size_t byteCount);
 	uint8_t* readBytesNoCopy(size_t byteCount);
+	void skipBytes(size_t byteCount);
+	size_t getBytesRead() const { return m_bytesRead; }
+	size_t getRemainingByteCount() const { return m_bufferSize - m_bytesRead; }
 
 	template<int Count>
 	void readBytes(std::array<uint8_t, Count>& outBuffer)
@@ -124,6 +153,8 @@ SERIALIZATION_API void from_binary(BinaryReader& reader, float& outValue);
 SERIALIZATION_API void from_binary(BinaryReader& reader, double& outValue);
 SERIALIZATION_API void from_binary(BinaryReader& reader, std::string& outString);
 
+SERIALIZATION_API void from_binary_varint(BinaryReader& reader, uint64_t& outValue);
+
 template<typename T, int Count>
 inline void from_binary(BinaryReader& reader, std::array<T, Count>& outArray)
 {
@@ -4,6 +4,7 @@
 #include "SerializationVisitor.h"
 
 #include <nlohmann/json_fwd.hpp>
+#include <functional>
 #include <string>
 
 namespace Serialization
@@ -19,6 +20,26 @@ namespace Serialization
 		void* instance, 
 		rfk::Struct const& structType);
 
+	// Deserializes directly from the json text in a single SAX pass (no intermediate DOM)
+	SERIALIZATION_API bool deserializeFromJsonString(
+		const char* utf8JsonString,
+		std::size_t jsonLength,
+		void* instance,
+		rfk::Struct const& structType);
+
+	// Returns the instance to deserialize into (and its struct type) for the type id read from the json,
+	// or nullptr if the type id is unknown
+	using JsonTypedInstanceAllocator = std::function<void*(int64_t typeId, rfk::Struct const*& outStructType)>;
+
+	// For json that names its own struct type in an integer field (e.g. a request's "requestTypeId").
+	// Still a single SAX pass: the members before the type field are buffered until the instance exists.
+	// Fails if the type field appears more than once.
+	SERIALIZATION_API bool deserializeTypedFromJsonString(
+		const char* utf8JsonString,
+		std::size_t jsonLength,
+		const char* typeIdFieldName,
+		const JsonTypedInstanceAllocator& allocateInstance);
+
 	template<typename t_object_type>
 	bool deserializeFromJson(const nlohmann::json& jsonObject, t_object_type& instance)
 	{
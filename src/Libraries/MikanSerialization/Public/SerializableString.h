@@ -26,6 +26,7 @@ namespace Serialization NAMESPACE()
 		String& operator=(const String& other);
 
 		void setValue(std::string const& string);
+		void setValue(const char* chars, std::size_t length);
 		const std::string& getValue() const;
 
 		bool operator==(std::string const& other) const;
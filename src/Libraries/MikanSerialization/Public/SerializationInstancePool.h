@@ -0,0 +1,99 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Serialization
+{
+	// Recycles heap allocated instances of reflected types for high rate decoding.
+	// Every instance handed out by acquire() belongs to the current batch until releaseBatch(),
+	// which takes back the instances nobody else still references. A batch that reaches
+	// maxBatchSize is released by the next acquire(), so a caller that never calls releaseBatch()
+	// doesn't grow the pool without bound (it just stops getting recycled instances). A recycled instance keeps
+	// the storage of its String and List members, so decoding into it again doesn't allocate.
+	// Recycled instances are not reset, so only decode JSON into them: the JSON readers write every field
+	// (or fail on a missing one), while the V2 binary reader leaves fields missing from the data untouched.
+	// Not thread safe.
+	template <typename t_base_type>
+	class InstancePool
+	{
+	public:
+		using InstancePtr = std::shared_ptr<t_base_type>;
+
+		InstancePool(std::size_t maxFreeInstancesPerType = 64, std::size_t maxBatchSize = 4096)
+			: m_maxFreeInstancesPerType(maxFreeInstancesPerType)
+			, m_maxBatchSize(maxBatchSize)
+		{}
+
+		// Returns a recycled instance of the given class, or one made by the factory if none are free
+		template <typename t_factory>
+		InstancePtr acquire(std::size_t classId, t_factory&& makeInstance)
+		{
+			if (m_batchInstances.size() >= m_maxBatchSize)
+			{
+				releaseBatch();
+			}
+
+			InstancePtr instance;
+
+			auto free_it = m_freeInstances.find(classId);
+			if (free_it != m_freeInstances.end() && !free_it->second.empty())
+			{
+				instance = std::move(free_it->second.back());
+				free_it->second.pop_back();
+			}
+			else
+			{
+				instance = makeInstance();
+			}
+
+			if (instance)
+			{
+				m_batchInstances.push_back({classId, instance});
+			}
+
+			return instance;
+		}
+
+		// Ends the current batch, reclaiming instances the caller has let go of.
+		// Instances still referenced elsewhere are left to their shared pointers.
+		void releaseBatch()
+		{
+			for (BatchEntry& entry : m_batchInstances)
+			{
+				if (entry.instance.use_count() == 1)
+				{
+					std::vector<InstancePtr>& freeList = m_freeInstances[entry.classId];
+
+					if (freeList.size() < m_maxFreeInstancesPerType)
+					{
+						freeList.push_back(std::move(entry.instance));
+					}
+				}
+			}
+
+			m_batchInstances.clear();
+		}
+
+		void clear()
+		{
+			m_batchInstances.clear();
+			m_freeInstances.clear();
+		}
+
+		std::size_t getBatchSize() const { return m_batchInstances.size(); }
+
+	private:
+		struct BatchEntry
+		{
+			std::size_t classId;
+			InstancePtr instance;
+		};
+
+		std::size_t m_maxFreeInstancesPerType;
+		std::size_t m_maxBatchSize;
+		std::vector<BatchEntry> m_batchInstances;
+		std::unordered_map<std::size_t, std::vector<InstancePtr>> m_freeInstances;
+	};
+};
@@ -147,6 +147,8 @@ namespace Serialization
 		visitStruct(&instance, t_struct_type::staticGetArchetype(), visitor, userdata);
 	}
 
+	SERIALIZATION_API void memoryOffsetSortStructFields(rfk::Struct const& structType, FieldList& outFields);
+
 	SERIALIZATION_API void visitStruct(const void* instance, rfk::Struct const& structType, IVisitor *visitor);
 	SERIALIZATION_API void visitStruct(void* instance, rfk::Struct const& structType, IVisitor *visitor);
 
@@ -0,0 +1,249 @@
+#include "SharedEventRing.h"
+
+#include <atomic>
+#include <new>
+#include <string.h>
+
+#define SHARED_EVENT_RING_MAGIC				0x52454B4D // "MKER"
+#define SHARED_EVENT_RING_VERSION			1
+#define SHARED_EVENT_RECORD_FLAG_PADDING	0x1
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory atomics must be lock-free");
+
+// Lives at the start of the shared memory block, followed by the ring data.
+// Positions only ever increase, the ring offset is the position modulo the capacity.
+struct SharedEventRingHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t capacity;
+	// The producer may be writing anywhere below this position
+	alignas(64) std::atomic<uint64_t> reservePosition;
+	// Every record below this position is completely written
+	alignas(64) std::atomic<uint64_t> commitPosition;
+};
+
+// Precedes every event in the ring.
+// A padding record fills the end of the ring when the next event doesn't fit there.
+struct SharedEventRecordHeader
+{
+	uint32_t dataSize;
+	uint32_t flags;
+	uint64_t readerMask;
+};
+
+static const size_t k_recordAlignment= sizeof(SharedEventRecordHeader);
+static const size_t k_ringDataOffset= (sizeof(SharedEventRingHeader) + 63) & ~(size_t)63;
+static const size_t k_minRingCapacity= 4096;
+
+static size_t getRecordSize(size_t dataSize)
+{
+	return (sizeof(SharedEventRecordHeader) + dataSize + k_recordAlignment - 1) & ~(k_recordAlignment - 1);
+}
+
+static size_t getMaxRecordDataSize(uint64_t capacity)
+{
+	// Small enough that a record never has to wrap more than once per quarter ring
+	return (size_t)(capacity / 4) - sizeof(SharedEventRecordHeader);
+}
+
+//-- SharedEventRingWriter -----
+SharedEventRingWriter::SharedEventRingWriter()
+{
+}
+
+SharedEventRingWriter::~SharedEventRingWriter()
+{
+	dispose();
+}
+
+bool SharedEventRingWriter::create(const std::string& name, size_t capacity)
+{
+	dispose();
+
+	size_t ringCapacity= k_minRingCapacity;
+	while (ringCapacity < capacity)
+	{
+		ringCapacity<<= 1;
+	}
+
+	if (!m_sharedMemory.create(name, k_ringDataOffset + ringCapacity))
+		return false;
+
+	uint8_t* sharedData= reinterpret_cast<uint8_t*>(m_sharedMemory.getData());
+	SharedEventRingHeader* header= new (sharedData) SharedEventRingHeader();
+	header->version= SHARED_EVENT_RING_VERSION;
+	header->capacity= ringCapacity;
+	header->reservePosition.store(0, std::memory_order_relaxed);
+	header->commitPosition.store(0, std::memory_order_relaxed);
+
+	// Readers check the magic last
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic= SHARED_EVENT_RING_MAGIC;
+
+	m_header= header;
+	m_ringData= sharedData + k_ringDataOffset;
+
+	return true;
+}
+
+void SharedEventRingWriter::dispose()
+{
+	m_header= nullptr;
+	m_ringData= nullptr;
+	m_sharedMemory.dispose();
+}
+
+size_t SharedEventRingWriter::getMaxEventSize() const
+{
+	return m_header != nullptr ? getMaxRecordDataSize(m_header->capacity) : 0;
+}
+
+uint64_t SharedEventRingWriter::getWritePosition() const
+{
+	return m_header != nullptr ? m_header->commitPosition.load(std::memory_order_relaxed) : 0;
+}
+
+bool SharedEventRingWriter::writeEvent(uint64_t readerMask, const void* data, size_t dataSize)
+{
+	if (m_header == nullptr || dataSize > getMaxEventSize())
+		return false;
+
+	const uint64_t capacity= m_header->capacity;
+	const size_t recordSize= getRecordSize(dataSize);
+	const uint64_t position= m_header->commitPosition.load(std::memory_order_relaxed);
+	size_t offset= (size_t)(position & (capacity - 1));
+	const size_t paddingSize= (offset + recordSize > capacity) ? (size_t)(capacity - offset) : 0;
+
+	// Tell readers which bytes are about to be overwritten before touching them
+	m_header->reservePosition.store(position + paddingSize + recordSize, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	if (paddingSize > 0)
+	{
+		SharedEventRecordHeader padding= {
+			(uint32_t)(paddingSize - sizeof(SharedEventRecordHeader)), 
+			SHARED_EVENT_RECORD_FLAG_PADDING, 
+			0};
+		memcpy(m_ringData + offset, &padding, sizeof(padding));
+		offset= 0;
+	}
+
+	SharedEventRecordHeader record= {(uint32_t)dataSize, 0, readerMask};
+	memcpy(m_ringData + offset, &record, sizeof(record));
+	memcpy(m_ringData + offset + sizeof(record), data, dataSize);
+
+	m_header->commitPosition.store(position + paddingSize + recordSize, std::memory_order_release);
+
+	return true;
+}
+
+//-- SharedEventRingReader -----
+SharedEventRingReader::SharedEventRingReader()
+{
+}
+
+SharedEventRingReader::~SharedEventRingReader()
+{
+	dispose();
+}
+
+bool SharedEventRingReader::open(const std::string& name, int readerIndex, uint64_t startPosition)
+{
+	dispose();
+
+	if (readerIndex < 0 || readerIndex >= SHARED_EVENT_RING_MAX_READERS)
+		return false;
+
+	if (!m_sharedMemory.open(name))
+		return false;
+
+	SharedEventRingHeader* header= reinterpret_cast<SharedEventRingHeader*>(m_sharedMemory.getData());
+	const bool bIsValidRing=
+		m_sharedMemory.getSize() >= k_ringDataOffset &&
+		header->magic == SHARED_EVENT_RING_MAGIC &&
+		header->version == SHARED_EVENT_RING_VERSION &&
+		m_sharedMemory.getSize() >= k_ringDataOffset + header->capacity;
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	if (!bIsValidRing)
+	{
+		m_sharedMemory.dispose();
+		return false;
+	}
+
+	m_header= header;
+	m_ringData= reinterpret_cast<const uint8_t*>(m_sharedMemory.getData()) + k_ringDataOffset;
+	m_readerBit= 1ull << readerIndex;
+	// A start position the ring has already moved past is caught as an overrun by the first read
+	m_readPosition= startPosition;
+	m_overrunCount= 0;
+
+	return true;
+}
+
+void SharedEventRingReader::dispose()
+{
+	m_header= nullptr;
+	m_ringData= nullptr;
+	m_readerBit= 0;
+	m_sharedMemory.dispose();
+}
+
+bool SharedEventRingReader::tryReadEvent(std::string& outEvent)
+{
+	if (m_header == nullptr)
+		return false;
+
+	const uint64_t capacity= m_header->capacity;
+
+	while (true)
+	{
+		const uint64_t commitPosition= m_header->commitPosition.load(std::memory_order_acquire);
+		if (m_readPosition == commitPosition)
+			return false;
+
+		// Already lapped, the record at the read position is gone
+		if (commitPosition - m_readPosition > capacity)
+		{
+			m_readPosition= commitPosition;
+			m_overrunCount++;
+			continue;
+		}
+
+		const size_t offset= (size_t)(m_readPosition & (capacity - 1));
+		SharedEventRecordHeader record;
+		memcpy(&record, m_ringData + offset, sizeof(record));
+
+		// A header torn by the producer can hold any size, check it before copying anything
+		const bool bIsPadding= (record.flags & SHARED_EVENT_RECORD_FLAG_PADDING) != 0;
+		const size_t recordSize= getRecordSize(record.dataSize);
+		const bool bIsValidRecord=
+			bIsPadding 
+			? offset + recordSize == capacity
+			: record.dataSize <= getMaxRecordDataSize(capacity) && offset + recordSize <= capacity;
+		const bool bIsForReader= bIsValidRecord && !bIsPadding && (record.readerMask & m_readerBit) != 0;
+
+		if (bIsForReader)
+		{
+			outEvent.assign(
+				reinterpret_cast<const char*>(m_ringData + offset + sizeof(record)), 
+				record.dataSize);
+		}
+
+		// Only trust what was copied if the producer hasn't started overwriting it since
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t reservePosition= m_header->reservePosition.load(std::memory_order_relaxed);
+		if (reservePosition > m_readPosition + capacity || !bIsValidRecord)
+		{
+			m_readPosition= m_header->commitPosition.load(std::memory_order_acquire);
+			m_overrunCount++;
+			continue;
+		}
+
+		m_readPosition+= recordSize;
+
+		if (bIsForReader)
+			return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "SharedMemory.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+	#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+// Session local, so it doesn't need the create global objects privilege
+static std::string makeMappingName(const std::string& name)
+{
+	return "Local\\" + name;
+}
+#else
+static std::string makeMappingName(const std::string& name)
+{
+	return "/" + name;
+}
+#endif
+
+SharedMemory::SharedMemory()
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+	dispose();
+}
+
+bool SharedMemory::create(const std::string& name, size_t size)
+{
+	dispose();
+
+	const std::string mappingName= makeMappingName(name);
+
+#ifdef _WIN32
+	const unsigned long long mappingSize= (unsigned long long)size;
+	m_fileMapping= 
+		CreateFileMappingA(
+			INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 
+			(DWORD)(mappingSize >> 32), (DWORD)(mappingSize & 0xffffffff), 
+			mappingName.c_str());
+	if (m_fileMapping == nullptr)
+		return false;
+
+	m_data= MapViewOfFile(m_fileMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (m_data == nullptr)
+	{
+		CloseHandle(m_fileMapping);
+		m_fileMapping= nullptr;
+		return false;
+	}
+
+	// An existing mapping of the same name (left open by a reader) keeps its old contents
+	memset(m_data, 0, size);
+#else
+	// Replace any block left behind by a previous run
+	shm_unlink(mappingName.c_str());
+
+	int fd= shm_open(mappingName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0)
+		return false;
+
+	if (ftruncate(fd, (off_t)size) != 0)
+	{
+		close(fd);
+		shm_unlink(mappingName.c_str());
+		return false;
+	}
+
+	void* data= mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		shm_unlink(mappingName.c_str());
+		return false;
+	}
+
+	// New shared memory objects are zero filled
+	m_data= data;
+#endif
+
+	m_name= name;
+	m_size= size;
+	m_bIsOwner= true;
+
+	return true;
+}
+
+bool SharedMemory::open(const std::string& name)
+{
+	dispose();
+
+	const std::string mappingName= makeMappingName(name);
+
+#ifdef _WIN32
+	m_fileMapping= OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mappingName.c_str());
+	if (m_fileMapping == nullptr)
+		return false;
+
+	m_data= MapViewOfFile(m_fileMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (m_data == nullptr)
+	{
+		CloseHandle(m_fileMapping);
+		m_fileMapping= nullptr;
+		return false;
+	}
+
+	MEMORY_BASIC_INFORMATION memoryInfo;
+	VirtualQuery(m_data, &memoryInfo, sizeof(memoryInfo));
+	m_size= memoryInfo.RegionSize;
+#else
+	int fd= shm_open(mappingName.c_str(), O_RDWR, 0600);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* data= mmap(nullptr, (size_t)fileStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data= data;
+	m_size= (size_t)fileStat.st_size;
+#endif
+
+	m_name= name;
+	m_bIsOwner= false;
+
+	return true;
+}
+
+void SharedMemory::dispose()
+{
+	if (m_data == nullptr)
+		return;
+
+#ifdef _WIN32
+	// The mapping goes away with its last handle
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_fileMapping);
+	m_fileMapping= nullptr;
+#else
+	munmap(m_data, m_size);
+	if (m_bIsOwner)
+	{
+		shm_unlink(makeMappingName(m_name).c_str());
+	}
+#endif
+
+	m_data= nullptr;
+	m_size= 0;
+	m_bIsOwner= false;
+	m_name.clear();
+}
\ No newline at end of file
@@ -31,6 +31,16 @@ public:
 		return m_keyValueFound;
 	}
 
+	bool fetchKeyValuePair(const char* szJsonString, const std::string& key, t_value_type& outValue)
+	{
+		m_searchKey = key;
+		m_resultValue = t_value_type();
+		json::sax_parse(szJsonString, this);
+
+		outValue = m_resultValue;
+		return m_keyValueFound;
+	}
+
 	// SAX Parse Interface
 	bool null() override
 	{
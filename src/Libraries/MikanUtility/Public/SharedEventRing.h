@@ -0,0 +1,70 @@
+#pragma once
+
+#include "MikanUtilityExport.h"
+#include "SharedMemory.h"
+
+#include <stdint.h>
+#include <string>
+
+// Readers are identified by a bit in each event's reader mask
+#define SHARED_EVENT_RING_MAX_READERS		64
+// Written in place of an event too big for the ring, which the producer sends over the socket instead.
+// Readers hand out that socket event when they reach the marker, so events stay in publish order.
+#define SHARED_EVENT_RING_SOCKET_EVENT_MARKER	"socket_event"
+
+// Lock-free, single producer / multiple consumer ring of events in shared memory.
+// Each event is a variable sized record tagged with the mask of readers it is meant for.
+// The producer never waits on readers: a reader that falls a whole ring behind
+// loses the overwritten events and picks up again at the newest one.
+// The reader mask only decides which events a well-behaved reader copies out.
+// It is not access control: any process that can open the ring by name sees every event in it.
+class MIKAN_UTILITY_CLASS SharedEventRingWriter
+{
+public:
+	SharedEventRingWriter();
+	virtual ~SharedEventRingWriter();
+
+	// Capacity is rounded up to a power of two
+	bool create(const std::string& name, size_t capacity);
+	void dispose();
+
+	inline bool getIsValid() const { return m_header != nullptr; }
+	// Bigger events have to be sent some other way
+	size_t getMaxEventSize() const;
+	// Where the next event will be written, a reader opened there sees every event from now on
+	uint64_t getWritePosition() const;
+
+	// Returns false if the ring isn't open or the event is too big for it
+	bool writeEvent(uint64_t readerMask, const void* data, size_t dataSize);
+
+private:
+	SharedMemory m_sharedMemory;
+	struct SharedEventRingHeader* m_header= nullptr;
+	uint8_t* m_ringData= nullptr;
+};
+
+class MIKAN_UTILITY_CLASS SharedEventRingReader
+{
+public:
+	SharedEventRingReader();
+	virtual ~SharedEventRingReader();
+
+	// Starts reading at the given write position (see SharedEventRingWriter::getWritePosition)
+	bool open(const std::string& name, int readerIndex, uint64_t startPosition);
+	void dispose();
+
+	inline bool getIsValid() const { return m_header != nullptr; }
+	// Times the producer lapped this reader (skipping the events in between)
+	inline uint64_t getOverrunCount() const { return m_overrunCount; }
+
+	// Copies out the next event meant for this reader, returns false if there isn't one
+	bool tryReadEvent(std::string& outEvent);
+
+private:
+	SharedMemory m_sharedMemory;
+	struct SharedEventRingHeader* m_header= nullptr;
+	const uint8_t* m_ringData= nullptr;
+	uint64_t m_readerBit= 0;
+	uint64_t m_readPosition= 0;
+	uint64_t m_overrunCount= 0;
+};
\ No newline at end of file
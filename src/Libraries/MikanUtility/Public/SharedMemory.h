@@ -0,0 +1,35 @@
+#pragma once
+
+#include "MikanUtilityExport.h"
+
+#include <stddef.h>
+#include <string>
+
+// A named block of memory shared between processes on the same machine.
+// The creator owns the name: it is removed once the creator disposes it,
+// although processes that already opened it keep their mapping.
+class MIKAN_UTILITY_CLASS SharedMemory
+{
+public:
+	SharedMemory();
+	virtual ~SharedMemory();
+
+	// Creates (or replaces) the named block, zero filled
+	bool create(const std::string& name, size_t size);
+	// Maps a block created by another process
+	bool open(const std::string& name);
+	void dispose();
+
+	inline bool getIsValid() const { return m_data != nullptr; }
+	inline void* getData() const { return m_data; }
+	inline size_t getSize() const { return m_size; }
+
+private:
+	std::string m_name;
+	void* m_data= nullptr;
+	size_t m_size= 0;
+	bool m_bIsOwner= false;
+#ifdef _WIN32
+	void* m_fileMapping= nullptr;
+#endif
+};
\ No newline at end of file
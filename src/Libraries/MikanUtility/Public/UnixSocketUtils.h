@@ -0,0 +1,379 @@
+#pragma once
+
+// Unix domain socket helpers shared by the local (same machine) client and server transports.
+// Messages are sent as length prefixed frames:
+//   [uint32 payload size, little endian][uint8 frame type][payload]
+// Windows 10 (1803+) supports AF_UNIX sockets through winsock, the net system
+// (WSAStartup) must already be initialized before any of these are called.
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+	#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <winsock2.h>
+	#include <afunix.h>
+#else
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <unistd.h>
+#endif
+
+#include <filesystem>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define UNIX_SOCKET_HOST_PREFIX				"unix:"
+#define UNIX_SOCKET_DEFAULT_FILENAME		"MikanXR.sock"
+
+namespace UnixSocketUtils
+{
+#ifdef _WIN32
+	using SocketHandle = SOCKET;
+	const SocketHandle k_invalidSocket = INVALID_SOCKET;
+#else
+	using SocketHandle = int;
+	const SocketHandle k_invalidSocket = -1;
+#endif
+
+	enum class eFrameType : uint8_t
+	{
+		text,		// UTF-8 JSON request, response or event
+		binary,		// Binary encoded request or response
+		handshake,	// Protocol version ("Mikan-<version>"), first frame sent by each side
+		close		// "<code>:<reason>", sent before closing the socket
+	};
+
+	const size_t k_frameHeaderSize = 5;
+	// Anything bigger is treated as a corrupt stream
+	const uint32_t k_maxFramePayloadSize = 256 * 1024 * 1024;
+
+	// "unix:<path>" selects the unix socket transport, an empty path means the default socket
+	inline bool isUnixSocketHost(const std::string& host)
+	{
+		return host.rfind(UNIX_SOCKET_HOST_PREFIX, 0) == 0;
+	}
+
+	inline std::string getDefaultSocketPath()
+	{
+		std::error_code error;
+		std::filesystem::path tempDir = std::filesystem::temp_directory_path(error);
+
+		return (tempDir / UNIX_SOCKET_DEFAULT_FILENAME).string();
+	}
+
+	inline std::string getSocketPathFromHost(const std::string& host)
+	{
+		std::string socketPath =
+			isUnixSocketHost(host) ? host.substr(strlen(UNIX_SOCKET_HOST_PREFIX)) : host;
+
+		return socketPath.empty() ? getDefaultSocketPath() : socketPath;
+	}
+
+	inline int getLastSocketError()
+	{
+#ifdef _WIN32
+		return WSAGetLastError();
+#else
+		return errno;
+#endif
+	}
+
+	inline bool isWouldBlockError(int error)
+	{
+#ifdef _WIN32
+		return error == WSAEWOULDBLOCK;
+#else
+		return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+#endif
+	}
+
+	inline void closeSocket(SocketHandle socketHandle)
+	{
+		if (socketHandle != k_invalidSocket)
+		{
+#ifdef _WIN32
+			::closesocket(socketHandle);
+#else
+			::close(socketHandle);
+#endif
+		}
+	}
+
+	// Wakes up any thread blocked on the socket, which then sees the connection as closed
+	inline void shutdownSocket(SocketHandle socketHandle)
+	{
+		if (socketHandle != k_invalidSocket)
+		{
+#ifdef _WIN32
+			::shutdown(socketHandle, SD_BOTH);
+#else
+			::shutdown(socketHandle, SHUT_RDWR);
+#endif
+		}
+	}
+
+	inline bool setNonBlocking(SocketHandle socketHandle)
+	{
+#ifdef _WIN32
+		u_long mode = 1;
+		return ::ioctlsocket(socketHandle, FIONBIO, &mode) == 0;
+#else
+		int flags = ::fcntl(socketHandle, F_GETFL, 0);
+		return flags != -1 && ::fcntl(socketHandle, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+	}
+
+	// Returns 1 if the socket is ready, 0 on timeout, -1 on error (or a hung up socket)
+	inline int pollSocket(SocketHandle socketHandle, bool bForWrite, int timeoutMilliseconds)
+	{
+#ifdef _WIN32
+		WSAPOLLFD pollFd = {};
+		pollFd.fd = socketHandle;
+		pollFd.events = bForWrite ? POLLWRNORM : POLLRDNORM;
+		int result = ::WSAPoll(&pollFd, 1, timeoutMilliseconds);
+#else
+		struct pollfd pollFd = {};
+		pollFd.fd = socketHandle;
+		pollFd.events = bForWrite ? POLLOUT : POLLIN;
+		int result = ::poll(&pollFd, 1, timeoutMilliseconds);
+#endif
+
+		if (result < 0)
+			return isWouldBlockError(getLastSocketError()) ? 0 : -1;
+		if (result == 0)
+			return 0;
+
+		// A hung up socket still has to be read to drain it, only fail writes
+		if (bForWrite && (pollFd.revents & (POLLERR | POLLHUP)) != 0)
+			return -1;
+
+		return 1;
+	}
+
+	inline bool makeSocketAddress(const std::string& socketPath, struct sockaddr_un& outAddress)
+	{
+		memset(&outAddress, 0, sizeof(outAddress));
+		outAddress.sun_family = AF_UNIX;
+
+		if (socketPath.size() >= sizeof(outAddress.sun_path))
+			return false;
+
+		memcpy(outAddress.sun_path, socketPath.c_str(), socketPath.size());
+		return true;
+	}
+
+	// True if a server accepts connections on the socket address (i.e. the socket file isn't stale)
+	inline bool isSocketAddressInUse(const struct sockaddr_un& address)
+	{
+		SocketHandle probeSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (probeSocket == k_invalidSocket)
+			return false;
+
+		const bool bIsInUse = ::connect(probeSocket, (const struct sockaddr*)&address, sizeof(address)) == 0;
+		closeSocket(probeSocket);
+
+		return bIsInUse;
+	}
+
+	// Creates a non-blocking socket listening on the given path, replacing any stale socket file.
+	// Fails if another server is still listening on the path.
+	inline SocketHandle openListenSocket(const std::string& socketPath, std::string& outError)
+	{
+		struct sockaddr_un address;
+		if (!makeSocketAddress(socketPath, address))
+		{
+			outError = "Socket path too long: " + socketPath;
+			return k_invalidSocket;
+		}
+
+		std::error_code error;
+		if (std::filesystem::exists(socketPath, error))
+		{
+			if (isSocketAddressInUse(address))
+			{
+				outError = "Another server is already running on " + socketPath;
+				return k_invalidSocket;
+			}
+
+			// A socket file left behind by a previous run would make bind fail
+			std::filesystem::remove(socketPath, error);
+		}
+
+		SocketHandle listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listenSocket == k_invalidSocket)
+		{
+			outError = "Failed to create socket, error " + std::to_string(getLastSocketError());
+			return k_invalidSocket;
+		}
+
+		if (::bind(listenSocket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+			::listen(listenSocket, SOMAXCONN) != 0 ||
+			!setNonBlocking(listenSocket))
+		{
+			outError = "Failed to listen on " + socketPath + ", error " + std::to_string(getLastSocketError());
+			closeSocket(listenSocket);
+			return k_invalidSocket;
+		}
+
+		return listenSocket;
+	}
+
+	// Connects to the server listening on the given path, the returned socket is non-blocking
+	inline SocketHandle connectSocket(const std::string& socketPath, std::string& outError)
+	{
+		struct sockaddr_un address;
+		if (!makeSocketAddress(socketPath, address))
+		{
+			outError = "Socket path too long: " + socketPath;
+			return k_invalidSocket;
+		}
+
+		SocketHandle clientSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (clientSocket == k_invalidSocket)
+		{
+			outError = "Failed to create socket, error " + std::to_string(getLastSocketError());
+			return k_invalidSocket;
+		}
+
+		if (::connect(clientSocket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+			!setNonBlocking(clientSocket))
+		{
+			outError = "Failed to connect to " + socketPath + ", error " + std::to_string(getLastSocketError());
+			closeSocket(clientSocket);
+			return k_invalidSocket;
+		}
+
+		return clientSocket;
+	}
+
+	inline void appendFrame(std::vector<uint8_t>& outBuffer, eFrameType frameType, const void* payload, size_t payloadSize)
+	{
+		const uint32_t size = (uint32_t)payloadSize;
+		const uint8_t header[k_frameHeaderSize] = {
+			(uint8_t)(size & 0xff),
+			(uint8_t)((size >> 8) & 0xff),
+			(uint8_t)((size >> 16) & 0xff),
+			(uint8_t)((size >> 24) & 0xff),
+			(uint8_t)frameType
+		};
+
+		outBuffer.insert(outBuffer.end(), header, header + k_frameHeaderSize);
+		if (payloadSize > 0)
+		{
+			const uint8_t* payloadBytes = reinterpret_cast<const uint8_t*>(payload);
+			outBuffer.insert(outBuffer.end(), payloadBytes, payloadBytes + payloadSize);
+		}
+	}
+
+	// Sends as much of the buffer as the socket accepts without blocking.
+	// Returns the number of bytes sent, or -1 if the socket failed.
+	inline int64_t sendSome(SocketHandle socketHandle, const uint8_t* buffer, size_t bufferSize)
+	{
+		size_t totalSent = 0;
+		while (totalSent < bufferSize)
+		{
+			const size_t chunkSize = bufferSize - totalSent;
+#ifdef _WIN32
+			int sent = ::send(socketHandle, (const char*)buffer + totalSent, (int)chunkSize, 0);
+#elif defined(MSG_NOSIGNAL)
+			ssize_t sent = ::send(socketHandle, buffer + totalSent, chunkSize, MSG_NOSIGNAL);
+#else
+			ssize_t sent = ::send(socketHandle, buffer + totalSent, chunkSize, 0);
+#endif
+			if (sent < 0)
+			{
+				if (isWouldBlockError(getLastSocketError()))
+					break;
+
+				return -1;
+			}
+
+			totalSent += (size_t)sent;
+		}
+
+		return (int64_t)totalSent;
+	}
+
+	// Reads whatever is available without blocking.
+	// Returns the number of bytes read, 0 if nothing was ready, or -1 if the socket closed or failed.
+	inline int64_t recvSome(SocketHandle socketHandle, uint8_t* buffer, size_t bufferSize)
+	{
+#ifdef _WIN32
+		int received = ::recv(socketHandle, (char*)buffer, (int)bufferSize, 0);
+#else
+		ssize_t received = ::recv(socketHandle, buffer, bufferSize, 0);
+#endif
+		if (received > 0)
+			return (int64_t)received;
+		if (received < 0 && isWouldBlockError(getLastSocketError()))
+			return 0;
+
+		return -1;
+	}
+
+	// Reassembles frames from the byte stream read off a socket
+	class FrameReader
+	{
+	public:
+		inline bool getHasError() const { return m_bHasError; }
+
+		void append(const uint8_t* data, size_t dataSize)
+		{
+			m_buffer.insert(m_buffer.end(), data, data + dataSize);
+		}
+
+		// Pops the next complete frame, returns false if there isn't one yet
+		bool tryReadFrame(eFrameType& outFrameType, std::string& outPayload)
+		{
+			const size_t available = m_buffer.size() - m_readOffset;
+			if (m_bHasError || available < k_frameHeaderSize)
+				return false;
+
+			const uint8_t* header = m_buffer.data() + m_readOffset;
+			const uint32_t payloadSize =
+				(uint32_t)header[0] |
+				((uint32_t)header[1] << 8) |
+				((uint32_t)header[2] << 16) |
+				((uint32_t)header[3] << 24);
+			const uint8_t frameType = header[4];
+
+			if (payloadSize > k_maxFramePayloadSize || frameType > (uint8_t)eFrameType::close)
+			{
+				m_bHasError = true;
+				return false;
+			}
+
+			if (available < k_frameHeaderSize + payloadSize)
+				return false;
+
+			const char* payload = reinterpret_cast<const char*>(header + k_frameHeaderSize);
+			outFrameType = (eFrameType)frameType;
+			outPayload.assign(payload, payloadSize);
+			m_readOffset += k_frameHeaderSize + payloadSize;
+
+			// Drop the consumed bytes once they make up most of the buffer
+			if (m_readOffset == m_buffer.size())
+			{
+				m_buffer.clear();
+				m_readOffset = 0;
+			}
+			else if (m_readOffset * 2 > m_buffer.size())
+			{
+				m_buffer.erase(m_buffer.begin(), m_buffer.begin() + m_readOffset);
+				m_readOffset = 0;
+			}
+
+			return true;
+		}
+
+	private:
+		std::vector<uint8_t> m_buffer;
+		size_t m_readOffset = 0;
+		bool m_bHasError = false;
+	};
+};
@@ -180,6 +180,7 @@ protected:
 
 		if (m_mikanApi->init(MikanLogLevel_Info, onMikanLog) == MikanAPIResult::Success)
 		{
+			m_mikanApi->setEventPoolEnabled(true);
 			m_mikanInitialized= true;
 		}
 		else
@@ -432,8 +433,10 @@ protected:
 
 		if (m_mikanApi->getIsConnected())
 		{
-			MikanEventPtr mikanEvent;
-			while (m_mikanApi->fetchNextEvent(mikanEvent) == MikanAPIResult::Success)
+			// Handle everything that arrived since the last frame
+			std::vector<MikanEventPtr> mikanEvents;
+			m_mikanApi->fetchEvents(mikanEvents);
+			for (const MikanEventPtr& mikanEvent : mikanEvents)
 			{
 				// App Connection Events
 				if (typeid(*mikanEvent) == typeid(MikanConnectedEvent))
@@ -488,6 +491,12 @@ protected:
 
 					handleVRDevicePoseChanged(*devicePoseEvent);
 				}
+				else if (typeid(*mikanEvent) == typeid(MikanVRDevicePoseBatchEvent))
+				{
+					auto devicePoseBatchEvent = std::static_pointer_cast<MikanVRDevicePoseBatchEvent>(mikanEvent);
+
+					handleVRDevicePoseBatch(*devicePoseBatchEvent);
+				}
 				// Spatial Anchor Events
 				else if (typeid(*mikanEvent) == typeid(MikanAnchorNameUpdateEvent))
 				{
@@ -538,6 +547,10 @@ protected:
 					handleScriptMessage(*scriptMessageEvent.get());
 				}
 			}
+
+			// This frame's events have been handled, so the API can recycle them
+			mikanEvents.clear();
+			m_mikanApi->releaseEventBatch();
 		}
 		else
 		{
@@ -666,6 +679,19 @@ protected:
 	{
 	}
 
+	void handleVRDevicePoseBatch(const MikanVRDevicePoseBatchEvent& DevicePoseBatchEvent)
+	{
+		for (const MikanVRDevicePose& devicePose : DevicePoseBatchEvent.poses)
+		{
+			MikanVRDevicePoseUpdateEvent devicePoseEvent;
+			devicePoseEvent.transform = devicePose.transform;
+			devicePoseEvent.device_id = devicePose.device_id;
+			devicePoseEvent.frame = DevicePoseBatchEvent.frame;
+
+			handleVRDevicePoseChanged(devicePoseEvent);
+		}
+	}
+
 	// Spatial Anchor Events
 	void handleAnchorListChanged()
 	{
@@ -0,0 +1,1280 @@
+//-- includes -----
+#include "MikanAPI.h"
+#include "MikanClientEvents.h"
+#include "MikanClientRequests.h"
+#include "MikanSpatialAnchorRequests.h"
+#include "MikanStencilRequests.h"
+#include "MikanVideoSourceRequests.h"
+#include "MikanVRDeviceEvents.h"
+#include "MikanVRDeviceRequests.h"
+
+#include "IServerObjectSystems.h"
+#include "JsonSerializer.h"
+#include "Logger.h"
+#include "RequestWorkerPool.h"
+#include "ServerObjectRequestHandlers.h"
+#include "ServerResponseHelpers.h"
+#include "ServerStateSnapshot.h"
+#include "StringUtils.h"
+#include "Version.h"
+#include "VRDevicePosePublisher.h"
+#include "WebsocketInterprocessMessageServer.h"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+	#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+using namespace std::placeholders;
+
+//-- constants -----
+// Stub editor state served to the clients
+static const int k_stubSpatialAnchorCount = 8;
+static const int k_stubQuadStencilCount = 8;
+static const int k_stubModelStencilCount = 2;
+static const int k_stubModelGridSize = 64; // 64 x 64 x 2 = 8192 triangles per model
+
+static const int64_t k_connectTimeoutNs = 10000000000ll;
+static const int64_t k_drainTimeoutNs = 1000000000ll;
+
+//-- types -----
+enum class eLoadTestRequest : int
+{
+	anchorList,
+	anchorInfo,
+	quadList,
+	quadInfo,
+	modelGeometry,
+	videoIntrinsics,
+	vrDeviceList,
+
+	COUNT
+};
+static const char* k_requestNames[(int)eLoadTestRequest::COUNT] = {
+	"anchor_list",
+	"anchor_info",
+	"quad_list",
+	"quad_info",
+	"model_geometry",
+	"video_intrinsics",
+	"vr_device_list"
+};
+static const char* k_defaultRequestMix =
+	"anchor_list=2,anchor_info=4,quad_list=2,quad_info=4,model_geometry=1,video_intrinsics=2,vr_device_list=1";
+
+struct LoadTestSettings
+{
+	int clientCount = 8;
+	double durationSeconds = 10.0;
+	// Per client, 0 only streams poses
+	double requestsPerSecond = 50.0;
+	// Per client, requests due while this many are outstanding are skipped
+	int maxRequestsInFlight = 32;
+	// Server updates (and VR pose frames) per second
+	int tickRate = 90;
+	// Every client subscribes to the poses of all of the devices
+	int vrDeviceCount = 3;
+	// 0 runs the read-only requests on the server thread too
+	int requestWorkerCount = 2;
+	std::string requestMix = k_defaultRequestMix;
+	std::string outputPath = "server_load_test.json";
+};
+
+struct LatencySample
+{
+	int requestType;
+	double microseconds;
+};
+
+struct PercentileSummary
+{
+	size_t count = 0;
+	double p50 = 0.0;
+	double p99 = 0.0;
+	double p999 = 0.0;
+	double max = 0.0;
+};
+
+//-- timing -----
+static int64_t get_time_nanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// CPU time used so far by the calling thread
+static double get_thread_cpu_seconds()
+{
+#ifdef _WIN32
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+		return 0.0;
+
+	// 100ns ticks
+	const uint64_t kernelTicks = ((uint64_t)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+	const uint64_t userTicks = ((uint64_t)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+
+	return (double)(kernelTicks + userTicks) * 1e-7;
+#else
+	struct timespec cpuTime;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime) != 0)
+		return 0.0;
+
+	return (double)cpuTime.tv_sec + (double)cpuTime.tv_nsec * 1e-9;
+#endif
+}
+
+// CPU time used so far by every thread of this process
+static double get_process_cpu_seconds()
+{
+#ifdef _WIN32
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+		return 0.0;
+
+	// 100ns ticks
+	const uint64_t kernelTicks = ((uint64_t)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+	const uint64_t userTicks = ((uint64_t)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+
+	return (double)(kernelTicks + userTicks) * 1e-7;
+#else
+	struct timespec cpuTime;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuTime) != 0)
+		return 0.0;
+
+	return (double)cpuTime.tv_sec + (double)cpuTime.tv_nsec * 1e-9;
+#endif
+}
+
+static PercentileSummary summarize_samples(std::vector<double>& samples)
+{
+	PercentileSummary summary;
+	summary.count = samples.size();
+	if (samples.empty())
+		return summary;
+
+	std::sort(samples.begin(), samples.end());
+
+	auto percentile = [&samples](double fraction) {
+		const size_t rank = (size_t)ceil(fraction * (double)samples.size());
+		return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+	};
+	summary.p50 = percentile(0.5);
+	summary.p99 = percentile(0.99);
+	summary.p999 = percentile(0.999);
+	summary.max = samples.back();
+
+	return summary;
+}
+
+//-- pose publish log -----
+// When each recent pose frame was published, so clients can measure event delivery lag.
+// Clients and server share the process, so they share the clock.
+class PosePublishLog
+{
+public:
+	void recordPublish(int64_t frame, int64_t timeNs)
+	{
+		Entry& entry = m_entries[(size_t)frame % k_capacity];
+		entry.timeNs.store(timeNs, std::memory_order_relaxed);
+		entry.frame.store(frame, std::memory_order_release);
+	}
+
+	bool tryGetPublishTime(int64_t frame, int64_t& outTimeNs) const
+	{
+		const Entry& entry = m_entries[(size_t)frame % k_capacity];
+		if (entry.frame.load(std::memory_order_acquire) != frame)
+			return false;
+
+		outTimeNs = entry.timeNs.load(std::memory_order_relaxed);
+		return true;
+	}
+
+private:
+	static const size_t k_capacity = 4096;
+
+	struct Entry
+	{
+		std::atomic<int64_t> frame{-1};
+		std::atomic<int64_t> timeNs{0};
+	};
+	Entry m_entries[k_capacity];
+};
+static PosePublishLog g_posePublishLog;
+
+//-- stub object systems -----
+// Stands in for the editor's anchor, stencil, video source and VR device systems
+class StubObjectSystems : public IServerObjectSystems
+{
+public:
+	StubObjectSystems(int vrDeviceCount)
+		: m_vrDeviceCount(vrDeviceCount)
+	{
+		buildStubState();
+	}
+
+	// The pose of every stub device moves a little each frame
+	void setFrameIndex(int64_t frameIndex) { m_frameIndex = frameIndex; }
+
+	virtual void extractStateSnapshot(
+		const ServerStateSnapshot* previousSnapshot,
+		ServerStateSnapshot& outSnapshot) const override
+	{
+		// The stub state never changes, so the model geometry is always shared
+		outSnapshot = m_stubState;
+	}
+
+	virtual void getVRDeviceIdList(std::vector<MikanVRDeviceID>& outDeviceIds) const override
+	{
+		for (int deviceId = 0; deviceId < m_vrDeviceCount; ++deviceId)
+		{
+			outDeviceIds.push_back(deviceId);
+		}
+	}
+
+	virtual bool getVRDeviceInfo(MikanVRDeviceID deviceId, MikanVRDeviceInfo& outInfo) const override
+	{
+		if (deviceId < 0 || deviceId >= m_vrDeviceCount)
+			return false;
+
+		outInfo.device_path = "stub_vr_device_" + std::to_string(deviceId);
+		outInfo.vr_device_api = MikanVRDeviceApi_STEAM_VR;
+		outInfo.vr_device_type = MikanVRDeviceType_TRACKER;
+		return true;
+	}
+
+	virtual bool getVRDevicePose(MikanVRDeviceID deviceId, MikanMatrix4f& outTransform) const override
+	{
+		if (deviceId < 0 || deviceId >= m_vrDeviceCount)
+			return false;
+
+		const float offset = (float)(m_frameIndex % 1000) * 0.001f;
+		outTransform = {
+			1.f, 0.f, 0.f, 0.f,
+			0.f, 1.f, 0.f, 0.f,
+			0.f, 0.f, 1.f, 0.f,
+			offset, 1.5f, (float)deviceId, 1.f};
+		return true;
+	}
+
+protected:
+	void buildStubState()
+	{
+		for (int anchorIndex = 0; anchorIndex < k_stubSpatialAnchorCount; ++anchorIndex)
+		{
+			MikanSpatialAnchorInfo anchorInfo = {};
+			anchorInfo.anchor_id = anchorIndex;
+			anchorInfo.anchor_name = "anchor_" + std::to_string(anchorIndex);
+
+			m_stubState.spatialAnchorIds.push_back(anchorInfo.anchor_id);
+			m_stubState.spatialAnchors.push_back(anchorInfo);
+		}
+
+		for (int stencilIndex = 0; stencilIndex < k_stubQuadStencilCount; ++stencilIndex)
+		{
+			MikanStencilQuadInfo quadInfo = {};
+			quadInfo.stencil_id = stencilIndex;
+			quadInfo.parent_anchor_id = stencilIndex % k_stubSpatialAnchorCount;
+			quadInfo.quad_width = 1.f;
+			quadInfo.quad_height = 1.f;
+			quadInfo.stencil_name = "quad_" + std::to_string(stencilIndex);
+
+			m_stubState.quadStencils.push_back(quadInfo);
+		}
+
+		for (int stencilIndex = 0; stencilIndex < k_stubModelStencilCount; ++stencilIndex)
+		{
+			MikanStencilModelInfo modelInfo = {};
+			modelInfo.stencil_id = k_stubQuadStencilCount + stencilIndex;
+			modelInfo.parent_anchor_id = stencilIndex % k_stubSpatialAnchorCount;
+			modelInfo.stencil_name = "model_" + std::to_string(stencilIndex);
+
+			ServerStateSnapshot::ModelStencilGeometry geometryEntry;
+			geometryEntry.revision = 1;
+			geometryEntry.geometry = buildStubModelGeometry(k_stubModelGridSize);
+
+			m_stubState.modelStencils.push_back(modelInfo);
+			m_stubState.modelStencilGeometry.insert({modelInfo.stencil_id, geometryEntry});
+		}
+
+		MikanMonoIntrinsics& monoIntrinsics = m_stubState.videoSourceIntrinsics.intrinsics.makeMonoIntrinsics();
+		monoIntrinsics.pixel_width = 1920.0;
+		monoIntrinsics.pixel_height = 1080.0;
+		monoIntrinsics.aspect_ratio = 16.0 / 9.0;
+		monoIntrinsics.hfov = 90.0;
+		monoIntrinsics.vfov = 58.7;
+		monoIntrinsics.znear = 0.1;
+		monoIntrinsics.zfar = 100.0;
+		m_stubState.bHasVideoSourceIntrinsics = true;
+	}
+
+	// A regular grid mesh with (gridSize x gridSize x 2) triangles
+	static ModelStencilGeometryConstPtr buildStubModelGeometry(int gridSize)
+	{
+		auto renderGeometry = std::make_shared<MikanStencilModelRenderGeometry>();
+		MikanTriagulatedMesh mesh;
+		const int vertexRowSize = gridSize + 1;
+
+		for (int row = 0; row < vertexRowSize; ++row)
+		{
+			for (int col = 0; col < vertexRowSize; ++col)
+			{
+				const float u = (float)col / (float)gridSize;
+				const float v = (float)row / (float)gridSize;
+
+				mesh.vertices.push_back({u, 0.f, v});
+				mesh.normals.push_back({0.f, 1.f, 0.f});
+				mesh.texels.push_back({u, v});
+			}
+		}
+
+		for (int row = 0; row < gridSize; ++row)
+		{
+			for (int col = 0; col < gridSize; ++col)
+			{
+				const int i0 = row * vertexRowSize + col;
+				const int i1 = i0 + 1;
+				const int i2 = i0 + vertexRowSize;
+				const int i3 = i2 + 1;
+
+				mesh.indices.push_back(i0);
+				mesh.indices.push_back(i2);
+				mesh.indices.push_back(i1);
+				mesh.indices.push_back(i1);
+				mesh.indices.push_back(i2);
+				mesh.indices.push_back(i3);
+			}
+		}
+
+		renderGeometry->meshes.push_back(mesh);
+
+		return renderGeometry;
+	}
+
+private:
+	int m_vrDeviceCount;
+	int64_t m_frameIndex = 0;
+	ServerStateSnapshot m_stubState;
+};
+
+//-- server -----
+// The editor's object request handlers and pose publisher on the same message server
+// and request worker pool as MikanServer, running against the stub object systems.
+// Only the client connection bookkeeping (init, dispose, connect events) is done here,
+// MikanServer's version of it is tied to render targets and the rest of the editor.
+class LoadTestServer
+{
+public:
+	LoadTestServer(const LoadTestSettings& settings)
+		: m_settings(settings)
+		, m_messageServer(new WebsocketInterprocessMessageServer())
+		, m_requestWorkerPool(new RequestWorkerPool())
+		, m_objectSystems(settings.vrDeviceCount)
+		, m_objectRequestHandlers(&m_objectSystems)
+		, m_vrDevicePosePublisher(
+			&m_objectSystems,
+			[this](const std::vector<std::string>& connectionIds, const std::string& mikanJsonEvent, uint64_t coalesceKey) {
+				m_messageServer->sendMessageToClients(connectionIds, mikanJsonEvent, coalesceKey);
+			})
+	{
+	}
+
+	~LoadTestServer()
+	{
+		delete m_requestWorkerPool;
+		delete m_messageServer;
+	}
+
+	bool startup()
+	{
+		if (!m_messageServer->initialize())
+		{
+			MIKAN_LOG_ERROR("LoadTestServer::startup()") << "Failed to initialize websocket message server";
+			return false;
+		}
+
+		m_messageServer->setSocketEventHandler(
+			WEBSOCKET_CONNECT_EVENT,
+			std::bind(&LoadTestServer::onClientConnectedHandler, this, _1));
+		m_messageServer->setSocketEventHandler(
+			WEBSOCKET_DISCONNECT_EVENT,
+			std::bind(&LoadTestServer::onClientDisconnectedHandler, this, _1));
+
+		// Client Init/Dispose Requests
+		m_messageServer->setRequestHandler(
+			InitClientRequest::staticGetArchetype().getId(),
+			RequestHandler::bind<&LoadTestServer::initClientHandler>(this));
+		m_messageServer->setRequestHandler(
+			DisposeClientRequest::staticGetArchetype().getId(),
+			RequestHandler::bind<&LoadTestServer::disposeClientHandler>(this));
+
+		// The editor's own anchor, stencil, video source and VR device request handlers
+		m_objectRequestHandlers.bindRequestHandlers(m_messageServer);
+		m_vrDevicePosePublisher.bindRequestHandlers(m_messageServer);
+
+		publishStateSnapshot();
+		m_messageServer->setStateSnapshotPublisher([this]() { publishStateSnapshotIfDirty(); });
+		if (m_settings.requestWorkerCount > 0)
+		{
+			if (!m_requestWorkerPool->startup(m_settings.requestWorkerCount))
+			{
+				MIKAN_LOG_ERROR("LoadTestServer::startup()") << "Failed to start request worker threads";
+				return false;
+			}
+
+			m_messageServer->setRequestWorkerPool(m_requestWorkerPool);
+		}
+
+		return true;
+	}
+
+	// One editor frame, in the same order as MikanServer::update()
+	void update()
+	{
+		m_messageServer->processSocketEvents();
+
+		publishStateSnapshotIfDirty();
+
+		m_messageServer->processRequests();
+		publishVRDevicePoses();
+		m_messageServer->flushOutboundMessages();
+	}
+
+	void shutdown()
+	{
+		m_messageServer->setRequestWorkerPool(nullptr);
+		m_messageServer->setStateSnapshotPublisher(nullptr);
+		m_requestWorkerPool->shutdown();
+
+		m_connectionBinaryFormats.clear();
+		m_vrDevicePosePublisher.clearConnections();
+		m_messageServer->dispose();
+	}
+
+	size_t getConnectionCount() const { return m_connectionBinaryFormats.size(); }
+	int64_t getFrameIndex() const { return m_frameIndex; }
+
+protected:
+	// Same as MikanServer::publishStateSnapshot()
+	void publishStateSnapshot()
+	{
+		m_objectRequestHandlers.publishStateSnapshot(m_connectionBinaryFormats);
+	}
+
+	void publishStateSnapshotIfDirty()
+	{
+		if (m_objectRequestHandlers.getIsStateSnapshotDirty())
+		{
+			publishStateSnapshot();
+		}
+	}
+
+	// Stands in for VRDeviceManager::OnDevicePosesChanged, once per server frame
+	void publishVRDevicePoses()
+	{
+		const int64_t frameIndex = ++m_frameIndex;
+
+		m_objectSystems.setFrameIndex(frameIndex);
+		g_posePublishLog.recordPublish(frameIndex, get_time_nanoseconds());
+		m_vrDevicePosePublisher.publishVRDevicePoses(frameIndex);
+	}
+
+	// Socket Event Handlers
+	void onClientConnectedHandler(const ClientSocketEvent& event)
+	{
+		bool bIsClientCompatible = false;
+		int clientProtocol = -1;
+		std::vector<std::string> protocols = StringUtils::splitString(event.eventArgs[0], ',');
+		for (const std::string& protocol : protocols)
+		{
+			std::string prefix = WEBSOCKET_PROTOCOL_PREFIX;
+			if (protocol.rfind(prefix.c_str(), 0) == 0 && protocol.length() > prefix.length())
+			{
+				clientProtocol = std::atoi(protocol.substr(prefix.length()).c_str());
+				bIsClientCompatible = clientProtocol >= MIKAN_MIN_ALLOWED_CLIENT_API_VERSION;
+				break;
+			}
+		}
+
+		// V1 until the client info says otherwise, same as MikanServer
+		m_connectionBinaryFormats[event.connectionId] = Serialization::BinaryFormat::V1;
+		m_vrDevicePosePublisher.addConnection(event.connectionId);
+		m_objectRequestHandlers.markStateSnapshotDirty();
+
+		MikanConnectedEvent connectedEvent = {};
+		connectedEvent.serverVersion.version = MIKAN_SERVER_API_VERSION;
+		connectedEvent.minClientVersion.version = MIKAN_MIN_ALLOWED_CLIENT_API_VERSION;
+		connectedEvent.isClientCompatible = bIsClientCompatible;
+
+		Serialization::serializeToJsonString(connectedEvent, m_eventJsonBuffer);
+		m_messageServer->sendMessageToClient(event.connectionId, m_eventJsonBuffer);
+	}
+
+	void onClientDisconnectedHandler(const ClientSocketEvent& event)
+	{
+		m_connectionBinaryFormats.erase(event.connectionId);
+		m_vrDevicePosePublisher.removeConnection(event.connectionId);
+		m_objectRequestHandlers.markStateSnapshotDirty();
+	}
+
+	// Client Init/Dispose Request Handlers
+	void initClientHandler(const ClientRequest& request, ClientResponse& response)
+	{
+		InitClientRequest initClientRequest;
+		if (!readTypedRequest(request, initClientRequest) ||
+			initClientRequest.clientInfo.clientId.getValue().empty())
+		{
+			writeSimpleJsonResponse(request.requestId, MikanAPIResult::MalformedParameters, response);
+			return;
+		}
+
+		auto connection_it = m_connectionBinaryFormats.find(request.connectionId);
+		const bool bIsKnownClient = connection_it != m_connectionBinaryFormats.end();
+		if (bIsKnownClient)
+		{
+			const MikanClientInfo& clientInfo = initClientRequest.clientInfo;
+
+			connection_it->second =
+				clientInfo.supportsBinaryFormatV2
+				? Serialization::BinaryFormat::V2
+				: Serialization::BinaryFormat::V1;
+			m_objectRequestHandlers.markStateSnapshotDirty();
+			m_vrDevicePosePublisher.setSupportsPoseBatch(
+				request.connectionId, clientInfo.supportsVRDevicePoseBatch);
+		}
+
+		writeSimpleJsonResponse(
+			request.requestId,
+			bIsKnownClient ? MikanAPIResult::Success : MikanAPIResult::UnknownClient,
+			response);
+	}
+
+	void disposeClientHandler(const ClientRequest& request, ClientResponse& response)
+	{
+		writeSimpleJsonResponse(request.requestId, MikanAPIResult::Success, response);
+	}
+
+private:
+	LoadTestSettings m_settings;
+	IInterprocessMessageServer* m_messageServer;
+	RequestWorkerPool* m_requestWorkerPool;
+
+	StubObjectSystems m_objectSystems;
+	ServerObjectRequestHandlers m_objectRequestHandlers;
+	VRDevicePosePublisher m_vrDevicePosePublisher;
+
+	std::map<std::string, Serialization::BinaryFormat> m_connectionBinaryFormats;
+	int64_t m_frameIndex = 0;
+	std::string m_eventJsonBuffer;
+};
+
+//-- simulated client -----
+// One client app on its own thread, talking to the server through the regular client API
+class SimulatedClient
+{
+public:
+	SimulatedClient(int clientIndex, const LoadTestSettings& settings, const std::vector<int>& requestWeights)
+		: m_clientIndex(clientIndex)
+		, m_settings(settings)
+		, m_random((unsigned int)(clientIndex + 1))
+		, m_requestDistribution(requestWeights.begin(), requestWeights.end())
+	{
+	}
+
+	void run(
+		std::atomic<int>& connectAttemptCount,
+		std::atomic<int>& finishedCount,
+		const std::atomic<bool>& bMeasuring,
+		const std::atomic<bool>& bStopRequested)
+	{
+		m_bConnected = connectToServer();
+		connectAttemptCount.fetch_add(1);
+
+		if (m_bConnected)
+		{
+			const int64_t requestIntervalNs =
+				m_settings.requestsPerSecond > 0.0
+				? (int64_t)(1e9 / m_settings.requestsPerSecond)
+				: 0;
+			int64_t nextRequestTimeNs = get_time_nanoseconds();
+			bool bWasMeasured = false;
+			double measureStartCpuSeconds = 0.0;
+
+			while (!bStopRequested.load() && !m_bDisconnected)
+			{
+				const bool bMeasured = bMeasuring.load();
+
+				// This thread's own CPU time over the measurement, taken out of the server's share
+				if (bMeasured != bWasMeasured)
+				{
+					if (bMeasured)
+						measureStartCpuSeconds = get_process_cpu_seconds();
+					else
+						m_measuredCpuSeconds += get_thread_cpu_seconds() - measureStartCpuSeconds;
+
+					bWasMeasured = bMeasured;
+				}
+
+				// Open loop: requests go out on schedule, whether or not earlier ones were answered
+				const int64_t nowNs = get_time_nanoseconds();
+				while (requestIntervalNs > 0 && nowNs >= nextRequestTimeNs)
+				{
+					if (m_inFlightCount.load() < m_settings.maxRequestsInFlight)
+					{
+						sendRandomRequest(bMeasured);
+					}
+					else if (bMeasured)
+					{
+						++m_throttledCount;
+					}
+
+					nextRequestTimeNs += requestIntervalNs;
+				}
+
+				handleEvents(bMeasured);
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			if (bWasMeasured)
+			{
+				m_measuredCpuSeconds += get_thread_cpu_seconds() - measureStartCpuSeconds;
+			}
+
+			// Let the outstanding requests finish before disconnecting
+			const int64_t drainStartNs = get_time_nanoseconds();
+			while (m_inFlightCount.load() > 0 && get_time_nanoseconds() - drainStartNs < k_drainTimeoutNs)
+			{
+				handleEvents(false);
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			m_api->disconnect();
+		}
+
+		if (m_api)
+		{
+			m_api->shutdown();
+		}
+
+		finishedCount.fetch_add(1);
+	}
+
+	bool getIsConnected() const { return m_bConnected; }
+	uint64_t getSentCount() const { return m_sentCount; }
+	uint64_t getThrottledCount() const { return m_throttledCount; }
+	uint64_t getPoseEventCount() const { return m_poseEventCount; }
+	double getMeasuredCpuSeconds() const { return m_measuredCpuSeconds; }
+	const std::vector<double>& getEventLagSamples() const { return m_eventLagSamples; }
+
+	// Only call once the client thread is done
+	const std::vector<LatencySample>& getLatencySamples() const { return m_latencySamples; }
+	uint64_t getFailedCount() const { return m_failedCount; }
+
+protected:
+	bool connectToServer()
+	{
+		m_api = IMikanAPI::createMikanAPI();
+		if (m_api->init(MikanLogLevel_Warning, nullptr) != MikanAPIResult::Success ||
+			m_api->connect() != MikanAPIResult::Success)
+		{
+			return false;
+		}
+
+		// The server says hello before it takes any requests
+		bool bGotConnectedEvent = false;
+		const int64_t connectStartNs = get_time_nanoseconds();
+		while (!bGotConnectedEvent && get_time_nanoseconds() - connectStartNs < k_connectTimeoutNs)
+		{
+			m_api->fetchEvents(m_events);
+			for (const MikanEventPtr& mikanEvent : m_events)
+			{
+				if (typeid(*mikanEvent) == typeid(MikanConnectedEvent))
+				{
+					bGotConnectedEvent = true;
+				}
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		if (!bGotConnectedEvent)
+			return false;
+
+		MikanClientInfo clientInfo = m_api->allocateClientInfo();
+		clientInfo.engineName = "MikanXR Load Test";
+		clientInfo.engineVersion = "1.0";
+		clientInfo.applicationName = "load_test_client_" + std::to_string(m_clientIndex);
+		clientInfo.applicationVersion = "1.0";
+
+		InitClientRequest initClientRequest = {};
+		initClientRequest.clientInfo = clientInfo;
+		if (!getIsSuccessResponse(m_api->sendRequest(initClientRequest).fetchResponse()))
+			return false;
+
+		for (int deviceId = 0; deviceId < m_settings.vrDeviceCount; ++deviceId)
+		{
+			SubscribeToVRDevicePoseUpdates subscribeRequest;
+			subscribeRequest.deviceId = deviceId;
+
+			if (!getIsSuccessResponse(m_api->sendRequest(subscribeRequest).fetchResponse()))
+				return false;
+		}
+
+		return true;
+	}
+
+	static bool getIsSuccessResponse(const MikanResponsePtr& response)
+	{
+		return response && response->resultCode == MikanAPIResult::Success;
+	}
+
+	MikanResponseFuture sendLoadTestRequest(eLoadTestRequest requestType)
+	{
+		switch (requestType)
+		{
+			case eLoadTestRequest::anchorList:
+			{
+				GetSpatialAnchorList request;
+				return m_api->sendRequest(request);
+			}
+			case eLoadTestRequest::anchorInfo:
+			{
+				GetSpatialAnchorInfo request;
+				request.anchorId = (MikanSpatialAnchorID)(m_random() % k_stubSpatialAnchorCount);
+				return m_api->sendRequest(request);
+			}
+			case eLoadTestRequest::quadList:
+			{
+				GetQuadStencilList request;
+				return m_api->sendRequest(request);
+			}
+			case eLoadTestRequest::quadInfo:
+			{
+				GetQuadStencil request;
+				request.stencilId = (MikanStencilID)(m_random() % k_stubQuadStencilCount);
+				return m_api->sendRequest(request);
+			}
+			case eLoadTestRequest::modelGeometry:
+			{
+				GetModelStencilRenderGeometry request;
+				request.stencilId = (MikanStencilID)(k_stubQuadStencilCount + m_random() % k_stubModelStencilCount);
+				return m_api->sendRequest(request);
+			}
+			case eLoadTestRequest::videoIntrinsics:
+			{
+				GetVideoSourceIntrinsics request;
+				return m_api->sendRequest(request);
+			}
+			case eLoadTestRequest::vrDeviceList:
+			default:
+			{
+				GetVRDeviceList request;
+				return m_api->sendRequest(request);
+			}
+		}
+	}
+
+	void sendRandomRequest(bool bMeasured)
+	{
+		const int requestType = m_requestDistribution(m_random);
+		const int64_t sendTimeNs = get_time_nanoseconds();
+
+		MikanResponseFuture future = sendLoadTestRequest((eLoadTestRequest)requestType);
+		if (bMeasured)
+		{
+			++m_sentCount;
+		}
+
+		if (!future.isValid())
+		{
+			recordResponse(requestType, sendTimeNs, MikanResponsePtr(), bMeasured, false);
+			return;
+		}
+
+		// Timed on the socket thread as soon as the response arrives
+		m_inFlightCount.fetch_add(1);
+		SimulatedClient* client = this;
+		future.then(
+			[client, requestType, sendTimeNs, bMeasured](MikanResponsePtr response) {
+				client->recordResponse(requestType, sendTimeNs, response, bMeasured, true);
+			},
+			MikanResponseExecutor::Immediate);
+	}
+
+	void recordResponse(
+		int requestType,
+		int64_t sendTimeNs,
+		const MikanResponsePtr& response,
+		bool bMeasured,
+		bool bWasInFlight)
+	{
+		const double latencyMicroseconds = (double)(get_time_nanoseconds() - sendTimeNs) / 1000.0;
+
+		if (bMeasured)
+		{
+			std::lock_guard<std::mutex> lock(m_resultsMutex);
+
+			if (getIsSuccessResponse(response))
+			{
+				m_latencySamples.push_back({requestType, latencyMicroseconds});
+			}
+			else
+			{
+				++m_failedCount;
+			}
+		}
+
+		if (bWasInFlight)
+		{
+			m_inFlightCount.fetch_sub(1);
+		}
+	}
+
+	void handleEvents(bool bMeasured)
+	{
+		m_api->fetchEvents(m_events);
+
+		const int64_t receiveTimeNs = get_time_nanoseconds();
+		for (const MikanEventPtr& mikanEvent : m_events)
+		{
+			if (typeid(*mikanEvent) == typeid(MikanVRDevicePoseBatchEvent))
+			{
+				auto poseBatchEvent = std::static_pointer_cast<MikanVRDevicePoseBatchEvent>(mikanEvent);
+
+				recordPoseEvent(poseBatchEvent->frame, receiveTimeNs, bMeasured);
+			}
+			else if (typeid(*mikanEvent) == typeid(MikanVRDevicePoseUpdateEvent))
+			{
+				auto poseEvent = std::static_pointer_cast<MikanVRDevicePoseUpdateEvent>(mikanEvent);
+
+				recordPoseEvent(poseEvent->frame, receiveTimeNs, bMeasured);
+			}
+			else if (typeid(*mikanEvent) == typeid(MikanDisconnectedEvent))
+			{
+				m_bDisconnected = true;
+			}
+		}
+	}
+
+	void recordPoseEvent(int64_t frame, int64_t receiveTimeNs, bool bMeasured)
+	{
+		int64_t publishTimeNs;
+		if (bMeasured && g_posePublishLog.tryGetPublishTime(frame, publishTimeNs))
+		{
+			++m_poseEventCount;
+			m_eventLagSamples.push_back((double)(receiveTimeNs - publishTimeNs) / 1000.0);
+		}
+	}
+
+private:
+	int m_clientIndex;
+	const LoadTestSettings& m_settings;
+	IMikanAPIPtr m_api;
+	std::vector<MikanEventPtr> m_events;
+
+	std::mt19937 m_random;
+	std::discrete_distribution<int> m_requestDistribution;
+
+	bool m_bConnected = false;
+	bool m_bDisconnected = false;
+	std::atomic<int> m_inFlightCount{0};
+
+	// Client thread only
+	uint64_t m_sentCount = 0;
+	uint64_t m_throttledCount = 0;
+	uint64_t m_poseEventCount = 0;
+	double m_measuredCpuSeconds = 0.0;
+	std::vector<double> m_eventLagSamples;
+
+	// Also written by the socket thread (response callbacks)
+	std::mutex m_resultsMutex;
+	std::vector<LatencySample> m_latencySamples;
+	uint64_t m_failedCount = 0;
+};
+
+//-- reporting -----
+static nlohmann::json summary_to_json(const PercentileSummary& summary)
+{
+	return {
+		{"count", summary.count},
+		{"p50_us", summary.p50},
+		{"p99_us", summary.p99},
+		{"p999_us", summary.p999},
+		{"max_us", summary.max}
+	};
+}
+
+static void print_summary(const char* name, const PercentileSummary& summary)
+{
+	fprintf(stdout, "  %-20s %10zu samples  p50 %10.1f us  p99 %10.1f us  p999 %10.1f us  max %10.1f us\n",
+			name, summary.count, summary.p50, summary.p99, summary.p999, summary.max);
+}
+
+static bool parse_request_mix(const std::string& requestMix, std::vector<int>& outWeights)
+{
+	outWeights.assign((size_t)eLoadTestRequest::COUNT, 0);
+
+	int totalWeight = 0;
+	for (const std::string& entry : StringUtils::splitString(requestMix, ','))
+	{
+		const size_t separator = entry.find('=');
+		const std::string name = entry.substr(0, separator);
+		const int weight = separator != std::string::npos ? atoi(entry.substr(separator + 1).c_str()) : 1;
+
+		auto name_it = std::find_if(
+			std::begin(k_requestNames), std::end(k_requestNames),
+			[&name](const char* requestName) { return name == requestName; });
+		if (name_it == std::end(k_requestNames) || weight < 0)
+		{
+			fprintf(stderr, "Unknown request mix entry: %s\n", entry.c_str());
+			return false;
+		}
+
+		outWeights[name_it - std::begin(k_requestNames)] = weight;
+		totalWeight += weight;
+	}
+
+	if (totalWeight <= 0)
+	{
+		fprintf(stderr, "Request mix has no requests: %s\n", requestMix.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+static bool parse_arguments(int argc, char* argv[], LoadTestSettings& outSettings)
+{
+	for (int argIndex = 1; argIndex < argc; ++argIndex)
+	{
+		const bool bHasValue = argIndex + 1 < argc;
+
+		if (strcmp(argv[argIndex], "--clients") == 0 && bHasValue)
+		{
+			outSettings.clientCount = atoi(argv[++argIndex]);
+		}
+		else if (strcmp(argv[argIndex], "--duration-sec") == 0 && bHasValue)
+		{
+			outSettings.durationSeconds = atof(argv[++argIndex]);
+		}
+		else if (strcmp(argv[argIndex], "--rate") == 0 && bHasValue)
+		{
+			outSettings.requestsPerSecond = atof(argv[++argIndex]);
+		}
+		else if (strcmp(argv[argIndex], "--max-in-flight") == 0 && bHasValue)
+		{
+			outSettings.maxRequestsInFlight = atoi(argv[++argIndex]);
+		}
+		else if (strcmp(argv[argIndex], "--tick-hz") == 0 && bHasValue)
+		{
+			outSettings.tickRate = atoi(argv[++argIndex]);
+		}
+		else if (strcmp(argv[argIndex], "--devices") == 0 && bHasValue)
+		{
+			outSettings.vrDeviceCount = atoi(argv[++argIndex]);
+		}
+		else if (strcmp(argv[argIndex], "--workers") == 0 && bHasValue)
+		{
+			outSettings.requestWorkerCount = atoi(argv[++argIndex]);
+		}
+		else if (strcmp(argv[argIndex], "--mix") == 0 && bHasValue)
+		{
+			outSettings.requestMix = argv[++argIndex];
+		}
+		else if (strcmp(argv[argIndex], "--out") == 0 && bHasValue)
+		{
+			outSettings.outputPath = argv[++argIndex];
+		}
+		else
+		{
+			fprintf(stderr,
+				"Usage: %s [--clients <count>] [--duration-sec <seconds>] [--rate <requests/sec per client>]\n"
+				"          [--max-in-flight <requests per client>] [--tick-hz <server updates/sec>]\n"
+				"          [--devices <VR devices>] [--workers <request worker threads>]\n"
+				"          [--mix <name=weight,...>] [--out <results.json>]\n"
+				"Request names: anchor_list, anchor_info, quad_list, quad_info, model_geometry,\n"
+				"               video_intrinsics, vr_device_list\n",
+				argv[0]);
+			return false;
+		}
+	}
+
+	if (outSettings.clientCount < 1 || outSettings.tickRate < 1 || outSettings.durationSeconds <= 0.0)
+	{
+		fprintf(stderr, "--clients, --tick-hz and --duration-sec must be positive\n");
+		return false;
+	}
+
+	return true;
+}
+
+//-- entry point -----
+int
+main(int argc, char* argv[])
+{
+	LoadTestSettings settings;
+	std::vector<int> requestWeights;
+	if (!parse_arguments(argc, argv, settings) ||
+		!parse_request_mix(settings.requestMix, requestWeights))
+	{
+		return EXIT_FAILURE;
+	}
+
+	LoggerSettings loggerSettings = {};
+	loggerSettings.min_log_level = LogSeverityLevel::warning;
+	loggerSettings.enable_console = true;
+	log_init(loggerSettings);
+
+	LoadTestServer server(settings);
+	if (!server.startup())
+	{
+		log_dispose();
+		return EXIT_FAILURE;
+	}
+
+	fprintf(stdout, "Running Mikan Server Load Test: %d clients, %.1f requests/sec each, %d Hz, %d VR devices, %d workers.\n",
+			settings.clientCount, settings.requestsPerSecond, settings.tickRate,
+			settings.vrDeviceCount, settings.requestWorkerCount);
+
+	std::atomic<int> connectAttemptCount(0);
+	std::atomic<int> finishedCount(0);
+	std::atomic<bool> bMeasuring(false);
+	std::atomic<bool> bStopRequested(false);
+
+	std::vector<std::unique_ptr<SimulatedClient>> clients;
+	std::vector<std::thread> clientThreads;
+	for (int clientIndex = 0; clientIndex < settings.clientCount; ++clientIndex)
+	{
+		clients.push_back(std::make_unique<SimulatedClient>(clientIndex, settings, requestWeights));
+		clientThreads.emplace_back(
+			&SimulatedClient::run, clients.back().get(),
+			std::ref(connectAttemptCount), std::ref(finishedCount),
+			std::cref(bMeasuring), std::cref(bStopRequested));
+	}
+
+	// The server runs on this thread, at the editor's frame rate.
+	// Measuring starts once every client has connected (or given up).
+	enum class ePhase { connecting, measuring, stopping };
+	ePhase phase = ePhase::connecting;
+
+	const int64_t tickIntervalNs = 1000000000ll / settings.tickRate;
+	const int64_t startTimeNs = get_time_nanoseconds();
+	int64_t nextTickTimeNs = startTimeNs;
+	int64_t measureStartNs = 0;
+	int64_t measureEndNs = 0;
+	int64_t measureStartFrame = 0;
+	int64_t measureEndFrame = 0;
+	double measureStartCpuSeconds = 0.0;
+	double measureEndCpuSeconds = 0.0;
+	uint64_t lateTickCount = 0;
+
+	while (true)
+	{
+		const int64_t tickStartNs = get_time_nanoseconds();
+		server.update();
+		const int64_t tickEndNs = get_time_nanoseconds();
+
+		if (phase == ePhase::connecting)
+		{
+			if (connectAttemptCount.load() == settings.clientCount ||
+				tickEndNs - startTimeNs > k_connectTimeoutNs)
+			{
+				measureStartNs = tickEndNs;
+				measureStartFrame = server.getFrameIndex();
+				measureStartCpuSeconds = get_process_cpu_seconds();
+				bMeasuring = true;
+				phase = ePhase::measuring;
+			}
+		}
+		else if (phase == ePhase::measuring)
+		{
+			if (tickEndNs - tickStartNs > tickIntervalNs)
+			{
+				++lateTickCount;
+			}
+
+			if ((double)(tickEndNs - measureStartNs) * 1e-9 >= settings.durationSeconds)
+			{
+				bMeasuring = false;
+				measureEndNs = tickEndNs;
+				measureEndFrame = server.getFrameIndex();
+				measureEndCpuSeconds = get_process_cpu_seconds();
+				bStopRequested = true;
+				phase = ePhase::stopping;
+			}
+		}
+		else if (finishedCount.load() == settings.clientCount)
+		{
+			break;
+		}
+
+		// Fixed rate, without trying to catch up on missed ticks
+		nextTickTimeNs += tickIntervalNs;
+		const int64_t nowNs = get_time_nanoseconds();
+		if (nextTickTimeNs > nowNs)
+		{
+			std::this_thread::sleep_for(std::chrono::nanoseconds(nextTickTimeNs - nowNs));
+		}
+		else
+		{
+			nextTickTimeNs = nowNs;
+		}
+	}
+
+	for (std::thread& clientThread : clientThreads)
+	{
+		clientThread.join();
+	}
+
+	server.shutdown();
+
+	// Gather the results
+	int connectedClientCount = 0;
+	uint64_t sentCount = 0;
+	uint64_t failedCount = 0;
+	uint64_t throttledCount = 0;
+	uint64_t poseEventCount = 0;
+	double clientCpuSeconds = 0.0;
+	std::vector<double> allLatencies;
+	std::vector<std::vector<double>> latenciesByType((size_t)eLoadTestRequest::COUNT);
+	std::vector<double> eventLags;
+	for (const std::unique_ptr<SimulatedClient>& client : clients)
+	{
+		if (client->getIsConnected())
+		{
+			++connectedClientCount;
+		}
+
+		sentCount += client->getSentCount();
+		failedCount += client->getFailedCount();
+		throttledCount += client->getThrottledCount();
+		poseEventCount += client->getPoseEventCount();
+		clientCpuSeconds += client->getMeasuredCpuSeconds();
+
+		for (const LatencySample& sample : client->getLatencySamples())
+		{
+			allLatencies.push_back(sample.microseconds);
+			latenciesByType[sample.requestType].push_back(sample.microseconds);
+		}
+
+		const std::vector<double>& clientEventLags = client->getEventLagSamples();
+		eventLags.insert(eventLags.end(), clientEventLags.begin(), clientEventLags.end());
+	}
+
+	const double measuredSeconds = (double)(measureEndNs - measureStartNs) * 1e-9;
+	// The simulated clients share the process with the server (main, request worker and socket threads),
+	// so the server gets the process CPU time minus what the client threads measured for themselves
+	const double processCpuSeconds = measureEndCpuSeconds - measureStartCpuSeconds;
+	const double serverCpuSeconds = std::max(processCpuSeconds - clientCpuSeconds, 0.0);
+	const double processCpuPercent = measuredSeconds > 0.0 ? 100.0 * processCpuSeconds / measuredSeconds : 0.0;
+	const double serverCpuPercent = measuredSeconds > 0.0 ? 100.0 * serverCpuSeconds / measuredSeconds : 0.0;
+	const double serverCpuPercentPerClient =
+		connectedClientCount > 0 ? serverCpuPercent / (double)connectedClientCount : 0.0;
+	const uint64_t answeredCount = (uint64_t)allLatencies.size() + failedCount;
+	const uint64_t unansweredCount = sentCount > answeredCount ? sentCount - answeredCount : 0;
+	const int64_t publishedFrameCount = measureEndFrame - measureStartFrame;
+
+	const PercentileSummary latencySummary = summarize_samples(allLatencies);
+	const PercentileSummary eventLagSummary = summarize_samples(eventLags);
+
+	fprintf(stdout, "Clients: %d of %d connected, measured for %.2f s\n",
+			connectedClientCount, settings.clientCount, measuredSeconds);
+	fprintf(stdout, "Requests: %llu sent, %zu succeeded, %llu failed, %llu unanswered, %llu skipped (in-flight limit)\n",
+			(unsigned long long)sentCount, allLatencies.size(), (unsigned long long)failedCount,
+			(unsigned long long)unansweredCount, (unsigned long long)throttledCount);
+	fprintf(stdout, "Request latency:\n");
+	print_summary("all", latencySummary);
+
+	nlohmann::json jsonLatencyByType = nlohmann::json::object();
+	for (int requestType = 0; requestType < (int)eLoadTestRequest::COUNT; ++requestType)
+	{
+		if (requestWeights[requestType] > 0)
+		{
+			const PercentileSummary typeSummary = summarize_samples(latenciesByType[requestType]);
+
+			print_summary(k_requestNames[requestType], typeSummary);
+			jsonLatencyByType[k_requestNames[requestType]] = summary_to_json(typeSummary);
+		}
+	}
+
+	fprintf(stdout, "Pose events: %lld frames published, %llu events received (coalesced frames are skipped)\n",
+			(long long)publishedFrameCount, (unsigned long long)poseEventCount);
+	print_summary("event lag", eventLagSummary);
+	fprintf(stdout, "Server CPU: %.1f%% of a core (%.3f%% per client), %llu late ticks\n",
+			serverCpuPercent, serverCpuPercentPerClient, (unsigned long long)lateTickCount);
+	fprintf(stdout, "  (process CPU %.1f%% minus the simulated client threads, client socket threads are still included)\n",
+			processCpuPercent);
+
+	nlohmann::json jsonReport = {
+		{"benchmark", "server_load"},
+		{"version", 2},
+		{"settings", {
+			{"clients", settings.clientCount},
+			{"duration_sec", settings.durationSeconds},
+			{"requests_per_sec", settings.requestsPerSecond},
+			{"max_in_flight", settings.maxRequestsInFlight},
+			{"tick_hz", settings.tickRate},
+			{"vr_devices", settings.vrDeviceCount},
+			{"request_workers", settings.requestWorkerCount},
+			{"request_mix", settings.requestMix}
+		}},
+		{"results", {
+			{"connected_clients", connectedClientCount},
+			{"measured_sec", measuredSeconds},
+			{"requests_sent", sentCount},
+			{"requests_succeeded", allLatencies.size()},
+			{"requests_failed", failedCount},
+			{"requests_unanswered", unansweredCount},
+			{"requests_skipped", throttledCount},
+			{"request_latency", summary_to_json(latencySummary)},
+			{"request_latency_by_type", jsonLatencyByType},
+			{"pose_frames_published", publishedFrameCount},
+			{"pose_events_received", poseEventCount},
+			{"event_lag", summary_to_json(eventLagSummary)},
+			{"process_cpu_percent", processCpuPercent},
+			{"server_cpu_percent", serverCpuPercent},
+			{"server_cpu_percent_per_client", serverCpuPercentPerClient},
+			{"late_ticks", lateTickCount}
+		}}
+	};
+
+	bool bWroteResults = false;
+	std::ofstream outputFile(settings.outputPath);
+	if (outputFile)
+	{
+		outputFile << jsonReport.dump(2) << std::endl;
+		fprintf(stdout, "Wrote results to %s\n", settings.outputPath.c_str());
+		bWroteResults = true;
+	}
+	else
+	{
+		fprintf(stderr, "Failed to open results file: %s\n", settings.outputPath.c_str());
+	}
+
+	log_dispose();
+
+	return (bWroteResults && connectedClientCount == settings.clientCount) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
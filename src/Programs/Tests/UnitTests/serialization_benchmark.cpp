@@ -0,0 +1,363 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MikanStencilRequests.h"
+#include "MikanVideoSourceRequests.h"
+#include "MikanVRDeviceEvents.h"
+
+#include "BinarySerializer.h"
+#include "BinaryDeserializer.h"
+#include "JsonSerializer.h"
+#include "JsonDeserializer.h"
+#include "SerializableList.h"
+
+#include "nlohmann/json.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+//-- allocation tracking -----
+// Counts every allocation made through the global operator new.
+// NOTE: On Windows each DLL links its own CRT allocator, so allocations made inside
+// MikanSerialization.dll are only counted when the libraries are built statically.
+static std::atomic<uint64_t> g_allocationCount(0);
+
+void* operator new(std::size_t size)
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	void* ptr = malloc(size > 0 ? size : 1);
+	if (ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	free(ptr);
+}
+
+//-- types -----
+struct BenchmarkResult
+{
+	std::string payloadName;
+	std::string format;
+	std::string operation;
+	size_t payloadBytes;
+	uint64_t iterations;
+	double nsPerOp;
+	double mbPerSec;
+	double allocsPerOp;
+};
+
+struct BenchmarkSettings
+{
+	double minTimeSeconds = 0.25;
+	uint64_t minIterations = 5;
+	std::string outputPath = "serialization_benchmark.json";
+};
+
+//-- payloads -----
+static void build_pose_event(MikanVRDevicePoseUpdateEvent& outEvent)
+{
+	outEvent.transform = {
+		1.f, 0.f, 0.f, 0.f,
+		0.f, 1.f, 0.f, 0.f,
+		0.f, 0.f, 1.f, 0.f,
+		0.25f, 1.5f, -0.75f, 1.f};
+	outEvent.device_id = 3;
+	outEvent.frame = 123456;
+}
+
+static void build_stencil_list(MikanStencilListResponse& outResponse)
+{
+	outResponse.requestId = 42;
+	outResponse.resultCode = MikanAPIResult::Success;
+	for (MikanStencilID stencilId = 0; stencilId < 64; ++stencilId)
+	{
+		outResponse.stencil_id_list.push_back(stencilId);
+	}
+}
+
+// A regular grid mesh with (gridSize x gridSize x 2) triangles
+static void build_model_geometry(MikanStencilModelRenderGeometryResponse& outResponse, int gridSize)
+{
+	MikanTriagulatedMesh mesh;
+	const int vertexRowSize = gridSize + 1;
+
+	for (int row = 0; row < vertexRowSize; ++row)
+	{
+		for (int col = 0; col < vertexRowSize; ++col)
+		{
+			const float u = (float)col / (float)gridSize;
+			const float v = (float)row / (float)gridSize;
+
+			mesh.vertices.push_back({u, 0.f, v});
+			mesh.normals.push_back({0.f, 1.f, 0.f});
+			mesh.texels.push_back({u, v});
+		}
+	}
+
+	for (int row = 0; row < gridSize; ++row)
+	{
+		for (int col = 0; col < gridSize; ++col)
+		{
+			const int i0 = row * vertexRowSize + col;
+			const int i1 = i0 + 1;
+			const int i2 = i0 + vertexRowSize;
+			const int i3 = i2 + 1;
+
+			mesh.indices.push_back(i0);
+			mesh.indices.push_back(i2);
+			mesh.indices.push_back(i1);
+			mesh.indices.push_back(i1);
+			mesh.indices.push_back(i2);
+			mesh.indices.push_back(i3);
+		}
+	}
+
+	outResponse.requestId = 43;
+	outResponse.resultCode = MikanAPIResult::Success;
+	outResponse.render_geometry.meshes.push_back(mesh);
+}
+
+static void build_polymorphic_intrinsics(MikanVideoSourceIntrinsicsResponse& outResponse)
+{
+	MikanStereoIntrinsics& stereoIntrinsics = outResponse.intrinsics.makeStereoIntrinsics();
+	stereoIntrinsics.pixel_width = 1920.0;
+	stereoIntrinsics.pixel_height = 1080.0;
+	stereoIntrinsics.aspect_ratio = 16.0 / 9.0;
+	stereoIntrinsics.hfov = 90.0;
+	stereoIntrinsics.vfov = 58.7;
+	stereoIntrinsics.znear = 0.1;
+	stereoIntrinsics.zfar = 100.0;
+	stereoIntrinsics.translation_between_cameras = {0.064, 0.0, 0.0};
+
+	outResponse.requestId = 44;
+	outResponse.resultCode = MikanAPIResult::Success;
+}
+
+//-- timing -----
+// Runs the operation until both the minimum time and iteration count are reached
+static BenchmarkResult run_benchmark(
+	const BenchmarkSettings& settings,
+	const char* payloadName,
+	const char* format,
+	const char* operation,
+	size_t payloadBytes,
+	const std::function<bool()>& operationFunc)
+{
+	using clock = std::chrono::steady_clock;
+
+	// Warm up (compiles and caches the struct plans, grows reused buffers)
+	if (!operationFunc())
+	{
+		fprintf(stderr, "  %s %s %s failed!\n", payloadName, format, operation);
+	}
+
+	uint64_t iterations = 0;
+	const uint64_t startAllocations = g_allocationCount.load();
+	const clock::time_point startTime = clock::now();
+	double elapsedSeconds = 0.0;
+
+	while (iterations < settings.minIterations || elapsedSeconds < settings.minTimeSeconds)
+	{
+		operationFunc();
+		++iterations;
+
+		elapsedSeconds = std::chrono::duration<double>(clock::now() - startTime).count();
+	}
+
+	const uint64_t allocations = g_allocationCount.load() - startAllocations;
+
+	BenchmarkResult result;
+	result.payloadName = payloadName;
+	result.format = format;
+	result.operation = operation;
+	result.payloadBytes = payloadBytes;
+	result.iterations = iterations;
+	result.nsPerOp = elapsedSeconds * 1e9 / (double)iterations;
+	result.mbPerSec = ((double)payloadBytes * (double)iterations) / (elapsedSeconds * 1024.0 * 1024.0);
+	result.allocsPerOp = (double)allocations / (double)iterations;
+
+	fprintf(stdout, "  %-16s %-6s %-11s %10zu bytes %14.1f ns/op %10.2f MB/s %10.1f allocs/op\n",
+			payloadName, format, operation, payloadBytes,
+			result.nsPerOp, result.mbPerSec, result.allocsPerOp);
+
+	return result;
+}
+
+// Times serialize + deserialize in the json and both binary formats for one payload type
+template <typename t_payload_type>
+static void benchmark_payload(
+	const BenchmarkSettings& settings,
+	const char* payloadName,
+	const t_payload_type& payload,
+	std::vector<BenchmarkResult>& outResults)
+{
+	// Output buffers are reused across iterations, like the server and client do
+	std::string jsonString;
+	std::vector<uint8_t> bytes;
+	std::vector<uint8_t> v2Bytes;
+
+	Serialization::serializeToJsonString(payload, jsonString);
+	Serialization::serializeToBytes(payload, bytes);
+	Serialization::serializeToBytes(payload, v2Bytes, Serialization::BinaryFormat::V2);
+
+	outResults.push_back(
+		run_benchmark(settings, payloadName, "json", "serialize", jsonString.size(),
+			[&payload, &jsonString]() {
+				return Serialization::serializeToJsonString(payload, jsonString);
+			}));
+	outResults.push_back(
+		run_benchmark(settings, payloadName, "json", "deserialize", jsonString.size(),
+			[&jsonString]() {
+				t_payload_type instance;
+				return Serialization::deserializeFromJsonString(jsonString, instance);
+			}));
+	outResults.push_back(
+		run_benchmark(settings, payloadName, "binary", "serialize", bytes.size(),
+			[&payload, &bytes]() {
+				bytes.clear();
+				return Serialization::serializeToBytes(payload, bytes);
+			}));
+	outResults.push_back(
+		run_benchmark(settings, payloadName, "binary", "deserialize", bytes.size(),
+			[&bytes]() {
+				t_payload_type instance;
+				return Serialization::deserializeFromBytes(bytes, instance);
+			}));
+	outResults.push_back(
+		run_benchmark(settings, payloadName, "binv2", "serialize", v2Bytes.size(),
+			[&payload, &v2Bytes]() {
+				v2Bytes.clear();
+				return Serialization::serializeToBytes(payload, v2Bytes, Serialization::BinaryFormat::V2);
+			}));
+	outResults.push_back(
+		run_benchmark(settings, payloadName, "binv2", "deserialize", v2Bytes.size(),
+			[&v2Bytes]() {
+				t_payload_type instance;
+				return Serialization::deserializeFromBytes(v2Bytes, instance, Serialization::BinaryFormat::V2);
+			}));
+}
+
+static bool write_results(const BenchmarkSettings& settings, const std::vector<BenchmarkResult>& results)
+{
+	nlohmann::json jsonResults = nlohmann::json::array();
+	for (const BenchmarkResult& result : results)
+	{
+		jsonResults.push_back({
+			{"payload", result.payloadName},
+			{"format", result.format},
+			{"operation", result.operation},
+			{"payload_bytes", result.payloadBytes},
+			{"iterations", result.iterations},
+			{"ns_per_op", result.nsPerOp},
+			{"mb_per_sec", result.mbPerSec},
+			{"allocs_per_op", result.allocsPerOp}
+		});
+	}
+
+	nlohmann::json jsonReport = {
+		{"benchmark", "serialization"},
+		{"version", 1},
+		{"results", jsonResults}
+	};
+
+	std::ofstream outputFile(settings.outputPath);
+	if (!outputFile)
+	{
+		fprintf(stderr, "Failed to open benchmark output file: %s\n", settings.outputPath.c_str());
+		return false;
+	}
+
+	outputFile << jsonReport.dump(2) << std::endl;
+	fprintf(stdout, "Wrote results to %s\n", settings.outputPath.c_str());
+
+	return true;
+}
+
+static bool parse_arguments(int argc, char* argv[], BenchmarkSettings& outSettings)
+{
+	for (int argIndex = 1; argIndex < argc; ++argIndex)
+	{
+		if (strcmp(argv[argIndex], "--out") == 0 && argIndex + 1 < argc)
+		{
+			outSettings.outputPath = argv[++argIndex];
+		}
+		else if (strcmp(argv[argIndex], "--min-time-ms") == 0 && argIndex + 1 < argc)
+		{
+			outSettings.minTimeSeconds = atof(argv[++argIndex]) / 1000.0;
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--out <results.json>] [--min-time-ms <milliseconds>]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//-- entry point -----
+int
+main(int argc, char* argv[])
+{
+	BenchmarkSettings settings;
+	if (!parse_arguments(argc, argv, settings))
+	{
+		return EXIT_FAILURE;
+	}
+
+	std::vector<BenchmarkResult> results;
+	fprintf(stdout, "Running Serialization Benchmarks.\n");
+
+	MikanVRDevicePoseUpdateEvent poseEvent;
+	build_pose_event(poseEvent);
+	benchmark_payload(settings, "pose_event", poseEvent, results);
+
+	MikanStencilListResponse stencilList;
+	build_stencil_list(stencilList);
+	benchmark_payload(settings, "stencil_list", stencilList, results);
+
+	// 224 x 224 x 2 = 100352 triangles
+	MikanStencilModelRenderGeometryResponse modelGeometry;
+	build_model_geometry(modelGeometry, 224);
+	benchmark_payload(settings, "model_geometry", modelGeometry, results);
+
+	MikanVideoSourceIntrinsicsResponse intrinsics;
+	build_polymorphic_intrinsics(intrinsics);
+	benchmark_payload(settings, "polymorphic_ptr", intrinsics, results);
+
+	return write_results(settings, results) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,6 +4,7 @@
 #include <assert.h>
 
 #include "MikanRemoteControlRequests.h"
+#include "MikanVRDeviceEvents.h"
 
 #include "BinarySerializer.h"
 #include "BinaryDeserializer.h"
@@ -13,6 +14,9 @@
 #include "MathUtility.h"
 #include "SerializableList.h"
 #include "SerializableMap.h"
+#include "SerializationInstancePool.h"
+
+#include "nlohmann/json.hpp"
 
 #include "serialization_unit_tests.h"
 #include "serialization_unit_tests.rfks.h"
@@ -25,7 +29,16 @@ bool run_serialization_unit_tests()
 		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_endian_swap);
 		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_reflection_from_json);
 		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_reflection_from_bytes);
+		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_repeated_serialization);
+		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_packed_list_bytes);
+		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_serialized_size);
+		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_binary_format_v2);
+		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_instance_pool);
+		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_json_stream_matches_dom);
+		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_json_sax_matches_dom);
 		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_remote_control);
+		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_binary_request_header);
+		UNIT_TEST_MODULE_CALL_TEST(serialization_utility_test_vr_device_pose_batch);
 	UNIT_TEST_MODULE_END()
 }
 
@@ -232,6 +245,302 @@ bool serialization_utility_test_reflection_from_bytes()
 	UNIT_TEST_COMPLETE()
 }
 
+bool serialization_utility_test_repeated_serialization()
+{
+	UNIT_TEST_BEGIN("repeated serialization")
+		SerializationTestStruct expected;
+		build_serialization_test_struct(expected);
+
+		// The first call compiles and caches the struct plan, later calls reuse it.
+		// Both must produce exactly the same output.
+		std::string firstJsonString;
+		std::string secondJsonString;
+		bool bCanSerialize= Serialization::serializeToJsonString(expected, firstJsonString);
+		bCanSerialize&= Serialization::serializeToJsonString(expected, secondJsonString);
+		assert(bCanSerialize);
+		assert(firstJsonString == secondJsonString);
+
+		std::vector<uint8_t> firstBytes;
+		std::vector<uint8_t> secondBytes;
+		bCanSerialize= Serialization::serializeToBytes(expected, firstBytes);
+		bCanSerialize&= Serialization::serializeToBytes(expected, secondBytes);
+		assert(bCanSerialize);
+		assert(firstBytes == secondBytes);
+
+		SerializationTestStruct actual= {};
+		bool bCanDeserialize = Serialization::deserializeFromBytes(secondBytes, actual);
+		assert(bCanDeserialize);
+
+		verify_serialization_test_struct(actual, expected);
+	UNIT_TEST_COMPLETE()
+}
+
+bool serialization_utility_test_packed_list_bytes()
+{
+	UNIT_TEST_BEGIN("packed list bytes")
+		SerializationMeshStruct expected;
+		for (int i = 0; i < 16; ++i)
+		{
+			expected.vertices.push_back({(float)i, (float)i * 0.5f, (float)-i});
+			expected.indices.push_back(i);
+		}
+
+		std::vector<uint8_t> bytes;
+		bool bCanSerialize= Serialization::serializeToBytes(expected, bytes);
+		assert(bCanSerialize);
+
+		// Packed lists are block copied, but must match the per-element encoding exactly
+		std::vector<uint8_t> expectedBytes;
+		BinaryWriter writer(expectedBytes);
+		to_binary(writer, (int32_t)expected.vertices.size());
+		for (const SerializationVector3fStruct& vertex : expected.vertices)
+		{
+			to_binary(writer, vertex.x);
+			to_binary(writer, vertex.y);
+			to_binary(writer, vertex.z);
+		}
+		to_binary(writer, (int32_t)expected.indices.size());
+		for (int index : expected.indices)
+		{
+			to_binary(writer, (int32_t)index);
+		}
+		assert(bytes == expectedBytes);
+
+		SerializationMeshStruct actual= {};
+		bool bCanDeserialize = Serialization::deserializeFromBytes(bytes, actual);
+		assert(bCanDeserialize);
+
+		assert(actual.vertices.size() == expected.vertices.size());
+		for (size_t i = 0; i < expected.vertices.size(); ++i)
+		{
+			assert(actual.vertices[i].x == expected.vertices[i].x);
+			assert(actual.vertices[i].y == expected.vertices[i].y);
+			assert(actual.vertices[i].z == expected.vertices[i].z);
+		}
+		assert(actual.indices == expected.indices);
+
+		// A truncated block must be rejected rather than over-read
+		bytes.resize(bytes.size() - 1);
+		SerializationMeshStruct truncated= {};
+		bool bTruncatedFailed = false;
+		try
+		{
+			bTruncatedFailed = !Serialization::deserializeFromBytes(bytes, truncated);
+		}
+		catch (std::exception&)
+		{
+			bTruncatedFailed = true;
+		}
+		assert(bTruncatedFailed);
+	UNIT_TEST_COMPLETE()
+}
+
+bool serialization_utility_test_serialized_size()
+{
+	UNIT_TEST_BEGIN("serialized size")
+		SerializationTestStruct testStruct;
+		build_serialization_test_struct(testStruct);
+
+		// The size pass must exactly match what the writer appends
+		std::vector<uint8_t> bytes;
+		bool bCanSerialize= Serialization::serializeToBytes(testStruct, bytes);
+		assert(bCanSerialize);
+		assert(Serialization::computeSerializedSize(testStruct) == bytes.size());
+
+		SerializationMeshStruct mesh;
+		mesh.vertices.push_back({1.f, 2.f, 3.f});
+		mesh.indices.push_back(0);
+
+		// Serializing into a reused buffer appends after any existing bytes
+		const size_t testStructSize = bytes.size();
+		bytes.clear();
+		bCanSerialize= Serialization::serializeToBytes(testStruct, bytes);
+		bCanSerialize&= Serialization::serializeToBytes(mesh, bytes);
+		assert(bCanSerialize);
+		assert(bytes.size() == testStructSize + Serialization::computeSerializedSize(mesh));
+	UNIT_TEST_COMPLETE()
+}
+
+bool serialization_utility_test_binary_format_v2()
+{
+	UNIT_TEST_BEGIN("binary format v2")
+		SerializationTestStruct expected;
+		build_serialization_test_struct(expected);
+
+		std::vector<uint8_t> v1Bytes;
+		std::vector<uint8_t> v2Bytes;
+		bool bCanSerialize= Serialization::serializeToBytes(expected, v1Bytes);
+		bCanSerialize&= Serialization::serializeToBytes(expected, v2Bytes, Serialization::BinaryFormat::V2);
+		assert(bCanSerialize);
+		assert(v2Bytes.size() < v1Bytes.size());
+
+		const Serialization::BinaryFormat v1Format= Serialization::getBinaryFormat(v1Bytes.data(), v1Bytes.size());
+		const Serialization::BinaryFormat v2Format= Serialization::getBinaryFormat(v2Bytes.data(), v2Bytes.size());
+		assert(v1Format == Serialization::BinaryFormat::V1);
+		assert(v2Format == Serialization::BinaryFormat::V2);
+
+		SerializationTestStruct actual= {};
+		bool bCanDeserialize = Serialization::deserializeFromBytes(v2Bytes, actual, Serialization::BinaryFormat::V2);
+		assert(bCanDeserialize);
+		verify_serialization_test_struct(actual, expected);
+
+		// Header (4) + struct length (1) + vertices (count, element size, 12 bytes) + indices (count, element size, 4 bytes)
+		SerializationMeshStruct mesh;
+		mesh.vertices.push_back({1.f, 2.f, 3.f});
+		mesh.indices.push_back(7);
+
+		std::vector<uint8_t> meshBytes;
+		bCanSerialize= Serialization::serializeToBytes(mesh, meshBytes, Serialization::BinaryFormat::V2);
+		assert(bCanSerialize);
+		assert(meshBytes.size() == 4 + 1 + 14 + 6);
+
+		// A reader skips trailing fields it doesn't know about (here two extra bytes) ...
+		std::vector<uint8_t> newerMeshBytes= meshBytes;
+		newerMeshBytes[4]+= 2;
+		newerMeshBytes.push_back(0x05);
+		newerMeshBytes.push_back(0x07);
+
+		SerializationMeshStruct newerMesh;
+		bCanDeserialize= Serialization::deserializeFromBytes(newerMeshBytes, newerMesh, Serialization::BinaryFormat::V2);
+		assert(bCanDeserialize);
+		assert(newerMesh.vertices.size() == 1 && newerMesh.vertices[0].z == 3.f);
+		assert(newerMesh.indices.size() == 1 && newerMesh.indices[0] == 7);
+
+		// ... and leaves fields missing from an older writer at their defaults
+		std::vector<uint8_t> olderMeshBytes(meshBytes.begin(), meshBytes.begin() + 4 + 1 + 14);
+		olderMeshBytes[4]= 14;
+
+		SerializationMeshStruct olderMesh;
+		olderMesh.indices.push_back(42);
+		bCanDeserialize= Serialization::deserializeFromBytes(olderMeshBytes, olderMesh, Serialization::BinaryFormat::V2);
+		assert(bCanDeserialize);
+		assert(olderMesh.vertices.size() == 1 && olderMesh.vertices[0].y == 2.f);
+		assert(olderMesh.indices.size() == 1 && olderMesh.indices[0] == 42);
+	UNIT_TEST_COMPLETE()
+}
+
+bool serialization_utility_test_instance_pool()
+{
+	UNIT_TEST_BEGIN("instance pool")
+		Serialization::InstancePool<SerializationTestStruct> pool;
+		const std::size_t classId = SerializationTestStruct::staticGetArchetype().getId();
+		auto makeInstance = []() { return std::make_shared<SerializationTestStruct>(); };
+
+		SerializationTestStruct expected;
+		build_serialization_test_struct(expected);
+
+		std::string jsonString;
+		bool bCanSerialize= Serialization::serializeToJsonString(expected, jsonString);
+		assert(bCanSerialize);
+
+		auto firstInstance = pool.acquire(classId, makeInstance);
+		bool bCanDeserialize = Serialization::deserializeFromJsonString(jsonString, *firstInstance);
+		assert(bCanDeserialize);
+		verify_serialization_test_struct(*firstInstance, expected);
+
+		// Instances still held when the batch ends are not recycled
+		SerializationTestStruct* firstRawPtr = firstInstance.get();
+		pool.releaseBatch();
+		auto secondInstance = pool.acquire(classId, makeInstance);
+		assert(secondInstance.get() != firstRawPtr);
+
+		// Released instances are handed out again and fully overwritten by the next decode
+		firstInstance.reset();
+		pool.releaseBatch();
+		auto recycledInstance = pool.acquire(classId, makeInstance);
+		assert(recycledInstance.get() == firstRawPtr);
+
+		expected.string_field= Serialization::String("goodbye");
+		expected.int_array.push_back(4);
+		bCanSerialize= Serialization::serializeToJsonString(expected, jsonString);
+		assert(bCanSerialize);
+
+		bCanDeserialize = Serialization::deserializeFromJsonString(jsonString, *recycledInstance);
+		assert(bCanDeserialize);
+		verify_serialization_test_struct(*recycledInstance, expected);
+
+		// A full batch is released by the next acquire, even if releaseBatch() is never called
+		Serialization::InstancePool<SerializationTestStruct> cappedPool(64, 2);
+		cappedPool.acquire(classId, makeInstance);
+		cappedPool.acquire(classId, makeInstance);
+		assert(cappedPool.getBatchSize() == 2);
+		cappedPool.acquire(classId, makeInstance);
+		assert(cappedPool.getBatchSize() == 1);
+	UNIT_TEST_COMPLETE()
+}
+
+bool serialization_utility_test_json_stream_matches_dom()
+{
+	UNIT_TEST_BEGIN("json stream matches dom")
+		SerializationTestStruct expected;
+		build_serialization_test_struct(expected);
+		expected.string_field= Serialization::String("quote\" slash\\ tab\t utf8 \xC3\xA9");
+		expected.double_field= 1e-7;
+
+		// Streaming writer output must be byte-for-byte what dump() produces from the DOM
+		nlohmann::json jsonObject;
+		bool bCanSerialize= Serialization::serializeToJson(expected, jsonObject);
+		assert(bCanSerialize);
+
+		std::string jsonString = "stale contents";
+		bCanSerialize= Serialization::serializeToJsonString(expected, jsonString);
+		assert(bCanSerialize);
+		assert(jsonString == jsonObject.dump());
+
+		SerializationMeshStruct mesh;
+		mesh.vertices.push_back({0.1f, -2.f, 3.5e20f});
+		mesh.indices.push_back(-1);
+
+		nlohmann::json meshJsonObject;
+		Serialization::serializeToJson(mesh, meshJsonObject);
+		Serialization::serializeToJsonString(mesh, jsonString);
+		assert(jsonString == meshJsonObject.dump());
+	UNIT_TEST_COMPLETE()
+}
+
+bool serialization_utility_test_json_sax_matches_dom()
+{
+	UNIT_TEST_BEGIN("json sax matches dom")
+		SerializationTestStruct expected;
+		build_serialization_test_struct(expected);
+
+		std::string jsonString;
+		bool bCanSerialize= Serialization::serializeToJsonString(expected, jsonString);
+		assert(bCanSerialize);
+
+		// The SAX reader fills the struct straight from the text,
+		// and must agree with deserializing from a parsed DOM
+		SerializationTestStruct domActual= {};
+		bool bCanDeserialize= Serialization::deserializeFromJson(nlohmann::json::parse(jsonString), domActual);
+		assert(bCanDeserialize);
+		verify_serialization_test_struct(domActual, expected);
+
+		SerializationTestStruct saxActual= {};
+		bCanDeserialize= Serialization::deserializeFromJsonString(jsonString, saxActual);
+		assert(bCanDeserialize);
+		verify_serialization_test_struct(saxActual, expected);
+
+		// Unknown keys (including nested containers) are skipped
+		nlohmann::json jsonObject = nlohmann::json::parse(jsonString);
+		jsonObject["aaa_unknown_field"] = {{"nested", {1, 2, 3}}};
+		SerializationTestStruct extraKeysActual= {};
+		bCanDeserialize= Serialization::deserializeFromJsonString(jsonObject.dump(), extraKeysActual);
+		assert(bCanDeserialize);
+		verify_serialization_test_struct(extraKeysActual, expected);
+
+		// Missing fields and malformed text are rejected
+		jsonObject.erase("int_field");
+		SerializationTestStruct missingFieldActual= {};
+		bool bMissingFieldFailed= !Serialization::deserializeFromJsonString(jsonObject.dump(), missingFieldActual);
+		assert(bMissingFieldFailed);
+
+		SerializationTestStruct truncatedActual= {};
+		bool bTruncatedFailed=
+			!Serialization::deserializeFromJsonString(jsonString.substr(0, jsonString.size() / 2), truncatedActual);
+		assert(bTruncatedFailed);
+	UNIT_TEST_COMPLETE()
+}
+
 bool serialization_utility_test_remote_control()
 {
 	UNIT_TEST_BEGIN("remote control")
@@ -258,4 +567,75 @@ bool serialization_utility_test_remote_control()
 			assert(actualValue == expectedValue);
 		}
 	UNIT_TEST_COMPLETE()
+}
+
+bool serialization_utility_test_binary_request_header()
+{
+	UNIT_TEST_BEGIN("binary request header")
+		MikanRemoteControlCommand expected= {};
+		expected.requestId = 17;
+		expected.command = "test_command";
+		expected.parameters.push_back("param1");
+
+		std::vector<uint8_t> bytes;
+		bool bCanSerialize= Serialization::serializeToBytes(expected, bytes, Serialization::BinaryFormat::V2);
+		assert(bCanSerialize);
+
+		// The server dispatches binary requests on the MikanRequest fields alone
+		MikanRequest header;
+		const Serialization::BinaryFormat format= Serialization::getBinaryFormat(bytes.data(), bytes.size());
+		bool bCanDeserialize = Serialization::deserializeFromBytes(
+			bytes.data(), bytes.size(), &header, MikanRequest::staticGetArchetype(), format);
+		assert(bCanDeserialize);
+		assert(header.requestTypeId == expected.requestTypeId);
+		assert(header.requestId == expected.requestId);
+
+		MikanRemoteControlCommand actual= {};
+		bCanDeserialize = Serialization::deserializeFromBytes(bytes, actual, format);
+		assert(bCanDeserialize);
+		assert(actual.command == expected.command);
+		assert(actual.parameters.size() == 1);
+	UNIT_TEST_COMPLETE()
+}
+
+bool serialization_utility_test_vr_device_pose_batch()
+{
+	UNIT_TEST_BEGIN("vr device pose batch")
+		MikanVRDevicePoseBatchEvent expected;
+		expected.frame = 1234;
+		for (MikanVRDeviceID deviceId= 0; deviceId < 6; ++deviceId)
+		{
+			MikanVRDevicePose devicePose= {};
+			devicePose.transform.x0 = 1.f;
+			devicePose.transform.y1 = 1.f;
+			devicePose.transform.z2 = 1.f;
+			devicePose.transform.w0 = (float)deviceId;
+			devicePose.transform.w3 = 1.f;
+			devicePose.device_id = deviceId;
+
+			expected.poses.push_back(devicePose);
+		}
+
+		std::string jsonString;
+		bool bCanSerialize= Serialization::serializeToJsonString(expected, jsonString);
+		assert(bCanSerialize);
+
+		// The client picks the event type from the MikanEvent fields
+		MikanEvent header;
+		bool bCanDeserialize = Serialization::deserializeFromJsonString(jsonString, header);
+		assert(bCanDeserialize);
+		assert(header.eventTypeId == expected.eventTypeId);
+
+		MikanVRDevicePoseBatchEvent actual;
+		bCanDeserialize = Serialization::deserializeFromJsonString(jsonString, actual);
+		assert(bCanDeserialize);
+		assert(actual.frame == expected.frame);
+		assert(actual.poses.size() == expected.poses.size());
+		for (int i= 0; i < expected.poses.size(); ++i)
+		{
+			assert(actual.poses[i].device_id == expected.poses[i].device_id);
+			assert(actual.poses[i].transform.w0 == expected.poses[i].transform.w0);
+			assert(actual.poses[i].transform.w3 == expected.poses[i].transform.w3);
+		}
+	UNIT_TEST_COMPLETE()
 }
\ No newline at end of file
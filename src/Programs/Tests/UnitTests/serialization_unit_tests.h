@@ -66,6 +66,36 @@ struct STRUCT() SerializationPoint3dStruct: public SerializationPointStruct
 	#endif
 };
 
+// Plain (non-polymorphic) struct of floats, stored tightly packed in lists
+struct STRUCT() SerializationVector3fStruct
+{
+	FIELD()
+	float x;
+
+	FIELD()
+	float y;
+
+	FIELD()
+	float z;
+
+	#ifndef KODGEN_PARSING
+	SerializationVector3fStruct_GENERATED
+	#endif
+};
+
+struct STRUCT() SerializationMeshStruct
+{
+	FIELD()
+	Serialization::List<SerializationVector3fStruct> vertices;
+
+	FIELD()
+	Serialization::List<int> indices;
+
+	#ifndef KODGEN_PARSING
+	SerializationMeshStruct_GENERATED
+	#endif
+};
+
 struct STRUCT() SerializationTestStruct
 {
 	FIELD()
@@ -0,0 +1,338 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "EventSubscriptionFilter.h"
+#include "SceneVersionTracker.h"
+#include "SharedEventRing.h"
+#include "unit_test.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+//-- public interface -----
+bool run_server_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("server")
+		UNIT_TEST_MODULE_CALL_TEST(server_test_event_subscription_filter);
+		UNIT_TEST_MODULE_CALL_TEST(server_test_event_subscriber_counts);
+		UNIT_TEST_MODULE_CALL_TEST(server_test_scene_version_delta);
+		UNIT_TEST_MODULE_CALL_TEST(server_test_scene_version_removal_cap);
+		UNIT_TEST_MODULE_CALL_TEST(server_test_scene_version_server_runs);
+		UNIT_TEST_MODULE_CALL_TEST(server_test_event_ring_reader_mask);
+		UNIT_TEST_MODULE_CALL_TEST(server_test_event_ring_wrap);
+		UNIT_TEST_MODULE_CALL_TEST(server_test_event_ring_overrun);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+static bool has_object_id(const std::vector<int32_t>& objectIds, int32_t objectId)
+{
+	return std::find(objectIds.begin(), objectIds.end(), objectId) != objectIds.end();
+}
+
+// Every test gets its own ring, a ring left behind by a crashed run can't be created again
+static std::string make_event_ring_name(const char* testName)
+{
+	return std::string("MikanXR_UnitTest_") + testName;
+}
+
+bool server_test_event_subscription_filter()
+{
+	UNIT_TEST_BEGIN("event subscription filter")
+		const int64_t subscribedEventId = 0x1234;
+		const int64_t otherEventId = 0x5678;
+
+		// Clients get every event until they subscribe
+		EventSubscriptionFilter filter;
+		assert(filter.getIsSubscribedToAllEvents());
+		assert(filter.getIsSubscribedToEvent(subscribedEventId));
+		assert(filter.getIsSubscribedToEvent(otherEventId));
+
+		// Event type ids are 64-bit class ids, so they use the full (signed) range
+		filter.setSubscribedEvents(std::vector<int64_t>{subscribedEventId, INT64_MIN, INT64_MAX});
+		assert(!filter.getIsSubscribedToAllEvents());
+		assert(filter.getIsSubscribedToEvent(subscribedEventId));
+		assert(filter.getIsSubscribedToEvent(INT64_MIN));
+		assert(filter.getIsSubscribedToEvent(INT64_MAX));
+		assert(!filter.getIsSubscribedToEvent(otherEventId));
+
+		// Subscribing again replaces the old list
+		filter.setSubscribedEvents(std::vector<int64_t>{otherEventId});
+		assert(!filter.getIsSubscribedToEvent(subscribedEventId));
+		assert(filter.getIsSubscribedToEvent(otherEventId));
+
+		// An empty list means every event again
+		filter.setSubscribedEvents(std::vector<int64_t>());
+		assert(filter.getIsSubscribedToAllEvents());
+		assert(filter.getIsSubscribedToEvent(subscribedEventId));
+	UNIT_TEST_COMPLETE()
+}
+
+bool server_test_event_subscriber_counts()
+{
+	UNIT_TEST_BEGIN("event subscriber counts")
+		const int64_t poseEventId = 1;
+		const int64_t frameEventId = 2;
+		const int64_t otherEventId = 3;
+
+		EventSubscriberCounts counts;
+		assert(!counts.hasEventSubscribers(poseEventId));
+
+		EventSubscriptionFilter poseFilter;
+		poseFilter.setSubscribedEvents(std::vector<int64_t>{poseEventId});
+		EventSubscriptionFilter poseAndFrameFilter;
+		poseAndFrameFilter.setSubscribedEvents(std::vector<int64_t>{poseEventId, frameEventId});
+
+		counts.addFilter(poseFilter);
+		assert(counts.hasEventSubscribers(poseEventId));
+		assert(!counts.hasEventSubscribers(frameEventId));
+
+		counts.addFilter(poseAndFrameFilter);
+		assert(counts.hasEventSubscribers(frameEventId));
+		assert(!counts.hasEventSubscribers(otherEventId));
+
+		// An event stays wanted until the last filter asking for it goes away
+		counts.removeFilter(poseFilter);
+		assert(counts.hasEventSubscribers(poseEventId));
+		counts.removeFilter(poseAndFrameFilter);
+		assert(!counts.hasEventSubscribers(poseEventId));
+		assert(!counts.hasEventSubscribers(frameEventId));
+
+		// A connection that hasn't subscribed yet wants everything
+		EventSubscriptionFilter allEventsFilter;
+		counts.addFilter(allEventsFilter);
+		assert(counts.hasEventSubscribers(otherEventId));
+
+		// Changing a subscription is a remove of the old filter and an add of the new one
+		counts.removeFilter(allEventsFilter);
+		allEventsFilter.setSubscribedEvents(std::vector<int64_t>{frameEventId});
+		counts.addFilter(allEventsFilter);
+		assert(!counts.hasEventSubscribers(otherEventId));
+		assert(counts.hasEventSubscribers(frameEventId));
+
+		counts.clear();
+		assert(!counts.hasEventSubscribers(frameEventId));
+	UNIT_TEST_COMPLETE()
+}
+
+bool server_test_scene_version_delta()
+{
+	UNIT_TEST_BEGIN("scene version delta")
+		SceneVersionTracker tracker;
+		std::vector<int32_t> objectIds;
+
+		tracker.syncObjectIds(eSceneObjectType::stencil, {1, 2});
+		const int64_t syncedVersion = tracker.getSceneVersion();
+		assert(tracker.canComputeDelta(syncedVersion));
+		assert(!tracker.canComputeDelta(syncedVersion + 1));
+
+		// Only the objects changed after the client's version are in the delta
+		tracker.markObjectChanged(eSceneObjectType::stencil, 2);
+		tracker.markObjectChanged(eSceneObjectType::spatialAnchor, 2);
+		tracker.getChangedObjectIds(eSceneObjectType::stencil, syncedVersion, objectIds);
+		assert(objectIds.size() == 1 && objectIds[0] == 2);
+		objectIds.clear();
+		tracker.getChangedObjectIds(eSceneObjectType::spatialAnchor, syncedVersion, objectIds);
+		assert(objectIds.size() == 1 && objectIds[0] == 2);
+		objectIds.clear();
+		tracker.getChangedObjectIds(eSceneObjectType::vrDevice, syncedVersion, objectIds);
+		assert(objectIds.empty());
+
+		// Syncing reports the missing ids as removed and the new ones as changed
+		const int64_t changedVersion = tracker.getSceneVersion();
+		tracker.syncObjectIds(eSceneObjectType::stencil, {2, 3});
+		tracker.getChangedObjectIds(eSceneObjectType::stencil, changedVersion, objectIds);
+		assert(objectIds.size() == 1 && objectIds[0] == 3);
+		objectIds.clear();
+		tracker.getRemovedObjectIds(eSceneObjectType::stencil, changedVersion, objectIds);
+		assert(objectIds.size() == 1 && objectIds[0] == 1);
+		objectIds.clear();
+		tracker.getRemovedObjectIds(eSceneObjectType::spatialAnchor, changedVersion, objectIds);
+		assert(objectIds.empty());
+
+		// Removing an object that isn't tracked doesn't change the scene
+		const int64_t removedVersion = tracker.getSceneVersion();
+		tracker.markObjectRemoved(eSceneObjectType::stencil, 1);
+		assert(tracker.getSceneVersion() == removedVersion);
+
+		// An object removed and then added again is only reported as changed
+		tracker.markObjectChanged(eSceneObjectType::stencil, 1);
+		tracker.getChangedObjectIds(eSceneObjectType::stencil, changedVersion, objectIds);
+		assert(has_object_id(objectIds, 1) && has_object_id(objectIds, 3));
+		objectIds.clear();
+		tracker.getRemovedObjectIds(eSceneObjectType::stencil, changedVersion, objectIds);
+		assert(objectIds.empty());
+	UNIT_TEST_COMPLETE()
+}
+
+bool server_test_scene_version_removal_cap()
+{
+	UNIT_TEST_BEGIN("scene version removal cap")
+		SceneVersionTracker tracker(2);
+		std::vector<int32_t> objectIds;
+
+		tracker.syncObjectIds(eSceneObjectType::vrDevice, {1, 2, 3});
+		const int64_t syncedVersion = tracker.getSceneVersion();
+
+		tracker.markObjectRemoved(eSceneObjectType::vrDevice, 1);
+		const int64_t firstRemovalVersion = tracker.getSceneVersion();
+		tracker.markObjectRemoved(eSceneObjectType::vrDevice, 2);
+		assert(tracker.canComputeDelta(syncedVersion));
+
+		// The third removal pushes out the first, deltas that needed it get a full snapshot instead
+		tracker.markObjectRemoved(eSceneObjectType::vrDevice, 3);
+		assert(!tracker.canComputeDelta(syncedVersion));
+		assert(tracker.canComputeDelta(firstRemovalVersion));
+
+		tracker.getRemovedObjectIds(eSceneObjectType::vrDevice, firstRemovalVersion, objectIds);
+		assert(objectIds.size() == 2 && has_object_id(objectIds, 2) && has_object_id(objectIds, 3));
+	UNIT_TEST_COMPLETE()
+}
+
+bool server_test_scene_version_server_runs()
+{
+	UNIT_TEST_BEGIN("scene version server runs")
+		SceneVersionTracker firstRun(1024, 1);
+		firstRun.syncObjectIds(eSceneObjectType::spatialAnchor, {1, 2, 3});
+		const int64_t firstRunVersion = firstRun.getSceneVersion();
+		assert(firstRun.canComputeDelta(firstRunVersion));
+
+		// The server restarted, versions from the last run must not be taken as this run's
+		SceneVersionTracker laterRun(1024, 2);
+		laterRun.syncObjectIds(eSceneObjectType::spatialAnchor, {1});
+		assert(!laterRun.canComputeDelta(firstRunVersion));
+
+		// Even when the run before had a higher run id, or handed out more versions
+		for (int32_t anchorId = 10; anchorId < 20; ++anchorId)
+		{
+			laterRun.markObjectChanged(eSceneObjectType::spatialAnchor, anchorId);
+		}
+		SceneVersionTracker restartedRun(1024, 1);
+		restartedRun.syncObjectIds(eSceneObjectType::spatialAnchor, {1});
+		assert(!restartedRun.canComputeDelta(laterRun.getSceneVersion()));
+
+		// A client without any scene version yet always gets a full snapshot
+		assert(!laterRun.canComputeDelta(0));
+	UNIT_TEST_COMPLETE()
+}
+
+bool server_test_event_ring_reader_mask()
+{
+	UNIT_TEST_BEGIN("event ring reader mask")
+		const std::string ringName = make_event_ring_name("EventRingReaderMask");
+
+		SharedEventRingWriter writer;
+		bool bCreated = writer.create(ringName, 4096);
+		assert(bCreated);
+
+		SharedEventRingReader firstReader;
+		SharedEventRingReader lastReader;
+		bool bOpened = firstReader.open(ringName, 0, writer.getWritePosition());
+		assert(bOpened);
+		bOpened = lastReader.open(ringName, SHARED_EVENT_RING_MAX_READERS - 1, writer.getWritePosition());
+		assert(bOpened);
+
+		SharedEventRingReader invalidReader;
+		assert(!invalidReader.open(ringName, SHARED_EVENT_RING_MAX_READERS, 0));
+		assert(!invalidReader.open(make_event_ring_name("MissingEventRing"), 0, 0));
+
+		const uint64_t firstReaderBit = 1ull;
+		const uint64_t lastReaderBit = 1ull << (SHARED_EVENT_RING_MAX_READERS - 1);
+		writer.writeEvent(firstReaderBit, "first", 5);
+		writer.writeEvent(lastReaderBit, "last", 4);
+		writer.writeEvent(firstReaderBit | lastReaderBit, "both", 4);
+		// Events for readers that aren't open are skipped by everyone else
+		writer.writeEvent(0x2, "nobody", 6);
+
+		std::string event;
+		assert(firstReader.tryReadEvent(event) && event == "first");
+		assert(firstReader.tryReadEvent(event) && event == "both");
+		assert(!firstReader.tryReadEvent(event));
+
+		assert(lastReader.tryReadEvent(event) && event == "last");
+		assert(lastReader.tryReadEvent(event) && event == "both");
+		assert(!lastReader.tryReadEvent(event));
+
+		assert(firstReader.getOverrunCount() == 0);
+		assert(lastReader.getOverrunCount() == 0);
+
+		// Too big to ever fit in the ring
+		std::string hugeEvent(writer.getMaxEventSize() + 1, 'x');
+		assert(!writer.writeEvent(firstReaderBit, hugeEvent.data(), hugeEvent.size()));
+	UNIT_TEST_COMPLETE()
+}
+
+bool server_test_event_ring_wrap()
+{
+	UNIT_TEST_BEGIN("event ring wrap")
+		const std::string ringName = make_event_ring_name("EventRingWrap");
+
+		SharedEventRingWriter writer;
+		bool bCreated = writer.create(ringName, 4096);
+		assert(bCreated);
+
+		SharedEventRingReader reader;
+		bool bOpened = reader.open(ringName, 3, writer.getWritePosition());
+		assert(bOpened);
+
+		// Records that don't evenly divide the ring, so the end of it gets padding records
+		std::string event;
+		for (int eventIndex = 0; eventIndex < 20; ++eventIndex)
+		{
+			const std::string expected(900 + eventIndex, (char)('a' + eventIndex));
+			bool bWritten = writer.writeEvent(1ull << 3, expected.data(), expected.size());
+			assert(bWritten);
+
+			assert(reader.tryReadEvent(event));
+			assert(event == expected);
+			assert(!reader.tryReadEvent(event));
+		}
+
+		// Keeping up with the writer never loses anything
+		assert(reader.getOverrunCount() == 0);
+		assert(writer.getWritePosition() > 4096);
+	UNIT_TEST_COMPLETE()
+}
+
+bool server_test_event_ring_overrun()
+{
+	UNIT_TEST_BEGIN("event ring overrun")
+		const std::string ringName = make_event_ring_name("EventRingOverrun");
+
+		SharedEventRingWriter writer;
+		bool bCreated = writer.create(ringName, 4096);
+		assert(bCreated);
+
+		SharedEventRingReader reader;
+		bool bOpened = reader.open(ringName, 0, writer.getWritePosition());
+		assert(bOpened);
+
+		// The writer never waits, so a reader a whole ring behind loses those events
+		const std::string staleEvent(1000, 's');
+		for (int eventIndex = 0; eventIndex < 8; ++eventIndex)
+		{
+			writer.writeEvent(1ull, staleEvent.data(), staleEvent.size());
+		}
+
+		std::string event;
+		assert(!reader.tryReadEvent(event));
+		assert(reader.getOverrunCount() == 1);
+
+		// And picks up again with the next one
+		writer.writeEvent(1ull, "fresh", 5);
+		assert(reader.tryReadEvent(event) && event == "fresh");
+		assert(reader.getOverrunCount() == 1);
+
+		// A reader opened at a position the ring already moved past is caught up the same way
+		SharedEventRingReader lateReader;
+		bOpened = lateReader.open(ringName, 1, 0);
+		assert(bOpened);
+		assert(!lateReader.tryReadEvent(event));
+		assert(lateReader.getOverrunCount() == 1);
+		writer.writeEvent(1ull << 1, "late", 4);
+		assert(lateReader.tryReadEvent(event) && event == "late");
+	UNIT_TEST_COMPLETE()
+}